@@ -26,6 +26,7 @@
 #include "esp_event.h"
 #include "esp_log.h"
 #include "esp_mac.h"
+#include "esp_random.h"
 
 #include "esp_netif.h"
 #include "esp_wifi.h"
@@ -39,12 +40,26 @@
 #include "globals.h"
 #include "helpers.h"
 #include "config.h"
+#include "pool.h"
+#include "tasks.h"
 #include "wifi.h"
+#include "link.h"
 #include "http.h"
 #include "discovery.h"
 #include "camera.h"
-#include "comm_udp.h"
+#include "transport.h"
+#include "comm_endpoint.h"
+#include "stream.h"
 #include "drive.h"
+#include "bench.h"
+#include "recorder.h"
+#include "history.h"
+#include "tiles.h"
+#include "pipeline.h"
+#include "tracker.h"
+#include "sweep.h"
+#include "profiler.h"
+#include "dlog.h"
 
 
 static const char * roverLogTAG = "rover";
@@ -52,14 +67,33 @@ static const char * roverLogTAG = "rover";
 static char roverHostname[] = "camrover-\0MMAACC";
 
 static t_rover_discovery roverDiscovery;
-static t_rover_comm_udp roverCommControl = { 0 };
-static t_rover_comm_udp roverCommStreaming = { 0 };
+static t_rover_transport roverTransportControl;
+static t_rover_transport roverTransportStreaming;
+static t_rover_comm_endpoint roverCommControl = { 0 };
+static t_rover_comm_endpoint roverCommStreaming = { 0 };
+static t_rover_stream roverStream;
 static t_rover_camera roverCamera = { 0 };
+static t_rover_link roverLink = { 0 };
 static t_rover_drive roverDrive = { 0 };
+static t_rover_bench roverBench = { 0 };
+static t_rover_recorder roverRecorder = { 0 };
+static t_rover_history roverHistory = { 0 };
+static t_rover_tiles roverTiles = { 0 };
+static t_rover_pipeline roverPipeline = { 0 };
+static t_rover_tracker roverTracker = { 0 };
+#ifdef CONFIG_ROVER_BENCH_CAMERA_SWEEP
+static t_rover_sweep roverSweep;
+#endif
+#ifdef CONFIG_ROVER_PROFILER
+static t_rover_profiler roverProfiler;
+// busier core over the last profiler window, percent
+static uint8_t roverProfilerLoad = 0;
+#endif
 
 
 static void rover_comm_handler_move_stop( void )
 {
+	rover_tracker_set_enabled( &roverTracker, false );
 	rover_drive_change_speed( &roverDrive, -roverDrive.motor1.speed, -roverDrive.motor2.speed );
 }
 
@@ -82,9 +116,11 @@ t_rover_motors_speed rover_comm_handler_move_turn( int32_t incL, int32_t incR )
 }
 
 
+// duty ticks on the wire, a share of the full duty in the config
 void rover_comm_handler_move_deadzone( uint32_t v )
 {
-	roverDrive.deadzone = v;
+	uint32_t dutyTickMax = roverDrive.pwm.dutyTickMax;
+	rover_config_set( ROVER_CONFIG_DRIVE_DEADZONE, MIN( v, dutyTickMax ) * 1000 / dutyTickMax );
 }
 
 
@@ -94,15 +130,161 @@ void rover_comm_handler_camera_flash( uint8_t duty )
 }
 
 
-static void rover_camera_handler_frame( t_rover_camera_frame * frame )
+void rover_comm_handler_camera_flash_mode( uint8_t mode )
 {
-	rover_comm_udp_send( &roverCommStreaming, frame->ptr, frame->len );
+	if ( mode <= ROVER_CAMERA_FLASH_MODE_AUTO ) {
+		rover_camera_set_flash_mode( &roverCamera, mode );
+	}
+}
+
+
+// runs on the config task; a change that cannot be applied puts the setting back
+static void rover_config_handler_changed( void * context, t_rover_config_id id, uint32_t value )
+{
+	if ( ROVER_CONFIG_CAMERA_JPEG_QUALITY == id ) {
+		rover_camera_set_jpeg_quality( &roverCamera, value );
+	}
+	else if ( ROVER_CONFIG_CAMERA_FRAME_SIZE == id ) {
+		if ( value != roverCamera.config.frame_size && rover_camera_set_frame_size( &roverCamera, value ) != ESP_OK ) {
+			rover_config_set( id, roverCamera.config.frame_size );
+		}
+	}
+	else if ( ROVER_CONFIG_DRIVE_DEADZONE == id ) {
+		rover_drive_set_deadzone( &roverDrive, value );
+	}
+	else if ( ROVER_CONFIG_DRIVE_PWM_FREQ == id ) {
+		if ( value != roverDrive.pwm.freqHz && !rover_drive_set_pwm_freq( &roverDrive, value ) ) {
+			rover_config_set( id, roverDrive.pwm.freqHz );
+		}
+	}
+}
+
+
+static void rover_tiles_handler_send( void * context, uint8_t * data, size_t len )
+{
+	rover_comm_endpoint_send( (t_rover_comm_endpoint *)context, data, len );
+}
+
+
+#ifdef CONFIG_ROVER_PROFILER
+// the profile goes to the stream client, interleaved with the frames, and the busier core becomes the load discovery
+// announces; runs on the profiler task, so it may block
+static void rover_profiler_handler_sample( void * context, const t_rover_profiler_sample * sample )
+{
+	static uint8_t packet[ROVER_PROFILER_PACKET_LEN_MAX];
+	t_rover_comm_endpoint * endpoint = (t_rover_comm_endpoint *)context;
+	uint16_t load = 0;
+
+	for ( size_t i = 0; i < ROVER_PROFILER_CORES; ++i ) {
+		load = MAX( load, sample->coreLoad[i] );
+	}
+
+	__atomic_store_n( &roverProfilerLoad, ( load + 5 ) / 10, __ATOMIC_RELAXED );
+
+	if ( endpoint->transport->hasClient ) {
+		rover_comm_endpoint_send( endpoint, packet, rover_profiler_emit( sample, packet, sizeof packet ) );
+	}
+}
+#endif
+
+
+void rover_comm_handler_move_autonomous( uint8_t isEnabled )
+{
+#ifdef CONFIG_ROVER_TRACKER
+	rover_tracker_set_enabled( &roverTracker, isEnabled != 0 );
+	rover_camera_wake( &roverCamera );
+#endif
+}
+
+
+static void rover_pipeline_handler_stream( void * context, t_rover_pipeline_frame * frame )
+{
+	if ( frame->frame.format != PIXFORMAT_JPEG ) {
+		rover_tiles_process( &roverTiles, &frame->frame );
+		return;
+	}
+
+	rover_stream_send_frame( (t_rover_stream *)context, &frame->frame );
+}
+
+
+static void rover_pipeline_handler_recorder( void * context, t_rover_pipeline_frame * frame )
+{
+	if ( PIXFORMAT_JPEG == frame->frame.format ) {
+		rover_recorder_append( (t_rover_recorder *)context, &frame->frame );
+	}
+}
+
+
+static void rover_pipeline_handler_tracker( void * context, t_rover_pipeline_frame * frame )
+{
+	rover_tracker_process( (t_rover_tracker *)context, &frame->frame );
+}
+
+
+static void rover_pipeline_handler_history( void * context, t_rover_pipeline_frame * frame )
+{
+	if ( PIXFORMAT_JPEG == frame->frame.format ) {
+		rover_history_append( (t_rover_history *)context, &frame->frame );
+	}
+}
+
+
+static void rover_discovery_handler_status( void * context, t_rover_discovery_status * status )
+{
+	const t_rover_camera_stats * stats = &( (t_rover_camera *)context )->stats;
+
+	status->width = stats->width;
+	status->height = stats->height;
+	status->fps = stats->fps;
+#ifdef CONFIG_ROVER_PROFILER
+	status->load = __atomic_load_n( &roverProfilerLoad, __ATOMIC_RELAXED );
+#else
+	// the camera task's busy share of the frame period, the closest thing without run time counters
+	status->load = stats->load;
+#endif
+	status->linkQuality = roverLink.quality;
+}
+
+
+static void rover_link_handler_quality( void * context, uint8_t quality )
+{
+#ifdef CONFIG_ROVER_CAMERA_RATE_CONTROL
+	rover_camera_set_frame_budget(
+		(t_rover_camera *)context, rover_link_scale_budget( quality, CONFIG_ROVER_CAMERA_FRAME_BUDGET ) );
+#endif
+}
+
+
+#ifdef CONFIG_ROVER_CAMERA_IDLE
+// the app ACKs the stream while it shows it; recording and the tracker need frames without a viewer
+static bool rover_camera_handler_demand( void * context )
+{
+	return rover_comm_endpoint_get_idle_ms( (t_rover_comm_endpoint *)context ) < CONFIG_ROVER_CAMERA_IDLE_TIMEOUT_MS ||
+		roverRecorder.isEnabled || roverTracker.isEnabled;
+}
+
+
+static void rover_comm_handler_stream_receive( void * context )
+{
+	rover_camera_wake( (t_rover_camera *)context );
+}
+#endif
+
+
+static void rover_comm_transport_init( t_rover_transport * transport, uint16_t portNo )
+{
+#ifdef CONFIG_ROVER_COMM_TRANSPORT_TCP
+	rover_transport_tcp_init( transport, portNo );
+#else
+	rover_transport_udp_init( transport, portNo );
+#endif
 }
 
 
 static void rover_http_handler_post_wlan_config( const char * ssid, const char * password )
 {
-	t_rover_config config;
+	t_rover_config config = { 0 };
 	config.wlan.ssid = ssid;
 	config.wlan.password = password;
 
@@ -117,6 +299,23 @@ static void rover_http_handler_post_wlan_config( const char * ssid, const char *
 static httpd_handle_t rover_start_webserver( void )
 {
 	static const httpd_uri_t root = { .uri = "/", .method = HTTP_ANY, .handler = rover_http_root_handler };
+	static const httpd_uri_t history = { .uri = "/history", .method = HTTP_GET, .handler = rover_http_history_handler };
+	static const httpd_uri_t historyFrame = {
+		.uri = "/history/frame", .method = HTTP_GET, .handler = rover_http_history_frame_handler
+	};
+	static const httpd_uri_t pools = { .uri = "/pools", .method = HTTP_GET, .handler = rover_http_pools_handler };
+	static const httpd_uri_t settings = { .uri = "/config", .method = HTTP_ANY, .handler = rover_http_config_handler };
+#ifdef CONFIG_ROVER_DLOG
+	static const httpd_uri_t logDump = { .uri = "/log", .method = HTTP_GET, .handler = rover_http_log_handler };
+#endif
+#ifdef CONFIG_ROVER_BENCH_CAMERA_SWEEP
+	static const httpd_uri_t sweepStart = {
+		.uri = "/bench/camera/start", .method = HTTP_GET, .handler = rover_http_sweep_start_handler
+	};
+	static const httpd_uri_t sweep = {
+		.uri = "/bench/camera", .method = HTTP_GET, .handler = rover_http_sweep_handler
+	};
+#endif
 
 	httpd_handle_t server = NULL;
 	httpd_config_t config = HTTPD_DEFAULT_CONFIG();
@@ -130,6 +329,17 @@ static httpd_handle_t rover_start_webserver( void )
 		// Set URI handlers
 		ESP_LOGI( roverLogTAG, "Registering URI handlers" );
 		httpd_register_uri_handler( server, &root );
+		httpd_register_uri_handler( server, &history );
+		httpd_register_uri_handler( server, &historyFrame );
+		httpd_register_uri_handler( server, &pools );
+		httpd_register_uri_handler( server, &settings );
+#ifdef CONFIG_ROVER_DLOG
+		httpd_register_uri_handler( server, &logDump );
+#endif
+#ifdef CONFIG_ROVER_BENCH_CAMERA_SWEEP
+		httpd_register_uri_handler( server, &sweepStart );
+		httpd_register_uri_handler( server, &sweep );
+#endif
 		httpd_register_err_handler( server, HTTPD_404_NOT_FOUND, rover_http_404_error_handler );
 	}
 
@@ -152,6 +362,13 @@ void app_main( void )
 	// Initialize NVS needed by Wi-Fi
 	ESP_ERROR_CHECK( nvs_flash_init() );
 
+	rover_pool_init();
+	rover_tasks_init();
+	rover_dlog_init();
+	rover_config_init();
+
+	roverDrive.pwm.freqHz = rover_config_get( ROVER_CONFIG_DRIVE_PWM_FREQ );
+	roverDrive.deadzonePermille = rover_config_get( ROVER_CONFIG_DRIVE_DEADZONE );
 	rover_drive_init( &roverDrive );
 
 	uint8_t mac[6];
@@ -161,6 +378,7 @@ void app_main( void )
 	strcat( roverHostname, macString );
 
 	t_rover_config roverConfig;
+	wifi_mode_t wifiMode = WIFI_MODE_STA;
 
 	if ( rover_load_config( &roverConfig ) ) {
 		ESP_LOGI( roverLogTAG,
@@ -174,10 +392,14 @@ void app_main( void )
 			rover_reset_config();
 			esp_restart();
 		}
+
+		// the Wi-Fi driver keeps its own copy
+		rover_free_config( &roverConfig );
 	}
 	else {
 		esp_netif_set_hostname( esp_netif_create_default_wifi_ap(), roverHostname );
 		rover_wifi_init_softap( macString );
+		wifiMode = WIFI_MODE_AP;
 
 		// Start the DNS server that will redirect all queries to the softAP IP
 		dns_server_config_t config =
@@ -188,24 +410,102 @@ void app_main( void )
 
 	rover_http_set_handler_post_wlan_config( rover_http_handler_post_wlan_config );
 
-	roverCamera.frameHandler = rover_camera_handler_frame;
+	rover_pipeline_init( &roverPipeline );
+	rover_stream_init( &roverStream, &roverCommStreaming );
+	rover_pipeline_add_stage(
+		&roverPipeline, ROVER_TASK_PIPELINE, "rover_stream", rover_pipeline_handler_stream, &roverStream );
+
+	if ( rover_recorder_start( &roverRecorder ) ) {
+		rover_pipeline_add_stage(
+			&roverPipeline, ROVER_TASK_PIPELINE, "rover_recorder", rover_pipeline_handler_recorder, &roverRecorder );
+	}
+
+	if ( CONFIG_ROVER_HISTORY_SIZE > 0 && rover_history_init( &roverHistory, CONFIG_ROVER_HISTORY_SIZE ) ) {
+		rover_http_set_history( &roverHistory );
+		rover_pipeline_add_stage(
+			&roverPipeline, ROVER_TASK_PIPELINE, "rover_history", rover_pipeline_handler_history, &roverHistory );
+	}
+
+#ifdef CONFIG_ROVER_TRACKER
+	if ( rover_tracker_init( &roverTracker, &roverDrive ) ) {
+		rover_pipeline_add_stage(
+			&roverPipeline, ROVER_TASK_TRACKER, "rover_tracker", rover_pipeline_handler_tracker, &roverTracker );
+	}
+#endif
+
+#ifdef CONFIG_ROVER_CAMERA_TILES
+	rover_tiles_init( &roverTiles, rover_tiles_handler_send, &roverCommStreaming );
+#endif
+
+	roverCamera.pipeline = &roverPipeline;
+#ifdef CONFIG_ROVER_CAMERA_IDLE
+	roverCamera.demand = rover_camera_handler_demand;
+	roverCamera.demandContext = &roverCommStreaming;
+#endif
+	roverCamera.config.frame_size = rover_config_get( ROVER_CONFIG_CAMERA_FRAME_SIZE );
+	roverCamera.config.jpeg_quality = rover_config_get( ROVER_CONFIG_CAMERA_JPEG_QUALITY );
 	rover_camera_start( &roverCamera );
 
+	for ( size_t i = 0; i < ROVER_CONFIG_COUNT; ++i ) {
+		rover_config_subscribe( i, rover_config_handler_changed, NULL );
+	}
+
+	rover_config_start();
+
+#ifdef CONFIG_ROVER_BENCH_CAMERA_SWEEP
+	rover_sweep_init( &roverSweep, &roverCamera );
+	rover_http_set_sweep( &roverSweep );
+#endif
+
 	rover_start_webserver();
 
+	// one session per boot, clients resuming after a gap see the same token and keep their state
+	uint32_t sessionToken = esp_random() | 1;
+	roverDiscovery.sessionToken = sessionToken;
+
 	// control
+	roverCommControl.sessionToken = sessionToken;
 	roverCommControl.handlers.move.speed = rover_comm_handler_move_speed;
 	roverCommControl.handlers.move.stop = rover_comm_handler_move_stop;
 	roverCommControl.handlers.move.turn = rover_comm_handler_move_turn;
 	roverCommControl.handlers.move.set = rover_comm_handler_move_set;
 	roverCommControl.handlers.move.deadzone = rover_comm_handler_move_deadzone;
+	roverCommControl.handlers.move.autonomous = rover_comm_handler_move_autonomous;
 	roverCommControl.handlers.camera.flash = rover_comm_handler_camera_flash;
-	roverCommControl.portNo = 101;
-	roverDiscovery.controlPortNo = rover_comm_udp_start( &roverCommControl );
+	roverCommControl.handlers.camera.flashMode = rover_comm_handler_camera_flash_mode;
+	rover_comm_transport_init( &roverTransportControl, 101 );
+	roverTransportControl.tos = ROVER_TRANSPORT_TOS_VOICE;
+	roverCommControl.transport = &roverTransportControl;
+	roverCommControl.taskId = ROVER_TASK_COMM_CONTROL;
+	roverDiscovery.controlPortNo = rover_comm_endpoint_start( &roverCommControl ) ? roverTransportControl.portNo : 0;
 
 	// streaming
-	roverCommStreaming.portNo = 102;
-	roverDiscovery.cameraStreamPortNo = rover_comm_udp_start( &roverCommStreaming );
-
+	rover_comm_transport_init( &roverTransportStreaming, 102 );
+	roverTransportStreaming.tos = ROVER_TRANSPORT_TOS_VIDEO;
+	roverCommStreaming.transport = &roverTransportStreaming;
+	roverCommStreaming.sessionToken = sessionToken;
+	roverCommStreaming.taskId = ROVER_TASK_COMM_STREAM;
+#ifdef CONFIG_ROVER_CAMERA_IDLE
+	roverCommStreaming.handlerReceive = rover_comm_handler_stream_receive;
+	roverCommStreaming.handlerReceiveContext = &roverCamera;
+#endif
+	roverDiscovery.cameraStreamPortNo =
+		rover_comm_endpoint_start( &roverCommStreaming ) ? roverTransportStreaming.portNo : 0;
+
+	roverDiscovery.status = rover_discovery_handler_status;
+	roverDiscovery.statusContext = &roverCamera;
 	rover_discovery_start( &roverDiscovery );
+
+	roverLink.transport = &roverTransportStreaming;
+	roverLink.handler = rover_link_handler_quality;
+	roverLink.handlerContext = &roverCamera;
+	rover_link_start( &roverLink, wifiMode );
+
+	rover_bench_start( &roverBench );
+
+#ifdef CONFIG_ROVER_PROFILER
+	roverProfiler.handler = rover_profiler_handler_sample;
+	roverProfiler.handlerContext = &roverCommStreaming;
+	rover_profiler_start( &roverProfiler );
+#endif
 }
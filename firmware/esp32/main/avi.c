@@ -0,0 +1,207 @@
+/*
+ *	Copyright (c) 2025 Denis Rozhkov <denis@rozhkoff.com>
+ *	This file is part of cam-rover.
+ *
+ *	cam-rover is free software: you can redistribute it and/or
+ *	modify it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or (at your
+ *	option) any later version.
+ *
+ *	cam-rover is distributed in the hope that it will be
+ *	useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ *	Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along with
+ *	cam-rover. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <string.h>
+
+#include "avi.h"
+
+
+// RIFF 'AVI ' > LIST 'hdrl' > 'avih', LIST 'strl' > 'strh', 'strf'; LIST 'movi' follows the header
+#define ROVER_AVI_OFFSET_AVIH 32
+#define ROVER_AVI_OFFSET_STRH 108
+#define ROVER_AVI_OFFSET_STRF 172
+#define ROVER_AVI_OFFSET_MOVI 220
+
+#define ROVER_AVI_FLAG_HASINDEX 0x10
+#define ROVER_AVI_FLAG_KEYFRAME 0x10
+
+
+static void rover_avi_put_u16( uint8_t * p, uint16_t v )
+{
+	p[0] = v & 0xff;
+	p[1] = ( v >> 8 ) & 0xff;
+}
+
+
+static void rover_avi_put_u32( uint8_t * p, uint32_t v )
+{
+	p[0] = v & 0xff;
+	p[1] = ( v >> 8 ) & 0xff;
+	p[2] = ( v >> 16 ) & 0xff;
+	p[3] = ( v >> 24 ) & 0xff;
+}
+
+
+static void rover_avi_put_fourcc( uint8_t * p, const char * fourcc )
+{
+	memcpy( p, fourcc, 4 );
+}
+
+
+static void rover_avi_put_chunk( uint8_t * p, const char * fourcc, uint32_t len )
+{
+	rover_avi_put_fourcc( p, fourcc );
+	rover_avi_put_u32( p + 4, len );
+}
+
+
+static uint32_t rover_avi_us_per_frame( const t_rover_avi * avi )
+{
+	if ( avi->frameCount < 2 || avi->lastTsUs <= avi->firstTsUs ) {
+		return 40000;
+	}
+
+	return (uint32_t)( ( avi->lastTsUs - avi->firstTsUs ) / ( avi->frameCount - 1 ) );
+}
+
+
+static void rover_avi_build_header( const t_rover_avi * avi, uint8_t * h )
+{
+	uint32_t usPerFrame = rover_avi_us_per_frame( avi );
+	uint32_t indexLen = avi->frameCount * ROVER_AVI_INDEX_ENTRY_SIZE;
+
+	memset( h, 0, ROVER_AVI_HEADER_SIZE );
+
+	rover_avi_put_chunk( h, "RIFF", ROVER_AVI_HEADER_SIZE - 8 + avi->moviLen + 8 + indexLen );
+	rover_avi_put_fourcc( h + 8, "AVI " );
+	rover_avi_put_chunk( h + 12, "LIST", 192 );
+	rover_avi_put_fourcc( h + 20, "hdrl" );
+
+	uint8_t * p = h + 24;
+	rover_avi_put_chunk( p, "avih", 56 );
+	p = h + ROVER_AVI_OFFSET_AVIH;
+	rover_avi_put_u32( p, usPerFrame );
+	rover_avi_put_u32( p + 4, (uint32_t)( (uint64_t)avi->maxFrameLen * 1000000 / usPerFrame ) );
+	rover_avi_put_u32( p + 12, ROVER_AVI_FLAG_HASINDEX );
+	rover_avi_put_u32( p + 16, avi->frameCount );
+	rover_avi_put_u32( p + 24, 1 );
+	rover_avi_put_u32( p + 28, avi->maxFrameLen );
+	rover_avi_put_u32( p + 32, avi->width );
+	rover_avi_put_u32( p + 36, avi->height );
+
+	rover_avi_put_chunk( h + 88, "LIST", 116 );
+	rover_avi_put_fourcc( h + 96, "strl" );
+
+	rover_avi_put_chunk( h + 100, "strh", 56 );
+	p = h + ROVER_AVI_OFFSET_STRH;
+	rover_avi_put_fourcc( p, "vids" );
+	rover_avi_put_fourcc( p + 4, "MJPG" );
+	rover_avi_put_u32( p + 20, usPerFrame );
+	rover_avi_put_u32( p + 24, 1000000 );
+	rover_avi_put_u32( p + 32, avi->frameCount );
+	rover_avi_put_u32( p + 36, avi->maxFrameLen );
+	rover_avi_put_u32( p + 40, 0xffffffff );
+	rover_avi_put_u16( p + 52, avi->width );
+	rover_avi_put_u16( p + 54, avi->height );
+
+	rover_avi_put_chunk( h + 164, "strf", 40 );
+	p = h + ROVER_AVI_OFFSET_STRF;
+	rover_avi_put_u32( p, 40 );
+	rover_avi_put_u32( p + 4, avi->width );
+	rover_avi_put_u32( p + 8, avi->height );
+	rover_avi_put_u16( p + 12, 1 );
+	rover_avi_put_u16( p + 14, 24 );
+	rover_avi_put_fourcc( p + 16, "MJPG" );
+	rover_avi_put_u32( p + 20, avi->width * avi->height * 3 );
+
+	rover_avi_put_chunk( h + 212, "LIST", 4 + avi->moviLen );
+	rover_avi_put_fourcc( h + ROVER_AVI_OFFSET_MOVI, "movi" );
+}
+
+
+bool rover_avi_open( t_rover_avi * avi,
+	const t_rover_avi_sink * sink,
+	uint32_t width,
+	uint32_t height,
+	uint8_t * index,
+	uint32_t indexCapacity )
+{
+	memset( avi, 0, sizeof *avi );
+	avi->sink = *sink;
+	avi->width = width;
+	avi->height = height;
+	avi->index = index;
+	avi->indexCapacity = indexCapacity;
+
+	uint8_t header[ROVER_AVI_HEADER_SIZE];
+	rover_avi_build_header( avi, header );
+
+	return avi->sink.write( avi->sink.ctx, header, sizeof header );
+}
+
+
+bool rover_avi_add_frame( t_rover_avi * avi, const uint8_t * data, size_t len, int64_t tsUs )
+{
+	if ( rover_avi_is_full( avi ) ) {
+		return false;
+	}
+
+	uint8_t chunk[8];
+	rover_avi_put_chunk( chunk, "00dc", len );
+
+	static const uint8_t pad = 0;
+
+	if ( !avi->sink.write( avi->sink.ctx, chunk, sizeof chunk ) || !avi->sink.write( avi->sink.ctx, data, len ) ||
+		( ( len & 1 ) && !avi->sink.write( avi->sink.ctx, &pad, 1 ) ) ) {
+
+		return false;
+	}
+
+	uint8_t * entry = avi->index + avi->frameCount * ROVER_AVI_INDEX_ENTRY_SIZE;
+	rover_avi_put_fourcc( entry, "00dc" );
+	rover_avi_put_u32( entry + 4, ROVER_AVI_FLAG_KEYFRAME );
+	// offset is relative to the 'movi' fourcc
+	rover_avi_put_u32( entry + 8, 4 + avi->moviLen );
+	rover_avi_put_u32( entry + 12, len );
+
+	if ( 0 == avi->frameCount ) {
+		avi->firstTsUs = tsUs;
+	}
+
+	avi->lastTsUs = tsUs;
+	avi->frameCount++;
+	avi->moviLen += ROVER_AVI_CHUNK_SIZE( len );
+
+	if ( len > avi->maxFrameLen ) {
+		avi->maxFrameLen = len;
+	}
+
+	return true;
+}
+
+
+bool rover_avi_close( t_rover_avi * avi )
+{
+	uint8_t chunk[8];
+	uint32_t indexLen = avi->frameCount * ROVER_AVI_INDEX_ENTRY_SIZE;
+	rover_avi_put_chunk( chunk, "idx1", indexLen );
+
+	if ( !avi->sink.write( avi->sink.ctx, chunk, sizeof chunk ) ||
+		!avi->sink.write( avi->sink.ctx, avi->index, indexLen ) ) {
+
+		return false;
+	}
+
+	uint8_t header[ROVER_AVI_HEADER_SIZE];
+	rover_avi_build_header( avi, header );
+
+	return avi->sink.patch( avi->sink.ctx, 0, header, sizeof header );
+}
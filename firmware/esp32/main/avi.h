@@ -0,0 +1,73 @@
+/*
+ *	Copyright (c) 2025 Denis Rozhkov <denis@rozhkoff.com>
+ *	This file is part of cam-rover.
+ *
+ *	cam-rover is free software: you can redistribute it and/or
+ *	modify it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or (at your
+ *	option) any later version.
+ *
+ *	cam-rover is distributed in the hope that it will be
+ *	useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ *	Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along with
+ *	cam-rover. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef __ROVER__AVI__H
+#define __ROVER__AVI__H
+
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+
+#define ROVER_AVI_HEADER_SIZE 224
+#define ROVER_AVI_INDEX_ENTRY_SIZE 16
+#define ROVER_AVI_CHUNK_SIZE( a_len ) ( 8 + ( a_len ) + ( ( a_len ) & 1 ) )
+
+
+typedef struct {
+	void * ctx;
+	// appends data to the end of the file
+	bool ( *write )( void * ctx, const void * data, size_t len );
+	// overwrites already written data
+	bool ( *patch )( void * ctx, size_t offset, const void * data, size_t len );
+} t_rover_avi_sink;
+
+typedef struct {
+	t_rover_avi_sink sink;
+	uint32_t width;
+	uint32_t height;
+	uint8_t * index;
+	uint32_t indexCapacity;
+	uint32_t frameCount;
+	uint32_t moviLen;
+	uint32_t maxFrameLen;
+	int64_t firstTsUs;
+	int64_t lastTsUs;
+} t_rover_avi;
+
+
+bool rover_avi_open( t_rover_avi * avi,
+	const t_rover_avi_sink * sink,
+	uint32_t width,
+	uint32_t height,
+	uint8_t * index,
+	uint32_t indexCapacity );
+bool rover_avi_add_frame( t_rover_avi * avi, const uint8_t * data, size_t len, int64_t tsUs );
+bool rover_avi_close( t_rover_avi * avi );
+
+static inline bool rover_avi_is_full( const t_rover_avi * avi )
+{
+	return avi->frameCount >= avi->indexCapacity;
+}
+
+
+#endif
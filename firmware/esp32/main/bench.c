@@ -0,0 +1,185 @@
+/*
+ *	Copyright (c) 2025 Denis Rozhkov <denis@rozhkoff.com>
+ *	This file is part of cam-rover.
+ *
+ *	cam-rover is free software: you can redistribute it and/or
+ *	modify it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or (at your
+ *	option) any later version.
+ *
+ *	cam-rover is distributed in the hope that it will be
+ *	useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ *	Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along with
+ *	cam-rover. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <inttypes.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "types.h"
+#include "comm.h"
+#include "tasks.h"
+#include "transport.h"
+#include "bench.h"
+
+
+#define ROVER_BENCH_ACK_TIMEOUT_MS 250
+
+#if defined( CONFIG_ROVER_BENCH_ACK_LOOPBACK ) || defined( CONFIG_ROVER_COMM_TRANSPORT_TCP )
+#define ROVER_BENCH_ACK_IN_PROCESS
+#endif
+
+
+#ifdef CONFIG_ROVER_BENCH_ACK_LATENCY
+
+static const char * roverLogTAG = "rover.bench";
+
+
+static int rover_bench_compare_u32( const void * a, const void * b )
+{
+	uint32_t va = *(const uint32_t *)a;
+	uint32_t vb = *(const uint32_t *)b;
+
+	return ( va > vb ) - ( va < vb );
+}
+
+
+static void rover_bench_log_topology( void )
+{
+	for ( t_rover_task_id id = 0; id < ROVER_TASK_COUNT; ++id ) {
+		const t_rover_task_config * task = rover_task_get_config( id );
+
+		ESP_LOGI( roverLogTAG,
+			"  %s: core %d, priority %u",
+			task->name,
+			tskNO_AFFINITY == task->coreId ? -1 : (int)task->coreId,
+			(unsigned)task->priority );
+	}
+}
+
+
+// the in-process variant measures protocol and task switch cost only, the other one adds the network stack; either
+// way the endpoint runs with the control task settings
+static bool rover_bench_ack_open( t_rover_bench * bench )
+{
+	t_rover_transport * transport = &bench->transport;
+	bench->endpoint.transport = &bench->endpointTransport;
+	bench->endpoint.taskId = ROVER_TASK_COMM_CONTROL;
+
+#ifdef ROVER_BENCH_ACK_IN_PROCESS
+	rover_transport_loopback_init( &bench->endpointTransport, transport, ROVER_COMM_ACK_LEN );
+
+	return rover_transport_open( transport ) && rover_comm_endpoint_start( &bench->endpoint );
+#else
+	rover_transport_udp_init( &bench->endpointTransport, 0 );
+	rover_transport_udp_init( transport, 0 );
+
+	if ( !rover_comm_endpoint_start( &bench->endpoint ) || !rover_transport_open( transport ) ) {
+		return false;
+	}
+
+	struct sockaddr_in addr = { 0 };
+	addr.sin_family = PF_INET;
+	addr.sin_port = htons( bench->endpointTransport.portNo );
+	addr.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+	rover_transport_set_client( transport, (struct sockaddr *)&addr, sizeof addr );
+
+	return true;
+#endif
+}
+
+
+static void rover_bench_ack_task( void * parameters )
+{
+	t_rover_bench * bench = (t_rover_bench *)parameters;
+	t_rover_transport * transport = &bench->transport;
+
+	static uint32_t samples[CONFIG_ROVER_BENCH_ACK_SAMPLES];
+	size_t sampleCount = 0;
+	size_t lostCount = 0;
+	uint32_t messageId = 0;
+	uint8_t buffer[32];
+
+	if ( !rover_bench_ack_open( bench ) ) {
+		vTaskDelete( NULL );
+		return;
+	}
+
+	while ( true ) {
+		vTaskDelay( pdMS_TO_TICKS( CONFIG_ROVER_BENCH_ACK_INTERVAL_MS ) );
+
+		size_t messageLen = rover_comm_emit_ping( buffer, sizeof buffer, ++messageId );
+
+		int64_t startTs = esp_timer_get_time();
+		rover_transport_send( transport, NULL, 0, buffer, messageLen );
+
+		bool isAcked = false;
+
+		while ( !isAcked ) {
+			int64_t remainingUs = ROVER_BENCH_ACK_TIMEOUT_MS * 1000 - ( esp_timer_get_time() - startTs );
+
+			if ( remainingUs <= 0 ) {
+				break;
+			}
+
+			if ( rover_transport_poll( transport, ( remainingUs + 999 ) / 1000 ) <= 0 ) {
+				break;
+			}
+
+			int len = rover_transport_recv( transport, buffer, sizeof buffer );
+			t_rover_comm_header header;
+
+			isAcked = len > 0 && rover_comm_parse_header( buffer, len, &header ) &&
+				ROVER_COMM_COMMAND_ACK == header.command && header.id == messageId;
+		}
+
+		if ( !isAcked ) {
+			lostCount++;
+			continue;
+		}
+
+		samples[sampleCount++] = (uint32_t)( esp_timer_get_time() - startTs );
+
+		if ( sampleCount < CONFIG_ROVER_BENCH_ACK_SAMPLES ) {
+			continue;
+		}
+
+		qsort( samples, sampleCount, sizeof samples[0], rover_bench_compare_u32 );
+
+		ESP_LOGI( roverLogTAG,
+			"%s ACK latency (us): min %" PRIu32 ", p50 %" PRIu32 ", p95 %" PRIu32 ", p99 %" PRIu32 ", max %" PRIu32
+			", lost %u",
+			transport->name,
+			samples[0],
+			samples[sampleCount / 2],
+			samples[sampleCount * 95 / 100],
+			samples[sampleCount * 99 / 100],
+			samples[sampleCount - 1],
+			(unsigned)lostCount );
+
+		rover_bench_log_topology();
+
+		sampleCount = 0;
+		lostCount = 0;
+	}
+}
+
+#endif
+
+
+void rover_bench_start( t_rover_bench * bench )
+{
+#ifdef CONFIG_ROVER_BENCH_ACK_LATENCY
+	rover_task_create( ROVER_TASK_BENCH, &rover_bench_ack_task, bench, NULL );
+#endif
+}
@@ -19,32 +19,25 @@
 // SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>
 // SPDX-License-Identifier: GPL-3.0-or-later
 
-#ifndef __ROVER__COMM_UDP__H
-#define __ROVER__COMM_UDP__H
+#ifndef __ROVER__BENCH__H
+#define __ROVER__BENCH__H
 
 
-#include <time.h>
+#include <stdint.h>
 
-#include "freertos/semphr.h"
+#include "transport.h"
+#include "comm_endpoint.h"
 
-#include "lwip/sockets.h"
 
-#include "types.h"
+typedef struct {
+	t_rover_transport transport;
+	// the rover side is an endpoint of its own without handlers, so the control client is left alone
+	t_rover_transport endpointTransport;
+	t_rover_comm_endpoint endpoint;
+} t_rover_bench;
 
 
-typedef struct {
-	int socketFd;
-	StaticSemaphore_t syncBuffer;
-	SemaphoreHandle_t sync;
-	struct sockaddr clientAddress;
-	t_rover_comm_handlers handlers;
-	struct timespec lastReceiveTs;
-	uint16_t portNo;
-} t_rover_comm_udp;
-
-
-void rover_comm_udp_send( t_rover_comm_udp * commUdp, uint8_t * data, size_t dataLen );
-uint16_t rover_comm_udp_start( t_rover_comm_udp * commUdp );
+void rover_bench_start( t_rover_bench * bench );
 
 
 #endif
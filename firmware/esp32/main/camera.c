@@ -20,6 +20,7 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 
 #include <time.h>
+#include <stdlib.h>
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -27,11 +28,17 @@
 #include "esp_system.h"
 #include "esp_log.h"
 #include "esp_camera.h"
+#include "esp_heap_caps.h"
+#include "img_converters.h"
+#include "driver/gpio.h"
 
 #include "nvs_flash.h"
 
 #include "types.h"
+#include "tasks.h"
 #include "camera.h"
+#include "pipeline.h"
+#include "dlog.h"
 
 
 #define ROVER_CAMERA_PIN_PWDN 32
@@ -90,6 +97,155 @@ static void rover_camera_flash_led_init( t_rover_camera_flash * flash )
 }
 
 
+static void rover_camera_flash_apply_duty( t_rover_camera_flash * flash, uint32_t duty )
+{
+	ledc_set_duty( flash->ledcMode, flash->ledcChannel, duty );
+	ledc_update_duty( flash->ledcMode, flash->ledcChannel );
+}
+
+
+static void rover_camera_flash_strobe_on( void * arg )
+{
+	t_rover_camera_flash * flash = (t_rover_camera_flash *)arg;
+
+	rover_camera_flash_apply_duty( flash, flash->strobeDuty );
+	esp_timer_start_once( flash->strobeOffTimer, CONFIG_ROVER_CAMERA_STROBE_US );
+}
+
+
+static void rover_camera_flash_strobe_off( void * arg )
+{
+	rover_camera_flash_apply_duty( (t_rover_camera_flash *)arg, 0 );
+}
+
+
+static bool rover_camera_flash_vsync_isr(
+	pcnt_unit_handle_t unit, const pcnt_watch_event_data_t * eventData, void * userContext )
+{
+	t_rover_camera_flash * flash = (t_rover_camera_flash *)userContext;
+
+	if ( flash->mode != ROVER_CAMERA_FLASH_MODE_CONSTANT && flash->strobeDuty > 0 ) {
+		esp_timer_start_once( flash->strobeOnTimer, 0 );
+	}
+
+	return false;
+}
+
+
+// the camera driver owns the VSYNC GPIO interrupt, so the strobe counts VSYNC edges with a PCNT unit
+// on the same pin instead; must run before esp_camera_init() so that the driver's pin setup wins
+static void rover_camera_flash_strobe_init( t_rover_camera_flash * flash )
+{
+	esp_timer_create_args_t timerArgs = { .callback = rover_camera_flash_strobe_on, .arg = flash, .name = "strobe_on" };
+	ESP_ERROR_CHECK( esp_timer_create( &timerArgs, &flash->strobeOnTimer ) );
+
+	timerArgs.callback = rover_camera_flash_strobe_off;
+	timerArgs.name = "strobe_off";
+	ESP_ERROR_CHECK( esp_timer_create( &timerArgs, &flash->strobeOffTimer ) );
+
+	pcnt_unit_config_t unitConfig = { .high_limit = 1, .low_limit = -1 };
+	ESP_ERROR_CHECK( pcnt_new_unit( &unitConfig, &flash->vsyncUnit ) );
+
+	pcnt_chan_config_t channelConfig = { .edge_gpio_num = ROVER_CAMERA_PIN_VSYNC, .level_gpio_num = -1 };
+	pcnt_channel_handle_t channel = NULL;
+	ESP_ERROR_CHECK( pcnt_new_channel( flash->vsyncUnit, &channelConfig, &channel ) );
+	ESP_ERROR_CHECK( pcnt_channel_set_edge_action(
+		channel, PCNT_CHANNEL_EDGE_ACTION_INCREASE, PCNT_CHANNEL_EDGE_ACTION_HOLD ) );
+
+	ESP_ERROR_CHECK( pcnt_unit_add_watch_point( flash->vsyncUnit, 1 ) );
+	pcnt_event_callbacks_t callbacks = { .on_reach = rover_camera_flash_vsync_isr };
+	ESP_ERROR_CHECK( pcnt_unit_register_event_callbacks( flash->vsyncUnit, &callbacks, flash ) );
+
+	ESP_ERROR_CHECK( pcnt_unit_enable( flash->vsyncUnit ) );
+	ESP_ERROR_CHECK( pcnt_unit_clear_count( flash->vsyncUnit ) );
+	ESP_ERROR_CHECK( pcnt_unit_start( flash->vsyncUnit ) );
+}
+
+
+// mean luma of a 1/8 scale decode, only the DC part of every block is reconstructed
+static void rover_camera_flash_auto_update( t_rover_camera_flash * flash, camera_fb_t * pic )
+{
+	if ( flash->mode != ROVER_CAMERA_FLASH_MODE_AUTO || pic->format != PIXFORMAT_JPEG ||
+		++flash->autoFrameCount < CONFIG_ROVER_CAMERA_FLASH_AUTO_INTERVAL ) {
+
+		return;
+	}
+
+	flash->autoFrameCount = 0;
+
+	size_t pixelCount = ( pic->width / 8 + 1 ) * ( pic->height / 8 + 1 );
+
+	if ( pixelCount * 2 > flash->autoBufferSize ) {
+		free( flash->autoBuffer );
+		flash->autoBuffer = heap_caps_malloc( pixelCount * 2, MALLOC_CAP_SPIRAM );
+		flash->autoBufferSize = NULL == flash->autoBuffer ? 0 : pixelCount * 2;
+	}
+
+	if ( NULL == flash->autoBuffer || !jpg2rgb565( pic->buf, pic->len, flash->autoBuffer, JPG_SCALE_8X ) ) {
+		return;
+	}
+
+	pixelCount = ( pic->width / 8 ) * ( pic->height / 8 );
+	uint32_t sum = 0;
+
+	for ( size_t i = 0; i < pixelCount; ++i ) {
+		uint8_t hi = flash->autoBuffer[i * 2];
+		uint8_t lo = flash->autoBuffer[i * 2 + 1];
+		uint32_t r = hi & 0xf8;
+		uint32_t g = ( ( hi & 0x07 ) << 5 ) | ( ( lo & 0xe0 ) >> 3 );
+		uint32_t b = ( lo & 0x1f ) << 3;
+		sum += ( 77 * r + 150 * g + 29 * b ) >> 8;
+	}
+
+	int32_t luma = sum / pixelCount;
+	// the set duty caps auto mode, 0 keeps the LED off as in the other modes
+	int32_t dutyMax = flash->duty;
+	int32_t duty = (int32_t)flash->strobeDuty + ( CONFIG_ROVER_CAMERA_FLASH_AUTO_TARGET - luma ) / 2;
+
+	flash->strobeDuty = duty < 0 ? 0 : ( duty > dutyMax ? dutyMax : duty );
+}
+
+
+static void rover_camera_rate_control_update( t_rover_camera * camera, camera_fb_t * pic )
+{
+#ifdef CONFIG_ROVER_CAMERA_RATE_CONTROL
+	if ( pic->format != PIXFORMAT_JPEG ) {
+		return;
+	}
+
+	uint8_t quality = camera->rateControl.quality;
+
+	if ( rover_ratectl_update( &camera->rateControl, pic->len ) != quality ) {
+		sensor_t * s = esp_camera_sensor_get();
+		s->set_quality( s, camera->rateControl.quality );
+	}
+#endif
+}
+
+
+// software JPEG stage for raw capture modes, the frame then points to the encoder output
+static bool rover_camera_encode( t_rover_camera * camera, t_rover_camera_frame * frame )
+{
+#ifdef CONFIG_ROVER_CAMERA_PARALLEL_JPEG
+	// the encoder output is reused, stages must be done with the previous frame
+	rover_pipeline_wait_released( camera->pipeline );
+
+	uint8_t * data = NULL;
+	size_t len = rover_encoder_encode( &camera->encoder, frame->ptr, frame->width, frame->height, &data );
+
+	if ( 0 == len ) {
+		return false;
+	}
+
+	frame->ptr = data;
+	frame->len = len;
+	frame->format = PIXFORMAT_JPEG;
+#endif
+
+	return true;
+}
+
+
 static esp_err_t rover_camera_init( camera_config_t * config )
 {
 	ROVER_CAMER_SET_DEFAULT( config->pin_pwdn, ROVER_CAMERA_PIN_PWDN );
@@ -111,10 +267,16 @@ static esp_err_t rover_camera_init( camera_config_t * config )
 	ROVER_CAMER_SET_DEFAULT( config->xclk_freq_hz, ROVER_CAMERA_XCLK_FREQ_HZ );
 	ROVER_CAMER_SET_DEFAULT( config->ledc_timer, LEDC_TIMER_0 );
 	ROVER_CAMER_SET_DEFAULT( config->ledc_channel, LEDC_CHANNEL_0 );
+#if defined( CONFIG_ROVER_CAMERA_TILES ) || defined( CONFIG_ROVER_CAMERA_RAW_RGB565 )
+	// PIXFORMAT_RGB565 is 0 and would be replaced by the default below
+	config->pixel_format = PIXFORMAT_RGB565;
+#elif defined( CONFIG_ROVER_CAMERA_RAW_GRAYSCALE )
+	config->pixel_format = PIXFORMAT_GRAYSCALE;
+#endif
 	ROVER_CAMER_SET_DEFAULT( config->pixel_format, PIXFORMAT_JPEG );
-	ROVER_CAMER_SET_DEFAULT( config->frame_size, FRAMESIZE_VGA );
-	ROVER_CAMER_SET_DEFAULT( config->jpeg_quality, 4 );
-	ROVER_CAMER_SET_DEFAULT( config->fb_count, 2 );
+	ROVER_CAMER_SET_DEFAULT( config->frame_size, ROVER_CAMERA_FRAME_SIZE_DEFAULT );
+	ROVER_CAMER_SET_DEFAULT( config->jpeg_quality, ROVER_CAMERA_JPEG_QUALITY_DEFAULT );
+	ROVER_CAMER_SET_DEFAULT( config->fb_count, CONFIG_ROVER_CAMERA_FB_COUNT );
 	ROVER_CAMER_SET_DEFAULT( config->fb_location, CAMERA_FB_IN_PSRAM );
 	ROVER_CAMER_SET_DEFAULT( config->grab_mode, CAMERA_GRAB_WHEN_EMPTY );
 
@@ -129,36 +291,169 @@ static esp_err_t rover_camera_init( camera_config_t * config )
 }
 
 
+#ifdef CONFIG_ROVER_CAMERA_IDLE
+// the driver sets PWDN up as an output and drives it low on init, the sensor keeps its registers in power down
+static void rover_camera_set_standby( t_rover_camera * camera, bool isStandby )
+{
+	if ( camera->config.pin_pwdn >= 0 ) {
+		gpio_set_level( camera->config.pin_pwdn, isStandby ? 1 : 0 );
+	}
+
+	// a constant flash would keep lighting up an idle rover, strobes stop with VSYNC anyway
+	if ( ROVER_CAMERA_FLASH_MODE_CONSTANT == camera->flash.mode ) {
+		rover_camera_flash_apply_duty( &camera->flash, isStandby ? 0 : camera->flash.duty );
+	}
+}
+
+
+// blocks until there is demand again; standby is reapplied on every timeout, a reinitialization in the
+// meantime (frame size change, sweep) powers the sensor up
+static void rover_camera_idle( t_rover_camera * camera )
+{
+	camera->isIdle = true;
+	camera->stats.fps = 0;
+	camera->stats.load = 0;
+	ROVER_DLOGI( roverLogTAG, "no demand, standby" );
+
+	// checked after isIdle is set, so that a wake in between is not missed
+	while ( !camera->demand( camera->demandContext ) ) {
+		xSemaphoreTake( camera->sync, portMAX_DELAY );
+		rover_camera_set_standby( camera, true );
+		xSemaphoreGive( camera->sync );
+
+		ulTaskNotifyTake( pdTRUE, pdMS_TO_TICKS( CONFIG_ROVER_CAMERA_IDLE_TIMEOUT_MS ) );
+	}
+
+	xSemaphoreTake( camera->sync, portMAX_DELAY );
+	rover_camera_set_standby( camera, false );
+	camera->isIdle = false;
+	xSemaphoreGive( camera->sync );
+}
+#endif
+
+
 static void rover_camera_task( void * parameters )
 {
 	t_rover_camera * camera = (t_rover_camera *)parameters;
 
 	clock_t startTs = 0;
 	size_t frameCount = 0;
+	int64_t fbWaitUs = 0;
+	// standby exit, 0 once a frame has been published after it
+	int64_t resumeTs = 0;
 
 	while ( true ) {
+		// the mutex alone would be taken right back by this task, it does not hand over to a waiter
+		while ( camera->isPaused ) {
+			vTaskDelay( pdMS_TO_TICKS( 10 ) );
+		}
+
+#ifdef CONFIG_ROVER_CAMERA_IDLE
+		if ( camera->demand != NULL && !camera->demand( camera->demandContext ) ) {
+			rover_camera_idle( camera );
+			resumeTs = esp_timer_get_time();
+			startTs = 0;
+			continue;
+		}
+#endif
+
+		xSemaphoreTake( camera->sync, portMAX_DELAY );
+
 		if ( 0 == startTs ) {
 			startTs = clock();
 			frameCount = 0;
+			fbWaitUs = 0;
 		}
 
 		// ESP_LOGI( TAG, "Taking picture..." );
+		// waits longer than the frame period mean pipeline stages still hold all frame buffers
+		int64_t fbGetUs = esp_timer_get_time();
 		camera_fb_t * pic = esp_camera_fb_get();
+		fbWaitUs += esp_timer_get_time() - fbGetUs;
+
+		if ( NULL == pic ) {
+			xSemaphoreGive( camera->sync );
+			continue;
+		}
+
+		int64_t timestampUs = (int64_t)pic->timestamp.tv_sec * 1000000 + pic->timestamp.tv_usec;
+
+		// frames grabbed before the standby are still queued in the driver
+		if ( timestampUs < resumeTs ) {
+			esp_camera_fb_return( pic );
+			xSemaphoreGive( camera->sync );
+			continue;
+		}
+
+		camera->stats.width = pic->width;
+		camera->stats.height = pic->height;
+
+		rover_camera_flash_auto_update( &camera->flash, pic );
+		rover_camera_rate_control_update( camera, pic );
 
 		// use pic->buf to access the image
 		// ESP_LOGI(TAG, "Picture taken! Its size was: %zu bytes", pic->len);
-		ROVER_CALL( camera->frameHandler, &( t_rover_camera_frame ){ .ptr = pic->buf, .len = pic->len } );
+		t_rover_camera_frame frame = { .ptr = pic->buf,
+			.len = pic->len,
+			.width = pic->width,
+			.height = pic->height,
+			.format = pic->format,
+			.timestampUs = timestampUs };
+
+		if ( NULL == camera->pipeline || !rover_camera_encode( camera, &frame ) ) {
+			esp_camera_fb_return( pic );
+		}
+		else if ( frame.ptr != pic->buf ) {
+			// encoded copy, the raw frame is not needed anymore
+			esp_camera_fb_return( pic );
+			rover_pipeline_publish( camera->pipeline, &frame, NULL );
+		}
+		else {
+			rover_pipeline_publish( camera->pipeline, &frame, pic );
+		}
 
-		esp_camera_fb_return( pic );
+		if ( resumeTs != 0 ) {
+			camera->stats.resumeUs = esp_timer_get_time() - resumeTs;
+			ROVER_DLOGI( roverLogTAG, "resumed in %u us", (unsigned)camera->stats.resumeUs );
+			resumeTs = 0;
+		}
 
 		frameCount++;
 		clock_t elapsed = clock() - startTs;
 
 		if ( ( elapsed / CLOCKS_PER_SEC ) > 5 ) {
-			ESP_LOGI( roverLogTAG, "FPS:  %d", (int)( frameCount * 1000 / elapsed ) );
+			int64_t elapsedUs = (int64_t)elapsed * 1000000 / CLOCKS_PER_SEC;
+			camera->stats.fps = frameCount * CLOCKS_PER_SEC / elapsed;
+			camera->stats.load = fbWaitUs < elapsedUs ? 100 - fbWaitUs * 100 / elapsedUs : 0;
+
+			uint32_t flashDuty =
+				ROVER_CAMERA_FLASH_MODE_CONSTANT == camera->flash.mode ? camera->flash.duty : camera->flash.strobeDuty;
+
+			ROVER_DLOGI( roverLogTAG,
+				"FPS:  %d, fb wait %u us, flash mode %d, duty %u",
+				(int)( frameCount * 1000 / elapsed ),
+				(unsigned)( fbWaitUs / frameCount ),
+				(int)camera->flash.mode,
+				(unsigned)flashDuty );
+
+#ifdef CONFIG_ROVER_CAMERA_RATE_CONTROL
+			ROVER_DLOGI( roverLogTAG,
+				"quality %u, avg size %u, budget %u, over budget %u/%u",
+				(unsigned)camera->rateControl.quality,
+				(unsigned)camera->rateControl.sizeAvg,
+				(unsigned)camera->rateControl.budget,
+				(unsigned)camera->rateControl.overBudgetCount,
+				(unsigned)camera->rateControl.frameCount );
+
+			camera->rateControl.overBudgetCount = 0;
+			camera->rateControl.frameCount = 0;
+#endif
+
 			startTs = 0;
 		}
 
+		xSemaphoreGive( camera->sync );
+
 		// vTaskDelay( 5000 / portTICK_RATE_MS );
 	}
 }
@@ -166,15 +461,169 @@ static void rover_camera_task( void * parameters )
 
 void rover_camera_set_flash_duty( t_rover_camera * camera, uint32_t duty )
 {
-	ledc_set_duty( camera->flash.ledcMode, camera->flash.ledcChannel, duty );
-	ledc_update_duty( camera->flash.ledcMode, camera->flash.ledcChannel );
+	t_rover_camera_flash * flash = &camera->flash;
+	flash->duty = duty;
+
+	if ( ROVER_CAMERA_FLASH_MODE_CONSTANT == flash->mode ) {
+		rover_camera_flash_apply_duty( flash, camera->isIdle ? 0 : duty );
+	}
+	else if ( ROVER_CAMERA_FLASH_MODE_STROBE == flash->mode || flash->strobeDuty > duty ) {
+		flash->strobeDuty = duty;
+	}
+}
+
+
+void rover_camera_set_flash_mode( t_rover_camera * camera, t_rover_camera_flash_mode mode )
+{
+	t_rover_camera_flash * flash = &camera->flash;
+	sensor_t * s = esp_camera_sensor_get();
+
+	flash->strobeDuty = flash->duty;
+	flash->mode = mode;
+
+	// no sensor while the camera is being reinitialized, rover_camera_reinit applies the mode afterwards
+	if ( ROVER_CAMERA_FLASH_MODE_CONSTANT == mode ) {
+		if ( s != NULL ) {
+			s->set_exposure_ctrl( s, 1 );
+		}
+
+		rover_camera_flash_apply_duty( flash, camera->isIdle ? 0 : flash->duty );
+	}
+	else {
+		// the strobe provides the light, so keep the exposure short instead of letting AEC stretch it
+		if ( s != NULL ) {
+			s->set_exposure_ctrl( s, 0 );
+			s->set_aec_value( s, CONFIG_ROVER_CAMERA_STROBE_AEC_VALUE );
+		}
+
+		rover_camera_flash_apply_duty( flash, 0 );
+	}
+}
+
+
+void rover_camera_set_frame_budget( t_rover_camera * camera, uint32_t budget )
+{
+	rover_ratectl_set_budget( &camera->rateControl, budget );
+}
+
+
+static void rover_camera_rate_control_init( t_rover_camera * camera, uint32_t budget, uint8_t quality )
+{
+	rover_ratectl_init( &camera->rateControl,
+		budget,
+		quality,
+		CONFIG_ROVER_CAMERA_RATE_QUALITY_MIN,
+		CONFIG_ROVER_CAMERA_RATE_QUALITY_MAX,
+		CONFIG_ROVER_CAMERA_RATE_STEP_MAX,
+		CONFIG_ROVER_CAMERA_RATE_DELAY );
 }
 
 
 void rover_camera_start( t_rover_camera * camera )
 {
-	rover_camera_init( &camera->config );
+	camera->sync = xSemaphoreCreateMutexStatic( &camera->syncBuffer );
+
 	rover_camera_flash_led_init( &camera->flash );
+	rover_camera_flash_strobe_init( &camera->flash );
+	rover_camera_init( &camera->config );
+	rover_camera_rate_control_init( camera, CONFIG_ROVER_CAMERA_FRAME_BUDGET, camera->config.jpeg_quality );
+
+#ifdef CONFIG_ROVER_CAMERA_PARALLEL_JPEG
+	rover_encoder_start( &camera->encoder,
+		PIXFORMAT_GRAYSCALE == camera->config.pixel_format ? ROVER_JPEG_FORMAT_GRAYSCALE : ROVER_JPEG_FORMAT_RGB565,
+		CONFIG_ROVER_CAMERA_JPEG_QUALITY );
+#endif
+
+	rover_task_create( ROVER_TASK_CAMERA, &rover_camera_task, camera, &camera->task );
+}
+
+
+void rover_camera_wake( t_rover_camera * camera )
+{
+	if ( camera->isIdle && camera->task != NULL ) {
+		xTaskNotifyGive( camera->task );
+	}
+}
+
+
+// stops the camera task after its current frame and waits until the pipeline stages are done with their frames
+void rover_camera_pause( t_rover_camera * camera )
+{
+	camera->isPaused = true;
+	xSemaphoreTake( camera->sync, portMAX_DELAY );
+
+	if ( camera->pipeline != NULL ) {
+		rover_pipeline_wait_released( camera->pipeline );
+	}
+}
+
+
+void rover_camera_resume( t_rover_camera * camera )
+{
+	xSemaphoreGive( camera->sync );
+	camera->isPaused = false;
+}
+
+
+// the camera has to be paused
+void rover_camera_deinit( t_rover_camera * camera )
+{
+	esp_camera_deinit();
+}
+
+
+// the camera has to be paused and deinitialized, camera->config is left as it is so that it can be restored
+esp_err_t rover_camera_reinit( t_rover_camera * camera, const camera_config_t * config )
+{
+	camera_config_t c = *config;
+	esp_err_t err = rover_camera_init( &c );
+
+	if ( err != ESP_OK ) {
+		return err;
+	}
+
+	// sensor registers are reset, apply what the flash mode and rate control set up again
+	rover_camera_set_flash_mode( camera, camera->flash.mode );
+	rover_camera_rate_control_init( camera, camera->rateControl.budget, c.jpeg_quality );
+
+	return ESP_OK;
+}
+
+
+void rover_camera_set_jpeg_quality( t_rover_camera * camera, uint8_t quality )
+{
+	rover_camera_pause( camera );
+
+	camera->config.jpeg_quality = quality;
+	sensor_t * s = esp_camera_sensor_get();
+
+	if ( s != NULL ) {
+		s->set_quality( s, quality );
+	}
+
+	rover_camera_rate_control_init( camera, camera->rateControl.budget, quality );
+
+	rover_camera_resume( camera );
+}
+
+
+// the frame buffers are sized for the frame size at init, so a change takes a reinitialization
+esp_err_t rover_camera_set_frame_size( t_rover_camera * camera, framesize_t frameSize )
+{
+	rover_camera_pause( camera );
+	rover_camera_deinit( camera );
+
+	framesize_t previous = camera->config.frame_size;
+	camera->config.frame_size = frameSize;
+	esp_err_t err = rover_camera_reinit( camera, &camera->config );
+
+	if ( err != ESP_OK ) {
+		ESP_LOGE( roverLogTAG, "frame size %d failed: 0x%x", (int)frameSize, err );
+		camera->config.frame_size = previous;
+		rover_camera_reinit( camera, &camera->config );
+	}
+
+	rover_camera_resume( camera );
 
-	xTaskCreate( &rover_camera_task, "rover_camera_task", 4096, camera, 5, NULL );
+	return err;
 }
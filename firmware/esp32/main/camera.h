@@ -23,30 +23,102 @@
 #define __ROVER__CAMERA__H
 
 
+#include <stdbool.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
 #include "esp_camera.h"
+#include "esp_timer.h"
+#include "driver/pulse_cnt.h"
+
+#include "ratectl.h"
+#include "encoder.h"
 
 
+#define ROVER_CAMERA_FRAME_SIZE_DEFAULT FRAMESIZE_VGA
+#define ROVER_CAMERA_JPEG_QUALITY_DEFAULT 4
+
 typedef struct {
 	uint8_t * ptr;
 	size_t len;
+	uint32_t width;
+	uint32_t height;
+	pixformat_t format;
+	int64_t timestampUs;
 } t_rover_camera_frame;
 
-typedef void ( *t_rover_camera_handler_frame )( t_rover_camera_frame * );
+struct t_rover_pipeline;
+
+// refreshed by the camera task, read without locking by whoever reports them
+typedef struct {
+	volatile uint16_t width;
+	volatile uint16_t height;
+	volatile uint16_t fps;
+	// share of the frame period spent on anything but waiting for the sensor, percent
+	volatile uint8_t load;
+	// last standby exit to the first frame published after it, us
+	volatile uint32_t resumeUs;
+} t_rover_camera_stats;
+
+// asked before every frame, nobody wanting frames puts the camera into standby until rover_camera_wake()
+typedef bool ( *t_rover_camera_handler_demand )( void * context );
+
+typedef enum {
+	ROVER_CAMERA_FLASH_MODE_CONSTANT = 0,
+	ROVER_CAMERA_FLASH_MODE_STROBE,
+	ROVER_CAMERA_FLASH_MODE_AUTO
+} t_rover_camera_flash_mode;
 
 typedef struct {
 	ledc_mode_t ledcMode;
 	ledc_channel_t ledcChannel;
+	t_rover_camera_flash_mode mode;
+	uint32_t duty;
+	uint32_t strobeDuty;
+	pcnt_unit_handle_t vsyncUnit;
+	esp_timer_handle_t strobeOnTimer;
+	esp_timer_handle_t strobeOffTimer;
+	uint8_t * autoBuffer;
+	size_t autoBufferSize;
+	size_t autoFrameCount;
 } t_rover_camera_flash;
 
 typedef struct {
 	camera_config_t config;
-	t_rover_camera_handler_frame frameHandler;
+	struct t_rover_pipeline * pipeline;
 	t_rover_camera_flash flash;
+	t_rover_ratectl rateControl;
+	t_rover_encoder encoder;
+	t_rover_camera_stats stats;
+	// held by the camera task for every captured frame, taken by whoever needs the sensor for itself
+	SemaphoreHandle_t sync;
+	StaticSemaphore_t syncBuffer;
+	volatile bool isPaused;
+	// NULL captures all the time
+	t_rover_camera_handler_demand demand;
+	void * demandContext;
+	TaskHandle_t task;
+	volatile bool isIdle;
 } t_rover_camera;
 
 
 void rover_camera_set_flash_duty( t_rover_camera * camera, uint32_t duty );
+void rover_camera_set_flash_mode( t_rover_camera * camera, t_rover_camera_flash_mode mode );
+void rover_camera_set_frame_budget( t_rover_camera * camera, uint32_t budget );
+// both hold the camera task meanwhile; the quality is where rate control starts from
+void rover_camera_set_jpeg_quality( t_rover_camera * camera, uint8_t quality );
+// reinitializes the camera, the previous size is restored on failure
+esp_err_t rover_camera_set_frame_size( t_rover_camera * camera, framesize_t frameSize );
 void rover_camera_start( t_rover_camera * camera );
+// cheap while capturing, so it can be called for every message of a would-be consumer
+void rover_camera_wake( t_rover_camera * camera );
+
+void rover_camera_pause( t_rover_camera * camera );
+void rover_camera_resume( t_rover_camera * camera );
+void rover_camera_deinit( t_rover_camera * camera );
+esp_err_t rover_camera_reinit( t_rover_camera * camera, const camera_config_t * config );
 
 
 #endif
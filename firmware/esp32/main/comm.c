@@ -0,0 +1,109 @@
+/*
+ *	Copyright (c) 2025 Denis Rozhkov <denis@rozhkoff.com>
+ *	This file is part of cam-rover.
+ *
+ *	cam-rover is free software: you can redistribute it and/or
+ *	modify it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or (at your
+ *	option) any later version.
+ *
+ *	cam-rover is distributed in the hope that it will be
+ *	useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ *	Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along with
+ *	cam-rover. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "comm.h"
+
+
+// parses a control message and calls the handlers, motorsSpeed tracks what the move handlers returned;
+// returns true if the message has to be acknowledged
+bool rover_comm_handle_message( const t_rover_comm_handlers * handlers,
+	t_rover_motors_speed * motorsSpeed,
+	const uint8_t * message,
+	size_t len,
+	uint32_t * messageId )
+{
+	t_rover_comm_header header;
+
+	// too short for its command means garbage, unknown commands are still acknowledged
+	if ( !rover_comm_parse_header( message, len, &header ) || len < rover_comm_command_len( header.command ) ) {
+		return false;
+	}
+
+	*messageId = header.id;
+	t_rover_comm_command cmd = header.command;
+
+	t_rover_comm_move_speed moveSpeed;
+	t_rover_comm_move_set moveSet;
+	t_rover_comm_move_deadzone moveDeadzone;
+	t_rover_comm_move_autonomous moveAutonomous;
+	t_rover_comm_camera_flash cameraFlash;
+	t_rover_comm_camera_flash_mode cameraFlashMode;
+
+	if ( rover_comm_parse_move_speed( message, len, &moveSpeed ) ) {
+		int32_t speed = moveSpeed.speed;
+
+		if ( ROVER_COMM_COMMAND_MOVE_SPEED_UP == cmd ) {
+			ROVER_CALL_FUNC( handlers->move.speed, *motorsSpeed, speed );
+		}
+		else if ( ROVER_COMM_COMMAND_MOVE_SPEED_DOWN == cmd ) {
+			ROVER_CALL_FUNC( handlers->move.speed, *motorsSpeed, -speed );
+		}
+		else if ( ROVER_COMM_COMMAND_MOVE_TURN_LEFT == cmd ) {
+			ROVER_CALL_FUNC( handlers->move.turn, *motorsSpeed, -speed, speed );
+		}
+		else {
+			ROVER_CALL_FUNC( handlers->move.turn, *motorsSpeed, speed, -speed );
+		}
+	}
+	else if ( rover_comm_parse_move_set( message, len, &moveSet ) ) {
+		ROVER_CALL_FUNC( handlers->move.set, *motorsSpeed, moveSet.speedL, moveSet.speedR );
+	}
+	else if ( ROVER_COMM_COMMAND_MOVE_STOP == cmd ) {
+		ROVER_CALL( handlers->move.stop );
+		motorsSpeed->motor1 = 0;
+		motorsSpeed->motor2 = 0;
+	}
+	else if ( rover_comm_parse_move_deadzone( message, len, &moveDeadzone ) ) {
+		ROVER_CALL( handlers->move.deadzone, moveDeadzone.deadzone );
+	}
+	else if ( rover_comm_parse_move_autonomous( message, len, &moveAutonomous ) ) {
+		ROVER_CALL( handlers->move.autonomous, moveAutonomous.isEnabled );
+	}
+	else if ( rover_comm_parse_camera_flash( message, len, &cameraFlash ) ) {
+		ROVER_CALL( handlers->camera.flash, cameraFlash.duty );
+	}
+	else if ( rover_comm_parse_camera_flash_mode( message, len, &cameraFlashMode ) ) {
+		ROVER_CALL( handlers->camera.flashMode, cameraFlashMode.mode );
+	}
+	else if ( ROVER_COMM_COMMAND_ACK == cmd ) {
+		return false;
+	}
+
+	return true;
+}
+
+
+// buffer has to hold ROVER_COMM_ACK_LEN bytes, returns the ACK length
+size_t rover_comm_build_ack( uint8_t * buffer,
+	uint32_t messageId,
+	const t_rover_motors_speed * motorsSpeed,
+	int64_t appliedUs,
+	uint32_t sessionToken )
+{
+	t_rover_comm_ack ack = {
+		.motor1 = motorsSpeed->motor1,
+		.motor2 = motorsSpeed->motor2,
+		.appliedUs = appliedUs,
+		.sessionToken = sessionToken,
+	};
+
+	return rover_comm_emit_ack( buffer, ROVER_COMM_ACK_LEN, messageId, &ack );
+}
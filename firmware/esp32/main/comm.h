@@ -23,71 +23,22 @@
 #define __ROVER__COMM__H
 
 
-#include "types.h"
-
-
-#define ROVER_COMM_U32( a_message, a_index )                                                                           \
-	( ( (uint32_t)( a_message )[a_index] ) | ( (uint32_t)( a_message )[a_index + 1] << 8 ) |                           \
-		( (uint32_t)( a_message )[a_index + 2] << 16 ) | ( (uint32_t)( a_message )[a_index + 3] << 24 ) )
-
-// 0 - message len
-// 1-4 - message ID
-// 5 - message type (command)
-#define ROVER_COMM_MESSAGE_PAYLOAD_LEN( a_message ) ( ( a_message )[0] )
-#define ROVER_COMM_MESSAGE_ID( a_message ) ROVER_COMM_U32( a_message, 1 )
-#define ROVER_COMM_MESSAGE_COMMAND( a_message ) ( ( a_message )[5] )
-#define ROVER_COMM_MESSAGE_MOVE_SPEED( a_message ) ( ( a_message )[6] )
-#define ROVER_COMM_MESSAGE_MOVE_SPEED_L( a_message ) ( (int32_t)ROVER_COMM_U32( a_message, 6 ) )
-#define ROVER_COMM_MESSAGE_MOVE_SPEED_R( a_message ) ( (int32_t)ROVER_COMM_U32( a_message, 10 ) )
-#define ROVER_COMM_MESSAGE_MOVE_DEADZONE( a_message ) ROVER_COMM_U32( a_message, 6 )
-#define ROVER_COMM_MESSAGE_CAMERA_FLASH_DUTY( a_message ) ( ( a_message )[6] )
-
-
-typedef enum {
-	ROVER_COMM_COMMAND_UNKNOWN = 0,
-	ROVER_COMM_COMMAND_MOVE_SPEED_UP = '+',
-	ROVER_COMM_COMMAND_MOVE_SPEED_DOWN = '-',
-	ROVER_COMM_COMMAND_MOVE_TURN_LEFT = 'l',
-	ROVER_COMM_COMMAND_MOVE_TURN_RIGHT = 'r',
-	ROVER_COMM_COMMAND_MOVE_STOP = 's',
-	ROVER_COMM_COMMAND_MOVE_SET = 't',
-	ROVER_COMM_COMMAND_MOVE_DEADZONE = 'z',
-	ROVER_COMM_COMMAND_CAMERA_FLASH = 'f',
-	ROVER_COMM_COMMAND_ACK = 'a'
-} t_rover_comm_command;
-
-
-inline void rover_comm_message_serialzie_u32( t_rover_buffer * message, uint32_t v )
-{
-	message->data[message->pos++] = v & 0xff;
-	message->data[message->pos++] = ( v >> 8 ) & 0xff;
-	message->data[message->pos++] = ( v >> 16 ) & 0xff;
-	message->data[message->pos++] = ( v >> 24 ) & 0xff;
-	message->len = message->pos;
-}
+#include <stdbool.h>
 
-
-inline void rover_comm_message_serialzie_id( t_rover_buffer * message, uint32_t messageId )
-{
-	rover_comm_message_serialzie_u32( message, messageId );
-}
-
-
-inline void rover_comm_message_init(
-	t_rover_buffer * message, uint8_t * buffer, t_rover_comm_command cmd, uint32_t messageId )
-{
-
-	message->pos = 1;
-	message->data = buffer;
-	rover_comm_message_serialzie_id( message, messageId );
-	message->data[message->pos++] = cmd;
-}
-
-
-inline void rover_comm_message_update_payload_len( t_rover_buffer * message )
-{
-	message->data[0] = message->len - 1;
-}
+#include "types.h"
+#include "comm_protocol.h"
+
+
+bool rover_comm_handle_message( const t_rover_comm_handlers * handlers,
+	t_rover_motors_speed * motorsSpeed,
+	const uint8_t * message,
+	size_t len,
+	uint32_t * messageId );
+size_t rover_comm_build_ack( uint8_t * buffer,
+	uint32_t messageId,
+	const t_rover_motors_speed * motorsSpeed,
+	int64_t appliedUs,
+	uint32_t sessionToken );
 
 
 #endif
@@ -0,0 +1,133 @@
+/*
+ *	Copyright (c) 2025 Denis Rozhkov <denis@rozhkoff.com>
+ *	This file is part of cam-rover.
+ *
+ *	cam-rover is free software: you can redistribute it and/or
+ *	modify it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or (at your
+ *	option) any later version.
+ *
+ *	cam-rover is distributed in the hope that it will be
+ *	useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ *	Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along with
+ *	cam-rover. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "comm.h"
+#include "comm_endpoint.h"
+#include "pool.h"
+
+
+// without any message for this long the last client still gets an ACK with the current speeds
+#define ROVER_COMM_ENDPOINT_KEEPALIVE_MS 2000
+// longest message taken, anything longer is truncated and fails the length check
+#define ROVER_COMM_ENDPOINT_RECV_LEN 32
+
+
+static const char * roverLogTAG = "rover.comm";
+
+
+static void rover_comm_endpoint_task( void * pvParameters )
+{
+	t_rover_comm_endpoint * endpoint = (t_rover_comm_endpoint *)pvParameters;
+	t_rover_transport * transport = endpoint->transport;
+	// held for the life of the task, see the "Buffer pools" Kconfig menu
+	t_rover_ptr * buffer = rover_pool_alloc( ROVER_POOL_NET, ROVER_COMM_ENDPOINT_RECV_LEN );
+	t_rover_ptr * ack = rover_pool_alloc( ROVER_POOL_NET, ROVER_COMM_ACK_LEN );
+	t_rover_motors_speed motorsSpeed = { 0 };
+
+	if ( NULL == buffer || NULL == ack ) {
+		ESP_LOGE( roverLogTAG, "no buffers for %s port: %d", transport->name, (int)transport->portNo );
+		rover_pool_release( buffer );
+		rover_pool_release( ack );
+		vTaskDelete( NULL );
+
+		return;
+	}
+
+	ESP_LOGI( roverLogTAG, "listening on %s port: %d", transport->name, (int)transport->portNo );
+
+	while ( true ) {
+		int s = rover_transport_poll( transport, ROVER_COMM_ENDPOINT_KEEPALIVE_MS );
+
+		if ( s < 0 ) {
+			vTaskDelay( pdMS_TO_TICKS( 100 ) );
+			continue;
+		}
+
+		uint32_t messageId = 0;
+		bool shouldSendAck = true;
+
+		if ( s > 0 ) {
+			int len = rover_transport_recv( transport, buffer->data, ROVER_COMM_ENDPOINT_RECV_LEN - 1 );
+
+			if ( len <= 0 ) {
+				continue;
+			}
+
+			__atomic_store_n( &endpoint->lastReceiveUs, esp_timer_get_time(), __ATOMIC_RELAXED );
+
+			if ( endpoint->handlerReceive != NULL ) {
+				endpoint->handlerReceive( endpoint->handlerReceiveContext );
+			}
+
+			shouldSendAck = rover_comm_handle_message( &endpoint->handlers, &motorsSpeed, buffer->data, len, &messageId );
+		}
+
+		int64_t appliedUs = esp_timer_get_time();
+
+		if ( shouldSendAck && transport->hasClient ) {
+			size_t ackLen = rover_comm_build_ack( ack->data, messageId, &motorsSpeed, appliedUs, endpoint->sessionToken );
+			rover_transport_send( transport, NULL, 0, ack->data, ackLen );
+		}
+	}
+}
+
+
+bool rover_comm_endpoint_send( t_rover_comm_endpoint * endpoint, uint8_t * data, size_t dataLen )
+{
+	return rover_transport_send( endpoint->transport, NULL, 0, data, dataLen );
+}
+
+
+// sends header and data as one message without copying them together
+bool rover_comm_endpoint_send_with_header(
+	t_rover_comm_endpoint * endpoint, uint8_t * header, size_t headerLen, uint8_t * data, size_t dataLen )
+{
+	return rover_transport_send( endpoint->transport, header, headerLen, data, dataLen );
+}
+
+
+// the port number is in endpoint->transport->portNo afterwards, loopback transports have none
+bool rover_comm_endpoint_start( t_rover_comm_endpoint * endpoint )
+{
+	if ( !rover_transport_open( endpoint->transport ) ) {
+		return false;
+	}
+
+	return rover_task_create( endpoint->taskId, &rover_comm_endpoint_task, endpoint, NULL ) == pdPASS;
+}
+
+
+// time since the last message received, UINT32_MAX if there has not been any yet
+uint32_t rover_comm_endpoint_get_idle_ms( const t_rover_comm_endpoint * endpoint )
+{
+	int64_t lastUs = __atomic_load_n( &endpoint->lastReceiveUs, __ATOMIC_RELAXED );
+
+	if ( 0 == lastUs ) {
+		return UINT32_MAX;
+	}
+
+	int64_t ms = ( esp_timer_get_time() - lastUs ) / 1000;
+
+	return ms < 0 ? 0 : ( ms > UINT32_MAX ? UINT32_MAX : (uint32_t)ms );
+}
@@ -0,0 +1,56 @@
+/*
+ *	Copyright (c) 2025 Denis Rozhkov <denis@rozhkoff.com>
+ *	This file is part of cam-rover.
+ *
+ *	cam-rover is free software: you can redistribute it and/or
+ *	modify it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or (at your
+ *	option) any later version.
+ *
+ *	cam-rover is distributed in the hope that it will be
+ *	useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ *	Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along with
+ *	cam-rover. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef __ROVER__COMM_ENDPOINT__H
+#define __ROVER__COMM_ENDPOINT__H
+
+
+#include "types.h"
+#include "tasks.h"
+#include "transport.h"
+
+
+// called by the endpoint task for every message received, after lastReceiveUs is updated
+typedef void ( *t_rover_comm_endpoint_handler_receive )( void * context );
+
+// runs the control protocol over a transport, the stream endpoint uses it for client keep-alives only
+typedef struct {
+	t_rover_transport * transport;
+	t_rover_comm_handlers handlers;
+	t_rover_comm_endpoint_handler_receive handlerReceive;
+	void * handlerReceiveContext;
+	// esp_timer time of the last message, 0 before the first; written by the endpoint task, read by others, so
+	// only through __atomic builtins
+	int64_t lastReceiveUs;
+	// changes with every boot, a client seeing the same token after a gap knows the rover kept its state
+	uint32_t sessionToken;
+	t_rover_task_id taskId;
+} t_rover_comm_endpoint;
+
+
+bool rover_comm_endpoint_send( t_rover_comm_endpoint * endpoint, uint8_t * data, size_t dataLen );
+bool rover_comm_endpoint_send_with_header(
+	t_rover_comm_endpoint * endpoint, uint8_t * header, size_t headerLen, uint8_t * data, size_t dataLen );
+bool rover_comm_endpoint_start( t_rover_comm_endpoint * endpoint );
+uint32_t rover_comm_endpoint_get_idle_ms( const t_rover_comm_endpoint * endpoint );
+
+
+#endif
@@ -0,0 +1,601 @@
+/*
+ *	Copyright (c) 2025 Denis Rozhkov <denis@rozhkoff.com>
+ *	This file is part of cam-rover.
+ *
+ *	cam-rover is free software: you can redistribute it and/or
+ *	modify it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or (at your
+ *	option) any later version.
+ *
+ *	cam-rover is distributed in the hope that it will be
+ *	useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ *	Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along with
+ *	cam-rover. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+// generated by protocol/protogen.py from protocol/protocol.json, do not edit
+
+#include "comm_protocol.h"
+
+
+static inline uint16_t rover_comm_get_u16( const uint8_t * p )
+{
+	uint16_t v = 0;
+
+	for ( int i = 1; i >= 0; i-- ) {
+		v = ( v << 8 ) | p[i];
+	}
+
+	return v;
+}
+
+
+static inline void rover_comm_put_u16( uint8_t * p, uint16_t value )
+{
+	uint16_t v = value;
+
+	for ( int i = 0; i < 2; i++ ) {
+		p[i] = v & 0xff;
+		v >>= 8;
+	}
+}
+
+
+static inline uint32_t rover_comm_get_u32( const uint8_t * p )
+{
+	uint32_t v = 0;
+
+	for ( int i = 3; i >= 0; i-- ) {
+		v = ( v << 8 ) | p[i];
+	}
+
+	return v;
+}
+
+
+static inline void rover_comm_put_u32( uint8_t * p, uint32_t value )
+{
+	uint32_t v = value;
+
+	for ( int i = 0; i < 4; i++ ) {
+		p[i] = v & 0xff;
+		v >>= 8;
+	}
+}
+
+
+static inline int32_t rover_comm_get_i32( const uint8_t * p )
+{
+	uint32_t v = 0;
+
+	for ( int i = 3; i >= 0; i-- ) {
+		v = ( v << 8 ) | p[i];
+	}
+
+	return (int32_t)v;
+}
+
+
+static inline void rover_comm_put_i32( uint8_t * p, int32_t value )
+{
+	uint32_t v = (uint32_t)value;
+
+	for ( int i = 0; i < 4; i++ ) {
+		p[i] = v & 0xff;
+		v >>= 8;
+	}
+}
+
+
+static inline int64_t rover_comm_get_i64( const uint8_t * p )
+{
+	uint64_t v = 0;
+
+	for ( int i = 7; i >= 0; i-- ) {
+		v = ( v << 8 ) | p[i];
+	}
+
+	return (int64_t)v;
+}
+
+
+static inline void rover_comm_put_i64( uint8_t * p, int64_t value )
+{
+	uint64_t v = (uint64_t)value;
+
+	for ( int i = 0; i < 8; i++ ) {
+		p[i] = v & 0xff;
+		v >>= 8;
+	}
+}
+
+
+static void rover_comm_put_header( uint8_t * data, size_t len, uint32_t id, t_rover_comm_command command )
+{
+	data[0] = len - 1;
+	rover_comm_put_u32( data + 1, id );
+	data[5] = command;
+}
+
+
+static void rover_comm_put_stream_header( uint8_t * data, t_rover_comm_stream_type type, int64_t timestampUs )
+{
+	data[0] = type;
+	rover_comm_put_i64( data + 1, timestampUs );
+}
+
+
+// fields added to a message later are ignored by older parsers, so only the known part has to be there
+static bool rover_comm_parse_message( const uint8_t * data, size_t len, size_t minLen, t_rover_comm_header * header )
+{
+	return rover_comm_parse_header( data, len, header ) && len >= minLen;
+}
+
+
+bool rover_comm_parse_header( const uint8_t * data, size_t len, t_rover_comm_header * header )
+{
+	if ( len < ROVER_COMM_MESSAGE_HEADER_LEN || (size_t)data[0] + 1 != len ) {
+		return false;
+	}
+
+	header->id = rover_comm_get_u32( data + 1 );
+	header->command = data[5];
+
+	return true;
+}
+
+
+size_t rover_comm_command_len( t_rover_comm_command command )
+{
+	if ( ROVER_COMM_COMMAND_MOVE_SPEED_UP == command ) {
+		return ROVER_COMM_MOVE_SPEED_LEN;
+	}
+	else if ( ROVER_COMM_COMMAND_MOVE_SPEED_DOWN == command ) {
+		return ROVER_COMM_MOVE_SPEED_LEN;
+	}
+	else if ( ROVER_COMM_COMMAND_MOVE_TURN_LEFT == command ) {
+		return ROVER_COMM_MOVE_SPEED_LEN;
+	}
+	else if ( ROVER_COMM_COMMAND_MOVE_TURN_RIGHT == command ) {
+		return ROVER_COMM_MOVE_SPEED_LEN;
+	}
+	else if ( ROVER_COMM_COMMAND_MOVE_STOP == command ) {
+		return ROVER_COMM_MOVE_STOP_LEN;
+	}
+	else if ( ROVER_COMM_COMMAND_MOVE_SET == command ) {
+		return ROVER_COMM_MOVE_SET_LEN;
+	}
+	else if ( ROVER_COMM_COMMAND_MOVE_DEADZONE == command ) {
+		return ROVER_COMM_MOVE_DEADZONE_LEN;
+	}
+	else if ( ROVER_COMM_COMMAND_MOVE_AUTONOMOUS == command ) {
+		return ROVER_COMM_MOVE_AUTONOMOUS_LEN;
+	}
+	else if ( ROVER_COMM_COMMAND_CAMERA_FLASH == command ) {
+		return ROVER_COMM_CAMERA_FLASH_LEN;
+	}
+	else if ( ROVER_COMM_COMMAND_CAMERA_FLASH_MODE == command ) {
+		return ROVER_COMM_CAMERA_FLASH_MODE_LEN;
+	}
+	else if ( ROVER_COMM_COMMAND_PING == command ) {
+		return ROVER_COMM_PING_LEN;
+	}
+	else if ( ROVER_COMM_COMMAND_ACK == command ) {
+		return ROVER_COMM_STREAM_ACK_LEN;
+	}
+
+	return 0;
+}
+
+
+bool rover_comm_parse_move_speed( const uint8_t * data, size_t len, t_rover_comm_move_speed * message )
+{
+	t_rover_comm_header header;
+
+	if ( !rover_comm_parse_message( data, len, ROVER_COMM_MOVE_SPEED_LEN, &header ) ) {
+		return false;
+	}
+
+	if ( ROVER_COMM_COMMAND_MOVE_SPEED_UP != header.command && ROVER_COMM_COMMAND_MOVE_SPEED_DOWN != header.command &&
+		ROVER_COMM_COMMAND_MOVE_TURN_LEFT != header.command && ROVER_COMM_COMMAND_MOVE_TURN_RIGHT != header.command ) {
+		return false;
+	}
+
+	message->speed = data[6];
+
+	return true;
+}
+
+
+size_t rover_comm_emit_move_speed( uint8_t * data,
+	size_t size,
+	uint32_t id,
+	t_rover_comm_command command,
+	const t_rover_comm_move_speed * message )
+{
+	if ( size < ROVER_COMM_MOVE_SPEED_LEN ) {
+		return 0;
+	}
+
+	rover_comm_put_header( data, ROVER_COMM_MOVE_SPEED_LEN, id, command );
+	data[6] = message->speed;
+
+	return ROVER_COMM_MOVE_SPEED_LEN;
+}
+
+
+size_t rover_comm_emit_move_stop( uint8_t * data, size_t size, uint32_t id )
+{
+	if ( size < ROVER_COMM_MOVE_STOP_LEN ) {
+		return 0;
+	}
+
+	rover_comm_put_header( data, ROVER_COMM_MOVE_STOP_LEN, id, ROVER_COMM_COMMAND_MOVE_STOP );
+
+	return ROVER_COMM_MOVE_STOP_LEN;
+}
+
+
+bool rover_comm_parse_move_set( const uint8_t * data, size_t len, t_rover_comm_move_set * message )
+{
+	t_rover_comm_header header;
+
+	if ( !rover_comm_parse_message( data, len, ROVER_COMM_MOVE_SET_LEN, &header ) ) {
+		return false;
+	}
+
+	if ( ROVER_COMM_COMMAND_MOVE_SET != header.command ) {
+		return false;
+	}
+
+	message->speedL = rover_comm_get_i32( data + 6 );
+	message->speedR = rover_comm_get_i32( data + 10 );
+
+	return true;
+}
+
+
+size_t rover_comm_emit_move_set( uint8_t * data, size_t size, uint32_t id, const t_rover_comm_move_set * message )
+{
+	if ( size < ROVER_COMM_MOVE_SET_LEN ) {
+		return 0;
+	}
+
+	rover_comm_put_header( data, ROVER_COMM_MOVE_SET_LEN, id, ROVER_COMM_COMMAND_MOVE_SET );
+	rover_comm_put_i32( data + 6, message->speedL );
+	rover_comm_put_i32( data + 10, message->speedR );
+
+	return ROVER_COMM_MOVE_SET_LEN;
+}
+
+
+bool rover_comm_parse_move_deadzone( const uint8_t * data, size_t len, t_rover_comm_move_deadzone * message )
+{
+	t_rover_comm_header header;
+
+	if ( !rover_comm_parse_message( data, len, ROVER_COMM_MOVE_DEADZONE_LEN, &header ) ) {
+		return false;
+	}
+
+	if ( ROVER_COMM_COMMAND_MOVE_DEADZONE != header.command ) {
+		return false;
+	}
+
+	message->deadzone = rover_comm_get_u32( data + 6 );
+
+	return true;
+}
+
+
+size_t rover_comm_emit_move_deadzone( uint8_t * data,
+	size_t size,
+	uint32_t id,
+	const t_rover_comm_move_deadzone * message )
+{
+	if ( size < ROVER_COMM_MOVE_DEADZONE_LEN ) {
+		return 0;
+	}
+
+	rover_comm_put_header( data, ROVER_COMM_MOVE_DEADZONE_LEN, id, ROVER_COMM_COMMAND_MOVE_DEADZONE );
+	rover_comm_put_u32( data + 6, message->deadzone );
+
+	return ROVER_COMM_MOVE_DEADZONE_LEN;
+}
+
+
+bool rover_comm_parse_move_autonomous( const uint8_t * data, size_t len, t_rover_comm_move_autonomous * message )
+{
+	t_rover_comm_header header;
+
+	if ( !rover_comm_parse_message( data, len, ROVER_COMM_MOVE_AUTONOMOUS_LEN, &header ) ) {
+		return false;
+	}
+
+	if ( ROVER_COMM_COMMAND_MOVE_AUTONOMOUS != header.command ) {
+		return false;
+	}
+
+	message->isEnabled = data[6];
+
+	return true;
+}
+
+
+size_t rover_comm_emit_move_autonomous( uint8_t * data,
+	size_t size,
+	uint32_t id,
+	const t_rover_comm_move_autonomous * message )
+{
+	if ( size < ROVER_COMM_MOVE_AUTONOMOUS_LEN ) {
+		return 0;
+	}
+
+	rover_comm_put_header( data, ROVER_COMM_MOVE_AUTONOMOUS_LEN, id, ROVER_COMM_COMMAND_MOVE_AUTONOMOUS );
+	data[6] = message->isEnabled;
+
+	return ROVER_COMM_MOVE_AUTONOMOUS_LEN;
+}
+
+
+bool rover_comm_parse_camera_flash( const uint8_t * data, size_t len, t_rover_comm_camera_flash * message )
+{
+	t_rover_comm_header header;
+
+	if ( !rover_comm_parse_message( data, len, ROVER_COMM_CAMERA_FLASH_LEN, &header ) ) {
+		return false;
+	}
+
+	if ( ROVER_COMM_COMMAND_CAMERA_FLASH != header.command ) {
+		return false;
+	}
+
+	message->duty = data[6];
+
+	return true;
+}
+
+
+size_t rover_comm_emit_camera_flash( uint8_t * data,
+	size_t size,
+	uint32_t id,
+	const t_rover_comm_camera_flash * message )
+{
+	if ( size < ROVER_COMM_CAMERA_FLASH_LEN ) {
+		return 0;
+	}
+
+	rover_comm_put_header( data, ROVER_COMM_CAMERA_FLASH_LEN, id, ROVER_COMM_COMMAND_CAMERA_FLASH );
+	data[6] = message->duty;
+
+	return ROVER_COMM_CAMERA_FLASH_LEN;
+}
+
+
+bool rover_comm_parse_camera_flash_mode( const uint8_t * data, size_t len, t_rover_comm_camera_flash_mode * message )
+{
+	t_rover_comm_header header;
+
+	if ( !rover_comm_parse_message( data, len, ROVER_COMM_CAMERA_FLASH_MODE_LEN, &header ) ) {
+		return false;
+	}
+
+	if ( ROVER_COMM_COMMAND_CAMERA_FLASH_MODE != header.command ) {
+		return false;
+	}
+
+	message->mode = data[6];
+
+	return true;
+}
+
+
+size_t rover_comm_emit_camera_flash_mode( uint8_t * data,
+	size_t size,
+	uint32_t id,
+	const t_rover_comm_camera_flash_mode * message )
+{
+	if ( size < ROVER_COMM_CAMERA_FLASH_MODE_LEN ) {
+		return 0;
+	}
+
+	rover_comm_put_header( data, ROVER_COMM_CAMERA_FLASH_MODE_LEN, id, ROVER_COMM_COMMAND_CAMERA_FLASH_MODE );
+	data[6] = message->mode;
+
+	return ROVER_COMM_CAMERA_FLASH_MODE_LEN;
+}
+
+
+size_t rover_comm_emit_ping( uint8_t * data, size_t size, uint32_t id )
+{
+	if ( size < ROVER_COMM_PING_LEN ) {
+		return 0;
+	}
+
+	rover_comm_put_header( data, ROVER_COMM_PING_LEN, id, ROVER_COMM_COMMAND_PING );
+
+	return ROVER_COMM_PING_LEN;
+}
+
+
+size_t rover_comm_emit_stream_ack( uint8_t * data, size_t size, uint32_t id )
+{
+	if ( size < ROVER_COMM_STREAM_ACK_LEN ) {
+		return 0;
+	}
+
+	rover_comm_put_header( data, ROVER_COMM_STREAM_ACK_LEN, id, ROVER_COMM_COMMAND_ACK );
+
+	return ROVER_COMM_STREAM_ACK_LEN;
+}
+
+
+bool rover_comm_parse_ack( const uint8_t * data, size_t len, t_rover_comm_ack * message )
+{
+	t_rover_comm_header header;
+
+	if ( !rover_comm_parse_message( data, len, ROVER_COMM_ACK_LEN, &header ) ) {
+		return false;
+	}
+
+	if ( ROVER_COMM_COMMAND_ACK != header.command ) {
+		return false;
+	}
+
+	message->motor1 = rover_comm_get_i32( data + 6 );
+	message->motor2 = rover_comm_get_i32( data + 10 );
+	message->appliedUs = rover_comm_get_i64( data + 14 );
+	message->sessionToken = rover_comm_get_u32( data + 22 );
+
+	return true;
+}
+
+
+size_t rover_comm_emit_ack( uint8_t * data, size_t size, uint32_t id, const t_rover_comm_ack * message )
+{
+	if ( size < ROVER_COMM_ACK_LEN ) {
+		return 0;
+	}
+
+	rover_comm_put_header( data, ROVER_COMM_ACK_LEN, id, ROVER_COMM_COMMAND_ACK );
+	rover_comm_put_i32( data + 6, message->motor1 );
+	rover_comm_put_i32( data + 10, message->motor2 );
+	rover_comm_put_i64( data + 14, message->appliedUs );
+	rover_comm_put_u32( data + 22, message->sessionToken );
+
+	return ROVER_COMM_ACK_LEN;
+}
+
+
+bool rover_comm_parse_stream_header( const uint8_t * data, size_t len, t_rover_comm_stream_header * header )
+{
+	if ( len < ROVER_COMM_STREAM_HEADER_LEN ) {
+		return false;
+	}
+
+	header->type = data[0];
+	header->timestampUs = rover_comm_get_i64( data + 1 );
+
+	return true;
+}
+
+
+size_t rover_comm_emit_stream_frame( uint8_t * data, size_t size, int64_t timestampUs )
+{
+	if ( size < ROVER_COMM_STREAM_FRAME_HEADER_LEN ) {
+		return 0;
+	}
+
+	rover_comm_put_stream_header( data, ROVER_COMM_STREAM_FRAME, timestampUs );
+
+	return ROVER_COMM_STREAM_FRAME_HEADER_LEN;
+}
+
+
+bool rover_comm_parse_stream_chunk( const uint8_t * data, size_t len, t_rover_comm_stream_chunk * packet )
+{
+	if ( len < ROVER_COMM_STREAM_CHUNK_HEADER_LEN || ROVER_COMM_STREAM_CHUNK != data[0] ) {
+		return false;
+	}
+
+	packet->offset = rover_comm_get_u32( data + 9 );
+	packet->length = rover_comm_get_u32( data + 13 );
+
+	return true;
+}
+
+
+size_t rover_comm_emit_stream_chunk( uint8_t * data,
+	size_t size,
+	int64_t timestampUs,
+	const t_rover_comm_stream_chunk * packet )
+{
+	if ( size < ROVER_COMM_STREAM_CHUNK_HEADER_LEN ) {
+		return 0;
+	}
+
+	rover_comm_put_stream_header( data, ROVER_COMM_STREAM_CHUNK, timestampUs );
+	rover_comm_put_u32( data + 9, packet->offset );
+	rover_comm_put_u32( data + 13, packet->length );
+
+	return ROVER_COMM_STREAM_CHUNK_HEADER_LEN;
+}
+
+
+bool rover_comm_parse_stream_tile( const uint8_t * data, size_t len, t_rover_comm_stream_tile * packet )
+{
+	if ( len < ROVER_COMM_STREAM_TILE_HEADER_LEN || ROVER_COMM_STREAM_TILE != data[0] ) {
+		return false;
+	}
+
+	packet->frameNo = rover_comm_get_u16( data + 9 );
+	packet->x = rover_comm_get_u16( data + 11 );
+	packet->y = rover_comm_get_u16( data + 13 );
+	packet->width = rover_comm_get_u16( data + 15 );
+	packet->height = rover_comm_get_u16( data + 17 );
+	packet->frameWidth = rover_comm_get_u16( data + 19 );
+	packet->frameHeight = rover_comm_get_u16( data + 21 );
+
+	return true;
+}
+
+
+size_t rover_comm_emit_stream_tile( uint8_t * data,
+	size_t size,
+	int64_t timestampUs,
+	const t_rover_comm_stream_tile * packet )
+{
+	if ( size < ROVER_COMM_STREAM_TILE_HEADER_LEN ) {
+		return 0;
+	}
+
+	rover_comm_put_stream_header( data, ROVER_COMM_STREAM_TILE, timestampUs );
+	rover_comm_put_u16( data + 9, packet->frameNo );
+	rover_comm_put_u16( data + 11, packet->x );
+	rover_comm_put_u16( data + 13, packet->y );
+	rover_comm_put_u16( data + 15, packet->width );
+	rover_comm_put_u16( data + 17, packet->height );
+	rover_comm_put_u16( data + 19, packet->frameWidth );
+	rover_comm_put_u16( data + 21, packet->frameHeight );
+
+	return ROVER_COMM_STREAM_TILE_HEADER_LEN;
+}
+
+
+bool rover_comm_parse_stream_profile( const uint8_t * data, size_t len, t_rover_comm_stream_profile * packet )
+{
+	if ( len < ROVER_COMM_STREAM_PROFILE_HEADER_LEN || ROVER_COMM_STREAM_PROFILE != data[0] ) {
+		return false;
+	}
+
+	packet->windowUs = rover_comm_get_u32( data + 9 );
+	packet->core0Load = rover_comm_get_u16( data + 13 );
+	packet->core1Load = rover_comm_get_u16( data + 15 );
+	packet->taskCount = data[17];
+
+	return true;
+}
+
+
+size_t rover_comm_emit_stream_profile( uint8_t * data,
+	size_t size,
+	int64_t timestampUs,
+	const t_rover_comm_stream_profile * packet )
+{
+	if ( size < ROVER_COMM_STREAM_PROFILE_HEADER_LEN ) {
+		return 0;
+	}
+
+	rover_comm_put_stream_header( data, ROVER_COMM_STREAM_PROFILE, timestampUs );
+	rover_comm_put_u32( data + 9, packet->windowUs );
+	rover_comm_put_u16( data + 13, packet->core0Load );
+	rover_comm_put_u16( data + 15, packet->core1Load );
+	data[17] = packet->taskCount;
+
+	return ROVER_COMM_STREAM_PROFILE_HEADER_LEN;
+}
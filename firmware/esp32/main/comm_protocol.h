@@ -0,0 +1,217 @@
+/*
+ *	Copyright (c) 2025 Denis Rozhkov <denis@rozhkoff.com>
+ *	This file is part of cam-rover.
+ *
+ *	cam-rover is free software: you can redistribute it and/or
+ *	modify it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or (at your
+ *	option) any later version.
+ *
+ *	cam-rover is distributed in the hope that it will be
+ *	useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ *	Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along with
+ *	cam-rover. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+// generated by protocol/protogen.py from protocol/protocol.json, do not edit
+
+#ifndef __ROVER__COMM_PROTOCOL__H
+#define __ROVER__COMM_PROTOCOL__H
+
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+
+// 2 - capture timestamped stream packets, session token in the ACK
+// 3 - full frames sent as paced chunks
+// 4 - per-task CPU profile telemetry
+#define ROVER_COMM_PROTOCOL_VERSION 4
+
+// 0 - payload length (message length - 1)
+// 1-4 - message ID
+// 5 - command
+#define ROVER_COMM_MESSAGE_HEADER_LEN 6
+
+// 0 - packet type
+// 1-8 - capture timestamp, us of rover time (esp_timer)
+#define ROVER_COMM_STREAM_HEADER_LEN 9
+
+// message lengths, header included
+#define ROVER_COMM_MOVE_SPEED_LEN 7
+#define ROVER_COMM_MOVE_STOP_LEN 6
+#define ROVER_COMM_MOVE_SET_LEN 14
+#define ROVER_COMM_MOVE_DEADZONE_LEN 10
+#define ROVER_COMM_MOVE_AUTONOMOUS_LEN 7
+#define ROVER_COMM_CAMERA_FLASH_LEN 7
+#define ROVER_COMM_CAMERA_FLASH_MODE_LEN 7
+#define ROVER_COMM_PING_LEN 6
+#define ROVER_COMM_STREAM_ACK_LEN 6
+#define ROVER_COMM_ACK_LEN 26
+
+// stream packet header lengths, the payload follows
+#define ROVER_COMM_STREAM_FRAME_HEADER_LEN 9
+#define ROVER_COMM_STREAM_CHUNK_HEADER_LEN 17
+#define ROVER_COMM_STREAM_TILE_HEADER_LEN 23
+#define ROVER_COMM_STREAM_PROFILE_HEADER_LEN 18
+
+
+typedef enum {
+	ROVER_COMM_COMMAND_UNKNOWN = 0,
+	ROVER_COMM_COMMAND_MOVE_SPEED_UP = '+',
+	ROVER_COMM_COMMAND_MOVE_SPEED_DOWN = '-',
+	ROVER_COMM_COMMAND_MOVE_TURN_LEFT = 'l',
+	ROVER_COMM_COMMAND_MOVE_TURN_RIGHT = 'r',
+	ROVER_COMM_COMMAND_MOVE_STOP = 's',
+	ROVER_COMM_COMMAND_MOVE_SET = 't',
+	ROVER_COMM_COMMAND_MOVE_DEADZONE = 'z',
+	ROVER_COMM_COMMAND_MOVE_AUTONOMOUS = 'o',
+	ROVER_COMM_COMMAND_CAMERA_FLASH = 'f',
+	ROVER_COMM_COMMAND_CAMERA_FLASH_MODE = 'm',
+	ROVER_COMM_COMMAND_PING = 'p',
+	ROVER_COMM_COMMAND_ACK = 'a'
+} t_rover_comm_command;
+
+typedef enum {
+	ROVER_COMM_STREAM_FRAME = 'F',
+	ROVER_COMM_STREAM_TILE = 'T',
+	ROVER_COMM_STREAM_CHUNK = 'C',
+	ROVER_COMM_STREAM_PROFILE = 'P'
+} t_rover_comm_stream_type;
+
+typedef struct {
+	uint32_t id;
+	t_rover_comm_command command;
+} t_rover_comm_header;
+
+typedef struct {
+	t_rover_comm_stream_type type;
+	int64_t timestampUs;
+} t_rover_comm_stream_header;
+
+// speed step, the command tells the direction
+typedef struct {
+	uint8_t speed;
+} t_rover_comm_move_speed;
+
+typedef struct {
+	int32_t speedL;
+	int32_t speedR;
+} t_rover_comm_move_set;
+
+typedef struct {
+	uint32_t deadzone;
+} t_rover_comm_move_deadzone;
+
+typedef struct {
+	uint8_t isEnabled;
+} t_rover_comm_move_autonomous;
+
+typedef struct {
+	uint8_t duty;
+} t_rover_comm_camera_flash;
+
+typedef struct {
+	uint8_t mode;
+} t_rover_comm_camera_flash_mode;
+
+// motor speeds and rover time (us) right after the acknowledged command was applied
+typedef struct {
+	int32_t motor1;
+	int32_t motor2;
+	int64_t appliedUs;
+	uint32_t sessionToken;
+} t_rover_comm_ack;
+
+// a full frame cut to datagram size, the capture timestamp identifies the frame
+typedef struct {
+	uint32_t offset;
+	uint32_t length;
+} t_rover_comm_stream_chunk;
+
+// a JPEG encoded rectangle of an RGB565 frame
+typedef struct {
+	uint16_t frameNo;
+	uint16_t x;
+	uint16_t y;
+	uint16_t width;
+	uint16_t height;
+	uint16_t frameWidth;
+	uint16_t frameHeight;
+} t_rover_comm_stream_tile;
+
+// CPU use over the window ending at the timestamp, permille of one core; followed by taskCount 21 byte records: name
+// (16 bytes, NUL padded), load u16 (permille), core i8 (-1 not pinned), least free stack u16 (bytes)
+typedef struct {
+	uint32_t windowUs;
+	uint16_t core0Load;
+	uint16_t core1Load;
+	uint8_t taskCount;
+} t_rover_comm_stream_profile;
+
+
+// parse functions return false unless data holds the whole message, emit functions return the length
+// written or 0 if it does not fit size
+bool rover_comm_parse_header( const uint8_t * data, size_t len, t_rover_comm_header * header );
+// shortest message a command comes with, 0 for unknown commands
+size_t rover_comm_command_len( t_rover_comm_command command );
+bool rover_comm_parse_move_speed( const uint8_t * data, size_t len, t_rover_comm_move_speed * message );
+size_t rover_comm_emit_move_speed( uint8_t * data,
+	size_t size,
+	uint32_t id,
+	t_rover_comm_command command,
+	const t_rover_comm_move_speed * message );
+size_t rover_comm_emit_move_stop( uint8_t * data, size_t size, uint32_t id );
+bool rover_comm_parse_move_set( const uint8_t * data, size_t len, t_rover_comm_move_set * message );
+size_t rover_comm_emit_move_set( uint8_t * data, size_t size, uint32_t id, const t_rover_comm_move_set * message );
+bool rover_comm_parse_move_deadzone( const uint8_t * data, size_t len, t_rover_comm_move_deadzone * message );
+size_t rover_comm_emit_move_deadzone( uint8_t * data,
+	size_t size,
+	uint32_t id,
+	const t_rover_comm_move_deadzone * message );
+bool rover_comm_parse_move_autonomous( const uint8_t * data, size_t len, t_rover_comm_move_autonomous * message );
+size_t rover_comm_emit_move_autonomous( uint8_t * data,
+	size_t size,
+	uint32_t id,
+	const t_rover_comm_move_autonomous * message );
+bool rover_comm_parse_camera_flash( const uint8_t * data, size_t len, t_rover_comm_camera_flash * message );
+size_t rover_comm_emit_camera_flash( uint8_t * data,
+	size_t size,
+	uint32_t id,
+	const t_rover_comm_camera_flash * message );
+bool rover_comm_parse_camera_flash_mode( const uint8_t * data, size_t len, t_rover_comm_camera_flash_mode * message );
+size_t rover_comm_emit_camera_flash_mode( uint8_t * data,
+	size_t size,
+	uint32_t id,
+	const t_rover_comm_camera_flash_mode * message );
+size_t rover_comm_emit_ping( uint8_t * data, size_t size, uint32_t id );
+size_t rover_comm_emit_stream_ack( uint8_t * data, size_t size, uint32_t id );
+bool rover_comm_parse_ack( const uint8_t * data, size_t len, t_rover_comm_ack * message );
+size_t rover_comm_emit_ack( uint8_t * data, size_t size, uint32_t id, const t_rover_comm_ack * message );
+bool rover_comm_parse_stream_header( const uint8_t * data, size_t len, t_rover_comm_stream_header * header );
+size_t rover_comm_emit_stream_frame( uint8_t * data, size_t size, int64_t timestampUs );
+bool rover_comm_parse_stream_chunk( const uint8_t * data, size_t len, t_rover_comm_stream_chunk * packet );
+size_t rover_comm_emit_stream_chunk( uint8_t * data,
+	size_t size,
+	int64_t timestampUs,
+	const t_rover_comm_stream_chunk * packet );
+bool rover_comm_parse_stream_tile( const uint8_t * data, size_t len, t_rover_comm_stream_tile * packet );
+size_t rover_comm_emit_stream_tile( uint8_t * data,
+	size_t size,
+	int64_t timestampUs,
+	const t_rover_comm_stream_tile * packet );
+bool rover_comm_parse_stream_profile( const uint8_t * data, size_t len, t_rover_comm_stream_profile * packet );
+size_t rover_comm_emit_stream_profile( uint8_t * data,
+	size_t size,
+	int64_t timestampUs,
+	const t_rover_comm_stream_profile * packet );
+
+
+#endif
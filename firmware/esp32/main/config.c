@@ -20,30 +20,81 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 
 #include <stdbool.h>
+#include <string.h>
 
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
 #include "nvs_flash.h"
 
 #include "config.h"
+#include "pool.h"
+#include "tasks.h"
+#include "camera.h"
+#include "drive.h"
 
 
 #define ROVER_CONFIG_VERSION 2
+// SSID (32) and WPA2 passphrase (64) with terminators
+#define ROVER_CONFIG_WLAN_STRINGS_LEN ( 33 + 65 )
 
 static const char roverNvsNamespace[] = "rover";
 static const char roverNvsKeyWlanSsid[] = "wlan.ssid";
 static const char roverNvsKeyWlanPassword[] = "wlan.password";
 static const char roverNvsKeyConfigVersion[] = "config.version";
 
-
-static const char * rover_config_get_string( nvs_handle_t h, const char * key )
+static const char * roverLogTAG = "rover.config";
+
+static const t_rover_config_info roverConfigInfo[ROVER_CONFIG_COUNT] = {
+	[ROVER_CONFIG_CAMERA_JPEG_QUALITY] = { .key = "cam.quality",
+		.type = ROVER_CONFIG_TYPE_U8,
+		.min = 1,
+		.max = 63,
+		.defaultValue = ROVER_CAMERA_JPEG_QUALITY_DEFAULT },
+	[ROVER_CONFIG_CAMERA_FRAME_SIZE] = { .key = "cam.framesize",
+		.type = ROVER_CONFIG_TYPE_U8,
+		.min = FRAMESIZE_QQVGA,
+		.max = FRAMESIZE_UXGA,
+		.defaultValue = ROVER_CAMERA_FRAME_SIZE_DEFAULT },
+	[ROVER_CONFIG_DRIVE_DEADZONE] = { .key = "drive.deadzone",
+		.type = ROVER_CONFIG_TYPE_U16,
+		.min = 0,
+		.max = 1000,
+		.defaultValue = ROVER_DRIVE_DEADZONE_DEFAULT },
+	// the speed curve of the slowest has to fit a blob pool block
+	[ROVER_CONFIG_DRIVE_PWM_FREQ] = { .key = "drive.pwmfreq",
+		.type = ROVER_CONFIG_TYPE_U32,
+		.min = 1000,
+		.max = 25000,
+		.defaultValue = ROVER_DRIVE_PWM_FREQ_HZ_DEFAULT },
+};
+
+typedef struct {
+	t_rover_config_id id;
+	t_rover_config_handler_changed handler;
+	void * context;
+} t_rover_config_subscriber;
+
+static uint32_t roverConfigValues[ROVER_CONFIG_COUNT];
+// settings changed since the config task last looked, one bit per id
+static uint32_t roverConfigChanged = 0;
+static t_rover_config_subscriber roverConfigSubscribers[ROVER_CONFIG_SUBSCRIBERS_MAX];
+static size_t roverConfigSubscriberCount = 0;
+static TaskHandle_t roverConfigTask = NULL;
+
+
+// reads the string into storage at *pos and moves pos past it
+static const char * rover_config_get_string( nvs_handle_t h, const char * key, t_rover_ptr * storage, size_t * pos )
 {
-	size_t len;
+	char * r = (char *)storage->data + *pos;
+	size_t len = storage->size - *pos;
 
-	if ( nvs_get_str( h, key, NULL, &len ) != ESP_OK ) {
+	if ( nvs_get_str( h, key, r, &len ) != ESP_OK ) {
 		return NULL;
 	}
 
-	char * r = malloc( len );
-	nvs_get_str( h, key, r, &len );
+	*pos += len;
 
 	return r;
 }
@@ -59,6 +110,8 @@ bool rover_load_config( t_rover_config * out )
 
 	bool r = false;
 	uint8_t configVersion;
+	size_t pos = 0;
+	out->storage = NULL;
 
 	if ( nvs_get_u8( h, roverNvsKeyConfigVersion, &configVersion ) != ESP_OK ||
 		configVersion != ROVER_CONFIG_VERSION ) {
@@ -66,23 +119,43 @@ bool rover_load_config( t_rover_config * out )
 		goto l_close;
 	}
 
-	out->wlan.ssid = rover_config_get_string( h, roverNvsKeyWlanSsid );
+	// both strings share one block, released by rover_free_config()
+	out->storage = rover_pool_alloc( ROVER_POOL_TEXT, ROVER_CONFIG_WLAN_STRINGS_LEN );
+
+	if ( NULL == out->storage ) {
+		goto l_close;
+	}
+
+	out->wlan.ssid = rover_config_get_string( h, roverNvsKeyWlanSsid, out->storage, &pos );
 
 	if ( NULL == out->wlan.ssid ) {
 		goto l_close;
 	}
 
-	out->wlan.password = rover_config_get_string( h, roverNvsKeyWlanPassword );
+	out->wlan.password = rover_config_get_string( h, roverNvsKeyWlanPassword, out->storage, &pos );
 
 	r = true;
 
 l_close:
 	nvs_close( h );
 
+	if ( !r ) {
+		rover_free_config( out );
+	}
+
 	return r;
 }
 
 
+void rover_free_config( t_rover_config * config )
+{
+	rover_pool_release( config->storage );
+	config->storage = NULL;
+	config->wlan.ssid = NULL;
+	config->wlan.password = NULL;
+}
+
+
 void rover_save_config( const t_rover_config * config )
 {
 	nvs_handle_t h;
@@ -113,3 +186,248 @@ void rover_reset_config( void )
 	nvs_set_u8( h, roverNvsKeyConfigVersion, 0 );
 	nvs_close( h );
 }
+
+
+bool rover_load_config_task( const char * key, t_rover_config_task * out )
+{
+	nvs_handle_t h;
+
+	if ( nvs_open( roverNvsNamespace, NVS_READONLY, &h ) != ESP_OK ) {
+		return false;
+	}
+
+	size_t len = sizeof *out;
+	bool r = ( nvs_get_blob( h, key, out, &len ) == ESP_OK && len == sizeof *out );
+
+	nvs_close( h );
+
+	return r;
+}
+
+
+bool rover_save_config_task( const char * key, const t_rover_config_task * config )
+{
+	nvs_handle_t h;
+
+	if ( nvs_open( roverNvsNamespace, NVS_READWRITE, &h ) != ESP_OK ) {
+		return false;
+	}
+
+	bool r = ( nvs_set_blob( h, key, config, sizeof *config ) == ESP_OK && nvs_commit( h ) == ESP_OK );
+
+	nvs_close( h );
+
+	return r;
+}
+
+
+static bool rover_config_load_value( nvs_handle_t h, const t_rover_config_info * info, uint32_t * out )
+{
+	if ( ROVER_CONFIG_TYPE_U8 == info->type ) {
+		uint8_t value;
+
+		if ( nvs_get_u8( h, info->key, &value ) != ESP_OK ) {
+			return false;
+		}
+
+		*out = value;
+	}
+	else if ( ROVER_CONFIG_TYPE_U16 == info->type ) {
+		uint16_t value;
+
+		if ( nvs_get_u16( h, info->key, &value ) != ESP_OK ) {
+			return false;
+		}
+
+		*out = value;
+	}
+	else if ( nvs_get_u32( h, info->key, out ) != ESP_OK ) {
+		return false;
+	}
+
+	return *out >= info->min && *out <= info->max;
+}
+
+
+static esp_err_t rover_config_save_value( nvs_handle_t h, const t_rover_config_info * info, uint32_t value )
+{
+	if ( ROVER_CONFIG_TYPE_U8 == info->type ) {
+		return nvs_set_u8( h, info->key, value );
+	}
+
+	if ( ROVER_CONFIG_TYPE_U16 == info->type ) {
+		return nvs_set_u16( h, info->key, value );
+	}
+
+	return nvs_set_u32( h, info->key, value );
+}
+
+
+void rover_config_init( void )
+{
+	for ( size_t i = 0; i < ROVER_CONFIG_COUNT; ++i ) {
+		roverConfigValues[i] = roverConfigInfo[i].defaultValue;
+	}
+
+	nvs_handle_t h;
+
+	if ( nvs_open( roverNvsNamespace, NVS_READONLY, &h ) != ESP_OK ) {
+		return;
+	}
+
+	for ( size_t i = 0; i < ROVER_CONFIG_COUNT; ++i ) {
+		uint32_t value;
+
+		if ( rover_config_load_value( h, &roverConfigInfo[i], &value ) ) {
+			roverConfigValues[i] = value;
+		}
+	}
+
+	nvs_close( h );
+}
+
+
+// one NVS commit for everything that changed
+static void rover_config_commit( uint32_t dirty )
+{
+	nvs_handle_t h;
+
+	if ( nvs_open( roverNvsNamespace, NVS_READWRITE, &h ) != ESP_OK ) {
+		ESP_LOGE( roverLogTAG, "NVS open failed, changes are kept in RAM" );
+		return;
+	}
+
+	size_t count = 0;
+
+	for ( size_t i = 0; i < ROVER_CONFIG_COUNT; ++i ) {
+		if ( dirty & ( 1u << i ) ) {
+			uint32_t value = __atomic_load_n( &roverConfigValues[i], __ATOMIC_RELAXED );
+
+			if ( rover_config_save_value( h, &roverConfigInfo[i], value ) == ESP_OK ) {
+				++count;
+			}
+		}
+	}
+
+	esp_err_t err = nvs_commit( h );
+	nvs_close( h );
+
+	ESP_LOGI( roverLogTAG, "%u settings saved, err 0x%x", (unsigned)count, err );
+}
+
+
+static void rover_config_notify( t_rover_config_id id )
+{
+	uint32_t value = __atomic_load_n( &roverConfigValues[id], __ATOMIC_RELAXED );
+
+	for ( size_t i = 0; i < roverConfigSubscriberCount; ++i ) {
+		t_rover_config_subscriber * subscriber = &roverConfigSubscribers[i];
+
+		if ( subscriber->id == id ) {
+			subscriber->handler( subscriber->context, id, value );
+		}
+	}
+}
+
+
+static void rover_config_task( void * parameters )
+{
+	const TickType_t delay = pdMS_TO_TICKS( CONFIG_ROVER_CONFIG_COMMIT_DELAY_MS );
+	uint32_t dirty = 0;
+	TickType_t dirtySince = 0;
+
+	while ( true ) {
+		bool isNotified = ulTaskNotifyTake( pdTRUE, 0 == dirty ? portMAX_DELAY : delay ) > 0;
+		uint32_t changed = __atomic_exchange_n( &roverConfigChanged, 0, __ATOMIC_SEQ_CST );
+
+		for ( size_t i = 0; i < ROVER_CONFIG_COUNT; ++i ) {
+			if ( changed & ( 1u << i ) ) {
+				rover_config_notify( i );
+			}
+		}
+
+		if ( 0 == dirty && changed != 0 ) {
+			dirtySince = xTaskGetTickCount();
+		}
+
+		dirty |= changed;
+
+		// a burst of changes is written once it settles, a steady stream of them every few delays
+		if ( dirty != 0 && ( !isNotified || xTaskGetTickCount() - dirtySince >= 4 * delay ) ) {
+			rover_config_commit( dirty );
+			dirty = 0;
+		}
+	}
+}
+
+
+void rover_config_start( void )
+{
+	rover_task_create( ROVER_TASK_CONFIG, rover_config_task, NULL, &roverConfigTask );
+}
+
+
+const t_rover_config_info * rover_config_get_info( t_rover_config_id id )
+{
+	return &roverConfigInfo[id];
+}
+
+
+bool rover_config_find( const char * key, t_rover_config_id * out )
+{
+	for ( size_t i = 0; i < ROVER_CONFIG_COUNT; ++i ) {
+		if ( 0 == strcmp( roverConfigInfo[i].key, key ) ) {
+			*out = i;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+uint32_t rover_config_get( t_rover_config_id id )
+{
+	return __atomic_load_n( &roverConfigValues[id], __ATOMIC_RELAXED );
+}
+
+
+bool rover_config_is_valid( t_rover_config_id id, uint32_t value )
+{
+	const t_rover_config_info * info = &roverConfigInfo[id];
+
+	return value >= info->min && value <= info->max;
+}
+
+
+bool rover_config_set( t_rover_config_id id, uint32_t value )
+{
+	if ( !rover_config_is_valid( id, value ) ) {
+		return false;
+	}
+
+	if ( __atomic_exchange_n( &roverConfigValues[id], value, __ATOMIC_SEQ_CST ) == value ) {
+		return true;
+	}
+
+	__atomic_or_fetch( &roverConfigChanged, 1u << id, __ATOMIC_SEQ_CST );
+
+	if ( roverConfigTask != NULL ) {
+		xTaskNotifyGive( roverConfigTask );
+	}
+
+	return true;
+}
+
+
+bool rover_config_subscribe( t_rover_config_id id, t_rover_config_handler_changed handler, void * context )
+{
+	if ( roverConfigSubscriberCount >= ROVER_CONFIG_SUBSCRIBERS_MAX ) {
+		return false;
+	}
+
+	roverConfigSubscribers[roverConfigSubscriberCount++] =
+		( t_rover_config_subscriber ){ .id = id, .handler = handler, .context = context };
+
+	return true;
+}
@@ -26,6 +26,8 @@
 #include <stdint.h>
 #include <stddef.h>
 
+#include "types.h"
+
 
 typedef struct {
 	const char * ssid;
@@ -34,12 +36,68 @@ typedef struct {
 
 typedef struct {
 	t_rover_config_wlan wlan;
+	// holds the strings of a loaded config, NULL otherwise
+	t_rover_ptr * storage;
 } t_rover_config;
 
+typedef struct {
+	int8_t coreId;
+	uint8_t priority;
+	uint16_t stackSize;
+} t_rover_config_task;
+
+// run time settings, cached in RAM and applied live by their subscribers
+typedef enum {
+	ROVER_CONFIG_CAMERA_JPEG_QUALITY = 0,
+	ROVER_CONFIG_CAMERA_FRAME_SIZE,
+	// permille of the full duty
+	ROVER_CONFIG_DRIVE_DEADZONE,
+	ROVER_CONFIG_DRIVE_PWM_FREQ,
+	ROVER_CONFIG_COUNT
+} t_rover_config_id;
+
+// how a setting is kept in NVS
+typedef enum {
+	ROVER_CONFIG_TYPE_U8 = 0,
+	ROVER_CONFIG_TYPE_U16,
+	ROVER_CONFIG_TYPE_U32
+} t_rover_config_type;
+
+typedef struct {
+	const char * key;
+	t_rover_config_type type;
+	uint32_t min;
+	uint32_t max;
+	uint32_t defaultValue;
+} t_rover_config_info;
+
+typedef void ( *t_rover_config_handler_changed )( void * context, t_rover_config_id id, uint32_t value );
+
+#define ROVER_CONFIG_SUBSCRIBERS_MAX 8
+
 
 bool rover_load_config( t_rover_config * out );
+void rover_free_config( t_rover_config * config );
 void rover_save_config( const t_rover_config * config );
 void rover_reset_config( void );
+bool rover_load_config_task( const char * key, t_rover_config_task * out );
+// taken by rover_tasks_init() on the next boot
+bool rover_save_config_task( const char * key, const t_rover_config_task * config );
+
+// fills the cache from NVS, values missing or out of range fall back to the defaults
+void rover_config_init( void );
+// starts the config task, subscribers are notified of changes from then on
+void rover_config_start( void );
+const t_rover_config_info * rover_config_get_info( t_rover_config_id id );
+bool rover_config_find( const char * key, t_rover_config_id * out );
+// the cached value, never touches NVS
+uint32_t rover_config_get( t_rover_config_id id );
+// whether rover_config_set() would take the value
+bool rover_config_is_valid( t_rover_config_id id, uint32_t value );
+// false when out of range; subscribers run on the config task, NVS is written once the changes settle
+bool rover_config_set( t_rover_config_id id, uint32_t value );
+// subscribe before rover_config_start()
+bool rover_config_subscribe( t_rover_config_id id, t_rover_config_handler_changed handler, void * context );
 
 
 #endif
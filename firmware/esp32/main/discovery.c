@@ -21,21 +21,45 @@
 
 #include <stdio.h>
 #include <stdint.h>
+#include <inttypes.h>
+#include <sys/param.h>
 
 #include "lwip/sockets.h"
 #include "lwip/sys.h"
 #include "lwip/netdb.h"
 
+#include "esp_app_desc.h"
+#include "esp_event.h"
 #include "esp_log.h"
+#include "esp_netif.h"
+#include "esp_timer.h"
 
 #include "globals.h"
 #include "helpers.h"
+#include "tasks.h"
+#include "comm.h"
 #include "discovery.h"
+#include "pool.h"
+#include "dlog.h"
 
 
 #define ROVER_DISCOVERY_IPV4_ADDR "239.255.255.250"
 #define ROVER_DISCOVERY_TTL 8
 #define ROVER_DISCOVERY_UDP_PORT 3703
+#define ROVER_DISCOVERY_RECORD_LEN_MAX 192
+#define ROVER_DISCOVERY_RECV_LEN 48
+
+#ifdef CONFIG_ROVER_CAMERA_TILES
+#define ROVER_DISCOVERY_STREAM_MODES "tiles"
+#else
+#define ROVER_DISCOVERY_STREAM_MODES "jpeg"
+#endif
+
+#ifdef CONFIG_ROVER_COMM_TRANSPORT_TCP
+#define ROVER_DISCOVERY_TRANSPORT "tcp"
+#else
+#define ROVER_DISCOVERY_TRANSPORT "udp"
+#endif
 
 
 struct {
@@ -67,7 +91,7 @@ static int rover_discovery_add_ipv4_multicast_group( int socketFd )
 		goto _l_exit;
 	}
 
-	ESP_LOGI( roverLogTAG, "Configured IPV4 Multicast address %s", inet_ntoa( mreq.imr_multiaddr.s_addr ) );
+	ESP_LOGD( roverLogTAG, "Configured IPV4 Multicast address %s", inet_ntoa( mreq.imr_multiaddr.s_addr ) );
 
 	// Assign the IPv4 multicast source interface, via its IP
 	// (only necessary if this socket is IPV4 only)
@@ -139,19 +163,86 @@ _l_close:
 }
 
 
+// CAM-ROVER:<PROBE_MATCH|ANNOUNCE>:<control port>:<stream port>:<session>:<key=value;...>
+static size_t rover_discovery_build_record(
+	t_rover_discovery * discovery, const char * kind, char * buffer, size_t size )
+{
+	t_rover_discovery_status status = { 0 };
+
+	if ( NULL != discovery->status ) {
+		discovery->status( discovery->statusContext, &status );
+	}
+
+	int len = snprintf( buffer,
+		size,
+		"CAM-ROVER:%s:%" PRIu16 ":%" PRIu16 ":%08" PRIx32
+		":fw=%s;proto=%d;modes=%s;transport=%s;res=%ux%u;fps=%u;load=%u;link=%u",
+		kind,
+		discovery->controlPortNo,
+		discovery->cameraStreamPortNo,
+		discovery->sessionToken,
+		esp_app_get_description()->version,
+		ROVER_COMM_PROTOCOL_VERSION,
+		ROVER_DISCOVERY_STREAM_MODES,
+		ROVER_DISCOVERY_TRANSPORT,
+		(unsigned)status.width,
+		(unsigned)status.height,
+		(unsigned)status.fps,
+		(unsigned)status.load,
+		(unsigned)status.linkQuality );
+
+	return len < 0 ? 0 : MIN( (size_t)len, size - 1 );
+}
+
+
+static void rover_discovery_announce( t_rover_discovery * discovery, int socketFd, char * record )
+{
+	size_t len = rover_discovery_build_record( discovery, "ANNOUNCE", record, ROVER_DISCOVERY_RECORD_LEN_MAX );
+
+	struct sockaddr_in addr = { 0 };
+	addr.sin_family = PF_INET;
+	addr.sin_port = htons( roverConfigDiscovery.portNo );
+	inet_aton( roverConfigDiscovery.address, &addr.sin_addr );
+
+	if ( sendto( socketFd, record, len, 0, (struct sockaddr *)&addr, sizeof addr ) < 0 ) {
+		ESP_LOGW( roverLogTAG, "announcement failed: errno %d", errno );
+	}
+	else {
+		ROVER_DLOGD( roverLogTAG, "announced %s", record );
+	}
+}
+
+
+static void rover_discovery_handler_ip( void * arg, esp_event_base_t eventBase, int32_t eventId, void * eventData )
+{
+	t_rover_discovery * discovery = (t_rover_discovery *)arg;
+
+	if ( IP_EVENT_STA_GOT_IP == eventId ) {
+		ROVER_DLOGI( roverLogTAG, "IP address changed, announcing" );
+	}
+
+	discovery->isAnnouncePending = true;
+}
+
+
 static void rover_discovery_task( void * pvParameters )
 {
 	t_rover_discovery * discovery = (t_rover_discovery *)pvParameters;
-	// char probeMatch[] = "CAM-ROVER:PROBE_MATCH:\0PORTC:PORTS";
-	char probeMatch[64];
+	t_rover_ptr * recordBuffer = rover_pool_alloc( ROVER_POOL_NET, ROVER_DISCOVERY_RECORD_LEN_MAX );
+	t_rover_ptr * recvBuffer = rover_pool_alloc( ROVER_POOL_NET, ROVER_DISCOVERY_RECV_LEN );
+	int64_t nextAnnounceUs = 0;
 
-	snprintf( probeMatch,
-		sizeof probeMatch,
-		"CAM-ROVER:PROBE_MATCH:%" PRIu16 ":%" PRIu16,
-		discovery->controlPortNo,
-		discovery->cameraStreamPortNo );
+	if ( NULL == recordBuffer || NULL == recvBuffer ) {
+		ESP_LOGE( roverLogTAG, "no buffers" );
+		rover_pool_release( recordBuffer );
+		rover_pool_release( recvBuffer );
+		vTaskDelete( NULL );
+
+		return;
+	}
 
-	size_t probeMatchLen = strlen( probeMatch );
+	char * record = recordBuffer->data;
+	char * recvbuf = recvBuffer->data;
 
 	while ( true ) {
 		int socketFd = rover_discovery_create_multicast_ipv4_socket();
@@ -166,13 +257,26 @@ static void rover_discovery_task( void * pvParameters )
 			continue;
 		}
 
+		// a fresh socket may be on a fresh interface, let the clients know
+		discovery->isAnnouncePending = true;
+
 		// Loop waiting for UDP received, and sending UDP packets if we don't
 		// see any.
 		int err = 1;
 
 		while ( err > 0 ) {
+			int64_t nowUs = esp_timer_get_time();
+
+			if ( discovery->isAnnouncePending
+				|| ( CONFIG_ROVER_DISCOVERY_ANNOUNCE_INTERVAL > 0 && nowUs >= nextAnnounceUs ) ) {
+				discovery->isAnnouncePending = false;
+				nextAnnounceUs = nowUs + CONFIG_ROVER_DISCOVERY_ANNOUNCE_INTERVAL * 1000000LL;
+				rover_discovery_announce( discovery, socketFd, record );
+			}
+
+			// short enough for an IP change to be announced promptly
 			struct timeval tv = {
-				.tv_sec = 2,
+				.tv_sec = 1,
 				.tv_usec = 0,
 			};
 
@@ -190,12 +294,11 @@ static void rover_discovery_task( void * pvParameters )
 
 			if ( s > 0 && FD_ISSET( socketFd, &rfds ) ) {
 				// Incoming datagram received
-				char recvbuf[48];
 				char raddr_name[32] = { 0 };
 
 				struct sockaddr_storage raddr; // Large enough for both IPv4 or IPv6
 				socklen_t socklen = sizeof( raddr );
-				int len = recvfrom( socketFd, recvbuf, sizeof( recvbuf ) - 1, 0, (struct sockaddr *)&raddr, &socklen );
+				int len = recvfrom( socketFd, recvbuf, ROVER_DISCOVERY_RECV_LEN - 1, 0, (struct sockaddr *)&raddr, &socklen );
 
 				if ( len < 0 ) {
 					ESP_LOGE( roverLogTAG, "multicast recvfrom failed: errno %d", errno );
@@ -208,13 +311,13 @@ static void rover_discovery_task( void * pvParameters )
 					inet_ntoa_r( ( (struct sockaddr_in *)&raddr )->sin_addr, raddr_name, sizeof( raddr_name ) - 1 );
 				}
 
-				ESP_LOGI( roverLogTAG, "received %d bytes from %s:", len, raddr_name );
-
 				recvbuf[len] = 0; // Null-terminate whatever we received and treat like a string...
-				ESP_LOGI( roverLogTAG, "%s", recvbuf );
+				ROVER_DLOGD( roverLogTAG, "received %d bytes from %s: %s", len, raddr_name, recvbuf );
 
 				if ( ROVER_IS_STRING_EQ( "CAM-ROVER:PROBE", recvbuf ) ) {
-					sendto( socketFd, probeMatch, probeMatchLen, 0, (struct sockaddr *)&raddr, socklen );
+					size_t recordLen =
+						rover_discovery_build_record( discovery, "PROBE_MATCH", record, ROVER_DISCOVERY_RECORD_LEN_MAX );
+					sendto( socketFd, record, recordLen, 0, (struct sockaddr *)&raddr, socklen );
 				}
 			}
 		}
@@ -228,5 +331,8 @@ static void rover_discovery_task( void * pvParameters )
 
 void rover_discovery_start( t_rover_discovery * discovery )
 {
-	xTaskCreate( &rover_discovery_task, "rover_discovery_task", 4096, discovery, 5, NULL );
+	esp_event_handler_register( IP_EVENT, IP_EVENT_STA_GOT_IP, &rover_discovery_handler_ip, discovery );
+	esp_event_handler_register( IP_EVENT, IP_EVENT_AP_STAIPASSIGNED, &rover_discovery_handler_ip, discovery );
+
+	rover_task_create( ROVER_TASK_DISCOVERY, &rover_discovery_task, discovery, NULL );
 }
@@ -23,9 +23,28 @@
 #define __ROVER__DISCOVERY__H
 
 
+#include <stdint.h>
+#include <stdbool.h>
+
+
+// the parts of the capability record that change at run time
+typedef struct {
+	uint16_t width;
+	uint16_t height;
+	uint16_t fps;
+	uint8_t load;
+	uint8_t linkQuality;
+} t_rover_discovery_status;
+
+typedef void ( *t_rover_discovery_handler_status )( void * context, t_rover_discovery_status * status );
+
 typedef struct {
 	uint16_t controlPortNo;
 	uint16_t cameraStreamPortNo;
+	uint32_t sessionToken;
+	t_rover_discovery_handler_status status;
+	void * statusContext;
+	volatile bool isAnnouncePending;
 } t_rover_discovery;
 
 
@@ -0,0 +1,408 @@
+/*
+ *	Copyright (c) 2025 Denis Rozhkov <denis@rozhkoff.com>
+ *	This file is part of cam-rover.
+ *
+ *	cam-rover is free software: you can redistribute it and/or
+ *	modify it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or (at your
+ *	option) any later version.
+ *
+ *	cam-rover is distributed in the hope that it will be
+ *	useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ *	Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along with
+ *	cam-rover. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+
+#include <stdbool.h>
+#include <inttypes.h>
+#include <string.h>
+#include <sys/param.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+
+#include "tasks.h"
+#include "dlog.h"
+
+
+#ifdef CONFIG_ROVER_DLOG
+#if ( CONFIG_ROVER_DLOG_SLOTS & ( CONFIG_ROVER_DLOG_SLOTS - 1 ) ) != 0
+#error "CONFIG_ROVER_DLOG_SLOTS has to be a power of two"
+#endif
+
+#define ROVER_DLOG_MASK ( CONFIG_ROVER_DLOG_SLOTS - 1 )
+#define ROVER_DLOG_TASK_INTERVAL_MS 50
+
+// bounded queue after D. Vyukov: a slot is free for the writer at position p when its sequence reads p and
+// holds a record for the reader when it reads p + 1; sequences are kept minus the slot index so that the
+// zeroed rings are ready before rover_dlog_init()
+typedef struct {
+	uint32_t head;
+	uint32_t tail;
+	uint32_t droppedCount;
+	t_rover_dlog_record records[CONFIG_ROVER_DLOG_SLOTS];
+} t_rover_dlog_ring;
+#endif
+
+
+static const char * roverLogTAG = "rover.dlog";
+
+#ifdef CONFIG_ROVER_DLOG
+static t_rover_dlog_ring roverDlogRings[ROVER_DLOG_CORES];
+#endif
+
+
+static size_t rover_dlog_encode( uint8_t * out, const t_rover_dlog_arg * args, size_t count )
+{
+	size_t len = 0;
+
+	for ( size_t i = 0; i < count; ++i ) {
+		const t_rover_dlog_arg * arg = &args[i];
+		size_t room = ROVER_DLOG_ARGS_LEN - len;
+
+		if ( ROVER_DLOG_ARG_STR == arg->type ) {
+			const char * str = NULL == arg->str ? "(null)" : arg->str;
+
+			if ( room < 2 ) {
+				break;
+			}
+
+			// cut to what is left of the record
+			size_t strLen = strnlen( str, MIN( room - 2, UINT8_MAX ) );
+			out[len++] = ROVER_DLOG_ARG_STR;
+			out[len++] = strLen;
+			memcpy( out + len, str, strLen );
+			len += strLen;
+
+			continue;
+		}
+
+		size_t valueLen = ROVER_DLOG_ARG_U32 == arg->type ? sizeof arg->u32 : sizeof arg->u64;
+
+		if ( room < 1 + valueLen ) {
+			break;
+		}
+
+		out[len++] = arg->type;
+		memcpy( out + len, &arg->u32, valueLen );
+		len += valueLen;
+	}
+
+	return len;
+}
+
+
+static bool rover_dlog_take( const uint8_t ** arg, const uint8_t * end, void * value, size_t len )
+{
+	if ( (size_t)( end - *arg ) < len ) {
+		return false;
+	}
+
+	memcpy( value, *arg, len );
+	*arg += len;
+
+	return true;
+}
+
+
+// one conversion of the format, spec is the whole conversion specification; the argument is converted to
+// what the specification expects where the stored type differs
+static int rover_dlog_format_arg(
+	const char * spec, const uint8_t ** arg, const uint8_t * end, char * out, size_t size )
+{
+	char conversion = spec[strlen( spec ) - 1];
+	bool isLong = strchr( spec, 'l' ) != NULL;
+	bool isLongLong = strstr( spec, "ll" ) != NULL;
+	bool isFloat = strchr( "fFeEgG", conversion ) != NULL;
+	uint8_t type = 0;
+
+	if ( !rover_dlog_take( arg, end, &type, 1 ) ) {
+		return snprintf( out, size, "?" );
+	}
+
+	if ( ROVER_DLOG_ARG_U32 == type ) {
+		uint32_t value = 0;
+
+		if ( !rover_dlog_take( arg, end, &value, sizeof value ) ) {
+			goto l_exit;
+		}
+
+		if ( 'p' == conversion ) {
+			return snprintf( out, size, spec, (void *)(uintptr_t)value );
+		}
+
+		if ( isFloat ) {
+			return snprintf( out, size, spec, (double)(int32_t)value );
+		}
+
+		if ( isLongLong ) {
+			return snprintf( out, size, spec, (unsigned long long)value );
+		}
+
+		if ( isLong ) {
+			return snprintf( out, size, spec, (unsigned long)value );
+		}
+
+		return snprintf( out, size, spec, (unsigned)value );
+	}
+	else if ( ROVER_DLOG_ARG_U64 == type ) {
+		uint64_t value = 0;
+
+		if ( !rover_dlog_take( arg, end, &value, sizeof value ) ) {
+			goto l_exit;
+		}
+
+		if ( isLongLong ) {
+			return snprintf( out, size, spec, (unsigned long long)value );
+		}
+
+		return snprintf( out, size, strchr( "di", conversion ) != NULL ? "%lld" : "%llu", (long long)value );
+	}
+	else if ( ROVER_DLOG_ARG_F64 == type ) {
+		double value = 0;
+
+		if ( !rover_dlog_take( arg, end, &value, sizeof value ) ) {
+			goto l_exit;
+		}
+
+		return snprintf( out, size, isFloat ? spec : "%g", value );
+	}
+	else if ( ROVER_DLOG_ARG_STR == type ) {
+		uint8_t len = 0;
+		char str[ROVER_DLOG_ARGS_LEN];
+
+		if ( !rover_dlog_take( arg, end, &len, 1 ) ||
+			len >= sizeof str ||
+			!rover_dlog_take( arg, end, str, len ) ) {
+
+			goto l_exit;
+		}
+
+		str[len] = '\0';
+
+		return snprintf( out, size, 's' == conversion ? spec : "%s", str );
+	}
+
+l_exit:
+	// unknown or cut short, nothing after it can be trusted
+	*arg = end;
+
+	return snprintf( out, size, "?" );
+}
+
+
+size_t rover_dlog_format( const t_rover_dlog_record * record, char * buffer, size_t size )
+{
+	const uint8_t * arg = record->args;
+	const uint8_t * end = record->args + record->argsLen;
+	const char * p = record->format;
+	size_t len = 0;
+
+	while ( *p != '\0' && len + 1 < size ) {
+		if ( *p != '%' ) {
+			buffer[len++] = *p++;
+			continue;
+		}
+
+		if ( '%' == p[1] ) {
+			buffer[len++] = '%';
+			p += 2;
+			continue;
+		}
+
+		const char * start = p++;
+
+		while ( *p != '\0' && NULL == strchr( "diouxXcsfFeEgGp", *p ) ) {
+			++p;
+		}
+
+		if ( '\0' == *p ) {
+			break;
+		}
+
+		char spec[16];
+		size_t specLen = ++p - start;
+
+		if ( specLen >= sizeof spec ) {
+			continue;
+		}
+
+		memcpy( spec, start, specLen );
+		spec[specLen] = '\0';
+
+		int n = rover_dlog_format_arg( spec, &arg, end, buffer + len, size - len );
+
+		if ( n > 0 ) {
+			len += MIN( (size_t)n, size - len - 1 );
+		}
+	}
+
+	buffer[len] = '\0';
+
+	return len;
+}
+
+
+static void rover_dlog_print( const t_rover_dlog_record * record )
+{
+	static const char levels[] = "NEWIDV";
+	char text[160];
+
+	rover_dlog_format( record, text, sizeof text );
+	esp_log_write( record->level,
+		record->tag,
+		"%c (%" PRIu32 ") %s: %s\n",
+		levels[MIN( record->level, sizeof levels - 2 )],
+		record->timestampMs,
+		record->tag,
+		text );
+}
+
+
+void rover_dlog_write(
+	esp_log_level_t level, const char * tag, const char * format, const t_rover_dlog_arg * args, size_t count )
+{
+#ifdef CONFIG_ROVER_DLOG
+	t_rover_dlog_ring * ring = &roverDlogRings[xPortGetCoreID()];
+	uint32_t pos = __atomic_load_n( &ring->head, __ATOMIC_RELAXED );
+	t_rover_dlog_record * record;
+
+	for ( ;; ) {
+		record = &ring->records[pos & ROVER_DLOG_MASK];
+		uint32_t sequence = __atomic_load_n( &record->sequence, __ATOMIC_ACQUIRE ) + ( pos & ROVER_DLOG_MASK );
+		int32_t diff = (int32_t)( sequence - pos );
+
+		if ( 0 == diff ) {
+			// on failure pos is reloaded
+			if ( __atomic_compare_exchange_n(
+					 &ring->head, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED ) ) {
+
+				break;
+			}
+		}
+		else if ( diff < 0 ) {
+			__atomic_add_fetch( &ring->droppedCount, 1, __ATOMIC_RELAXED );
+			return;
+		}
+		else {
+			pos = __atomic_load_n( &ring->head, __ATOMIC_RELAXED );
+		}
+	}
+
+	record->timestampMs = esp_log_timestamp();
+	record->format = format;
+	record->tag = tag;
+	record->level = level;
+	record->argsLen = rover_dlog_encode( record->args, args, count );
+
+	__atomic_store_n( &record->sequence, pos + 1 - ( pos & ROVER_DLOG_MASK ), __ATOMIC_RELEASE );
+#else
+	t_rover_dlog_record record = { .timestampMs = esp_log_timestamp(), .format = format, .tag = tag, .level = level };
+	record.argsLen = rover_dlog_encode( record.args, args, count );
+
+	rover_dlog_print( &record );
+#endif
+}
+
+
+bool rover_dlog_read( t_rover_dlog_record * out )
+{
+#ifdef CONFIG_ROVER_DLOG
+	for ( ;; ) {
+		t_rover_dlog_ring * oldest = NULL;
+		uint32_t oldestPos = 0;
+		uint32_t oldestMs = 0;
+
+		for ( size_t i = 0; i < ROVER_DLOG_CORES; ++i ) {
+			t_rover_dlog_ring * ring = &roverDlogRings[i];
+			uint32_t pos = __atomic_load_n( &ring->tail, __ATOMIC_RELAXED );
+			t_rover_dlog_record * record = &ring->records[pos & ROVER_DLOG_MASK];
+			uint32_t sequence = __atomic_load_n( &record->sequence, __ATOMIC_ACQUIRE ) + ( pos & ROVER_DLOG_MASK );
+			bool isReady = sequence == pos + 1;
+
+			if ( isReady && ( NULL == oldest || (int32_t)( record->timestampMs - oldestMs ) < 0 ) ) {
+				oldest = ring;
+				oldestPos = pos;
+				oldestMs = record->timestampMs;
+			}
+		}
+
+		if ( NULL == oldest ) {
+			return false;
+		}
+
+		// another reader may have taken it meanwhile
+		if ( __atomic_compare_exchange_n(
+				 &oldest->tail, &oldestPos, oldestPos + 1, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED ) ) {
+
+			t_rover_dlog_record * record = &oldest->records[oldestPos & ROVER_DLOG_MASK];
+			*out = *record;
+			__atomic_store_n( &record->sequence,
+				oldestPos + CONFIG_ROVER_DLOG_SLOTS - ( oldestPos & ROVER_DLOG_MASK ),
+				__ATOMIC_RELEASE );
+
+			return true;
+		}
+	}
+#else
+	return false;
+#endif
+}
+
+
+uint32_t rover_dlog_get_dropped( void )
+{
+	uint32_t count = 0;
+
+#ifdef CONFIG_ROVER_DLOG
+	for ( size_t i = 0; i < ROVER_DLOG_CORES; ++i ) {
+		count += __atomic_load_n( &roverDlogRings[i].droppedCount, __ATOMIC_RELAXED );
+	}
+#endif
+
+	return count;
+}
+
+
+#ifdef CONFIG_ROVER_DLOG_CONSOLE
+static void rover_dlog_task( void * params )
+{
+	uint32_t droppedReported = 0;
+
+	for ( ;; ) {
+		t_rover_dlog_record record;
+
+		while ( rover_dlog_read( &record ) ) {
+			rover_dlog_print( &record );
+		}
+
+		uint32_t dropped = rover_dlog_get_dropped();
+
+		if ( dropped != droppedReported ) {
+			ESP_LOGW( roverLogTAG, "%" PRIu32 " records dropped", dropped - droppedReported );
+			droppedReported = dropped;
+		}
+
+		vTaskDelay( pdMS_TO_TICKS( ROVER_DLOG_TASK_INTERVAL_MS ) );
+	}
+}
+#endif
+
+
+void rover_dlog_init( void )
+{
+#if defined( CONFIG_ROVER_DLOG_CONSOLE )
+	rover_task_create( ROVER_TASK_LOG, rover_dlog_task, NULL, NULL );
+#elif defined( CONFIG_ROVER_DLOG )
+	ESP_LOGI( roverLogTAG, "%d records per core kept for GET /log", CONFIG_ROVER_DLOG_SLOTS );
+#endif
+}
@@ -0,0 +1,173 @@
+/*
+ *	Copyright (c) 2025 Denis Rozhkov <denis@rozhkoff.com>
+ *	This file is part of cam-rover.
+ *
+ *	cam-rover is free software: you can redistribute it and/or
+ *	modify it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or (at your
+ *	option) any later version.
+ *
+ *	cam-rover is distributed in the hope that it will be
+ *	useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ *	Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along with
+ *	cam-rover. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+
+#ifndef __ROVER__DLOG__H
+#define __ROVER__DLOG__H
+
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "esp_log.h"
+
+
+// deferred logging: a call records the format string address and the raw arguments, the text is made later
+// by the log task or, from a /log dump, by tools/dlog_decode.py with the firmware ELF. Formats and tags have
+// to be string literals, %s arguments are copied; other pointers are passed as void *
+
+#define ROVER_DLOG_CORES 2
+#define ROVER_DLOG_RECORD_LEN 80
+#define ROVER_DLOG_ARGS_LEN ( ROVER_DLOG_RECORD_LEN - 18 )
+// /log dump: magic, version, record length, dropped count (u32), then the records without their sequence
+#define ROVER_DLOG_DUMP_MAGIC "RDLG"
+#define ROVER_DLOG_DUMP_VERSION 1
+#define ROVER_DLOG_DUMP_HEADER_LEN 10
+
+// argument encoding: type byte, then 4 or 8 bytes little endian, or a length byte and the characters
+typedef enum {
+	ROVER_DLOG_ARG_U32 = 1,
+	ROVER_DLOG_ARG_U64,
+	ROVER_DLOG_ARG_F64,
+	ROVER_DLOG_ARG_STR,
+	// arguments that did not fit into the record
+	ROVER_DLOG_ARG_TRUNCATED
+} t_rover_dlog_arg_type;
+
+typedef struct {
+	uint8_t type;
+	union {
+		uint32_t u32;
+		uint64_t u64;
+		double f64;
+		const char * str;
+	};
+} t_rover_dlog_arg;
+
+typedef struct {
+	// position in the ring, relative to the slot index
+	uint32_t sequence;
+	uint32_t timestampMs;
+	const char * format;
+	const char * tag;
+	uint8_t level;
+	uint8_t argsLen;
+	uint8_t args[ROVER_DLOG_ARGS_LEN];
+} t_rover_dlog_record;
+
+
+static inline t_rover_dlog_arg rover_dlog_arg_u32( uint32_t value )
+{
+	return ( t_rover_dlog_arg ){ .type = ROVER_DLOG_ARG_U32, .u32 = value };
+}
+
+
+static inline t_rover_dlog_arg rover_dlog_arg_u64( uint64_t value )
+{
+	return ( t_rover_dlog_arg ){ .type = ROVER_DLOG_ARG_U64, .u64 = value };
+}
+
+
+static inline t_rover_dlog_arg rover_dlog_arg_f64( double value )
+{
+	return ( t_rover_dlog_arg ){ .type = ROVER_DLOG_ARG_F64, .f64 = value };
+}
+
+
+static inline t_rover_dlog_arg rover_dlog_arg_ptr( const void * value )
+{
+	return ( t_rover_dlog_arg ){ .type = ROVER_DLOG_ARG_U32, .u32 = (uintptr_t)value };
+}
+
+
+static inline t_rover_dlog_arg rover_dlog_arg_str( const char * value )
+{
+	return ( t_rover_dlog_arg ){ .type = ROVER_DLOG_ARG_STR, .str = value };
+}
+
+
+#define ROVER_DLOG_ARG( a_value )                                                                                      \
+	_Generic( ( a_value ),                                                                                             \
+		char *: rover_dlog_arg_str,                                                                                    \
+		const char *: rover_dlog_arg_str,                                                                              \
+		int64_t: rover_dlog_arg_u64,                                                                                   \
+		uint64_t: rover_dlog_arg_u64,                                                                                  \
+		float: rover_dlog_arg_f64,                                                                                     \
+		double: rover_dlog_arg_f64,                                                                                    \
+		void *: rover_dlog_arg_ptr,                                                                                    \
+		const void *: rover_dlog_arg_ptr,                                                                              \
+		default: rover_dlog_arg_u32 )( a_value )
+
+#define ROVER_DLOG_MAP_0()
+#define ROVER_DLOG_MAP_1( a_1 ) ROVER_DLOG_ARG( a_1 )
+#define ROVER_DLOG_MAP_2( a_1, ... ) ROVER_DLOG_ARG( a_1 ), ROVER_DLOG_MAP_1( __VA_ARGS__ )
+#define ROVER_DLOG_MAP_3( a_1, ... ) ROVER_DLOG_ARG( a_1 ), ROVER_DLOG_MAP_2( __VA_ARGS__ )
+#define ROVER_DLOG_MAP_4( a_1, ... ) ROVER_DLOG_ARG( a_1 ), ROVER_DLOG_MAP_3( __VA_ARGS__ )
+#define ROVER_DLOG_MAP_5( a_1, ... ) ROVER_DLOG_ARG( a_1 ), ROVER_DLOG_MAP_4( __VA_ARGS__ )
+#define ROVER_DLOG_MAP_6( a_1, ... ) ROVER_DLOG_ARG( a_1 ), ROVER_DLOG_MAP_5( __VA_ARGS__ )
+#define ROVER_DLOG_MAP_7( a_1, ... ) ROVER_DLOG_ARG( a_1 ), ROVER_DLOG_MAP_6( __VA_ARGS__ )
+#define ROVER_DLOG_MAP_8( a_1, ... ) ROVER_DLOG_ARG( a_1 ), ROVER_DLOG_MAP_7( __VA_ARGS__ )
+#define ROVER_DLOG_MAP_SELECT( a_0, a_1, a_2, a_3, a_4, a_5, a_6, a_7, a_8, a_map, ... ) a_map
+// up to 8 arguments
+#define ROVER_DLOG_MAP( ... )                                                                                          \
+	ROVER_DLOG_MAP_SELECT( 0,                                                                                          \
+		##__VA_ARGS__,                                                                                                 \
+		ROVER_DLOG_MAP_8,                                                                                              \
+		ROVER_DLOG_MAP_7,                                                                                              \
+		ROVER_DLOG_MAP_6,                                                                                              \
+		ROVER_DLOG_MAP_5,                                                                                              \
+		ROVER_DLOG_MAP_4,                                                                                              \
+		ROVER_DLOG_MAP_3,                                                                                              \
+		ROVER_DLOG_MAP_2,                                                                                              \
+		ROVER_DLOG_MAP_1,                                                                                              \
+		ROVER_DLOG_MAP_0 )                                                                                             \
+	( __VA_ARGS__ )
+
+// levels above LOG_LOCAL_LEVEL are compiled out, like ESP_LOGx
+#define ROVER_DLOG( a_level, a_tag, a_format, ... )                                                                    \
+	do {                                                                                                               \
+		if ( ( a_level ) <= LOG_LOCAL_LEVEL ) {                                                                        \
+			const t_rover_dlog_arg roverDlogArgs[] = { ROVER_DLOG_MAP( __VA_ARGS__ ) };                                \
+			rover_dlog_write(                                                                                          \
+				( a_level ), ( a_tag ), ( a_format ), roverDlogArgs, sizeof roverDlogArgs / sizeof *roverDlogArgs );   \
+		}                                                                                                              \
+	} while ( 0 )
+
+#define ROVER_DLOGE( a_tag, a_format, ... ) ROVER_DLOG( ESP_LOG_ERROR, a_tag, a_format, ##__VA_ARGS__ )
+#define ROVER_DLOGW( a_tag, a_format, ... ) ROVER_DLOG( ESP_LOG_WARN, a_tag, a_format, ##__VA_ARGS__ )
+#define ROVER_DLOGI( a_tag, a_format, ... ) ROVER_DLOG( ESP_LOG_INFO, a_tag, a_format, ##__VA_ARGS__ )
+#define ROVER_DLOGD( a_tag, a_format, ... ) ROVER_DLOG( ESP_LOG_DEBUG, a_tag, a_format, ##__VA_ARGS__ )
+
+
+// starts the log task, records written before are kept
+void rover_dlog_init( void );
+// never blocks, the record is dropped when the ring of the calling core is full
+void rover_dlog_write(
+	esp_log_level_t level, const char * tag, const char * format, const t_rover_dlog_arg * args, size_t count );
+// the oldest pending record of all cores, false when there is none
+bool rover_dlog_read( t_rover_dlog_record * out );
+// the record's text without the level, timestamp and tag, always terminated
+size_t rover_dlog_format( const t_rover_dlog_record * record, char * buffer, size_t size );
+uint32_t rover_dlog_get_dropped( void );
+
+
+#endif
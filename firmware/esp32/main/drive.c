@@ -23,15 +23,15 @@
 
 #include "types.h"
 #include "drive.h"
+#include "pool.h"
 
 
 #define ROVER_DRIVE_MCPWM_TIMER_RESOLUTION_HZ ( 1000 * 1000 )
-#define ROVER_DRIVE_MCPWM_FREQ_HZ ( 10 * 1000 )
 
-#define ROVER_DRIVE_MCPWM_GPIO1_A 13
-#define ROVER_DRIVE_MCPWM_GPIO1_B 15
-#define ROVER_DRIVE_MCPWM_GPIO2_A 14
-#define ROVER_DRIVE_MCPWM_GPIO2_B 2
+#define ROVER_DRIVE_MCPWM_GPIO1_A CONFIG_ROVER_DRIVE_GPIO1_A
+#define ROVER_DRIVE_MCPWM_GPIO1_B CONFIG_ROVER_DRIVE_GPIO1_B
+#define ROVER_DRIVE_MCPWM_GPIO2_A CONFIG_ROVER_DRIVE_GPIO2_A
+#define ROVER_DRIVE_MCPWM_GPIO2_B CONFIG_ROVER_DRIVE_GPIO2_B
 
 
 static const char * roverLogTAG = "rover.drive";
@@ -44,7 +44,6 @@ static void rover_drive_init_motor_config( bdc_motor_config_t * config,
 	uint32_t gpioB )
 {
 
-	ROVER_CAMER_SET_DEFAULT( pwm->freqHz, ROVER_DRIVE_MCPWM_FREQ_HZ );
 	ROVER_CAMER_SET_DEFAULT( gpio->gpioNumA, gpioA );
 	ROVER_CAMER_SET_DEFAULT( gpio->gpioNumB, gpioB );
 
@@ -54,7 +53,33 @@ static void rover_drive_init_motor_config( bdc_motor_config_t * config,
 }
 
 
-void rover_drive_init( t_rover_drive * drive )
+// the previous curve is released once the new one is in place
+static bool rover_drive_build_speed_curve( t_rover_drive * drive, uint32_t dutyTickMax )
+{
+	t_rover_ptr * storage = rover_pool_alloc( ROVER_POOL_BLOB, ( dutyTickMax + 1 ) * sizeof( uint32_t ) );
+
+	if ( NULL == storage ) {
+		return false;
+	}
+
+	uint32_t * speedCurve = storage->data;
+	size_t limit = dutyTickMax;
+
+	for ( size_t i = 0; i < limit + 1; ++i ) {
+		speedCurve[i] = limit - ( ( limit - i ) * ( limit - i ) / ( 1 * limit ) );
+	}
+
+	rover_pool_release( drive->speedCurveStorage );
+	drive->speedCurveStorage = storage;
+	drive->speedCurve = speedCurve;
+	drive->pwm.dutyTickMax = dutyTickMax;
+	drive->deadzone = dutyTickMax * drive->deadzonePermille / 1000;
+
+	return true;
+}
+
+
+static void rover_drive_create_motors( t_rover_drive * drive )
 {
 	bdc_motor_config_t motor1Config;
 	rover_drive_init_motor_config(
@@ -64,30 +89,17 @@ void rover_drive_init( t_rover_drive * drive )
 	rover_drive_init_motor_config(
 		&motor2Config, &drive->pwm, &drive->motor2.gpio, ROVER_DRIVE_MCPWM_GPIO2_A, ROVER_DRIVE_MCPWM_GPIO2_B );
 
-	ROVER_CAMER_SET_DEFAULT( drive->pwm.timerResolutionHz, ROVER_DRIVE_MCPWM_TIMER_RESOLUTION_HZ );
-
 	bdc_motor_mcpwm_config_t mcpwmConfig = { .group_id = 0, .resolution_hz = drive->pwm.timerResolutionHz };
 
-	drive->pwm.dutyTickMax = drive->pwm.timerResolutionHz / drive->pwm.freqHz;
-	drive->speedCurve = malloc( ( drive->pwm.dutyTickMax + 1 ) * sizeof( uint32_t ) );
-
-	{
-		size_t limit = drive->pwm.dutyTickMax;
-
-		for ( size_t i = 0; i < limit + 1; ++i ) {
-			drive->speedCurve[i] = limit - ( ( limit - i ) * ( limit - i ) / ( 1 * limit ) );
-		}
-
-		drive->deadzone = limit / 3;
-	}
-
 	bdc_motor_handle_t motor1 = NULL;
 	ESP_ERROR_CHECK( bdc_motor_new_mcpwm_device( &motor1Config, &mcpwmConfig, &motor1 ) );
 	drive->motor1.handle = motor1;
+	drive->motor1.speed = 0;
 
 	bdc_motor_handle_t motor2 = NULL;
 	ESP_ERROR_CHECK( bdc_motor_new_mcpwm_device( &motor2Config, &mcpwmConfig, &motor2 ) );
 	drive->motor2.handle = motor2;
+	drive->motor2.speed = 0;
 
 	bdc_motor_set_speed( motor1, 0 );
 	bdc_motor_set_speed( motor2, 0 );
@@ -100,6 +112,62 @@ void rover_drive_init( t_rover_drive * drive )
 }
 
 
+static void rover_drive_delete_motors( t_rover_drive * drive )
+{
+	bdc_motor_disable( drive->motor1.handle );
+	bdc_motor_disable( drive->motor2.handle );
+	bdc_motor_del( drive->motor1.handle );
+	bdc_motor_del( drive->motor2.handle );
+}
+
+
+void rover_drive_init( t_rover_drive * drive )
+{
+	drive->sync = xSemaphoreCreateMutexStatic( &drive->syncBuffer );
+
+	ROVER_CAMER_SET_DEFAULT( drive->pwm.freqHz, ROVER_DRIVE_PWM_FREQ_HZ_DEFAULT );
+	ROVER_CAMER_SET_DEFAULT( drive->pwm.timerResolutionHz, ROVER_DRIVE_MCPWM_TIMER_RESOLUTION_HZ );
+	ROVER_CAMER_SET_DEFAULT( drive->deadzonePermille, ROVER_DRIVE_DEADZONE_DEFAULT );
+
+	bool isBuilt = rover_drive_build_speed_curve( drive, drive->pwm.timerResolutionHz / drive->pwm.freqHz );
+	ESP_ERROR_CHECK( isBuilt ? ESP_OK : ESP_ERR_NO_MEM );
+
+	rover_drive_create_motors( drive );
+}
+
+
+void rover_drive_set_deadzone( t_rover_drive * drive, uint16_t permille )
+{
+	drive->deadzonePermille = permille;
+	drive->deadzone = drive->pwm.dutyTickMax * permille / 1000;
+}
+
+
+bool rover_drive_set_pwm_freq( t_rover_drive * drive, uint32_t freqHz )
+{
+	xSemaphoreTake( drive->sync, portMAX_DELAY );
+
+	bool r = rover_drive_build_speed_curve( drive, drive->pwm.timerResolutionHz / freqHz );
+
+	if ( r ) {
+		rover_drive_delete_motors( drive );
+		drive->pwm.freqHz = freqHz;
+		rover_drive_create_motors( drive );
+	}
+
+	xSemaphoreGive( drive->sync );
+
+	if ( r ) {
+		ESP_LOGI( roverLogTAG, "PWM %u Hz, %u duty ticks", (unsigned)freqHz, (unsigned)drive->pwm.dutyTickMax );
+	}
+	else {
+		ESP_LOGW( roverLogTAG, "no blob block for the speed curve of %u Hz", (unsigned)freqHz );
+	}
+
+	return r;
+}
+
+
 int32_t rover_drive_change_motor_speed( t_rover_drive * drive, t_rover_drive_motor * motor, int32_t speedInc )
 {
 	int32_t speed = motor->speed;
@@ -139,7 +207,9 @@ _l_exit:
 t_rover_motors_speed rover_drive_change_speed( t_rover_drive * drive, int32_t motor1SpeedInc, int32_t motor2SpeedInc )
 {
 	t_rover_motors_speed r;
+	xSemaphoreTake( drive->sync, portMAX_DELAY );
 	r.motor1 = rover_drive_change_motor_speed( drive, &drive->motor1, motor1SpeedInc );
 	r.motor2 = rover_drive_change_motor_speed( drive, &drive->motor2, motor2SpeedInc );
+	xSemaphoreGive( drive->sync );
 	return r;
 }
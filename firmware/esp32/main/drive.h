@@ -23,8 +23,19 @@
 #define __ROVER__DRIVE__H
 
 
+#include <stdbool.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
 #include "bdc_motor.h"
 
+#include "types.h"
+
+
+#define ROVER_DRIVE_PWM_FREQ_HZ_DEFAULT ( 10 * 1000 )
+// permille of the full duty
+#define ROVER_DRIVE_DEADZONE_DEFAULT 333
 
 typedef struct {
 	uint32_t gpioNumA;
@@ -47,13 +58,26 @@ typedef struct {
 	t_rover_drive_motor motor1;
 	t_rover_drive_motor motor2;
 	t_rover_drive_pwm pwm;
+	// duty ticks added to any non-zero speed, follows deadzonePermille and the PWM frequency
 	uint32_t deadzone;
+	uint16_t deadzonePermille;
+	// points into speedCurveStorage, a block of the blob pool
 	uint32_t * speedCurve;
+	t_rover_ptr * speedCurveStorage;
+	// held while the motors are driven, a PWM frequency change replaces them and the speed curve
+	SemaphoreHandle_t sync;
+	StaticSemaphore_t syncBuffer;
 } t_rover_drive;
 
 
+// pwm.freqHz and deadzonePermille may be set beforehand
 void rover_drive_init( t_rover_drive * drive );
+// drive->sync has to be held, see rover_drive_change_speed()
 int32_t rover_drive_change_motor_speed( t_rover_drive * drive, t_rover_drive_motor * motor, int32_t speedInc );
+void rover_drive_set_deadzone( t_rover_drive * drive, uint16_t permille );
+// stops the motors, speeds are in duty ticks of the new frequency afterwards; false if the new speed curve
+// does not fit, the frequency is kept then
+bool rover_drive_set_pwm_freq( t_rover_drive * drive, uint32_t freqHz );
 t_rover_motors_speed rover_drive_change_speed( t_rover_drive * drive, int32_t motor1SpeedInc, int32_t motor2SpeedInc );
 
 
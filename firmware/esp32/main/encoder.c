@@ -0,0 +1,229 @@
+/*
+ *	Copyright (c) 2025 Denis Rozhkov <denis@rozhkoff.com>
+ *	This file is part of cam-rover.
+ *
+ *	cam-rover is free software: you can redistribute it and/or
+ *	modify it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or (at your
+ *	option) any later version.
+ *
+ *	cam-rover is distributed in the hope that it will be
+ *	useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ *	Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along with
+ *	cam-rover. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <string.h>
+#include <stdlib.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+
+#include "tasks.h"
+#include "encoder.h"
+#include "dlog.h"
+
+
+static const char * roverLogTAG = "rover.encoder";
+
+
+static void rover_encoder_task( void * parameters )
+{
+	t_rover_encoder_worker * worker = (t_rover_encoder_worker *)parameters;
+	t_rover_encoder * encoder = worker->encoder;
+
+	while ( true ) {
+		ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+
+		uint32_t firstRow;
+		uint32_t rowCount;
+		rover_jpeg_band( &encoder->jpeg, worker->bandIndex, encoder->bandCount, &firstRow, &rowCount );
+
+		worker->out.len = 0;
+		worker->isOk = rover_jpeg_encode_rows( &encoder->jpeg, encoder->pixels, firstRow, rowCount, &worker->out );
+
+		xSemaphoreGive( encoder->done );
+	}
+}
+
+
+static void rover_encoder_free( t_rover_encoder * encoder )
+{
+	free( encoder->out.data );
+	encoder->out.data = NULL;
+	encoder->out.size = 0;
+
+	for ( size_t i = 1; i < ROVER_ENCODER_BANDS; ++i ) {
+		free( encoder->workers[i].out.data );
+		encoder->workers[i].out.data = NULL;
+		encoder->workers[i].out.size = 0;
+	}
+}
+
+
+// a JPEG is assumed to stay under half of the raw frame, frames that do not fit are dropped
+static bool rover_encoder_resize( t_rover_encoder * encoder, uint32_t width, uint32_t height )
+{
+	size_t rawSize = width * height * ( ROVER_JPEG_FORMAT_RGB565 == encoder->format ? 2 : 1 );
+
+	rover_encoder_free( encoder );
+	rover_jpeg_init( &encoder->jpeg, width, height, encoder->format, encoder->quality );
+
+	encoder->out.size = ROVER_JPEG_HEADER_SIZE_MAX + rawSize / 2;
+	encoder->out.data = heap_caps_malloc( encoder->out.size, MALLOC_CAP_SPIRAM );
+
+	for ( size_t i = 1; i < ROVER_ENCODER_BANDS; ++i ) {
+		t_rover_buffer * out = &encoder->workers[i].out;
+		out->size = rawSize / 2 / ROVER_ENCODER_BANDS + 1024;
+		out->data = heap_caps_malloc( out->size, MALLOC_CAP_SPIRAM );
+
+		if ( NULL == out->data ) {
+			encoder->out.size = 0;
+		}
+	}
+
+	if ( NULL == encoder->out.data || 0 == encoder->out.size ) {
+		ESP_LOGE( roverLogTAG, "failed to allocate buffers for %ux%u", (unsigned)width, (unsigned)height );
+		rover_encoder_free( encoder );
+		encoder->jpeg.width = 0;
+
+		return false;
+	}
+
+	return true;
+}
+
+
+static bool rover_encoder_run( t_rover_encoder * encoder, const uint8_t * pixels, uint32_t bandCount )
+{
+	encoder->pixels = pixels;
+	encoder->bandCount = bandCount;
+	encoder->out.len = 0;
+
+	if ( !rover_jpeg_write_header( &encoder->jpeg, &encoder->out ) ) {
+		return false;
+	}
+
+	for ( size_t i = 1; i < bandCount; ++i ) {
+		xTaskNotifyGive( encoder->workers[i].task );
+	}
+
+	uint32_t firstRow;
+	uint32_t rowCount;
+	rover_jpeg_band( &encoder->jpeg, 0, bandCount, &firstRow, &rowCount );
+
+	bool isOk = rover_jpeg_encode_rows( &encoder->jpeg, pixels, firstRow, rowCount, &encoder->out );
+
+	for ( size_t i = 1; i < bandCount; ++i ) {
+		xSemaphoreTake( encoder->done, portMAX_DELAY );
+	}
+
+	// bands end on a restart marker, so they are simply appended
+	for ( size_t i = 1; i < bandCount && isOk; ++i ) {
+		t_rover_buffer * band = &encoder->workers[i].out;
+		isOk = encoder->workers[i].isOk && encoder->out.len + band->len <= encoder->out.size;
+
+		if ( isOk ) {
+			memcpy( encoder->out.data + encoder->out.len, band->data, band->len );
+			encoder->out.len += band->len;
+		}
+	}
+
+	return isOk && rover_jpeg_write_trailer( &encoder->out );
+}
+
+
+static void rover_encoder_log( t_rover_encoder * encoder, const uint8_t * pixels )
+{
+	size_t rawSize = encoder->jpeg.width * encoder->jpeg.height * ( ROVER_JPEG_FORMAT_RGB565 == encoder->format ? 2 : 1 );
+	int64_t encodeUs = encoder->statEncodeUs / encoder->statFrameCount;
+
+	ROVER_DLOGI( roverLogTAG,
+		"%u frames (%u failed): %u bytes/frame, encode %u us/frame, %u KB/s raw",
+		(unsigned)encoder->statFrameCount,
+		(unsigned)encoder->statFailedCount,
+		(unsigned)( encoder->statByteCount / encoder->statFrameCount ),
+		(unsigned)encodeUs,
+		(unsigned)( encodeUs > 0 ? rawSize * 1000 / encodeUs : 0 ) );
+
+#ifdef CONFIG_ROVER_BENCH_JPEG
+	int64_t startUs = esp_timer_get_time();
+	bool isOk = rover_encoder_run( encoder, pixels, 1 );
+	encodeUs = esp_timer_get_time() - startUs;
+
+	ROVER_DLOGI( roverLogTAG,
+		"single band: %u bytes, encode %u us, %u KB/s raw",
+		(unsigned)( isOk ? encoder->out.len : 0 ),
+		(unsigned)encodeUs,
+		(unsigned)( encodeUs > 0 ? rawSize * 1000 / encodeUs : 0 ) );
+#endif
+
+	encoder->statFrameCount = 0;
+	encoder->statFailedCount = 0;
+	encoder->statByteCount = 0;
+	encoder->statEncodeUs = 0;
+}
+
+
+bool rover_encoder_start( t_rover_encoder * encoder, t_rover_jpeg_format format, uint8_t quality )
+{
+	encoder->format = format;
+	encoder->quality = quality;
+	encoder->done = xSemaphoreCreateCountingStatic( ROVER_ENCODER_BANDS, 0, &encoder->doneBuffer );
+
+	for ( size_t i = 1; i < ROVER_ENCODER_BANDS; ++i ) {
+		t_rover_encoder_worker * worker = &encoder->workers[i];
+		worker->encoder = encoder;
+		worker->bandIndex = i;
+
+		if ( rover_task_create( ROVER_TASK_ENCODER, &rover_encoder_task, worker, &worker->task ) != pdPASS ) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+// returns the JPEG length, 0 if the frame could not be encoded; *data stays valid until the next call
+size_t rover_encoder_encode( t_rover_encoder * encoder, const uint8_t * pixels, uint32_t width, uint32_t height, uint8_t ** data )
+{
+	if ( ( encoder->jpeg.width != width || encoder->jpeg.height != height ) &&
+		!rover_encoder_resize( encoder, width, height ) ) {
+
+		return 0;
+	}
+
+	int64_t startUs = esp_timer_get_time();
+	bool isOk = rover_encoder_run( encoder, pixels, ROVER_ENCODER_BANDS );
+
+	encoder->statEncodeUs += esp_timer_get_time() - startUs;
+	encoder->statFrameCount++;
+
+	if ( isOk ) {
+		encoder->statByteCount += encoder->out.len;
+	}
+	else {
+		encoder->statFailedCount++;
+	}
+
+	if ( encoder->statFrameCount >= CONFIG_ROVER_CAMERA_JPEG_LOG_FRAMES ) {
+		rover_encoder_log( encoder, pixels );
+
+#ifdef CONFIG_ROVER_BENCH_JPEG
+		// the benchmark reuses the output buffer, encode the frame again for the caller
+		isOk = rover_encoder_run( encoder, pixels, ROVER_ENCODER_BANDS );
+#endif
+	}
+
+	*data = encoder->out.data;
+
+	return isOk ? encoder->out.len : 0;
+}
@@ -0,0 +1,74 @@
+/*
+ *	Copyright (c) 2025 Denis Rozhkov <denis@rozhkoff.com>
+ *	This file is part of cam-rover.
+ *
+ *	cam-rover is free software: you can redistribute it and/or
+ *	modify it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or (at your
+ *	option) any later version.
+ *
+ *	cam-rover is distributed in the hope that it will be
+ *	useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ *	Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along with
+ *	cam-rover. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef __ROVER__ENCODER__H
+#define __ROVER__ENCODER__H
+
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#include "types.h"
+#include "jpeg.h"
+
+
+// one band per core, band 0 is encoded by the calling task
+#define ROVER_ENCODER_BANDS 2
+
+
+struct t_rover_encoder;
+
+typedef struct {
+	struct t_rover_encoder * encoder;
+	uint32_t bandIndex;
+	t_rover_buffer out;
+	bool isOk;
+	TaskHandle_t task;
+} t_rover_encoder_worker;
+
+typedef struct t_rover_encoder {
+	t_rover_jpeg jpeg;
+	t_rover_jpeg_format format;
+	uint8_t quality;
+	const uint8_t * pixels;
+	uint32_t bandCount;
+	t_rover_buffer out;
+	t_rover_encoder_worker workers[ROVER_ENCODER_BANDS];
+	StaticSemaphore_t doneBuffer;
+	SemaphoreHandle_t done;
+
+	uint32_t statFrameCount;
+	uint32_t statFailedCount;
+	uint64_t statByteCount;
+	int64_t statEncodeUs;
+} t_rover_encoder;
+
+
+bool rover_encoder_start( t_rover_encoder * encoder, t_rover_jpeg_format format, uint8_t quality );
+size_t rover_encoder_encode( t_rover_encoder * encoder, const uint8_t * pixels, uint32_t width, uint32_t height, uint8_t ** data );
+
+
+#endif
@@ -0,0 +1,228 @@
+/*
+ *	Copyright (c) 2025 Denis Rozhkov <denis@rozhkoff.com>
+ *	This file is part of cam-rover.
+ *
+ *	cam-rover is free software: you can redistribute it and/or
+ *	modify it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or (at your
+ *	option) any later version.
+ *
+ *	cam-rover is distributed in the hope that it will be
+ *	useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ *	Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along with
+ *	cam-rover. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+
+#include "history.h"
+
+
+#define ROVER_HISTORY_WRAP UINT32_MAX
+#define ROVER_HISTORY_SPAN( a_len ) ( ( sizeof( t_rover_history_entry ) + ( a_len ) + 3 ) & ~(size_t)3 )
+
+
+static const char * roverLogTAG = "rover.history";
+
+
+static inline t_rover_history_entry * rover_history_entry_at( t_rover_history * history, size_t offset )
+{
+	return (t_rover_history_entry *)( history->arena + offset );
+}
+
+
+// entries never straddle the end of the arena: a wrap marker (or a too short tail) sends readers back to 0
+static size_t rover_history_next( t_rover_history * history, size_t offset )
+{
+	if ( offset + sizeof( t_rover_history_entry ) > history->size ||
+		ROVER_HISTORY_WRAP == rover_history_entry_at( history, offset )->len ) {
+
+		return 0;
+	}
+
+	return offset;
+}
+
+
+static void rover_history_evict( t_rover_history * history )
+{
+	history->head += ROVER_HISTORY_SPAN( rover_history_entry_at( history, history->head )->len );
+	history->count--;
+
+	if ( 0 == history->count ) {
+		history->head = 0;
+		history->tail = 0;
+	}
+	else {
+		history->head = rover_history_next( history, history->head );
+	}
+}
+
+
+static bool rover_history_reserve( t_rover_history * history, size_t span, size_t * offset )
+{
+	if ( span > history->size / 2 ) {
+		return false;
+	}
+
+	while ( true ) {
+		bool isWrapped = history->tail < history->head || ( history->tail == history->head && history->count > 0 );
+
+		if ( !isWrapped ) {
+			if ( history->size - history->tail >= span ) {
+				*offset = history->tail;
+				return true;
+			}
+
+			if ( 0 == history->head ) {
+				rover_history_evict( history );
+				continue;
+			}
+
+			if ( history->size - history->tail >= sizeof( t_rover_history_entry ) ) {
+				rover_history_entry_at( history, history->tail )->len = ROVER_HISTORY_WRAP;
+			}
+
+			history->tail = 0;
+			continue;
+		}
+
+		if ( history->head - history->tail >= span ) {
+			*offset = history->tail;
+			return true;
+		}
+
+		rover_history_evict( history );
+	}
+}
+
+
+bool rover_history_init( t_rover_history * history, size_t size )
+{
+	// one allocation for the whole lifetime, entries are carved out of it
+	history->arena = heap_caps_malloc( size, MALLOC_CAP_SPIRAM );
+
+	if ( NULL == history->arena ) {
+		ESP_LOGE( roverLogTAG, "Failed to allocate %u bytes", (unsigned)size );
+		return false;
+	}
+
+	history->size = size;
+	history->head = 0;
+	history->tail = 0;
+	history->count = 0;
+	history->sync = xSemaphoreCreateMutexStatic( &history->syncBuffer );
+
+	return true;
+}
+
+
+void rover_history_append( t_rover_history * history, const t_rover_camera_frame * frame )
+{
+	if ( NULL == history->arena ) {
+		return;
+	}
+
+	// readers only hold the lock for a copy, but capture must never wait for them
+	if ( xSemaphoreTake( history->sync, 0 ) != pdTRUE ) {
+		history->droppedCount++;
+		return;
+	}
+
+	size_t offset;
+
+	if ( rover_history_reserve( history, ROVER_HISTORY_SPAN( frame->len ), &offset ) ) {
+		t_rover_history_entry * entry = rover_history_entry_at( history, offset );
+		entry->timestampUs = frame->timestampUs;
+		entry->seq = history->nextSeq++;
+		entry->len = frame->len;
+		memcpy( entry + 1, frame->ptr, frame->len );
+
+		history->tail = offset + ROVER_HISTORY_SPAN( frame->len );
+		history->count++;
+	}
+	else {
+		history->droppedCount++;
+	}
+
+	xSemaphoreGive( history->sync );
+}
+
+
+size_t rover_history_list( t_rover_history * history,
+	int64_t fromUs,
+	int64_t toUs,
+	t_rover_history_entry * out,
+	size_t maxCount )
+{
+	size_t r = 0;
+
+	if ( NULL == history->arena ) {
+		return r;
+	}
+
+	xSemaphoreTake( history->sync, portMAX_DELAY );
+
+	size_t offset = history->head;
+
+	for ( uint32_t i = 0; i < history->count && r < maxCount; ++i ) {
+		t_rover_history_entry * entry = rover_history_entry_at( history, offset );
+
+		if ( entry->timestampUs > toUs ) {
+			break;
+		}
+
+		if ( entry->timestampUs >= fromUs ) {
+			out[r++] = *entry;
+		}
+
+		offset = rover_history_next( history, offset + ROVER_HISTORY_SPAN( entry->len ) );
+	}
+
+	xSemaphoreGive( history->sync );
+
+	return r;
+}
+
+
+size_t rover_history_copy( t_rover_history * history, uint32_t seq, uint8_t * buffer, size_t size, int64_t * timestampUs )
+{
+	size_t r = 0;
+
+	if ( NULL == history->arena ) {
+		return r;
+	}
+
+	xSemaphoreTake( history->sync, portMAX_DELAY );
+
+	size_t offset = history->head;
+
+	for ( uint32_t i = 0; i < history->count; ++i ) {
+		t_rover_history_entry * entry = rover_history_entry_at( history, offset );
+
+		if ( entry->seq == seq ) {
+			if ( entry->len <= size ) {
+				memcpy( buffer, entry + 1, entry->len );
+				*timestampUs = entry->timestampUs;
+			}
+
+			r = entry->len;
+			break;
+		}
+
+		offset = rover_history_next( history, offset + ROVER_HISTORY_SPAN( entry->len ) );
+	}
+
+	xSemaphoreGive( history->sync );
+
+	return r;
+}
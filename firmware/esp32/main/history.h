@@ -0,0 +1,67 @@
+/*
+ *	Copyright (c) 2025 Denis Rozhkov <denis@rozhkoff.com>
+ *	This file is part of cam-rover.
+ *
+ *	cam-rover is free software: you can redistribute it and/or
+ *	modify it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or (at your
+ *	option) any later version.
+ *
+ *	cam-rover is distributed in the hope that it will be
+ *	useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ *	Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along with
+ *	cam-rover. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef __ROVER__HISTORY__H
+#define __ROVER__HISTORY__H
+
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#include "camera.h"
+
+
+typedef struct {
+	int64_t timestampUs;
+	uint32_t seq;
+	uint32_t len;
+} t_rover_history_entry;
+
+typedef struct {
+	uint8_t * arena;
+	size_t size;
+	size_t head;
+	size_t tail;
+	uint32_t count;
+	uint32_t nextSeq;
+	size_t droppedCount;
+	StaticSemaphore_t syncBuffer;
+	SemaphoreHandle_t sync;
+} t_rover_history;
+
+
+bool rover_history_init( t_rover_history * history, size_t size );
+void rover_history_append( t_rover_history * history, const t_rover_camera_frame * frame );
+// entries are kept in capture order, so a caller pages through a range by passing the last timestamp it got + 1
+size_t rover_history_list( t_rover_history * history,
+	int64_t fromUs,
+	int64_t toUs,
+	t_rover_history_entry * out,
+	size_t maxCount );
+// returns the frame length, 0 once seq has been evicted; nothing is copied if the frame is longer than size
+size_t rover_history_copy( t_rover_history * history, uint32_t seq, uint8_t * buffer, size_t size, int64_t * timestampUs );
+
+
+#endif
@@ -19,19 +19,39 @@
 // SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>
 // SPDX-License-Identifier: GPL-3.0-or-later
 
+#include <stdlib.h>
+#include <inttypes.h>
+#include <sys/param.h>
+
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
 
 #include "globals.h"
 
 #include "helpers.h"
 #include "http.h"
+#include "pool.h"
+#include "dlog.h"
+#include "config.h"
+#include "tasks.h"
 
 
 extern const char roverHttpHtmlRootStart[] asm( "_binary_root_html_start" );
 extern const char roverHttpHtmlRootEnd[] asm( "_binary_root_html_end" );
 
+// the frame buffer grows in these steps, so that slowly growing frames do not reallocate every time
+#define ROVER_HTTP_HISTORY_FRAME_SIZE_STEP ( 16 * 1024 )
+#define ROVER_HTTP_HISTORY_PAGE_SIZE 16
+#define ROVER_HTTP_LOG_BATCH 8
+
 t_rover_http_handler_post_wlan_config roverHttpHandlerPostWlanConfig = NULL;
 
+static t_rover_history * roverHttpHistory = NULL;
+static uint8_t * roverHttpHistoryFrame = NULL;
+static size_t roverHttpHistoryFrameSize = 0;
+static t_rover_sweep * roverHttpSweep = NULL;
+
 static const char * roverLogTAG = "rover.http";
 
 
@@ -41,22 +61,110 @@ void rover_http_set_handler_post_wlan_config( t_rover_http_handler_post_wlan_con
 }
 
 
+void rover_http_set_history( t_rover_history * history )
+{
+	roverHttpHistory = history;
+}
+
+
+void rover_http_set_sweep( t_rover_sweep * sweep )
+{
+	roverHttpSweep = sweep;
+}
+
+
+static int64_t rover_http_query_i64( const char * query, const char * key, int64_t defaultValue )
+{
+	char value[24];
+
+	if ( httpd_query_key_value( query, key, value, sizeof value ) != ESP_OK ) {
+		return defaultValue;
+	}
+
+	return strtoll( value, NULL, 10 );
+}
+
+
+// comma separated list, returns the number of values or 0 if the key is missing
+static size_t rover_http_query_list( const char * query, const char * key, uint32_t * values, size_t max )
+{
+	char value[64];
+
+	if ( httpd_query_key_value( query, key, value, sizeof value ) != ESP_OK ) {
+		return 0;
+	}
+
+	size_t count = 0;
+	char * p = value;
+
+	while ( count < max && *p != '\0' ) {
+		char * end;
+		values[count++] = strtoul( p, &end, 10 );
+		p = ( ',' == *end ) ? end + 1 : end;
+
+		if ( *end != ',' ) {
+			break;
+		}
+	}
+
+	return count;
+}
+
+
+// "<core>,<priority>", core -1 leaves the task unpinned; false if the key is there but its value is not valid
+static bool rover_http_query_task( const char * query, const char * key, t_rover_config_task * out, bool * isPresent )
+{
+	char value[16];
+	*isPresent = httpd_query_key_value( query, key, value, sizeof value ) == ESP_OK;
+
+	if ( !*isPresent ) {
+		return true;
+	}
+
+	int coreId;
+	int priority;
+	char tail;
+
+	if ( sscanf( value, "%d,%d%c", &coreId, &priority, &tail ) != 2 || !ROVER_TASK_IS_CORE_VALID( coreId ) ||
+		!ROVER_TASK_IS_PRIORITY_VALID( priority ) ) {
+
+		return false;
+	}
+
+	// stacks are reserved at build time, 0 keeps the boot log quiet about it
+	*out = ( t_rover_config_task ){ .coreId = coreId, .priority = priority, .stackSize = 0 };
+
+	return true;
+}
+
+
 esp_err_t rover_http_root_handler( httpd_req_t * req )
 {
 	const ssize_t root_len = roverHttpHtmlRootEnd - roverHttpHtmlRootStart;
+	t_rover_ptr * body = NULL;
 
-	ESP_LOGI( roverLogTAG, "Serve root %d", req->method );
+	ROVER_DLOGI( roverLogTAG, "Serve root %d", req->method );
 
 	if ( HTTP_GET == req->method ) {
 		httpd_resp_set_type( req, "text/html" );
 		httpd_resp_send( req, roverHttpHtmlRootStart, root_len );
 	}
 	else if ( HTTP_POST == req->method ) {
-		char content[req->content_len + 1];
+		body = rover_pool_alloc( ROVER_POOL_TEXT, req->content_len + 1 );
+
+		if ( NULL == body && req->content_len >= CONFIG_ROVER_POOL_TEXT_BLOCK_SIZE ) {
+			return httpd_resp_send_err( req, HTTPD_400_BAD_REQUEST, "Request body too long" );
+		}
+
+		if ( NULL == body ) {
+			return httpd_resp_send_err( req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of buffers" );
+		}
+
+		char * content = body->data;
 
 		if ( httpd_req_recv( req, content, req->content_len ) > 0 ) {
 			content[req->content_len] = '\0';
-			ESP_LOGI( roverLogTAG, "Body: %s", content );
+			ROVER_DLOGI( roverLogTAG, "Body: %s", content );
 
 			char ssid[32 * 3];
 
@@ -77,10 +185,397 @@ esp_err_t rover_http_root_handler( httpd_req_t * req )
 	}
 
 l_exit:
+	rover_pool_release( body );
+
 	return ESP_OK;
 }
 
 
+// GET /history?from=<us>&to=<us> or ?last=<ms>, timestamps are microseconds since boot
+esp_err_t rover_http_history_handler( httpd_req_t * req )
+{
+	if ( NULL == roverHttpHistory ) {
+		return httpd_resp_send_404( req );
+	}
+
+	char query[64] = "";
+	httpd_req_get_url_query_str( req, query, sizeof query );
+
+	int64_t nowUs = esp_timer_get_time();
+	int64_t fromUs = rover_http_query_i64( query, "from", 0 );
+	int64_t toUs = rover_http_query_i64( query, "to", INT64_MAX );
+	int64_t lastMs = rover_http_query_i64( query, "last", 0 );
+
+	if ( lastMs > 0 ) {
+		fromUs = nowUs - lastMs * 1000;
+	}
+
+	char chunk[64];
+	httpd_resp_set_type( req, "application/json" );
+	snprintf( chunk, sizeof chunk, "{\"now\":%" PRId64 ",\"frames\":[", nowUs );
+	httpd_resp_sendstr_chunk( req, chunk );
+
+	// pages continue after the last timestamp sent, entries evicted meanwhile are neither skipped over nor repeated
+	t_rover_history_entry entries[ROVER_HTTP_HISTORY_PAGE_SIZE];
+	bool isFirst = true;
+	size_t count;
+
+	do {
+		count = rover_history_list( roverHttpHistory, fromUs, toUs, entries, ROVER_HTTP_HISTORY_PAGE_SIZE );
+
+		for ( size_t i = 0; i < count; ++i ) {
+			snprintf( chunk,
+				sizeof chunk,
+				"%s{\"seq\":%" PRIu32 ",\"ts\":%" PRId64 ",\"len\":%" PRIu32 "}",
+				isFirst ? "" : ",",
+				entries[i].seq,
+				entries[i].timestampUs,
+				entries[i].len );
+
+			httpd_resp_sendstr_chunk( req, chunk );
+			isFirst = false;
+		}
+
+		if ( count > 0 ) {
+			fromUs = entries[count - 1].timestampUs + 1;
+		}
+	}
+	while ( ROVER_HTTP_HISTORY_PAGE_SIZE == count );
+
+	httpd_resp_sendstr_chunk( req, "]}" );
+
+	return httpd_resp_send_chunk( req, NULL, 0 );
+}
+
+
+// GET /history/frame?seq=<seq>
+esp_err_t rover_http_history_frame_handler( httpd_req_t * req )
+{
+	char query[32] = "";
+	httpd_req_get_url_query_str( req, query, sizeof query );
+	int64_t seq = rover_http_query_i64( query, "seq", -1 );
+
+	if ( NULL == roverHttpHistory || seq < 0 ) {
+		return httpd_resp_send_404( req );
+	}
+
+	// frames are copied out so that capture can keep evicting while the response is being sent; the buffer is
+	// sized to the largest frame asked for so far
+	int64_t timestampUs;
+	size_t len = rover_history_copy(
+		roverHttpHistory, seq, roverHttpHistoryFrame, roverHttpHistoryFrameSize, &timestampUs );
+
+	if ( len > roverHttpHistoryFrameSize ) {
+		size_t size = ( len + ROVER_HTTP_HISTORY_FRAME_SIZE_STEP - 1 ) / ROVER_HTTP_HISTORY_FRAME_SIZE_STEP *
+			ROVER_HTTP_HISTORY_FRAME_SIZE_STEP;
+
+		heap_caps_free( roverHttpHistoryFrame );
+		roverHttpHistoryFrame = heap_caps_malloc( size, MALLOC_CAP_SPIRAM );
+		roverHttpHistoryFrameSize = NULL == roverHttpHistoryFrame ? 0 : size;
+
+		if ( NULL == roverHttpHistoryFrame ) {
+			return httpd_resp_send_err( req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory for the frame" );
+		}
+
+		// the frame may have been evicted meanwhile
+		len = rover_history_copy(
+			roverHttpHistory, seq, roverHttpHistoryFrame, roverHttpHistoryFrameSize, &timestampUs );
+	}
+
+	if ( 0 == len ) {
+		return httpd_resp_send_404( req );
+	}
+
+	char timestamp[24];
+	snprintf( timestamp, sizeof timestamp, "%" PRId64, timestampUs );
+
+	httpd_resp_set_type( req, "image/jpeg" );
+	httpd_resp_set_hdr( req, "X-Timestamp-Us", timestamp );
+
+	return httpd_resp_send( req, (const char *)roverHttpHistoryFrame, len );
+}
+
+
+// GET /bench/camera/start?frame_size=<framesize_t,..>&quality=<q,..>&xclk=<Hz,..>&fb_count=<n,..>&frames=<n>,
+// missing lists keep the current value
+esp_err_t rover_http_sweep_start_handler( httpd_req_t * req )
+{
+	if ( NULL == roverHttpSweep ) {
+		return httpd_resp_send_404( req );
+	}
+
+	char query[256] = "";
+	httpd_req_get_url_query_str( req, query, sizeof query );
+
+	const camera_config_t * config = &roverHttpSweep->camera->config;
+	t_rover_sweep_matrix matrix = { 0 };
+	uint32_t values[ROVER_SWEEP_VALUES_MAX];
+
+	matrix.frameSizeCount = rover_http_query_list( query, "frame_size", values, ROVER_SWEEP_VALUES_MAX );
+
+	for ( size_t i = 0; i < matrix.frameSizeCount; ++i ) {
+		matrix.frameSizes[i] = values[i] < FRAMESIZE_INVALID ? (framesize_t)values[i] : config->frame_size;
+	}
+
+	matrix.qualityCount = rover_http_query_list( query, "quality", values, ROVER_SWEEP_VALUES_MAX );
+
+	for ( size_t i = 0; i < matrix.qualityCount; ++i ) {
+		matrix.qualities[i] = values[i] <= 63 ? values[i] : config->jpeg_quality;
+	}
+
+	matrix.xclkFreqCount = rover_http_query_list( query, "xclk", matrix.xclkFreqsHz, ROVER_SWEEP_VALUES_MAX );
+	matrix.fbCountCount = rover_http_query_list( query, "fb_count", values, ROVER_SWEEP_VALUES_MAX );
+
+	for ( size_t i = 0; i < matrix.fbCountCount; ++i ) {
+		matrix.fbCounts[i] = values[i] > 0 && values[i] <= 4 ? values[i] : config->fb_count;
+	}
+
+	if ( 0 == matrix.frameSizeCount ) {
+		matrix.frameSizes[matrix.frameSizeCount++] = config->frame_size;
+	}
+
+	if ( 0 == matrix.qualityCount ) {
+		matrix.qualities[matrix.qualityCount++] = config->jpeg_quality;
+	}
+
+	if ( 0 == matrix.xclkFreqCount ) {
+		matrix.xclkFreqsHz[matrix.xclkFreqCount++] = config->xclk_freq_hz;
+	}
+
+	if ( 0 == matrix.fbCountCount ) {
+		matrix.fbCounts[matrix.fbCountCount++] = config->fb_count;
+	}
+
+	matrix.frameCount = rover_http_query_i64( query, "frames", 0 );
+
+	if ( !rover_sweep_start( roverHttpSweep, &matrix ) ) {
+		httpd_resp_set_status( req, "409 Conflict" );
+		return httpd_resp_sendstr( req, "sweep is running" );
+	}
+
+	char response[32];
+	snprintf( response, sizeof response, "{\"points\":%u}", (unsigned)roverHttpSweep->pointTotal );
+	httpd_resp_set_type( req, "application/json" );
+
+	return httpd_resp_sendstr( req, response );
+}
+
+
+// GET /bench/camera, results of the last sweep, points are added as they are measured
+esp_err_t rover_http_sweep_handler( httpd_req_t * req )
+{
+	if ( NULL == roverHttpSweep ) {
+		return httpd_resp_send_404( req );
+	}
+
+	char chunk[320];
+	httpd_resp_set_type( req, "application/json" );
+	snprintf( chunk,
+		sizeof chunk,
+		"{\"running\":%s,\"total\":%u,\"points\":[",
+		roverHttpSweep->isRunning ? "true" : "false",
+		(unsigned)roverHttpSweep->pointTotal );
+	httpd_resp_sendstr_chunk( req, chunk );
+
+	size_t count = roverHttpSweep->pointCount;
+
+	for ( size_t i = 0; i < count; ++i ) {
+		const t_rover_sweep_point * p = &roverHttpSweep->points[i];
+
+		snprintf( chunk,
+			sizeof chunk,
+			"%s{\"frame_size\":%d,\"width\":%" PRIu32 ",\"height\":%" PRIu32 ",\"quality\":%u,\"xclk\":%" PRIu32
+			",\"fb_count\":%u,\"err\":%d,\"fps\":%" PRIu32 ".%" PRIu32 ",\"size_mean\":%" PRIu32
+			",\"size_p95\":%" PRIu32 ",\"latency_mean_us\":%" PRIu32 ",\"latency_p95_us\":%" PRIu32
+			",\"dropped\":%" PRIu32 ",\"psram_used\":%" PRIu32 ",\"psram_free\":%" PRIu32 "}",
+			i > 0 ? "," : "",
+			(int)p->frameSize,
+			p->width,
+			p->height,
+			(unsigned)p->quality,
+			p->xclkFreqHz,
+			(unsigned)p->fbCount,
+			(int)p->err,
+			p->fpsX10 / 10,
+			p->fpsX10 % 10,
+			p->sizeMean,
+			p->sizeP95,
+			p->latencyMeanUs,
+			p->latencyP95Us,
+			p->droppedCount,
+			p->psramUsed,
+			p->psramFree );
+
+		httpd_resp_sendstr_chunk( req, chunk );
+	}
+
+	httpd_resp_sendstr_chunk( req, "]}" );
+
+	return httpd_resp_send_chunk( req, NULL, 0 );
+}
+
+
+// GET /pools, use and high water marks of the buffer pools
+esp_err_t rover_http_pools_handler( httpd_req_t * req )
+{
+	char chunk[160];
+	httpd_resp_set_type( req, "application/json" );
+	httpd_resp_sendstr_chunk( req, "[" );
+
+	for ( size_t i = 0; i < ROVER_POOL_COUNT; ++i ) {
+		t_rover_pool_stats stats;
+		rover_pool_get_stats( i, &stats );
+
+		snprintf( chunk,
+			sizeof chunk,
+			"%s{\"name\":\"%s\",\"block_size\":%u,\"blocks\":%u,\"used\":%u,\"high_water\":%u"
+			",\"failed\":%" PRIu32 "}",
+			i > 0 ? "," : "",
+			stats.name,
+			(unsigned)stats.blockSize,
+			(unsigned)stats.blockCount,
+			(unsigned)stats.usedCount,
+			(unsigned)stats.usedHighWater,
+			stats.failCount );
+
+		httpd_resp_sendstr_chunk( req, chunk );
+	}
+
+	httpd_resp_sendstr_chunk( req, "]" );
+
+	return httpd_resp_send_chunk( req, NULL, 0 );
+}
+
+
+// GET /config lists the settings and the task topology, POST /config with form encoded key=value pairs changes them
+// first; task.<name>=<core>,<priority> is stored in NVS and taken on the next boot
+esp_err_t rover_http_config_handler( httpd_req_t * req )
+{
+	if ( HTTP_POST == req->method ) {
+		t_rover_ptr * body = rover_pool_alloc( ROVER_POOL_TEXT, req->content_len + 1 );
+
+		if ( NULL == body && req->content_len >= CONFIG_ROVER_POOL_TEXT_BLOCK_SIZE ) {
+			return httpd_resp_send_err( req, HTTPD_400_BAD_REQUEST, "Request body too long" );
+		}
+
+		if ( NULL == body ) {
+			return httpd_resp_send_err( req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of buffers" );
+		}
+
+		char * content = body->data;
+		int len = httpd_req_recv( req, content, req->content_len );
+		bool isValid = len > 0;
+		content[MAX( len, 0 )] = '\0';
+
+		int64_t values[ROVER_CONFIG_COUNT];
+		t_rover_config_task tasks[ROVER_TASK_COUNT];
+		bool isTaskSet[ROVER_TASK_COUNT];
+
+		// all or nothing: one bad key leaves every setting as it was
+		for ( size_t i = 0; i < ROVER_CONFIG_COUNT && isValid; ++i ) {
+			values[i] = rover_http_query_i64( content, rover_config_get_info( i )->key, -1 );
+			isValid = values[i] < 0 || ( values[i] <= UINT32_MAX && rover_config_is_valid( i, values[i] ) );
+		}
+
+		for ( size_t i = 0; i < ROVER_TASK_COUNT && isValid; ++i ) {
+			isValid = rover_http_query_task( content, rover_task_get_config( i )->nvsKey, &tasks[i], &isTaskSet[i] );
+		}
+
+		rover_pool_release( body );
+
+		if ( !isValid ) {
+			return httpd_resp_send_err( req, HTTPD_400_BAD_REQUEST, "Invalid setting" );
+		}
+
+		for ( size_t i = 0; i < ROVER_CONFIG_COUNT; ++i ) {
+			if ( values[i] >= 0 ) {
+				rover_config_set( i, values[i] );
+			}
+		}
+
+		for ( size_t i = 0; i < ROVER_TASK_COUNT; ++i ) {
+			if ( isTaskSet[i] && !rover_save_config_task( rover_task_get_config( i )->nvsKey, &tasks[i] ) ) {
+				return httpd_resp_send_err( req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to save task settings" );
+			}
+		}
+	}
+
+	char chunk[128];
+	httpd_resp_set_type( req, "application/json" );
+	httpd_resp_sendstr_chunk( req, "[" );
+
+	for ( size_t i = 0; i < ROVER_CONFIG_COUNT; ++i ) {
+		const t_rover_config_info * info = rover_config_get_info( i );
+
+		snprintf( chunk,
+			sizeof chunk,
+			"%s{\"key\":\"%s\",\"value\":%" PRIu32 ",\"min\":%" PRIu32 ",\"max\":%" PRIu32 "}",
+			i > 0 ? "," : "",
+			info->key,
+			rover_config_get( i ),
+			info->min,
+			info->max );
+
+		httpd_resp_sendstr_chunk( req, chunk );
+	}
+
+	// what the tasks run with now, stored overrides show up after the next boot
+	for ( size_t i = 0; i < ROVER_TASK_COUNT; ++i ) {
+		const t_rover_task_config * task = rover_task_get_config( i );
+
+		snprintf( chunk,
+			sizeof chunk,
+			",{\"key\":\"%s\",\"core\":%d,\"priority\":%u}",
+			task->nvsKey,
+			tskNO_AFFINITY == task->coreId ? -1 : (int)task->coreId,
+			(unsigned)task->priority );
+
+		httpd_resp_sendstr_chunk( req, chunk );
+	}
+
+	httpd_resp_sendstr_chunk( req, "]" );
+
+	return httpd_resp_send_chunk( req, NULL, 0 );
+}
+
+
+// GET /log, drains the deferred log rings, see ROVER_DLOG_DUMP_MAGIC and tools/dlog_decode.py
+esp_err_t rover_http_log_handler( httpd_req_t * req )
+{
+	const size_t recordLen = ROVER_DLOG_RECORD_LEN - sizeof( uint32_t );
+	uint8_t batch[ROVER_HTTP_LOG_BATCH * ( ROVER_DLOG_RECORD_LEN - sizeof( uint32_t ) )];
+	uint32_t dropped = rover_dlog_get_dropped();
+
+	memcpy( batch, ROVER_DLOG_DUMP_MAGIC, 4 );
+	batch[4] = ROVER_DLOG_DUMP_VERSION;
+	batch[5] = recordLen;
+	memcpy( batch + 6, &dropped, sizeof dropped );
+
+	httpd_resp_set_type( req, "application/octet-stream" );
+	httpd_resp_send_chunk( req, (const char *)batch, ROVER_DLOG_DUMP_HEADER_LEN );
+
+	for ( ;; ) {
+		size_t count = 0;
+		t_rover_dlog_record record;
+
+		while ( count < ROVER_HTTP_LOG_BATCH && rover_dlog_read( &record ) ) {
+			// everything after the sequence
+			memcpy( batch + count++ * recordLen, &record.timestampMs, recordLen );
+		}
+
+		if ( 0 == count ) {
+			break;
+		}
+
+		if ( httpd_resp_send_chunk( req, (const char *)batch, count * recordLen ) != ESP_OK ) {
+			return ESP_FAIL;
+		}
+	}
+
+	return httpd_resp_send_chunk( req, NULL, 0 );
+}
+
+
 esp_err_t rover_http_404_error_handler( httpd_req_t * req, httpd_err_code_t err )
 {
 	// Set status
@@ -90,6 +585,6 @@ esp_err_t rover_http_404_error_handler( httpd_req_t * req, httpd_err_code_t err
 	// iOS requires content in the response to detect a captive portal, simply redirecting is not sufficient.
 	httpd_resp_send( req, "Redirect to the captive portal", HTTPD_RESP_USE_STRLEN );
 
-	ESP_LOGI( roverLogTAG, "Redirecting to root" );
+	ROVER_DLOGI( roverLogTAG, "Redirecting to root" );
 	return ESP_OK;
 }
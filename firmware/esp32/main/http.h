@@ -25,13 +25,25 @@
 
 #include "esp_http_server.h"
 
+#include "history.h"
+#include "sweep.h"
+
 
 typedef void ( *t_rover_http_handler_post_wlan_config )( const char * ssid, const char * password );
 
 
 void rover_http_set_handler_post_wlan_config( t_rover_http_handler_post_wlan_config handler );
+void rover_http_set_history( t_rover_history * history );
+void rover_http_set_sweep( t_rover_sweep * sweep );
 
 esp_err_t rover_http_root_handler( httpd_req_t * req );
+esp_err_t rover_http_history_handler( httpd_req_t * req );
+esp_err_t rover_http_history_frame_handler( httpd_req_t * req );
+esp_err_t rover_http_sweep_start_handler( httpd_req_t * req );
+esp_err_t rover_http_sweep_handler( httpd_req_t * req );
+esp_err_t rover_http_pools_handler( httpd_req_t * req );
+esp_err_t rover_http_log_handler( httpd_req_t * req );
+esp_err_t rover_http_config_handler( httpd_req_t * req );
 esp_err_t rover_http_404_error_handler( httpd_req_t * req, httpd_err_code_t err );
 
 
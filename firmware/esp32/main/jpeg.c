@@ -0,0 +1,476 @@
+/*
+ *	Copyright (c) 2025 Denis Rozhkov <denis@rozhkoff.com>
+ *	This file is part of cam-rover.
+ *
+ *	cam-rover is free software: you can redistribute it and/or
+ *	modify it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or (at your
+ *	option) any later version.
+ *
+ *	cam-rover is distributed in the hope that it will be
+ *	useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ *	Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along with
+ *	cam-rover. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <string.h>
+
+#include "jpeg.h"
+
+
+typedef struct {
+	t_rover_buffer * out;
+	uint32_t bits;
+	uint32_t bitCount;
+	bool isOverflow;
+} t_rover_jpeg_writer;
+
+
+static const uint8_t roverJpegNaturalOrder[64] = { 0, 1, 8, 16, 9, 2, 3, 10, 17, 24, 32, 25, 18, 11, 4, 5, 12, 19, 26,
+	33, 40, 48, 41, 34, 27, 20, 13, 6, 7, 14, 21, 28, 35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51, 58,
+	59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63 };
+
+static const uint8_t roverJpegQuantLuma[64] = { 16, 11, 10, 16, 24, 40, 51, 61, 12, 12, 14, 19, 26, 58, 60, 55, 14, 13,
+	16, 24, 40, 57, 69, 56, 14, 17, 22, 29, 51, 87, 80, 62, 18, 22, 37, 56, 68, 109, 103, 77, 24, 35, 55, 64, 81, 104, 113,
+	92, 49, 64, 78, 87, 103, 121, 120, 101, 72, 92, 95, 98, 112, 100, 103, 99 };
+
+static const uint8_t roverJpegQuantChroma[64] = { 17, 18, 24, 47, 99, 99, 99, 99, 18, 21, 26, 66, 99, 99, 99, 99, 24, 26,
+	56, 99, 99, 99, 99, 99, 47, 66, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99,
+	99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99 };
+
+static const float roverJpegAanScale[8] = {
+	1.0f, 1.387039845f, 1.306562965f, 1.175875602f, 1.0f, 0.785694958f, 0.541196100f, 0.275899379f
+};
+
+static const uint8_t roverJpegDcLumaBits[16] = { 0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0 };
+static const uint8_t roverJpegDcChromaBits[16] = { 0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0 };
+static const uint8_t roverJpegDcValues[12] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 };
+
+static const uint8_t roverJpegAcLumaBits[16] = { 0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7d };
+static const uint8_t roverJpegAcLumaValues[162] = { 0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41,
+	0x06, 0x13, 0x51, 0x61, 0x07, 0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xa1, 0x08, 0x23, 0x42, 0xb1, 0xc1, 0x15, 0x52, 0xd1,
+	0xf0, 0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0a, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2a, 0x34,
+	0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58,
+	0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x83, 0x84,
+	0x85, 0x86, 0x87, 0x88, 0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6,
+	0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7, 0xc8,
+	0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xe1, 0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9,
+	0xea, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa };
+
+static const uint8_t roverJpegAcChromaBits[16] = { 0, 2, 1, 2, 4, 4, 3, 4, 7, 5, 4, 4, 0, 1, 2, 0x77 };
+static const uint8_t roverJpegAcChromaValues[162] = { 0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12,
+	0x41, 0x51, 0x07, 0x61, 0x71, 0x13, 0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91, 0xa1, 0xb1, 0xc1, 0x09, 0x23, 0x33, 0x52,
+	0xf0, 0x15, 0x62, 0x72, 0xd1, 0x0a, 0x16, 0x24, 0x34, 0xe1, 0x25, 0xf1, 0x17, 0x18, 0x19, 0x1a, 0x26, 0x27, 0x28, 0x29,
+	0x2a, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57,
+	0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x82,
+	0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4,
+	0xa5, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6,
+	0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8,
+	0xe9, 0xea, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa };
+
+
+static void rover_jpeg_init_huffman( t_rover_jpeg_huffman * huffman, const uint8_t * bits, const uint8_t * values )
+{
+	uint16_t code = 0;
+	size_t k = 0;
+
+	memset( huffman, 0, sizeof *huffman );
+
+	for ( size_t len = 1; len <= 16; ++len ) {
+		for ( size_t i = 0; i < bits[len - 1]; ++i ) {
+			huffman->code[values[k]] = code++;
+			huffman->size[values[k]] = len;
+			k++;
+		}
+
+		code <<= 1;
+	}
+}
+
+
+static void rover_jpeg_init_quant( uint8_t * quant, float * scale, const uint8_t * base, uint8_t quality )
+{
+	uint32_t factor = quality < 50 ? 5000 / quality : 200 - quality * 2;
+
+	for ( size_t i = 0; i < 64; ++i ) {
+		uint32_t q = ( base[i] * factor + 50 ) / 100;
+		quant[i] = q < 1 ? 1 : ( q > 255 ? 255 : q );
+		scale[i] = 1.0f / ( quant[i] * roverJpegAanScale[i / 8] * roverJpegAanScale[i % 8] * 8.0f );
+	}
+}
+
+
+void rover_jpeg_init( t_rover_jpeg * jpeg, uint32_t width, uint32_t height, t_rover_jpeg_format format, uint8_t quality )
+{
+	quality = quality < 1 ? 1 : ( quality > 100 ? 100 : quality );
+
+	jpeg->width = width;
+	jpeg->height = height;
+	jpeg->format = format;
+	jpeg->quality = quality;
+	jpeg->mcuSize = ROVER_JPEG_FORMAT_RGB565 == format ? 16 : 8;
+	jpeg->mcuColumns = ( width + jpeg->mcuSize - 1 ) / jpeg->mcuSize;
+	jpeg->mcuRows = ( height + jpeg->mcuSize - 1 ) / jpeg->mcuSize;
+
+	rover_jpeg_init_quant( jpeg->quantLuma, jpeg->scaleLuma, roverJpegQuantLuma, quality );
+	rover_jpeg_init_quant( jpeg->quantChroma, jpeg->scaleChroma, roverJpegQuantChroma, quality );
+
+	rover_jpeg_init_huffman( &jpeg->dcLuma, roverJpegDcLumaBits, roverJpegDcValues );
+	rover_jpeg_init_huffman( &jpeg->acLuma, roverJpegAcLumaBits, roverJpegAcLumaValues );
+	rover_jpeg_init_huffman( &jpeg->dcChroma, roverJpegDcChromaBits, roverJpegDcValues );
+	rover_jpeg_init_huffman( &jpeg->acChroma, roverJpegAcChromaBits, roverJpegAcChromaValues );
+}
+
+
+void rover_jpeg_band( const t_rover_jpeg * jpeg, uint32_t bandIndex, uint32_t bandCount, uint32_t * firstRow, uint32_t * rowCount )
+{
+	uint32_t base = jpeg->mcuRows / bandCount;
+	uint32_t extra = jpeg->mcuRows % bandCount;
+
+	*firstRow = bandIndex * base + ( bandIndex < extra ? bandIndex : extra );
+	*rowCount = base + ( bandIndex < extra ? 1 : 0 );
+}
+
+
+static void rover_jpeg_put_byte( t_rover_jpeg_writer * writer, uint8_t b )
+{
+	t_rover_buffer * out = writer->out;
+
+	if ( out->len >= out->size ) {
+		writer->isOverflow = true;
+		return;
+	}
+
+	out->data[out->len++] = b;
+}
+
+
+static void rover_jpeg_put_u16( t_rover_jpeg_writer * writer, uint16_t v )
+{
+	rover_jpeg_put_byte( writer, v >> 8 );
+	rover_jpeg_put_byte( writer, v & 0xff );
+}
+
+
+static void rover_jpeg_put_bits( t_rover_jpeg_writer * writer, uint32_t code, uint32_t size )
+{
+	writer->bits = ( writer->bits << size ) | ( code & ( ( 1u << size ) - 1 ) );
+	writer->bitCount += size;
+
+	while ( writer->bitCount >= 8 ) {
+		uint8_t b = ( writer->bits >> ( writer->bitCount - 8 ) ) & 0xff;
+		rover_jpeg_put_byte( writer, b );
+
+		if ( 0xff == b ) {
+			rover_jpeg_put_byte( writer, 0 );
+		}
+
+		writer->bitCount -= 8;
+	}
+}
+
+
+static void rover_jpeg_flush_bits( t_rover_jpeg_writer * writer )
+{
+	if ( writer->bitCount > 0 ) {
+		rover_jpeg_put_bits( writer, 0xff, 8 - writer->bitCount );
+	}
+}
+
+
+static void rover_jpeg_put_table( t_rover_jpeg_writer * writer, uint8_t id, const uint8_t * quant )
+{
+	rover_jpeg_put_byte( writer, id );
+
+	for ( size_t i = 0; i < 64; ++i ) {
+		rover_jpeg_put_byte( writer, quant[roverJpegNaturalOrder[i]] );
+	}
+}
+
+
+static void rover_jpeg_put_huffman( t_rover_jpeg_writer * writer, uint8_t id, const uint8_t * bits, const uint8_t * values )
+{
+	size_t count = 0;
+
+	rover_jpeg_put_byte( writer, id );
+
+	for ( size_t i = 0; i < 16; ++i ) {
+		rover_jpeg_put_byte( writer, bits[i] );
+		count += bits[i];
+	}
+
+	for ( size_t i = 0; i < count; ++i ) {
+		rover_jpeg_put_byte( writer, values[i] );
+	}
+}
+
+
+bool rover_jpeg_write_header( const t_rover_jpeg * jpeg, t_rover_buffer * out )
+{
+	static const uint8_t app0[] = { 0xff, 0xd8, 0xff, 0xe0, 0, 16, 'J', 'F', 'I', 'F', 0, 1, 1, 0, 0, 1, 0, 1, 0, 0 };
+
+	t_rover_jpeg_writer writer = { .out = out };
+	bool isColor = ROVER_JPEG_FORMAT_RGB565 == jpeg->format;
+	uint8_t componentCount = isColor ? 3 : 1;
+
+	for ( size_t i = 0; i < sizeof app0; ++i ) {
+		rover_jpeg_put_byte( &writer, app0[i] );
+	}
+
+	rover_jpeg_put_u16( &writer, 0xffdb );
+	rover_jpeg_put_u16( &writer, 2 + 65 * ( isColor ? 2 : 1 ) );
+	rover_jpeg_put_table( &writer, 0, jpeg->quantLuma );
+
+	if ( isColor ) {
+		rover_jpeg_put_table( &writer, 1, jpeg->quantChroma );
+	}
+
+	rover_jpeg_put_u16( &writer, 0xffc0 );
+	rover_jpeg_put_u16( &writer, 8 + 3 * componentCount );
+	rover_jpeg_put_byte( &writer, 8 );
+	rover_jpeg_put_u16( &writer, jpeg->height );
+	rover_jpeg_put_u16( &writer, jpeg->width );
+	rover_jpeg_put_byte( &writer, componentCount );
+
+	for ( uint8_t i = 0; i < componentCount; ++i ) {
+		rover_jpeg_put_byte( &writer, i + 1 );
+		rover_jpeg_put_byte( &writer, 0 == i && isColor ? 0x22 : 0x11 );
+		rover_jpeg_put_byte( &writer, 0 == i ? 0 : 1 );
+	}
+
+	rover_jpeg_put_u16( &writer, 0xffc4 );
+	rover_jpeg_put_u16( &writer, 2 + ( 17 + 12 ) + ( 17 + 162 ) + ( isColor ? ( 17 + 12 ) + ( 17 + 162 ) : 0 ) );
+	rover_jpeg_put_huffman( &writer, 0x00, roverJpegDcLumaBits, roverJpegDcValues );
+	rover_jpeg_put_huffman( &writer, 0x10, roverJpegAcLumaBits, roverJpegAcLumaValues );
+
+	if ( isColor ) {
+		rover_jpeg_put_huffman( &writer, 0x01, roverJpegDcChromaBits, roverJpegDcValues );
+		rover_jpeg_put_huffman( &writer, 0x11, roverJpegAcChromaBits, roverJpegAcChromaValues );
+	}
+
+	// one restart interval per MCU row
+	rover_jpeg_put_u16( &writer, 0xffdd );
+	rover_jpeg_put_u16( &writer, 4 );
+	rover_jpeg_put_u16( &writer, jpeg->mcuColumns );
+
+	rover_jpeg_put_u16( &writer, 0xffda );
+	rover_jpeg_put_u16( &writer, 6 + 2 * componentCount );
+	rover_jpeg_put_byte( &writer, componentCount );
+
+	for ( uint8_t i = 0; i < componentCount; ++i ) {
+		rover_jpeg_put_byte( &writer, i + 1 );
+		rover_jpeg_put_byte( &writer, 0 == i ? 0x00 : 0x11 );
+	}
+
+	rover_jpeg_put_byte( &writer, 0 );
+	rover_jpeg_put_byte( &writer, 63 );
+	rover_jpeg_put_byte( &writer, 0 );
+
+	return !writer.isOverflow;
+}
+
+
+bool rover_jpeg_write_trailer( t_rover_buffer * out )
+{
+	t_rover_jpeg_writer writer = { .out = out };
+	rover_jpeg_put_u16( &writer, 0xffd9 );
+
+	return !writer.isOverflow;
+}
+
+
+// AA&N float forward DCT, output is scaled by the factors folded into t_rover_jpeg scale tables
+static void rover_jpeg_fdct( float * d, size_t stride, size_t step )
+{
+	for ( size_t n = 0; n < 8; ++n, d += stride ) {
+		float tmp0 = d[0] + d[7 * step];
+		float tmp7 = d[0] - d[7 * step];
+		float tmp1 = d[step] + d[6 * step];
+		float tmp6 = d[step] - d[6 * step];
+		float tmp2 = d[2 * step] + d[5 * step];
+		float tmp5 = d[2 * step] - d[5 * step];
+		float tmp3 = d[3 * step] + d[4 * step];
+		float tmp4 = d[3 * step] - d[4 * step];
+
+		float tmp10 = tmp0 + tmp3;
+		float tmp13 = tmp0 - tmp3;
+		float tmp11 = tmp1 + tmp2;
+		float tmp12 = tmp1 - tmp2;
+
+		d[0] = tmp10 + tmp11;
+		d[4 * step] = tmp10 - tmp11;
+
+		float z1 = ( tmp12 + tmp13 ) * 0.707106781f;
+		d[2 * step] = tmp13 + z1;
+		d[6 * step] = tmp13 - z1;
+
+		tmp10 = tmp4 + tmp5;
+		tmp11 = tmp5 + tmp6;
+		tmp12 = tmp6 + tmp7;
+
+		float z5 = ( tmp10 - tmp12 ) * 0.382683433f;
+		float z2 = 0.541196100f * tmp10 + z5;
+		float z4 = 1.306562965f * tmp12 + z5;
+		float z3 = tmp11 * 0.707106781f;
+		float z11 = tmp7 + z3;
+		float z13 = tmp7 - z3;
+
+		d[5 * step] = z13 + z2;
+		d[3 * step] = z13 - z2;
+		d[step] = z11 + z4;
+		d[7 * step] = z11 - z4;
+	}
+}
+
+
+static void rover_jpeg_put_value( t_rover_jpeg_writer * writer, const t_rover_jpeg_huffman * huffman, uint8_t run, int32_t v )
+{
+	int32_t a = v < 0 ? -v : v;
+	uint32_t size = 0;
+
+	while ( a > 0 ) {
+		size++;
+		a >>= 1;
+	}
+
+	uint8_t symbol = ( run << 4 ) | size;
+	rover_jpeg_put_bits( writer, huffman->code[symbol], huffman->size[symbol] );
+
+	if ( size > 0 ) {
+		rover_jpeg_put_bits( writer, v < 0 ? v - 1 : v, size );
+	}
+}
+
+
+static void rover_jpeg_encode_block( t_rover_jpeg_writer * writer,
+	float * block,
+	const float * scale,
+	const t_rover_jpeg_huffman * dc,
+	const t_rover_jpeg_huffman * ac,
+	int32_t * prevDc )
+{
+	int32_t q[64];
+
+	rover_jpeg_fdct( block, 8, 1 );
+	rover_jpeg_fdct( block, 1, 8 );
+
+	for ( size_t k = 0; k < 64; ++k ) {
+		size_t i = roverJpegNaturalOrder[k];
+		float v = block[i] * scale[i];
+		q[k] = (int32_t)( v < 0 ? v - 0.5f : v + 0.5f );
+	}
+
+	rover_jpeg_put_value( writer, dc, 0, q[0] - *prevDc );
+	*prevDc = q[0];
+
+	uint8_t run = 0;
+
+	for ( size_t k = 1; k < 64; ++k ) {
+		if ( 0 == q[k] ) {
+			run++;
+			continue;
+		}
+
+		while ( run > 15 ) {
+			rover_jpeg_put_bits( writer, ac->code[0xf0], ac->size[0xf0] );
+			run -= 16;
+		}
+
+		rover_jpeg_put_value( writer, ac, run, q[k] );
+		run = 0;
+	}
+
+	if ( run > 0 ) {
+		rover_jpeg_put_bits( writer, ac->code[0x00], ac->size[0x00] );
+	}
+}
+
+
+static void rover_jpeg_encode_mcu_gray(
+	const t_rover_jpeg * jpeg, t_rover_jpeg_writer * writer, const uint8_t * pixels, uint32_t x0, uint32_t y0, int32_t * dc )
+{
+	float block[64];
+
+	for ( uint32_t y = 0; y < 8; ++y ) {
+		uint32_t py = y0 + y < jpeg->height ? y0 + y : jpeg->height - 1;
+
+		for ( uint32_t x = 0; x < 8; ++x ) {
+			uint32_t px = x0 + x < jpeg->width ? x0 + x : jpeg->width - 1;
+			block[y * 8 + x] = (float)pixels[py * jpeg->width + px] - 128.0f;
+		}
+	}
+
+	rover_jpeg_encode_block( writer, block, jpeg->scaleLuma, &jpeg->dcLuma, &jpeg->acLuma, &dc[0] );
+}
+
+
+static void rover_jpeg_encode_mcu_rgb565(
+	const t_rover_jpeg * jpeg, t_rover_jpeg_writer * writer, const uint8_t * pixels, uint32_t x0, uint32_t y0, int32_t * dc )
+{
+	float luma[4][64];
+	float cb[64] = { 0 };
+	float cr[64] = { 0 };
+
+	for ( uint32_t y = 0; y < 16; ++y ) {
+		uint32_t py = y0 + y < jpeg->height ? y0 + y : jpeg->height - 1;
+
+		for ( uint32_t x = 0; x < 16; ++x ) {
+			uint32_t px = x0 + x < jpeg->width ? x0 + x : jpeg->width - 1;
+			const uint8_t * p = pixels + ( py * jpeg->width + px ) * 2;
+
+			float r = (float)( p[0] & 0xf8 );
+			float g = (float)( ( ( p[0] & 0x07 ) << 5 ) | ( ( p[1] & 0xe0 ) >> 3 ) );
+			float b = (float)( ( p[1] & 0x1f ) << 3 );
+
+			luma[( y / 8 ) * 2 + x / 8][( y % 8 ) * 8 + x % 8] = 0.299f * r + 0.587f * g + 0.114f * b - 128.0f;
+
+			size_t c = ( y / 2 ) * 8 + x / 2;
+			cb[c] += ( -0.168736f * r - 0.331264f * g + 0.5f * b ) * 0.25f;
+			cr[c] += ( 0.5f * r - 0.418688f * g - 0.081312f * b ) * 0.25f;
+		}
+	}
+
+	for ( size_t i = 0; i < 4; ++i ) {
+		rover_jpeg_encode_block( writer, luma[i], jpeg->scaleLuma, &jpeg->dcLuma, &jpeg->acLuma, &dc[0] );
+	}
+
+	rover_jpeg_encode_block( writer, cb, jpeg->scaleChroma, &jpeg->dcChroma, &jpeg->acChroma, &dc[1] );
+	rover_jpeg_encode_block( writer, cr, jpeg->scaleChroma, &jpeg->dcChroma, &jpeg->acChroma, &dc[2] );
+}
+
+
+// entropy coded data of MCU rows [firstRow, firstRow + rowCount), each row followed by its RSTn marker
+// unless it is the last row of the image
+bool rover_jpeg_encode_rows(
+	const t_rover_jpeg * jpeg, const uint8_t * pixels, uint32_t firstRow, uint32_t rowCount, t_rover_buffer * out )
+{
+	t_rover_jpeg_writer writer = { .out = out };
+
+	for ( uint32_t row = firstRow; row < firstRow + rowCount && !writer.isOverflow; ++row ) {
+		int32_t dc[3] = { 0 };
+
+		for ( uint32_t column = 0; column < jpeg->mcuColumns; ++column ) {
+			if ( ROVER_JPEG_FORMAT_RGB565 == jpeg->format ) {
+				rover_jpeg_encode_mcu_rgb565( jpeg, &writer, pixels, column * 16, row * 16, dc );
+			}
+			else {
+				rover_jpeg_encode_mcu_gray( jpeg, &writer, pixels, column * 8, row * 8, dc );
+			}
+		}
+
+		rover_jpeg_flush_bits( &writer );
+
+		if ( row + 1 < jpeg->mcuRows ) {
+			rover_jpeg_put_byte( &writer, 0xff );
+			rover_jpeg_put_byte( &writer, 0xd0 + ( row & 7 ) );
+		}
+	}
+
+	return !writer.isOverflow;
+}
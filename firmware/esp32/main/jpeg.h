@@ -0,0 +1,78 @@
+/*
+ *	Copyright (c) 2025 Denis Rozhkov <denis@rozhkoff.com>
+ *	This file is part of cam-rover.
+ *
+ *	cam-rover is free software: you can redistribute it and/or
+ *	modify it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or (at your
+ *	option) any later version.
+ *
+ *	cam-rover is distributed in the hope that it will be
+ *	useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ *	Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along with
+ *	cam-rover. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef __ROVER__JPEG__H
+#define __ROVER__JPEG__H
+
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "types.h"
+
+
+#define ROVER_JPEG_HEADER_SIZE_MAX 700
+
+
+typedef enum {
+	ROVER_JPEG_FORMAT_GRAYSCALE = 0,
+	// camera byte order, big endian
+	ROVER_JPEG_FORMAT_RGB565
+} t_rover_jpeg_format;
+
+typedef struct {
+	uint16_t code[256];
+	uint8_t size[256];
+} t_rover_jpeg_huffman;
+
+// baseline encoder, 4:2:0 for colour input; every MCU row is a restart interval, so any range of MCU
+// rows (a band) can be encoded independently of the others and the bands just concatenated
+typedef struct {
+	uint32_t width;
+	uint32_t height;
+	t_rover_jpeg_format format;
+	uint8_t quality;
+	uint32_t mcuSize;
+	uint32_t mcuColumns;
+	uint32_t mcuRows;
+
+	uint8_t quantLuma[64];
+	uint8_t quantChroma[64];
+	float scaleLuma[64];
+	float scaleChroma[64];
+
+	t_rover_jpeg_huffman dcLuma;
+	t_rover_jpeg_huffman acLuma;
+	t_rover_jpeg_huffman dcChroma;
+	t_rover_jpeg_huffman acChroma;
+} t_rover_jpeg;
+
+
+void rover_jpeg_init( t_rover_jpeg * jpeg, uint32_t width, uint32_t height, t_rover_jpeg_format format, uint8_t quality );
+void rover_jpeg_band( const t_rover_jpeg * jpeg, uint32_t bandIndex, uint32_t bandCount, uint32_t * firstRow, uint32_t * rowCount );
+bool rover_jpeg_write_header( const t_rover_jpeg * jpeg, t_rover_buffer * out );
+bool rover_jpeg_encode_rows(
+	const t_rover_jpeg * jpeg, const uint8_t * pixels, uint32_t firstRow, uint32_t rowCount, t_rover_buffer * out );
+bool rover_jpeg_write_trailer( t_rover_buffer * out );
+
+
+#endif
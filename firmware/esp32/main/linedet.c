@@ -0,0 +1,140 @@
+/*
+ *	Copyright (c) 2025 Denis Rozhkov <denis@rozhkoff.com>
+ *	This file is part of cam-rover.
+ *
+ *	cam-rover is free software: you can redistribute it and/or
+ *	modify it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or (at your
+ *	option) any later version.
+ *
+ *	cam-rover is distributed in the hope that it will be
+ *	useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ *	Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along with
+ *	cam-rover. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "linedet.h"
+
+
+// runs of line pixels in one row, the one closest to the expected position wins; returns the run
+// center in pixels * 2 (to keep half pixels) or -1
+static int32_t rover_linedet_scan_row( const t_rover_linedet_config * config,
+	const uint8_t * row,
+	uint32_t width,
+	uint8_t threshold,
+	int32_t expected,
+	bool * isMarker )
+{
+	int32_t best = -1;
+	int32_t bestDistance = INT32_MAX;
+	uint32_t runStart = 0;
+	bool isInRun = false;
+
+	for ( uint32_t x = 0; x <= width; ++x ) {
+		bool isLine = x < width && ( config->isDarkLine ? row[x] < threshold : row[x] > threshold );
+
+		if ( isLine && !isInRun ) {
+			runStart = x;
+			isInRun = true;
+		}
+		else if ( !isLine && isInRun ) {
+			isInRun = false;
+			uint32_t runWidth = x - runStart;
+
+			if ( runWidth < 2 ) {
+				continue;
+			}
+
+			if ( runWidth * 1000 > config->markerWidth * width ) {
+				*isMarker = true;
+				continue;
+			}
+
+			int32_t center = (int32_t)( runStart + x - 1 );
+			int32_t distance = center > expected ? center - expected : expected - center;
+
+			if ( distance < bestDistance ) {
+				best = center;
+				bestDistance = distance;
+			}
+		}
+	}
+
+	return best;
+}
+
+
+void rover_linedet_detect( const t_rover_linedet_config * config,
+	const uint8_t * gray,
+	uint32_t width,
+	uint32_t height,
+	t_rover_linedet_result * result )
+{
+	// scan rows evenly spread over the lower 60% of the image, nearest to the rover first
+	uint32_t rows[ROVER_LINEDET_SCAN_ROWS];
+	uint32_t top = height * 2 / 5;
+
+	for ( size_t i = 0; i < ROVER_LINEDET_SCAN_ROWS; ++i ) {
+		rows[i] = height - 1 - ( height - 1 - top ) * i / ( ROVER_LINEDET_SCAN_ROWS - 1 );
+	}
+
+	uint8_t lo = 255;
+	uint8_t hi = 0;
+
+	for ( size_t i = 0; i < ROVER_LINEDET_SCAN_ROWS; ++i ) {
+		const uint8_t * row = gray + rows[i] * width;
+
+		for ( uint32_t x = 0; x < width; ++x ) {
+			lo = row[x] < lo ? row[x] : lo;
+			hi = row[x] > hi ? row[x] : hi;
+		}
+	}
+
+	*result = ( t_rover_linedet_result ){ 0 };
+	result->threshold = ( lo + hi ) / 2;
+
+	if ( hi - lo < ROVER_LINEDET_CONTRAST_MIN ) {
+		return;
+	}
+
+	int32_t expected = (int32_t)width - 1;
+	int32_t first = -1;
+	int32_t last = -1;
+
+	for ( size_t i = 0; i < ROVER_LINEDET_SCAN_ROWS; ++i ) {
+		bool isMarker = false;
+		int32_t center =
+			rover_linedet_scan_row( config, gray + rows[i] * width, width, result->threshold, expected, &isMarker );
+
+		// a marker only counts close to the rover
+		if ( isMarker && i < ROVER_LINEDET_SCAN_ROWS / 2 ) {
+			result->isMarker = true;
+		}
+
+		if ( center < 0 ) {
+			continue;
+		}
+
+		if ( first < 0 ) {
+			first = center;
+		}
+
+		last = center;
+		expected = center;
+		result->rowCount++;
+	}
+
+	if ( first < 0 ) {
+		return;
+	}
+
+	result->isFound = true;
+	result->offset = ( first - ( (int32_t)width - 1 ) ) * 1000 / (int32_t)width;
+	result->heading = ( last - first ) * 1000 / (int32_t)width;
+}
@@ -0,0 +1,61 @@
+/*
+ *	Copyright (c) 2025 Denis Rozhkov <denis@rozhkoff.com>
+ *	This file is part of cam-rover.
+ *
+ *	cam-rover is free software: you can redistribute it and/or
+ *	modify it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or (at your
+ *	option) any later version.
+ *
+ *	cam-rover is distributed in the hope that it will be
+ *	useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ *	Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along with
+ *	cam-rover. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef __ROVER__LINEDET__H
+#define __ROVER__LINEDET__H
+
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+
+#define ROVER_LINEDET_SCAN_ROWS 4
+// scan row spread below which the view is taken for bare floor, texture and uneven light alone reach ~30
+#define ROVER_LINEDET_CONTRAST_MIN 48
+
+
+typedef struct {
+	bool isDarkLine;
+	// fraction of the width (permille) a run must exceed to count as a crossing marker
+	uint32_t markerWidth;
+} t_rover_linedet_config;
+
+// offset and heading are in permille of half the image width, positive to the right; heading is the
+// shift of the line between the bottom and the top scan row
+typedef struct {
+	bool isFound;
+	bool isMarker;
+	int32_t offset;
+	int32_t heading;
+	uint8_t threshold;
+	uint32_t rowCount;
+} t_rover_linedet_result;
+
+
+void rover_linedet_detect( const t_rover_linedet_config * config,
+	const uint8_t * gray,
+	uint32_t width,
+	uint32_t height,
+	t_rover_linedet_result * result );
+
+
+#endif
@@ -0,0 +1,189 @@
+/*
+ *	Copyright (c) 2025 Denis Rozhkov <denis@rozhkoff.com>
+ *	This file is part of cam-rover.
+ *
+ *	cam-rover is free software: you can redistribute it and/or
+ *	modify it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or (at your
+ *	option) any later version.
+ *
+ *	cam-rover is distributed in the hope that it will be
+ *	useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ *	Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along with
+ *	cam-rover. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <sys/param.h>
+
+#include "esp_log.h"
+
+#include "link.h"
+#include "dlog.h"
+
+
+// RSSI is extrapolated this many samples ahead while it falls, so the stream backs off before the link drops
+#define ROVER_LINK_RSSI_LOOKAHEAD 2
+// send error share, percent, that takes the score to 0
+#define ROVER_LINK_LOSS_MAX 25
+// score recovers at most this much per sample, drops are followed at once
+#define ROVER_LINK_QUALITY_RISE_MAX 5
+
+
+static const char * roverLogTAG = "rover.link";
+
+
+void rover_link_configure_radio( wifi_interface_t interface )
+{
+	uint8_t protocol = WIFI_PROTOCOL_11G | WIFI_PROTOCOL_11N;
+
+#ifndef CONFIG_ROVER_LINK_DISABLE_11B
+	protocol |= WIFI_PROTOCOL_11B;
+#endif
+
+	ESP_ERROR_CHECK( esp_wifi_set_protocol( interface, protocol ) );
+
+#ifdef CONFIG_ROVER_LINK_HT40
+	ESP_ERROR_CHECK( esp_wifi_set_bandwidth( interface, WIFI_BW_HT40 ) );
+#else
+	ESP_ERROR_CHECK( esp_wifi_set_bandwidth( interface, WIFI_BW_HT20 ) );
+#endif
+}
+
+
+static bool rover_link_get_rssi( t_rover_link * link, int8_t * rssi )
+{
+	if ( WIFI_MODE_STA == link->mode ) {
+		wifi_ap_record_t ap;
+
+		if ( ESP_OK != esp_wifi_sta_get_ap_info( &ap ) ) {
+			return false;
+		}
+
+		*rssi = ap.rssi;
+
+		return true;
+	}
+
+	// softAP: the weakest station decides
+	wifi_sta_list_t stations;
+
+	if ( ESP_OK != esp_wifi_ap_get_sta_list( &stations ) || 0 == stations.num ) {
+		return false;
+	}
+
+	*rssi = 0;
+
+	for ( int i = 0; i < stations.num; i++ ) {
+		*rssi = MIN( *rssi, stations.sta[i].rssi );
+	}
+
+	return true;
+}
+
+
+static uint8_t rover_link_score( t_rover_link * link )
+{
+	int rssi = link->rssi;
+
+	if ( link->rssi < link->rssiPrev ) {
+		rssi += ( link->rssi - link->rssiPrev ) * ROVER_LINK_RSSI_LOOKAHEAD;
+	}
+
+	int rssiScore =
+		( rssi - CONFIG_ROVER_LINK_RSSI_BAD ) * 100 / ( CONFIG_ROVER_LINK_RSSI_GOOD - CONFIG_ROVER_LINK_RSSI_BAD );
+
+	int lossScore = 100;
+
+	if ( NULL != link->transport ) {
+		uint32_t sendCount = link->transport->sendCount - link->sendCount;
+		uint32_t sendErrorCount = link->transport->sendErrorCount - link->sendErrorCount;
+		link->sendCount += sendCount;
+		link->sendErrorCount += sendErrorCount;
+
+		if ( sendCount > 0 ) {
+			lossScore = 100 - (int)( sendErrorCount * 100 / sendCount ) * 100 / ROVER_LINK_LOSS_MAX;
+		}
+	}
+
+	return (uint8_t)MAX( 0, MIN( 100, MIN( rssiScore, lossScore ) ) );
+}
+
+
+static void rover_link_sample( void * arg )
+{
+	t_rover_link * link = (t_rover_link *)arg;
+	int8_t rssi;
+
+	if ( !rover_link_get_rssi( link, &rssi ) ) {
+		return;
+	}
+
+	link->rssiPrev = 0 == link->rssi ? rssi : link->rssi;
+	link->rssi = rssi;
+
+	uint8_t score = rover_link_score( link );
+	uint8_t quality = score < link->quality ? score : MIN( score, link->quality + ROVER_LINK_QUALITY_RISE_MAX );
+
+	if ( quality == link->quality ) {
+		return;
+	}
+
+	if ( quality / 10 != link->quality / 10 ) {
+		ROVER_DLOGI( roverLogTAG,
+			"quality %u, rssi %d, send errors %u/%u",
+			(unsigned)quality,
+			(int)rssi,
+			(unsigned)link->sendErrorCount,
+			(unsigned)link->sendCount );
+	}
+
+	link->quality = quality;
+
+	if ( NULL != link->handler ) {
+		link->handler( link->handlerContext, quality );
+	}
+}
+
+
+// power save and TX power only take effect once Wi-Fi is started
+void rover_link_start( t_rover_link * link, wifi_mode_t mode )
+{
+	link->mode = mode;
+	link->quality = 100;
+
+	if ( WIFI_MODE_STA == mode ) {
+#ifdef CONFIG_ROVER_LINK_POWER_SAVE
+		ESP_ERROR_CHECK( esp_wifi_set_ps( WIFI_PS_MIN_MODEM ) );
+#else
+		ESP_ERROR_CHECK( esp_wifi_set_ps( WIFI_PS_NONE ) );
+#endif
+		ESP_ERROR_CHECK( esp_wifi_set_max_tx_power( CONFIG_ROVER_LINK_STA_TX_POWER ) );
+	}
+	else {
+		ESP_ERROR_CHECK( esp_wifi_set_max_tx_power( CONFIG_ROVER_LINK_AP_TX_POWER ) );
+	}
+
+	if ( NULL != link->transport ) {
+		link->sendCount = link->transport->sendCount;
+		link->sendErrorCount = link->transport->sendErrorCount;
+	}
+
+	esp_timer_create_args_t timerArgs = { .callback = rover_link_sample, .arg = link, .name = "link" };
+	ESP_ERROR_CHECK( esp_timer_create( &timerArgs, &link->timer ) );
+	ESP_ERROR_CHECK( esp_timer_start_periodic( link->timer, CONFIG_ROVER_LINK_SAMPLE_MS * 1000ULL ) );
+}
+
+
+// maps the score onto a share of the full frame budget, CONFIG_ROVER_LINK_BUDGET_MIN percent at score 0
+uint32_t rover_link_scale_budget( uint8_t quality, uint32_t budget )
+{
+	uint32_t percent = CONFIG_ROVER_LINK_BUDGET_MIN + ( 100 - CONFIG_ROVER_LINK_BUDGET_MIN ) * quality / 100;
+
+	return budget / 100 * percent;
+}
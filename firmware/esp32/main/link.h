@@ -0,0 +1,57 @@
+/*
+ *	Copyright (c) 2025 Denis Rozhkov <denis@rozhkoff.com>
+ *	This file is part of cam-rover.
+ *
+ *	cam-rover is free software: you can redistribute it and/or
+ *	modify it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or (at your
+ *	option) any later version.
+ *
+ *	cam-rover is distributed in the hope that it will be
+ *	useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ *	Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along with
+ *	cam-rover. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef __ROVER__LINK__H
+#define __ROVER__LINK__H
+
+
+#include <stdint.h>
+
+#include "esp_timer.h"
+#include "esp_wifi.h"
+
+#include "transport.h"
+
+
+// quality score 0 (link about to collapse) .. 100 (no reason to hold back)
+typedef void ( *t_rover_link_handler_quality )( void * context, uint8_t quality );
+
+typedef struct {
+	wifi_mode_t mode;
+	// send failures on this transport count as loss
+	t_rover_transport * transport;
+	t_rover_link_handler_quality handler;
+	void * handlerContext;
+	esp_timer_handle_t timer;
+	int8_t rssi;
+	int8_t rssiPrev;
+	uint32_t sendCount;
+	uint32_t sendErrorCount;
+	volatile uint8_t quality;
+} t_rover_link;
+
+
+void rover_link_configure_radio( wifi_interface_t interface );
+void rover_link_start( t_rover_link * link, wifi_mode_t mode );
+uint32_t rover_link_scale_budget( uint8_t quality, uint32_t budget );
+
+
+#endif
@@ -0,0 +1,235 @@
+/*
+ *	Copyright (c) 2025 Denis Rozhkov <denis@rozhkoff.com>
+ *	This file is part of cam-rover.
+ *
+ *	cam-rover is free software: you can redistribute it and/or
+ *	modify it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or (at your
+ *	option) any later version.
+ *
+ *	cam-rover is distributed in the hope that it will be
+ *	useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ *	Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along with
+ *	cam-rover. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "tasks.h"
+#include "pipeline.h"
+#include "dlog.h"
+
+
+static const char * roverLogTAG = "rover.pipeline";
+
+
+static void rover_pipeline_stage_task( void * parameters )
+{
+	t_rover_pipeline_stage * stage = (t_rover_pipeline_stage *)parameters;
+
+	while ( true ) {
+		t_rover_pipeline_frame * frame;
+
+		if ( xQueueReceive( stage->queue, &frame, portMAX_DELAY ) != pdTRUE ) {
+			continue;
+		}
+
+		int64_t startUs = esp_timer_get_time();
+		stage->handler( stage->context, frame );
+		uint32_t us = (uint32_t)( esp_timer_get_time() - startUs );
+
+		t_rover_pipeline_stage_stats * stats = &stage->stats;
+		__atomic_add_fetch( &stats->frameCount, 1, __ATOMIC_RELAXED );
+		__atomic_add_fetch( &stats->busyUs, us, __ATOMIC_RELAXED );
+
+		uint32_t maxUs = __atomic_load_n( &stats->maxUs, __ATOMIC_RELAXED );
+		bool isMax = false;
+
+		// the log may swap in a zero meanwhile, a failed exchange reloads maxUs
+		while ( us > maxUs && !isMax ) {
+			isMax = __atomic_compare_exchange_n( &stats->maxUs, &maxUs, us, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED );
+		}
+
+		rover_pipeline_release( frame );
+	}
+}
+
+
+static void rover_pipeline_log( t_rover_pipeline * pipeline )
+{
+	ROVER_DLOGI( roverLogTAG,
+		"%u frames published, %u without a free slot",
+		(unsigned)pipeline->publishedCount,
+		(unsigned)pipeline->noSlotCount );
+
+	for ( size_t i = 0; i < pipeline->stageCount; ++i ) {
+		t_rover_pipeline_stage * stage = &pipeline->stages[i];
+		// the stage task keeps running, a frame finishing in between may land half in this window and half in the next
+		t_rover_pipeline_stage_stats stats = {
+			.frameCount = __atomic_exchange_n( &stage->stats.frameCount, 0, __ATOMIC_RELAXED ),
+			.droppedCount = __atomic_exchange_n( &stage->stats.droppedCount, 0, __ATOMIC_RELAXED ),
+			.busyUs = __atomic_exchange_n( &stage->stats.busyUs, 0, __ATOMIC_RELAXED ),
+			.maxUs = __atomic_exchange_n( &stage->stats.maxUs, 0, __ATOMIC_RELAXED ),
+		};
+
+		ROVER_DLOGI( roverLogTAG,
+			"stage %s: %u frames, %u dropped, avg %u us, max %u us",
+			stage->name,
+			(unsigned)stats.frameCount,
+			(unsigned)stats.droppedCount,
+			(unsigned)( stats.frameCount > 0 ? stats.busyUs / stats.frameCount : 0 ),
+			(unsigned)stats.maxUs );
+	}
+
+	pipeline->publishedCount = 0;
+	pipeline->noSlotCount = 0;
+}
+
+
+bool rover_pipeline_init( t_rover_pipeline * pipeline )
+{
+	pipeline->freeFrames = xQueueCreateStatic( ROVER_PIPELINE_FRAMES_MAX,
+		sizeof( t_rover_pipeline_frame * ),
+		pipeline->freeFramesStorage,
+		&pipeline->freeFramesBuffer );
+
+	if ( NULL == pipeline->freeFrames ) {
+		return false;
+	}
+
+	for ( size_t i = 0; i < ROVER_PIPELINE_FRAMES_MAX; ++i ) {
+		t_rover_pipeline_frame * frame = &pipeline->frames[i];
+		frame->ref.owner = pipeline;
+		xQueueSend( pipeline->freeFrames, &frame, 0 );
+	}
+
+	return true;
+}
+
+
+bool rover_pipeline_add_stage( t_rover_pipeline * pipeline,
+	t_rover_task_id taskId,
+	const char * name,
+	t_rover_pipeline_handler_frame handler,
+	void * context )
+{
+	if ( pipeline->stageCount >= ROVER_PIPELINE_STAGES_MAX ) {
+		ESP_LOGE( roverLogTAG, "too many stages, %s not added", name );
+		return false;
+	}
+
+	t_rover_pipeline_stage * stage = &pipeline->stages[pipeline->stageCount];
+	stage->name = name;
+	stage->handler = handler;
+	stage->context = context;
+	stage->queue = xQueueCreateStatic( CONFIG_ROVER_PIPELINE_QUEUE_LEN,
+		sizeof( t_rover_pipeline_frame * ),
+		stage->queueStorage,
+		&stage->queueBuffer );
+
+	if ( NULL == stage->queue ) {
+		return false;
+	}
+
+	// stages sharing a task id share its settings and slots, the task is named after the stage
+	if ( rover_task_create_named( taskId, name, rover_pipeline_stage_task, stage, &stage->task ) != pdPASS ) {
+		ESP_LOGE( roverLogTAG, "Failed to create task for stage %s", name );
+		vQueueDelete( stage->queue );
+
+		return false;
+	}
+
+	pipeline->stageCount++;
+
+	return true;
+}
+
+
+// hands the frame to every stage that has room in its queue, never blocks; fb (if any) goes back to the
+// driver once the last stage is done with it
+void rover_pipeline_publish( t_rover_pipeline * pipeline, const t_rover_camera_frame * frame, camera_fb_t * fb )
+{
+	t_rover_pipeline_frame * pipelineFrame;
+
+	if ( xQueueReceive( pipeline->freeFrames, &pipelineFrame, 0 ) != pdTRUE ) {
+		pipeline->noSlotCount++;
+
+		if ( fb != NULL ) {
+			esp_camera_fb_return( fb );
+		}
+
+		return;
+	}
+
+	pipelineFrame->ref.data = fb;
+	pipelineFrame->ref.size = frame->len;
+	pipelineFrame->ref.refCount = 1;
+	pipelineFrame->frame = *frame;
+	__atomic_add_fetch( &pipeline->outstandingCount, 1, __ATOMIC_SEQ_CST );
+
+	for ( size_t i = 0; i < pipeline->stageCount; ++i ) {
+		t_rover_pipeline_stage * stage = &pipeline->stages[i];
+
+		rover_pipeline_retain( pipelineFrame );
+
+		if ( xQueueSend( stage->queue, &pipelineFrame, 0 ) != pdTRUE ) {
+			__atomic_add_fetch( &stage->stats.droppedCount, 1, __ATOMIC_RELAXED );
+			rover_pipeline_release( pipelineFrame );
+		}
+	}
+
+	rover_pipeline_release( pipelineFrame );
+
+	if ( ++pipeline->publishedCount >= CONFIG_ROVER_PIPELINE_LOG_FRAMES ) {
+		rover_pipeline_log( pipeline );
+	}
+}
+
+
+void rover_pipeline_retain( t_rover_pipeline_frame * frame )
+{
+	__atomic_add_fetch( &frame->ref.refCount, 1, __ATOMIC_SEQ_CST );
+}
+
+
+void rover_pipeline_release( t_rover_pipeline_frame * frame )
+{
+	if ( __atomic_sub_fetch( &frame->ref.refCount, 1, __ATOMIC_SEQ_CST ) != 0 ) {
+		return;
+	}
+
+	t_rover_pipeline * pipeline = (t_rover_pipeline *)frame->ref.owner;
+
+	if ( frame->ref.data != NULL ) {
+		esp_camera_fb_return( (camera_fb_t *)frame->ref.data );
+		frame->ref.data = NULL;
+	}
+
+	xQueueSend( pipeline->freeFrames, &frame, 0 );
+
+	TaskHandle_t waiter = pipeline->waiter;
+
+	if ( 0 == __atomic_sub_fetch( &pipeline->outstandingCount, 1, __ATOMIC_SEQ_CST ) && waiter != NULL ) {
+		xTaskNotifyGive( waiter );
+	}
+}
+
+
+// for publishers that reuse the frame memory (software encoder output), blocks until no stage holds a frame
+void rover_pipeline_wait_released( t_rover_pipeline * pipeline )
+{
+	pipeline->waiter = xTaskGetCurrentTaskHandle();
+
+	while ( __atomic_load_n( &pipeline->outstandingCount, __ATOMIC_SEQ_CST ) > 0 ) {
+		ulTaskNotifyTake( pdTRUE, pdMS_TO_TICKS( 100 ) );
+	}
+
+	pipeline->waiter = NULL;
+}
@@ -0,0 +1,99 @@
+/*
+ *	Copyright (c) 2025 Denis Rozhkov <denis@rozhkoff.com>
+ *	This file is part of cam-rover.
+ *
+ *	cam-rover is free software: you can redistribute it and/or
+ *	modify it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or (at your
+ *	option) any later version.
+ *
+ *	cam-rover is distributed in the hope that it will be
+ *	useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ *	Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along with
+ *	cam-rover. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef __ROVER__PIPELINE__H
+#define __ROVER__PIPELINE__H
+
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+
+#include "esp_camera.h"
+
+#include "types.h"
+#include "tasks.h"
+#include "camera.h"
+
+
+#define ROVER_PIPELINE_STAGES_MAX 6
+#define ROVER_PIPELINE_FRAMES_MAX 4
+
+
+// a published frame; frame.ptr points into the camera_fb_t held by ref.data (or into encoder output when
+// ref.data is NULL), nothing is copied between stages
+typedef struct {
+	t_rover_ptr ref;
+	t_rover_camera_frame frame;
+} t_rover_pipeline_frame;
+
+// the stage holds a reference while the handler runs, rover_pipeline_retain() keeps the frame beyond that
+typedef void ( *t_rover_pipeline_handler_frame )( void * context, t_rover_pipeline_frame * frame );
+
+// updated by the stage task and the publisher, swapped to zero by the log; 32 bits keep the atomics native
+typedef struct {
+	uint32_t frameCount;
+	uint32_t droppedCount;
+	uint32_t busyUs;
+	uint32_t maxUs;
+} t_rover_pipeline_stage_stats;
+
+typedef struct {
+	const char * name;
+	t_rover_pipeline_handler_frame handler;
+	void * context;
+	QueueHandle_t queue;
+	StaticQueue_t queueBuffer;
+	uint8_t queueStorage[CONFIG_ROVER_PIPELINE_QUEUE_LEN * sizeof( t_rover_pipeline_frame * )];
+	TaskHandle_t task;
+	t_rover_pipeline_stage_stats stats;
+} t_rover_pipeline_stage;
+
+typedef struct t_rover_pipeline {
+	t_rover_pipeline_stage stages[ROVER_PIPELINE_STAGES_MAX];
+	size_t stageCount;
+	t_rover_pipeline_frame frames[ROVER_PIPELINE_FRAMES_MAX];
+	QueueHandle_t freeFrames;
+	StaticQueue_t freeFramesBuffer;
+	uint8_t freeFramesStorage[ROVER_PIPELINE_FRAMES_MAX * sizeof( t_rover_pipeline_frame * )];
+	volatile uint32_t outstandingCount;
+	TaskHandle_t waiter;
+	uint32_t publishedCount;
+	uint32_t noSlotCount;
+} t_rover_pipeline;
+
+
+bool rover_pipeline_init( t_rover_pipeline * pipeline );
+bool rover_pipeline_add_stage( t_rover_pipeline * pipeline,
+	t_rover_task_id taskId,
+	const char * name,
+	t_rover_pipeline_handler_frame handler,
+	void * context );
+void rover_pipeline_publish( t_rover_pipeline * pipeline, const t_rover_camera_frame * frame, camera_fb_t * fb );
+void rover_pipeline_retain( t_rover_pipeline_frame * frame );
+void rover_pipeline_release( t_rover_pipeline_frame * frame );
+void rover_pipeline_wait_released( t_rover_pipeline * pipeline );
+
+
+#endif
@@ -0,0 +1,175 @@
+/*
+ *	Copyright (c) 2025 Denis Rozhkov <denis@rozhkoff.com>
+ *	This file is part of cam-rover.
+ *
+ *	cam-rover is free software: you can redistribute it and/or
+ *	modify it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or (at your
+ *	option) any later version.
+ *
+ *	cam-rover is distributed in the hope that it will be
+ *	useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ *	Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along with
+ *	cam-rover. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <stdbool.h>
+#include <inttypes.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+#include "esp_err.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+
+#include "pool.h"
+#include "dlog.h"
+
+
+typedef struct {
+	const char * name;
+	size_t blockSize;
+	uint16_t blockCount;
+	uint32_t caps;
+	uint8_t * blocks;
+	t_rover_ptr * handles;
+	// free handles, like the pipeline's free frames
+	QueueHandle_t freeHandles;
+	StaticQueue_t freeHandlesBuffer;
+	uint8_t * freeHandlesStorage;
+	uint16_t usedCount;
+	uint16_t usedHighWater;
+	uint32_t failCount;
+} t_rover_pool;
+
+
+// handles and free list storage, only the blocks themselves come from the heap
+#define ROVER_POOL_STORAGE( a_name, a_count )                                                                          \
+	static t_rover_ptr a_name##Handles[a_count];                                                                       \
+	static uint8_t a_name##FreeHandlesStorage[( a_count ) * sizeof( t_rover_ptr * )]
+
+#define ROVER_POOL_SLOTS( a_name ) .handles = a_name##Handles, .freeHandlesStorage = a_name##FreeHandlesStorage
+
+
+static const char * roverLogTAG = "rover.pool";
+
+ROVER_POOL_STORAGE( roverPoolNet, CONFIG_ROVER_POOL_NET_BLOCK_COUNT );
+ROVER_POOL_STORAGE( roverPoolText, CONFIG_ROVER_POOL_TEXT_BLOCK_COUNT );
+ROVER_POOL_STORAGE( roverPoolBlob, CONFIG_ROVER_POOL_BLOB_BLOCK_COUNT );
+
+static t_rover_pool roverPools[ROVER_POOL_COUNT] = {
+	[ROVER_POOL_NET] = { .name = "net",
+		.blockSize = CONFIG_ROVER_POOL_NET_BLOCK_SIZE,
+		.blockCount = CONFIG_ROVER_POOL_NET_BLOCK_COUNT,
+		.caps = MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA | MALLOC_CAP_8BIT,
+		ROVER_POOL_SLOTS( roverPoolNet ) },
+	[ROVER_POOL_TEXT] = { .name = "text",
+		.blockSize = CONFIG_ROVER_POOL_TEXT_BLOCK_SIZE,
+		.blockCount = CONFIG_ROVER_POOL_TEXT_BLOCK_COUNT,
+		.caps = MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT,
+		ROVER_POOL_SLOTS( roverPoolText ) },
+	[ROVER_POOL_BLOB] = { .name = "blob",
+		.blockSize = CONFIG_ROVER_POOL_BLOB_BLOCK_SIZE,
+		.blockCount = CONFIG_ROVER_POOL_BLOB_BLOCK_COUNT,
+		.caps = MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT,
+		ROVER_POOL_SLOTS( roverPoolBlob ) },
+};
+
+
+void rover_pool_init( void )
+{
+	for ( size_t i = 0; i < ROVER_POOL_COUNT; ++i ) {
+		t_rover_pool * pool = &roverPools[i];
+		pool->blockSize = ( pool->blockSize + 3 ) & ~(size_t)3;
+		pool->blocks = heap_caps_malloc( pool->blockSize * pool->blockCount, pool->caps );
+		pool->freeHandles = xQueueCreateStatic(
+			pool->blockCount, sizeof( t_rover_ptr * ), pool->freeHandlesStorage, &pool->freeHandlesBuffer );
+
+		ESP_ERROR_CHECK( NULL == pool->blocks ? ESP_ERR_NO_MEM : ESP_OK );
+
+		for ( size_t j = 0; j < pool->blockCount; ++j ) {
+			t_rover_ptr * ptr = &pool->handles[j];
+			ptr->data = pool->blocks + j * pool->blockSize;
+			ptr->owner = pool;
+			ptr->size = pool->blockSize;
+			xQueueSend( pool->freeHandles, &ptr, 0 );
+		}
+
+		ESP_LOGI( roverLogTAG,
+			"%s: %u x %u bytes, caps 0x%" PRIx32,
+			pool->name,
+			(unsigned)pool->blockCount,
+			(unsigned)pool->blockSize,
+			pool->caps );
+	}
+}
+
+
+t_rover_ptr * rover_pool_alloc( t_rover_pool_id id, size_t size )
+{
+	t_rover_pool * pool = &roverPools[id];
+	t_rover_ptr * ptr = NULL;
+
+	if ( size > pool->blockSize || xQueueReceive( pool->freeHandles, &ptr, 0 ) != pdTRUE ) {
+		__atomic_add_fetch( &pool->failCount, 1, __ATOMIC_SEQ_CST );
+
+		// callers may be on a hot path, never wait for the UART here
+		ROVER_DLOGW( roverLogTAG, "%s: no block for %u bytes", pool->name, (unsigned)size );
+
+		return NULL;
+	}
+
+	ptr->refCount = 1;
+	uint16_t used = __atomic_add_fetch( &pool->usedCount, 1, __ATOMIC_SEQ_CST );
+	uint16_t highWater = __atomic_load_n( &pool->usedHighWater, __ATOMIC_SEQ_CST );
+	bool isHighWater = false;
+
+	while ( used > highWater && !isHighWater ) {
+		isHighWater = __atomic_compare_exchange_n(
+			&pool->usedHighWater, &highWater, used, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST );
+	}
+
+	if ( isHighWater ) {
+		ROVER_DLOGI( roverLogTAG,
+			"%s: high water %u of %u",
+			pool->name,
+			(unsigned)used,
+			(unsigned)pool->blockCount );
+	}
+
+	return ptr;
+}
+
+
+void rover_pool_release( t_rover_ptr * ptr )
+{
+	if ( NULL == ptr || __atomic_sub_fetch( &ptr->refCount, 1, __ATOMIC_SEQ_CST ) != 0 ) {
+		return;
+	}
+
+	t_rover_pool * pool = (t_rover_pool *)ptr->owner;
+
+	__atomic_sub_fetch( &pool->usedCount, 1, __ATOMIC_SEQ_CST );
+	xQueueSend( pool->freeHandles, &ptr, 0 );
+}
+
+
+void rover_pool_get_stats( t_rover_pool_id id, t_rover_pool_stats * out )
+{
+	t_rover_pool * pool = &roverPools[id];
+
+	out->name = pool->name;
+	out->blockSize = pool->blockSize;
+	out->blockCount = pool->blockCount;
+	out->usedCount = __atomic_load_n( &pool->usedCount, __ATOMIC_SEQ_CST );
+	out->usedHighWater = __atomic_load_n( &pool->usedHighWater, __ATOMIC_SEQ_CST );
+	out->failCount = __atomic_load_n( &pool->failCount, __ATOMIC_SEQ_CST );
+}
+
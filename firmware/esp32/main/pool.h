@@ -0,0 +1,62 @@
+/*
+ *	Copyright (c) 2025 Denis Rozhkov <denis@rozhkoff.com>
+ *	This file is part of cam-rover.
+ *
+ *	cam-rover is free software: you can redistribute it and/or
+ *	modify it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or (at your
+ *	option) any later version.
+ *
+ *	cam-rover is distributed in the hope that it will be
+ *	useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ *	Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along with
+ *	cam-rover. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef __ROVER__POOL__H
+#define __ROVER__POOL__H
+
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "types.h"
+
+
+// fixed size block classes, each placed where its users need it
+typedef enum {
+	// internal, DMA capable: socket receive and send buffers
+	ROVER_POOL_NET = 0,
+	// internal: short lived strings (HTTP bodies, NVS values)
+	ROVER_POOL_TEXT,
+	// PSRAM: tables sized at run time
+	ROVER_POOL_BLOB,
+	ROVER_POOL_COUNT
+} t_rover_pool_id;
+
+typedef struct {
+	const char * name;
+	size_t blockSize;
+	uint16_t blockCount;
+	uint16_t usedCount;
+	uint16_t usedHighWater;
+	uint32_t failCount;
+} t_rover_pool_stats;
+
+
+void rover_pool_init( void );
+// a block of at least size bytes with a single reference, ptr->size is the block size; NULL when the class
+// is exhausted or size does not fit its blocks
+t_rover_ptr * rover_pool_alloc( t_rover_pool_id id, size_t size );
+// the block goes back to its pool with the last reference, NULL is ignored
+void rover_pool_release( t_rover_ptr * ptr );
+void rover_pool_get_stats( t_rover_pool_id id, t_rover_pool_stats * out );
+
+
+#endif
@@ -0,0 +1,227 @@
+/*
+ *	Copyright (c) 2025 Denis Rozhkov <denis@rozhkoff.com>
+ *	This file is part of cam-rover.
+ *
+ *	cam-rover is free software: you can redistribute it and/or
+ *	modify it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or (at your
+ *	option) any later version.
+ *
+ *	cam-rover is distributed in the hope that it will be
+ *	useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ *	Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along with
+ *	cam-rover. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <stdbool.h>
+#include <string.h>
+#include <sys/param.h>
+
+#include "esp_log.h"
+
+#include "types.h"
+#include "tasks.h"
+#include "profiler.h"
+#include "dlog.h"
+
+
+#ifdef CONFIG_ROVER_PROFILER
+
+static const char * roverLogTAG = "rover.profiler";
+
+
+static configRUN_TIME_COUNTER_TYPE rover_profiler_find_counter( t_rover_profiler * profiler, TaskHandle_t handle )
+{
+	for ( size_t i = 0; i < profiler->counterCount; ++i ) {
+		if ( profiler->counters[i].handle == handle ) {
+			return profiler->counters[i].runTime;
+		}
+	}
+
+	return 0;
+}
+
+
+static uint16_t rover_profiler_permille( configRUN_TIME_COUNTER_TYPE delta, configRUN_TIME_COUNTER_TYPE window )
+{
+	return 0 == window ? 0 : MIN( 1000, (uint64_t)delta * 1000 / window );
+}
+
+
+// runs on the esp_timer task, which must not block, so only the counters are taken here; uxTaskGetSystemState()
+// holds the scheduler for a walk of the task lists. A snapshot the task still works on is kept, the next window
+// is just longer then
+static void rover_profiler_snapshot( void * arg )
+{
+	t_rover_profiler * profiler = (t_rover_profiler *)arg;
+
+	if ( profiler->isPending ) {
+		return;
+	}
+
+	profiler->statusCount =
+		uxTaskGetSystemState( profiler->status, ROVER_PROFILER_TASKS_MAX, &profiler->statusRunTime );
+	profiler->statusTs = esp_timer_get_time();
+	profiler->isPending = true;
+
+	xTaskNotifyGive( profiler->task );
+}
+
+
+// nothing is allocated
+static void rover_profiler_sample( t_rover_profiler * profiler )
+{
+	t_rover_profiler_sample * sample = &profiler->sample;
+	configRUN_TIME_COUNTER_TYPE totalRunTime = profiler->statusRunTime;
+	UBaseType_t count = profiler->statusCount;
+
+	if ( 0 == count ) {
+		ESP_LOGW( roverLogTAG, "more than %d tasks, not sampled", ROVER_PROFILER_TASKS_MAX );
+		return;
+	}
+
+	// the run time clock is esp_timer, so the window is in microseconds; counters wrap, differences do not
+	configRUN_TIME_COUNTER_TYPE window = totalRunTime - profiler->totalRunTime;
+	bool isFirst = ( 0 == profiler->counterCount );
+
+	sample->timestampUs = profiler->statusTs;
+	sample->windowUs = window;
+	sample->taskCount = 0;
+
+	TaskHandle_t idle[ROVER_PROFILER_CORES];
+
+	for ( BaseType_t core = 0; core < ROVER_PROFILER_CORES; ++core ) {
+		idle[core] = xTaskGetIdleTaskHandleForCore( core );
+		sample->coreLoad[core] = 1000;
+	}
+
+	for ( UBaseType_t i = 0; i < count; ++i ) {
+		const TaskStatus_t * status = &profiler->status[i];
+		configRUN_TIME_COUNTER_TYPE delta = status->ulRunTimeCounter -
+			rover_profiler_find_counter( profiler, status->xHandle );
+		uint16_t load = rover_profiler_permille( delta, window );
+		BaseType_t coreId = xTaskGetCoreID( status->xHandle );
+
+		// a core is busy for whatever its idle task did not get
+		for ( BaseType_t core = 0; core < ROVER_PROFILER_CORES; ++core ) {
+			if ( status->xHandle == idle[core] ) {
+				sample->coreLoad[core] = 1000 - load;
+			}
+		}
+
+		// insertion by load, heaviest first
+		size_t j = sample->taskCount++;
+
+		for ( ; j > 0 && sample->tasks[j - 1].load < load; --j ) {
+			sample->tasks[j] = sample->tasks[j - 1];
+		}
+
+		t_rover_profiler_task * task = &sample->tasks[j];
+		strlcpy( task->name, status->pcTaskName, sizeof task->name );
+		task->load = load;
+		task->coreId = tskNO_AFFINITY == coreId ? -1 : (int8_t)coreId;
+		task->stackFree = MIN( UINT16_MAX, status->usStackHighWaterMark );
+	}
+
+	for ( UBaseType_t i = 0; i < count; ++i ) {
+		profiler->counters[i].handle = profiler->status[i].xHandle;
+		profiler->counters[i].runTime = profiler->status[i].ulRunTimeCounter;
+	}
+
+	profiler->counterCount = count;
+	profiler->totalRunTime = totalRunTime;
+
+	// the first sample covers everything since boot
+	if ( isFirst ) {
+		return;
+	}
+
+	ROVER_DLOGD( roverLogTAG,
+		"core 0 %u.%u%%, core 1 %u.%u%%, %s %u.%u%%",
+		sample->coreLoad[0] / 10,
+		sample->coreLoad[0] % 10,
+		sample->coreLoad[1] / 10,
+		sample->coreLoad[1] % 10,
+		sample->tasks[0].name,
+		sample->tasks[0].load / 10,
+		sample->tasks[0].load % 10 );
+
+	ROVER_CALL( profiler->handler, profiler->handlerContext, sample );
+}
+
+
+static void rover_profiler_task( void * parameters )
+{
+	t_rover_profiler * profiler = (t_rover_profiler *)parameters;
+
+	while ( true ) {
+		ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+
+		rover_profiler_sample( profiler );
+		profiler->isPending = false;
+	}
+}
+
+#endif
+
+
+void rover_profiler_start( t_rover_profiler * profiler )
+{
+#ifdef CONFIG_ROVER_PROFILER
+	profiler->counterCount = 0;
+	profiler->isPending = false;
+
+	if ( rover_task_create( ROVER_TASK_PROFILER, &rover_profiler_task, profiler, &profiler->task ) != pdPASS ) {
+		return;
+	}
+
+	esp_timer_create_args_t timerArgs = { .callback = rover_profiler_snapshot, .arg = profiler, .name = "profiler" };
+	ESP_ERROR_CHECK( esp_timer_create( &timerArgs, &profiler->timer ) );
+	ESP_ERROR_CHECK( esp_timer_start_periodic( profiler->timer, CONFIG_ROVER_PROFILER_WINDOW_MS * 1000LL ) );
+
+	ESP_LOGI( roverLogTAG, "sampling every %d ms", CONFIG_ROVER_PROFILER_WINDOW_MS );
+#endif
+}
+
+
+size_t rover_profiler_emit( const t_rover_profiler_sample * sample, uint8_t * buffer, size_t size )
+{
+	t_rover_comm_stream_profile packet = {
+		.windowUs = sample->windowUs,
+		.core0Load = sample->coreLoad[0],
+		.core1Load = sample->coreLoad[1],
+	};
+
+	// as many tasks as fit, the heaviest come first
+	size_t taskCount = sample->taskCount;
+
+	if ( size < ROVER_COMM_STREAM_PROFILE_HEADER_LEN ) {
+		return 0;
+	}
+
+	taskCount = MIN( taskCount, ( size - ROVER_COMM_STREAM_PROFILE_HEADER_LEN ) / ROVER_PROFILER_RECORD_LEN );
+	packet.taskCount = taskCount;
+
+	size_t len = rover_comm_emit_stream_profile( buffer, size, sample->timestampUs, &packet );
+
+	for ( size_t i = 0; i < taskCount; ++i ) {
+		const t_rover_profiler_task * task = &sample->tasks[i];
+		uint8_t * record = buffer + len;
+
+		memset( record, 0, ROVER_PROFILER_NAME_LEN );
+		memcpy( record, task->name, strnlen( task->name, ROVER_PROFILER_NAME_LEN ) );
+		memcpy( record + ROVER_PROFILER_NAME_LEN, &task->load, sizeof task->load );
+		record[ROVER_PROFILER_NAME_LEN + 2] = (uint8_t)task->coreId;
+		memcpy( record + ROVER_PROFILER_NAME_LEN + 3, &task->stackFree, sizeof task->stackFree );
+
+		len += ROVER_PROFILER_RECORD_LEN;
+	}
+
+	return len;
+}
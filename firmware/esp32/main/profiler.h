@@ -0,0 +1,97 @@
+/*
+ *	Copyright (c) 2025 Denis Rozhkov <denis@rozhkoff.com>
+ *	This file is part of cam-rover.
+ *
+ *	cam-rover is free software: you can redistribute it and/or
+ *	modify it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or (at your
+ *	option) any later version.
+ *
+ *	cam-rover is distributed in the hope that it will be
+ *	useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ *	Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along with
+ *	cam-rover. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef __ROVER__PROFILER__H
+#define __ROVER__PROFILER__H
+
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_timer.h"
+
+#include "comm_protocol.h"
+
+
+#define ROVER_PROFILER_CORES 2
+#define ROVER_PROFILER_TASKS_MAX 32
+// one task record on the wire, see the profile packet in protocol.json
+#define ROVER_PROFILER_RECORD_LEN 21
+#define ROVER_PROFILER_NAME_LEN 16
+#define ROVER_PROFILER_PACKET_LEN_MAX                                                                                  \
+	( ROVER_COMM_STREAM_PROFILE_HEADER_LEN + ROVER_PROFILER_TASKS_MAX * ROVER_PROFILER_RECORD_LEN )
+
+
+typedef struct {
+	char name[ROVER_PROFILER_NAME_LEN + 1];
+	// permille of one core
+	uint16_t load;
+	// -1 - not pinned
+	int8_t coreId;
+	// least free stack since the task started, bytes
+	uint16_t stackFree;
+} t_rover_profiler_task;
+
+// heaviest tasks first
+typedef struct {
+	int64_t timestampUs;
+	uint32_t windowUs;
+	uint16_t coreLoad[ROVER_PROFILER_CORES];
+	uint8_t taskCount;
+	t_rover_profiler_task tasks[ROVER_PROFILER_TASKS_MAX];
+} t_rover_profiler_sample;
+
+// called on the profiler task
+typedef void ( *t_rover_profiler_handler_sample )( void * context, const t_rover_profiler_sample * sample );
+
+typedef struct {
+	TaskHandle_t handle;
+	configRUN_TIME_COUNTER_TYPE runTime;
+} t_rover_profiler_counter;
+
+typedef struct {
+	t_rover_profiler_handler_sample handler;
+	void * handlerContext;
+	esp_timer_handle_t timer;
+	// run time counters as of the previous sample, a window is the difference
+	t_rover_profiler_counter counters[ROVER_PROFILER_TASKS_MAX];
+	size_t counterCount;
+	configRUN_TIME_COUNTER_TYPE totalRunTime;
+	// snapshot taken by the timer, turned into the sample by the profiler task
+	TaskStatus_t status[ROVER_PROFILER_TASKS_MAX];
+	UBaseType_t statusCount;
+	configRUN_TIME_COUNTER_TYPE statusRunTime;
+	int64_t statusTs;
+	volatile bool isPending;
+	TaskHandle_t task;
+	t_rover_profiler_sample sample;
+} t_rover_profiler;
+
+
+void rover_profiler_start( t_rover_profiler * profiler );
+// the sample as a profile stream packet, returns the length or 0 if it does not fit size
+size_t rover_profiler_emit( const t_rover_profiler_sample * sample, uint8_t * buffer, size_t size );
+
+
+#endif
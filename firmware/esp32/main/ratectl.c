@@ -0,0 +1,119 @@
+/*
+ *	Copyright (c) 2025 Denis Rozhkov <denis@rozhkoff.com>
+ *	This file is part of cam-rover.
+ *
+ *	cam-rover is free software: you can redistribute it and/or
+ *	modify it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or (at your
+ *	option) any later version.
+ *
+ *	cam-rover is distributed in the hope that it will be
+ *	useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ *	Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along with
+ *	cam-rover. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "ratectl.h"
+
+
+#define ROVER_RATECTL_QUALITY_OFFSET 4
+
+
+static uint8_t rover_ratectl_clamp( const t_rover_ratectl * rc, int32_t quality )
+{
+	if ( quality < rc->qualityMin ) {
+		return rc->qualityMin;
+	}
+
+	if ( quality > rc->qualityMax ) {
+		return rc->qualityMax;
+	}
+
+	return (uint8_t)quality;
+}
+
+
+void rover_ratectl_init( t_rover_ratectl * rc,
+	uint32_t budget,
+	uint8_t quality,
+	uint8_t qualityMin,
+	uint8_t qualityMax,
+	uint8_t stepMax,
+	uint8_t delay )
+{
+	rc->budget = budget;
+	rc->qualityMin = qualityMin;
+	rc->qualityMax = qualityMax;
+	rc->stepMax = stepMax > 0 ? stepMax : 1;
+	rc->delay = delay > ROVER_RATECTL_DELAY_MAX ? ROVER_RATECTL_DELAY_MAX : delay;
+
+	rc->quality = rover_ratectl_clamp( rc, quality );
+	rc->complexity = 0;
+	rc->sizeAvg = 0;
+	rc->overBudgetCount = 0;
+	rc->frameCount = 0;
+
+	for ( size_t i = 0; i <= ROVER_RATECTL_DELAY_MAX; ++i ) {
+		rc->applied[i] = rc->quality;
+	}
+}
+
+
+void rover_ratectl_set_budget( t_rover_ratectl * rc, uint32_t budget )
+{
+	rc->budget = budget;
+}
+
+
+// called once per frame with the size of the frame just captured, returns the quality for the next one;
+// a quality change only shows up in frames captured 'delay' frames later, so the frame is attributed to
+// the quality that was in effect when it was exposed
+uint8_t rover_ratectl_update( t_rover_ratectl * rc, size_t frameSize )
+{
+	uint32_t size = (uint32_t)frameSize;
+	uint32_t complexity = size * ( rc->applied[rc->delay] + ROVER_RATECTL_QUALITY_OFFSET );
+
+	// follow complexity up immediately so a busy scene does not blow the budget for several frames,
+	// let it decay slowly so the quality does not oscillate on noise
+	if ( 0 == rc->complexity || complexity > rc->complexity ) {
+		rc->complexity = complexity;
+	}
+	else {
+		rc->complexity -= ( rc->complexity - complexity ) / 4;
+	}
+
+	rc->sizeAvg = 0 == rc->sizeAvg ? size : rc->sizeAvg - rc->sizeAvg / 16 + size / 16;
+	rc->frameCount++;
+
+	if ( size > rc->budget ) {
+		rc->overBudgetCount++;
+	}
+
+	int32_t target = rc->budget > 0 ?
+		(int32_t)( ( rc->complexity + rc->budget - 1 ) / rc->budget ) - ROVER_RATECTL_QUALITY_OFFSET :
+		rc->qualityMin;
+
+	if ( target > rc->quality + rc->stepMax ) {
+		target = rc->quality + rc->stepMax;
+	}
+	else if ( target < rc->quality - 1 ) {
+		// step back towards better quality one notch at a time
+		target = rc->quality - 1;
+	}
+
+	rc->quality = rover_ratectl_clamp( rc, target );
+
+	for ( size_t i = ROVER_RATECTL_DELAY_MAX; i > 0; --i ) {
+		rc->applied[i] = rc->applied[i - 1];
+	}
+
+	rc->applied[0] = rc->quality;
+
+	return rc->quality;
+}
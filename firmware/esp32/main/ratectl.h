@@ -0,0 +1,64 @@
+/*
+ *	Copyright (c) 2025 Denis Rozhkov <denis@rozhkoff.com>
+ *	This file is part of cam-rover.
+ *
+ *	cam-rover is free software: you can redistribute it and/or
+ *	modify it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or (at your
+ *	option) any later version.
+ *
+ *	cam-rover is distributed in the hope that it will be
+ *	useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ *	Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along with
+ *	cam-rover. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef __ROVER__RATECTL__H
+#define __ROVER__RATECTL__H
+
+
+#include <stdint.h>
+#include <stddef.h>
+
+
+#define ROVER_RATECTL_DELAY_MAX 4
+
+
+// JPEG size is modelled as complexity / ( quality + ROVER_RATECTL_QUALITY_OFFSET ), where quality is the
+// sensor quality register (lower is better); complexity is tracked per frame and the next quality is
+// picked so that the predicted size fits the budget
+typedef struct {
+	uint32_t budget;
+	uint8_t qualityMin;
+	uint8_t qualityMax;
+	uint8_t stepMax;
+	uint8_t delay;
+
+	uint8_t quality;
+	uint8_t applied[ROVER_RATECTL_DELAY_MAX + 1];
+	uint32_t complexity;
+	uint32_t sizeAvg;
+	uint32_t overBudgetCount;
+	uint32_t frameCount;
+} t_rover_ratectl;
+
+
+void rover_ratectl_init( t_rover_ratectl * rc,
+	uint32_t budget,
+	uint8_t quality,
+	uint8_t qualityMin,
+	uint8_t qualityMax,
+	uint8_t stepMax,
+	uint8_t delay );
+
+void rover_ratectl_set_budget( t_rover_ratectl * rc, uint32_t budget );
+uint8_t rover_ratectl_update( t_rover_ratectl * rc, size_t frameSize );
+
+
+#endif
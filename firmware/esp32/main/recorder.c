@@ -0,0 +1,345 @@
+/*
+ *	Copyright (c) 2025 Denis Rozhkov <denis@rozhkoff.com>
+ *	This file is part of cam-rover.
+ *
+ *	cam-rover is free software: you can redistribute it and/or
+ *	modify it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or (at your
+ *	option) any later version.
+ *
+ *	cam-rover is distributed in the hope that it will be
+ *	useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ *	Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along with
+ *	cam-rover. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <string.h>
+#include <sys/param.h>
+#include <stdlib.h>
+#include <dirent.h>
+#include <inttypes.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "esp_vfs_fat.h"
+#include "sdmmc_cmd.h"
+#include "driver/sdmmc_host.h"
+
+#include "tasks.h"
+#include "recorder.h"
+#include "dlog.h"
+
+
+#define ROVER_RECORDER_MOUNT_POINT "/sdcard"
+
+#define ROVER_RECORDER_BLOCK_OPEN 0x01
+#define ROVER_RECORDER_BLOCK_CLOSE 0x02
+
+// the SD slot is wired to GPIO 2, 14 and 15 in 1-bit mode
+#define ROVER_RECORDER_IS_SD_PIN( a_pin ) ( 2 == ( a_pin ) || 14 == ( a_pin ) || 15 == ( a_pin ) )
+
+#if defined( CONFIG_ROVER_RECORDER ) &&                                                                                \
+	( ROVER_RECORDER_IS_SD_PIN( CONFIG_ROVER_DRIVE_GPIO1_A ) || ROVER_RECORDER_IS_SD_PIN( CONFIG_ROVER_DRIVE_GPIO1_B ) || \
+		ROVER_RECORDER_IS_SD_PIN( CONFIG_ROVER_DRIVE_GPIO2_A ) || ROVER_RECORDER_IS_SD_PIN( CONFIG_ROVER_DRIVE_GPIO2_B ) )
+#error "SD card recorder needs GPIO 2, 14 and 15: move the motor pins off them"
+#endif
+
+
+static const char * roverLogTAG = "rover.recorder";
+
+
+static bool rover_recorder_file_write( t_rover_recorder * recorder, const void * data, size_t len )
+{
+	return recorder->file != NULL && fwrite( data, 1, len, recorder->file ) == len;
+}
+
+
+static bool rover_recorder_sink_write( void * ctx, const void * data, size_t len )
+{
+	t_rover_recorder * recorder = (t_rover_recorder *)ctx;
+
+	// the index is written by the recorder task on close
+	if ( recorder->isClosing ) {
+		return rover_recorder_file_write( recorder, data, len );
+	}
+
+	const uint8_t * p = (const uint8_t *)data;
+
+	while ( len > 0 ) {
+		if ( NULL == recorder->active.data ) {
+			if ( xQueueReceive( recorder->freeBlocks, &recorder->active.data, 0 ) != pdTRUE ) {
+				return false;
+			}
+
+			recorder->active.len = 0;
+			recorder->active.flags = 0;
+		}
+
+		size_t n = MIN( len, CONFIG_ROVER_RECORDER_BLOCK_SIZE - recorder->active.len );
+		memcpy( recorder->active.data + recorder->active.len, p, n );
+		recorder->active.len += n;
+		p += n;
+		len -= n;
+
+		if ( CONFIG_ROVER_RECORDER_BLOCK_SIZE == recorder->active.len ) {
+			xQueueSend( recorder->fullBlocks, &recorder->active, 0 );
+			recorder->active.data = NULL;
+		}
+	}
+
+	return true;
+}
+
+
+static bool rover_recorder_sink_patch( void * ctx, size_t offset, const void * data, size_t len )
+{
+	t_rover_recorder * recorder = (t_rover_recorder *)ctx;
+
+	return fseek( recorder->file, offset, SEEK_SET ) == 0 && rover_recorder_file_write( recorder, data, len ) &&
+		fseek( recorder->file, 0, SEEK_END ) == 0;
+}
+
+
+static uint32_t rover_recorder_find_next_file_no( void )
+{
+	uint32_t r = 0;
+	DIR * dir = opendir( ROVER_RECORDER_MOUNT_POINT );
+
+	if ( NULL == dir ) {
+		return r;
+	}
+
+	struct dirent * entry;
+
+	while ( ( entry = readdir( dir ) ) != NULL ) {
+		unsigned long fileNo;
+
+		if ( sscanf( entry->d_name, "R%7lu.AVI", &fileNo ) == 1 && fileNo >= r ) {
+			r = fileNo + 1;
+		}
+	}
+
+	closedir( dir );
+
+	return r;
+}
+
+
+static bool rover_recorder_open_file( t_rover_recorder * recorder )
+{
+	char path[32];
+	snprintf( path, sizeof path, ROVER_RECORDER_MOUNT_POINT "/R%07" PRIu32 ".AVI", recorder->fileNo++ );
+
+	recorder->file = fopen( path, "wb" );
+
+	if ( NULL == recorder->file ) {
+		ESP_LOGE( roverLogTAG, "Failed to create %s, recording stopped", path );
+		return false;
+	}
+
+	// blocks are already cluster-sized, skip the stdio copy
+	setvbuf( recorder->file, NULL, _IONBF, 0 );
+	ESP_LOGI( roverLogTAG, "recording to %s", path );
+
+	return true;
+}
+
+
+static void rover_recorder_task( void * parameters )
+{
+	t_rover_recorder * recorder = (t_rover_recorder *)parameters;
+
+	uint64_t bytesWritten = 0;
+	int64_t writeUs = 0;
+
+	while ( true ) {
+		t_rover_recorder_block block;
+		xQueueReceive( recorder->fullBlocks, &block, portMAX_DELAY );
+
+		if ( block.flags & ROVER_RECORDER_BLOCK_OPEN ) {
+			// the blocks of a segment without a file are only handed back until the closing one
+			if ( !rover_recorder_open_file( recorder ) ) {
+				recorder->isEnabled = false;
+			}
+
+			bytesWritten = 0;
+			writeUs = 0;
+		}
+
+		int64_t startTs = esp_timer_get_time();
+
+		if ( !rover_recorder_file_write( recorder, block.data, block.len ) && recorder->file != NULL ) {
+			ESP_LOGE( roverLogTAG, "write failed, recording stopped" );
+			fclose( recorder->file );
+			recorder->file = NULL;
+			recorder->isEnabled = false;
+		}
+
+		writeUs += esp_timer_get_time() - startTs;
+		bytesWritten += block.len;
+
+		if ( block.data != NULL ) {
+			xQueueSend( recorder->freeBlocks, &block.data, 0 );
+		}
+
+		if ( block.flags & ROVER_RECORDER_BLOCK_CLOSE ) {
+			if ( recorder->file != NULL ) {
+				if ( !rover_avi_close( &recorder->avi ) ) {
+					ESP_LOGE( roverLogTAG, "failed to write the index" );
+				}
+
+				fclose( recorder->file );
+				recorder->file = NULL;
+
+				ROVER_DLOGI( roverLogTAG,
+					"segment closed: %" PRIu32 " frames, %u dropped, %.2f MB/s",
+					recorder->avi.frameCount,
+					(unsigned)recorder->droppedCount,
+					writeUs > 0 ? (double)bytesWritten / writeUs : 0.0 );
+			}
+
+			recorder->isClosing = false;
+		}
+	}
+}
+
+
+static void rover_recorder_close_segment( t_rover_recorder * recorder )
+{
+	recorder->isClosing = true;
+	recorder->isSegmentOpen = false;
+	// a block that has just been queued full is followed by an empty closing one
+	if ( NULL == recorder->active.data ) {
+		recorder->active.len = 0;
+		recorder->active.flags = 0;
+	}
+
+	recorder->active.flags |= ROVER_RECORDER_BLOCK_CLOSE;
+	xQueueSend( recorder->fullBlocks, &recorder->active, 0 );
+	recorder->active.data = NULL;
+}
+
+
+void rover_recorder_append( t_rover_recorder * recorder, const t_rover_camera_frame * frame )
+{
+	if ( !recorder->isEnabled ) {
+		return;
+	}
+
+	if ( !recorder->isSegmentOpen ) {
+		if ( recorder->isClosing || xQueueReceive( recorder->freeBlocks, &recorder->active.data, 0 ) != pdTRUE ) {
+			recorder->droppedCount++;
+			return;
+		}
+
+		recorder->active.len = 0;
+		recorder->active.flags = ROVER_RECORDER_BLOCK_OPEN;
+
+		t_rover_avi_sink sink = {
+			.ctx = recorder, .write = rover_recorder_sink_write, .patch = rover_recorder_sink_patch
+		};
+
+		rover_avi_open(
+			&recorder->avi, &sink, frame->width, frame->height, recorder->index, CONFIG_ROVER_RECORDER_SEGMENT_FRAMES );
+
+		recorder->isSegmentOpen = true;
+	}
+
+	// never wait for the SD card: drop the frame if it does not fit into the free blocks
+	size_t available = uxQueueMessagesWaiting( recorder->freeBlocks ) * CONFIG_ROVER_RECORDER_BLOCK_SIZE;
+
+	if ( recorder->active.data != NULL ) {
+		available += CONFIG_ROVER_RECORDER_BLOCK_SIZE - recorder->active.len;
+	}
+
+	if ( ROVER_AVI_CHUNK_SIZE( frame->len ) > available ) {
+		recorder->droppedCount++;
+		return;
+	}
+
+	rover_avi_add_frame( &recorder->avi, frame->ptr, frame->len, frame->timestampUs );
+
+	if ( rover_avi_is_full( &recorder->avi ) ) {
+		rover_recorder_close_segment( recorder );
+	}
+}
+
+
+bool rover_recorder_start( t_rover_recorder * recorder )
+{
+#ifdef CONFIG_ROVER_RECORDER
+	sdmmc_host_t host = SDMMC_HOST_DEFAULT();
+	sdmmc_slot_config_t slotConfig = SDMMC_SLOT_CONFIG_DEFAULT();
+	slotConfig.width = 1;
+
+	esp_vfs_fat_sdmmc_mount_config_t mountConfig = { .format_if_mount_failed = false,
+		.max_files = 2,
+		.allocation_unit_size = CONFIG_ROVER_RECORDER_BLOCK_SIZE };
+
+	sdmmc_card_t * card;
+	esp_err_t err = esp_vfs_fat_sdmmc_mount( ROVER_RECORDER_MOUNT_POINT, &host, &slotConfig, &mountConfig, &card );
+
+	if ( err != ESP_OK ) {
+		ESP_LOGE( roverLogTAG, "Failed to mount SD card: %s", esp_err_to_name( err ) );
+		return false;
+	}
+
+	bool isOk = false;
+
+	recorder->freeBlocks = xQueueCreateStatic(
+		ROVER_RECORDER_BLOCK_COUNT, sizeof( uint8_t * ), recorder->freeBlocksStorage, &recorder->freeBlocksBuffer );
+	recorder->fullBlocks = xQueueCreateStatic( ROVER_RECORDER_BLOCK_COUNT + 1,
+		sizeof( t_rover_recorder_block ),
+		recorder->fullBlocksStorage,
+		&recorder->fullBlocksBuffer );
+	recorder->index =
+		heap_caps_malloc( CONFIG_ROVER_RECORDER_SEGMENT_FRAMES * ROVER_AVI_INDEX_ENTRY_SIZE, MALLOC_CAP_SPIRAM );
+
+	if ( NULL == recorder->index ) {
+		ESP_LOGE( roverLogTAG, "Failed to allocate recorder index" );
+		goto l_exit;
+	}
+
+	for ( size_t i = 0; i < ROVER_RECORDER_BLOCK_COUNT; ++i ) {
+		uint8_t * block = heap_caps_malloc( CONFIG_ROVER_RECORDER_BLOCK_SIZE, MALLOC_CAP_SPIRAM );
+
+		if ( NULL == block ) {
+			ESP_LOGE( roverLogTAG, "Failed to allocate recorder blocks" );
+			goto l_exit;
+		}
+
+		xQueueSend( recorder->freeBlocks, &block, 0 );
+	}
+
+	recorder->fileNo = rover_recorder_find_next_file_no();
+	recorder->isEnabled = true;
+
+	rover_task_create( ROVER_TASK_RECORDER, &rover_recorder_task, recorder, NULL );
+
+	isOk = true;
+
+l_exit:
+	if ( !isOk ) {
+		uint8_t * block;
+
+		while ( xQueueReceive( recorder->freeBlocks, &block, 0 ) == pdTRUE ) {
+			heap_caps_free( block );
+		}
+
+		heap_caps_free( recorder->index );
+		recorder->index = NULL;
+		esp_vfs_fat_sdcard_unmount( ROVER_RECORDER_MOUNT_POINT, card );
+	}
+
+	return isOk;
+#else
+	return false;
+#endif
+}
@@ -0,0 +1,68 @@
+/*
+ *	Copyright (c) 2025 Denis Rozhkov <denis@rozhkoff.com>
+ *	This file is part of cam-rover.
+ *
+ *	cam-rover is free software: you can redistribute it and/or
+ *	modify it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or (at your
+ *	option) any later version.
+ *
+ *	cam-rover is distributed in the hope that it will be
+ *	useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ *	Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along with
+ *	cam-rover. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef __ROVER__RECORDER__H
+#define __ROVER__RECORDER__H
+
+
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+#include "avi.h"
+#include "camera.h"
+
+
+#define ROVER_RECORDER_BLOCK_COUNT 2
+
+
+typedef struct {
+	uint8_t * data;
+	size_t len;
+	uint32_t flags;
+} t_rover_recorder_block;
+
+typedef struct {
+	bool isEnabled;
+	bool isSegmentOpen;
+	volatile bool isClosing;
+	t_rover_avi avi;
+	uint8_t * index;
+	t_rover_recorder_block active;
+	QueueHandle_t freeBlocks;
+	StaticQueue_t freeBlocksBuffer;
+	uint8_t freeBlocksStorage[ROVER_RECORDER_BLOCK_COUNT * sizeof( uint8_t * )];
+	QueueHandle_t fullBlocks;
+	StaticQueue_t fullBlocksBuffer;
+	uint8_t fullBlocksStorage[( ROVER_RECORDER_BLOCK_COUNT + 1 ) * sizeof( t_rover_recorder_block )];
+	FILE * file;
+	uint32_t fileNo;
+	size_t droppedCount;
+} t_rover_recorder;
+
+
+bool rover_recorder_start( t_rover_recorder * recorder );
+void rover_recorder_append( t_rover_recorder * recorder, const t_rover_camera_frame * frame );
+
+
+#endif
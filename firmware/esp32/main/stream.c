@@ -0,0 +1,149 @@
+/*
+ *	Copyright (c) 2025 Denis Rozhkov <denis@rozhkoff.com>
+ *	This file is part of cam-rover.
+ *
+ *	cam-rover is free software: you can redistribute it and/or
+ *	modify it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or (at your
+ *	option) any later version.
+ *
+ *	cam-rover is distributed in the hope that it will be
+ *	useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ *	Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along with
+ *	cam-rover. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <sys/param.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "comm.h"
+#include "stream.h"
+#include "dlog.h"
+
+
+#define ROVER_STREAM_INTERVAL_DEFAULT_US 50000
+#define ROVER_STREAM_INTERVAL_MIN_US 10000
+#define ROVER_STREAM_INTERVAL_MAX_US 250000
+#define ROVER_STREAM_LOG_FRAMES 300
+
+
+void rover_stream_init( t_rover_stream * stream, t_rover_comm_endpoint * endpoint )
+{
+	stream->endpoint = endpoint;
+	stream->lastCaptureUs = 0;
+	stream->intervalUs = ROVER_STREAM_INTERVAL_DEFAULT_US;
+	stream->tokens = 0;
+	stream->tokensUs = esp_timer_get_time();
+	stream->frameCount = 0;
+	stream->skippedCount = 0;
+}
+
+
+#ifdef CONFIG_ROVER_STREAM_PACING
+static const char * roverLogTAG = "rover.stream";
+
+
+// smoothed capture interval, the frame should be out before the next one arrives
+static uint32_t rover_stream_update_interval( t_rover_stream * stream, int64_t captureUs )
+{
+	if ( stream->lastCaptureUs != 0 && captureUs > stream->lastCaptureUs ) {
+		int64_t intervalUs =
+			MIN( MAX( captureUs - stream->lastCaptureUs, ROVER_STREAM_INTERVAL_MIN_US ), ROVER_STREAM_INTERVAL_MAX_US );
+
+		stream->intervalUs = ( stream->intervalUs * 3 + (uint32_t)intervalUs ) / 4;
+	}
+
+	stream->lastCaptureUs = captureUs;
+
+	return stream->intervalUs;
+}
+
+
+static void rover_stream_take_tokens( t_rover_stream * stream, uint64_t rate, size_t len )
+{
+	while ( true ) {
+		int64_t nowUs = esp_timer_get_time();
+		stream->tokens += ( nowUs - stream->tokensUs ) * rate / 1000000;
+		stream->tokens = MIN( stream->tokens,
+			CONFIG_ROVER_STREAM_PACING_BURST * ( CONFIG_ROVER_STREAM_CHUNK_SIZE + ROVER_COMM_STREAM_CHUNK_HEADER_LEN ) );
+		stream->tokensUs = nowUs;
+
+		if ( stream->tokens >= (int64_t)len ) {
+			stream->tokens -= len;
+			return;
+		}
+
+		int64_t waitUs = ( len - stream->tokens ) * 1000000 / rate;
+		vTaskDelay( MAX( 1, pdMS_TO_TICKS( waitUs / 1000 ) ) );
+	}
+}
+#endif
+
+
+// a failed send (ENOMEM from the driver, most of the time) is backpressure, the rest of the frame is dropped
+// rather than pushed into a queue that is already full
+bool rover_stream_send_frame( t_rover_stream * stream, const t_rover_camera_frame * frame )
+{
+#ifndef CONFIG_ROVER_STREAM_PACING
+	uint8_t header[ROVER_COMM_STREAM_FRAME_HEADER_LEN];
+	size_t headerLen = rover_comm_emit_stream_frame( header, sizeof header, frame->timestampUs );
+
+	return rover_comm_endpoint_send_with_header( stream->endpoint, header, headerLen, frame->ptr, frame->len );
+#else
+	uint32_t intervalUs = rover_stream_update_interval( stream, frame->timestampUs );
+
+	// nobody to send to is not backpressure, such frames are left out of the skipped/sent counts
+	if ( !stream->endpoint->transport->hasClient ) {
+		return false;
+	}
+
+	uint64_t rate = (uint64_t)frame->len * 1000000 * 100 / ( (uint64_t)intervalUs * CONFIG_ROVER_STREAM_PACING_SHARE );
+	rate = MAX( rate, 1 );
+
+	uint8_t buffer[ROVER_COMM_STREAM_CHUNK_HEADER_LEN];
+	bool isSent = true;
+
+	for ( size_t offset = 0; offset < frame->len; ) {
+		size_t chunkLen = MIN( (size_t)CONFIG_ROVER_STREAM_CHUNK_SIZE, frame->len - offset );
+
+		t_rover_comm_stream_chunk chunk = { .offset = offset, .length = frame->len };
+		size_t headerLen = rover_comm_emit_stream_chunk( buffer, sizeof buffer, frame->timestampUs, &chunk );
+
+		rover_stream_take_tokens( stream, rate, headerLen + chunkLen );
+
+		if ( !rover_comm_endpoint_send_with_header(
+				 stream->endpoint, buffer, headerLen, frame->ptr + offset, chunkLen ) ) {
+			// a TCP client may have gone away mid frame
+			stream->skippedCount += stream->endpoint->transport->hasClient ? 1 : 0;
+			isSent = false;
+			break;
+		}
+
+		offset += chunkLen;
+	}
+
+	if ( ++stream->frameCount >= ROVER_STREAM_LOG_FRAMES ) {
+		ROVER_DLOGI( roverLogTAG,
+			"frame interval %u us, skipped %u/%u frames",
+			(unsigned)stream->intervalUs,
+			(unsigned)stream->skippedCount,
+			(unsigned)stream->frameCount );
+
+		stream->frameCount = 0;
+		stream->skippedCount = 0;
+	}
+
+	return isSent;
+#endif
+}
@@ -0,0 +1,52 @@
+/*
+ *	Copyright (c) 2025 Denis Rozhkov <denis@rozhkoff.com>
+ *	This file is part of cam-rover.
+ *
+ *	cam-rover is free software: you can redistribute it and/or
+ *	modify it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or (at your
+ *	option) any later version.
+ *
+ *	cam-rover is distributed in the hope that it will be
+ *	useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ *	Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along with
+ *	cam-rover. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef __ROVER__STREAM__H
+#define __ROVER__STREAM__H
+
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "camera.h"
+#include "comm_endpoint.h"
+
+
+// full frames are cut into datagram sized chunks and spread over the frame interval by a token bucket, so
+// control packets are not queued behind a whole frame in the Wi-Fi driver
+typedef struct {
+	t_rover_comm_endpoint * endpoint;
+	int64_t lastCaptureUs;
+	uint32_t intervalUs;
+	// token bucket, bytes
+	int64_t tokens;
+	int64_t tokensUs;
+	uint32_t frameCount;
+	// frames whose remaining chunks were dropped because a send to the client failed
+	uint32_t skippedCount;
+} t_rover_stream;
+
+
+void rover_stream_init( t_rover_stream * stream, t_rover_comm_endpoint * endpoint );
+bool rover_stream_send_frame( t_rover_stream * stream, const t_rover_camera_frame * frame );
+
+
+#endif
@@ -0,0 +1,249 @@
+/*
+ *	Copyright (c) 2025 Denis Rozhkov <denis@rozhkoff.com>
+ *	This file is part of cam-rover.
+ *
+ *	cam-rover is free software: you can redistribute it and/or
+ *	modify it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or (at your
+ *	option) any later version.
+ *
+ *	cam-rover is distributed in the hope that it will be
+ *	useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ *	Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along with
+ *	cam-rover. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+
+#include "tasks.h"
+#include "sweep.h"
+
+
+// frames right after init carry AEC/AWB settling and a possibly half filled buffer
+#define ROVER_SWEEP_WARMUP_FRAMES 5
+
+
+#ifdef CONFIG_ROVER_BENCH_CAMERA_SWEEP
+
+static const char * roverLogTAG = "rover.sweep";
+
+static uint32_t roverSweepSizes[ROVER_SWEEP_FRAMES_MAX];
+static uint32_t roverSweepLatencies[ROVER_SWEEP_FRAMES_MAX];
+
+
+static int rover_sweep_compare_u32( const void * a, const void * b )
+{
+	uint32_t va = *(const uint32_t *)a;
+	uint32_t vb = *(const uint32_t *)b;
+
+	return ( va > vb ) - ( va < vb );
+}
+
+
+static uint32_t rover_sweep_mean( const uint32_t * values, size_t count )
+{
+	uint64_t sum = 0;
+
+	for ( size_t i = 0; i < count; ++i ) {
+		sum += values[i];
+	}
+
+	return count > 0 ? (uint32_t)( sum / count ) : 0;
+}
+
+
+static uint32_t rover_sweep_p95( uint32_t * values, size_t count )
+{
+	if ( 0 == count ) {
+		return 0;
+	}
+
+	qsort( values, count, sizeof values[0], rover_sweep_compare_u32 );
+
+	return values[count * 95 / 100];
+}
+
+
+static void rover_sweep_measure( t_rover_sweep * sweep, t_rover_sweep_point * point )
+{
+	camera_config_t config = sweep->camera->config;
+	config.frame_size = point->frameSize;
+	config.jpeg_quality = point->quality;
+	config.xclk_freq_hz = point->xclkFreqHz;
+	config.fb_count = point->fbCount;
+
+	rover_camera_deinit( sweep->camera );
+	size_t psramFree = heap_caps_get_free_size( MALLOC_CAP_SPIRAM );
+	point->err = rover_camera_reinit( sweep->camera, &config );
+
+	if ( point->err != ESP_OK ) {
+		return;
+	}
+
+	point->psramFree = heap_caps_get_free_size( MALLOC_CAP_SPIRAM );
+	point->psramUsed = psramFree - point->psramFree;
+
+	size_t frameCount = sweep->matrix.frameCount;
+	size_t count = 0;
+	int64_t firstUs = 0;
+	int64_t lastUs = 0;
+
+	for ( size_t i = 0; count < frameCount && i < ( frameCount + ROVER_SWEEP_WARMUP_FRAMES ) * 2; ++i ) {
+		camera_fb_t * pic = esp_camera_fb_get();
+		int64_t nowUs = esp_timer_get_time();
+
+		if ( NULL == pic ) {
+			point->droppedCount++;
+			continue;
+		}
+
+		if ( i >= ROVER_SWEEP_WARMUP_FRAMES ) {
+			int64_t captureUs = (int64_t)pic->timestamp.tv_sec * 1000000 + pic->timestamp.tv_usec;
+
+			if ( 0 == count ) {
+				firstUs = nowUs;
+			}
+
+			lastUs = nowUs;
+			point->width = pic->width;
+			point->height = pic->height;
+			roverSweepSizes[count] = pic->len;
+			roverSweepLatencies[count] = (uint32_t)( nowUs - captureUs );
+			count++;
+		}
+
+		esp_camera_fb_return( pic );
+	}
+
+	if ( count > 1 ) {
+		point->fpsX10 = (uint32_t)( (int64_t)( count - 1 ) * 10000000 / ( lastUs - firstUs ) );
+	}
+
+	point->sizeMean = rover_sweep_mean( roverSweepSizes, count );
+	point->sizeP95 = rover_sweep_p95( roverSweepSizes, count );
+	point->latencyMeanUs = rover_sweep_mean( roverSweepLatencies, count );
+	point->latencyP95Us = rover_sweep_p95( roverSweepLatencies, count );
+}
+
+
+static void rover_sweep_task( void * parameters )
+{
+	t_rover_sweep * sweep = (t_rover_sweep *)parameters;
+	const t_rover_sweep_matrix * m = &sweep->matrix;
+
+	// created on the first sweep and kept, every start notifies it
+	while ( true ) {
+		ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+
+		rover_camera_pause( sweep->camera );
+
+		for ( size_t f = 0; f < m->frameSizeCount; ++f ) {
+			for ( size_t q = 0; q < m->qualityCount; ++q ) {
+				for ( size_t x = 0; x < m->xclkFreqCount; ++x ) {
+					for ( size_t b = 0; b < m->fbCountCount && sweep->pointCount < ROVER_SWEEP_POINTS_MAX; ++b ) {
+						t_rover_sweep_point * point = &sweep->points[sweep->pointCount];
+						memset( point, 0, sizeof *point );
+						point->frameSize = m->frameSizes[f];
+						point->quality = m->qualities[q];
+						point->xclkFreqHz = m->xclkFreqsHz[x];
+						point->fbCount = m->fbCounts[b];
+
+						rover_sweep_measure( sweep, point );
+
+						ESP_LOGI( roverLogTAG,
+							"size %d (%" PRIu32 "x%" PRIu32 "), quality %u, xclk %" PRIu32 ", fb %u: err 0x%x, FPS %"
+							PRIu32 ".%" PRIu32 ", size mean %" PRIu32 " p95 %" PRIu32 ", latency mean %" PRIu32
+							" p95 %" PRIu32 " us, PSRAM used %" PRIu32 " free %" PRIu32,
+							(int)point->frameSize,
+							point->width,
+							point->height,
+							(unsigned)point->quality,
+							point->xclkFreqHz,
+							(unsigned)point->fbCount,
+							(unsigned)point->err,
+							point->fpsX10 / 10,
+							point->fpsX10 % 10,
+							point->sizeMean,
+							point->sizeP95,
+							point->latencyMeanUs,
+							point->latencyP95Us,
+							point->psramUsed,
+							point->psramFree );
+
+						sweep->pointCount++;
+					}
+				}
+			}
+		}
+
+		rover_camera_deinit( sweep->camera );
+
+		if ( rover_camera_reinit( sweep->camera, &sweep->camera->config ) != ESP_OK ) {
+			ESP_LOGE( roverLogTAG, "Failed to restore the camera configuration" );
+		}
+
+		rover_camera_resume( sweep->camera );
+
+		sweep->isRunning = false;
+	}
+}
+
+#endif
+
+
+void rover_sweep_init( t_rover_sweep * sweep, t_rover_camera * camera )
+{
+	memset( sweep, 0, sizeof *sweep );
+	sweep->camera = camera;
+}
+
+
+// false if a sweep is already running or the sweep is disabled
+bool rover_sweep_start( t_rover_sweep * sweep, const t_rover_sweep_matrix * matrix )
+{
+#ifdef CONFIG_ROVER_BENCH_CAMERA_SWEEP
+	if ( sweep->isRunning ) {
+		return false;
+	}
+
+	sweep->matrix = *matrix;
+
+	if ( 0 == sweep->matrix.frameCount || sweep->matrix.frameCount > ROVER_SWEEP_FRAMES_MAX ) {
+		sweep->matrix.frameCount = CONFIG_ROVER_BENCH_CAMERA_SWEEP_FRAMES;
+	}
+
+	sweep->pointCount = 0;
+	sweep->pointTotal = matrix->frameSizeCount * matrix->qualityCount * matrix->xclkFreqCount * matrix->fbCountCount;
+
+	if ( sweep->pointTotal > ROVER_SWEEP_POINTS_MAX ) {
+		sweep->pointTotal = ROVER_SWEEP_POINTS_MAX;
+	}
+
+	sweep->isRunning = true;
+
+	if ( NULL == sweep->task &&
+		rover_task_create( ROVER_TASK_BENCH, &rover_sweep_task, sweep, &sweep->task ) != pdPASS ) {
+
+		sweep->isRunning = false;
+		return false;
+	}
+
+	xTaskNotifyGive( sweep->task );
+
+	return true;
+#else
+	return false;
+#endif
+}
@@ -0,0 +1,86 @@
+/*
+ *	Copyright (c) 2025 Denis Rozhkov <denis@rozhkoff.com>
+ *	This file is part of cam-rover.
+ *
+ *	cam-rover is free software: you can redistribute it and/or
+ *	modify it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or (at your
+ *	option) any later version.
+ *
+ *	cam-rover is distributed in the hope that it will be
+ *	useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ *	Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along with
+ *	cam-rover. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef __ROVER__SWEEP__H
+#define __ROVER__SWEEP__H
+
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "camera.h"
+
+
+#define ROVER_SWEEP_VALUES_MAX 8
+#define ROVER_SWEEP_POINTS_MAX 64
+#define ROVER_SWEEP_FRAMES_MAX 300
+
+
+// every combination of the listed values is measured
+typedef struct {
+	framesize_t frameSizes[ROVER_SWEEP_VALUES_MAX];
+	size_t frameSizeCount;
+	uint8_t qualities[ROVER_SWEEP_VALUES_MAX];
+	size_t qualityCount;
+	uint32_t xclkFreqsHz[ROVER_SWEEP_VALUES_MAX];
+	size_t xclkFreqCount;
+	uint8_t fbCounts[ROVER_SWEEP_VALUES_MAX];
+	size_t fbCountCount;
+	// frames measured per point, after the warm-up frames
+	size_t frameCount;
+} t_rover_sweep_matrix;
+
+typedef struct {
+	framesize_t frameSize;
+	uint8_t quality;
+	uint32_t xclkFreqHz;
+	uint8_t fbCount;
+	esp_err_t err;
+	uint32_t width;
+	uint32_t height;
+	uint32_t fpsX10;
+	uint32_t sizeMean;
+	uint32_t sizeP95;
+	// frame timestamp (start of the frame) to the frame being handed out by esp_camera_fb_get
+	uint32_t latencyMeanUs;
+	uint32_t latencyP95Us;
+	uint32_t droppedCount;
+	// PSRAM taken by the driver with this configuration and what is left
+	uint32_t psramUsed;
+	uint32_t psramFree;
+} t_rover_sweep_point;
+
+typedef struct {
+	t_rover_camera * camera;
+	t_rover_sweep_matrix matrix;
+	t_rover_sweep_point points[ROVER_SWEEP_POINTS_MAX];
+	size_t pointCount;
+	size_t pointTotal;
+	volatile bool isRunning;
+	TaskHandle_t task;
+} t_rover_sweep;
+
+
+void rover_sweep_init( t_rover_sweep * sweep, t_rover_camera * camera );
+bool rover_sweep_start( t_rover_sweep * sweep, const t_rover_sweep_matrix * matrix );
+
+
+#endif
@@ -0,0 +1,345 @@
+/*
+ *	Copyright (c) 2025 Denis Rozhkov <denis@rozhkoff.com>
+ *	This file is part of cam-rover.
+ *
+ *	cam-rover is free software: you can redistribute it and/or
+ *	modify it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or (at your
+ *	option) any later version.
+ *
+ *	cam-rover is distributed in the hope that it will be
+ *	useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ *	Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along with
+ *	cam-rover. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <stdbool.h>
+#include <inttypes.h>
+#include <sys/param.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "config.h"
+#include "tasks.h"
+
+
+#define ROVER_TASK_CORE( a_core ) ( ( a_core ) < 0 ? tskNO_AFFINITY : ( a_core ) )
+
+// stacks and control blocks of the tasks created under an id
+#define ROVER_TASK_STORAGE( a_name, a_stackSize, a_count )                                                             \
+	static StackType_t a_name##Stacks[( a_count ) * ( ( a_stackSize ) / sizeof( StackType_t ) )];                      \
+	static StaticTask_t a_name##Tcbs[a_count];                                                                         \
+	static TaskHandle_t a_name##Handles[a_count];                                                                      \
+	static uint32_t a_name##StackFreeMin[a_count]
+
+#define ROVER_TASK_SLOTS( a_name, a_count )                                                                            \
+	.instanceMax = ( a_count ), .stacks = a_name##Stacks, .tcbs = a_name##Tcbs, .handles = a_name##Handles,            \
+	.stackFreeMin = a_name##StackFreeMin
+
+// tasks created under each id, a feature that is built out reserves nothing: no storage, no slots
+#define ROVER_TASK_INSTANCES_CAMERA 1
+// the ACK benchmark runs an endpoint of its own with the control task settings
+#ifdef CONFIG_ROVER_BENCH_ACK_LATENCY
+#define ROVER_TASK_INSTANCES_COMM_CONTROL 2
+#else
+#define ROVER_TASK_INSTANCES_COMM_CONTROL 1
+#endif
+#define ROVER_TASK_INSTANCES_COMM_STREAM 1
+#define ROVER_TASK_INSTANCES_DISCOVERY 1
+
+#if defined( CONFIG_ROVER_BENCH_ACK_LATENCY ) && defined( CONFIG_ROVER_BENCH_CAMERA_SWEEP )
+#define ROVER_TASK_INSTANCES_BENCH 2
+#elif defined( CONFIG_ROVER_BENCH_ACK_LATENCY ) || defined( CONFIG_ROVER_BENCH_CAMERA_SWEEP )
+#define ROVER_TASK_INSTANCES_BENCH 1
+#else
+#define ROVER_TASK_INSTANCES_BENCH 0
+#endif
+
+#ifdef CONFIG_ROVER_RECORDER
+#define ROVER_TASK_INSTANCES_RECORDER 1
+#else
+#define ROVER_TASK_INSTANCES_RECORDER 0
+#endif
+
+// ROVER_ENCODER_BANDS - 1 workers, the camera task encodes the first band
+#ifdef CONFIG_ROVER_CAMERA_PARALLEL_JPEG
+#define ROVER_TASK_INSTANCES_ENCODER 1
+#else
+#define ROVER_TASK_INSTANCES_ENCODER 0
+#endif
+
+// stream, recorder and history stages
+#define ROVER_TASK_INSTANCES_PIPELINE ( 1 + ROVER_TASK_INSTANCES_RECORDER + ( CONFIG_ROVER_HISTORY_SIZE > 0 ) )
+
+#ifdef CONFIG_ROVER_TRACKER
+#define ROVER_TASK_INSTANCES_TRACKER 1
+#else
+#define ROVER_TASK_INSTANCES_TRACKER 0
+#endif
+
+#ifdef CONFIG_ROVER_DLOG_CONSOLE
+#define ROVER_TASK_INSTANCES_LOG 1
+#else
+#define ROVER_TASK_INSTANCES_LOG 0
+#endif
+
+#define ROVER_TASK_INSTANCES_CONFIG 1
+
+#ifdef CONFIG_ROVER_PROFILER
+#define ROVER_TASK_INSTANCES_PROFILER 1
+#else
+#define ROVER_TASK_INSTANCES_PROFILER 0
+#endif
+
+
+static const char * roverLogTAG = "rover.tasks";
+
+ROVER_TASK_STORAGE( roverTaskCamera, CONFIG_ROVER_TASK_CAMERA_STACK_SIZE, ROVER_TASK_INSTANCES_CAMERA );
+ROVER_TASK_STORAGE( roverTaskControl, CONFIG_ROVER_TASK_COMM_CONTROL_STACK_SIZE, ROVER_TASK_INSTANCES_COMM_CONTROL );
+ROVER_TASK_STORAGE( roverTaskStream, CONFIG_ROVER_TASK_COMM_STREAM_STACK_SIZE, ROVER_TASK_INSTANCES_COMM_STREAM );
+ROVER_TASK_STORAGE( roverTaskDiscovery, CONFIG_ROVER_TASK_DISCOVERY_STACK_SIZE, ROVER_TASK_INSTANCES_DISCOVERY );
+#if ROVER_TASK_INSTANCES_BENCH > 0
+ROVER_TASK_STORAGE( roverTaskBench, CONFIG_ROVER_TASK_BENCH_STACK_SIZE, ROVER_TASK_INSTANCES_BENCH );
+#endif
+#if ROVER_TASK_INSTANCES_RECORDER > 0
+ROVER_TASK_STORAGE( roverTaskRecorder, CONFIG_ROVER_TASK_RECORDER_STACK_SIZE, ROVER_TASK_INSTANCES_RECORDER );
+#endif
+#if ROVER_TASK_INSTANCES_ENCODER > 0
+ROVER_TASK_STORAGE( roverTaskEncoder, CONFIG_ROVER_TASK_ENCODER_STACK_SIZE, ROVER_TASK_INSTANCES_ENCODER );
+#endif
+ROVER_TASK_STORAGE( roverTaskPipeline, CONFIG_ROVER_TASK_PIPELINE_STACK_SIZE, ROVER_TASK_INSTANCES_PIPELINE );
+#if ROVER_TASK_INSTANCES_TRACKER > 0
+ROVER_TASK_STORAGE( roverTaskTracker, CONFIG_ROVER_TASK_TRACKER_STACK_SIZE, ROVER_TASK_INSTANCES_TRACKER );
+#endif
+#if ROVER_TASK_INSTANCES_LOG > 0
+ROVER_TASK_STORAGE( roverTaskLog, CONFIG_ROVER_TASK_LOG_STACK_SIZE, ROVER_TASK_INSTANCES_LOG );
+#endif
+ROVER_TASK_STORAGE( roverTaskConfig, CONFIG_ROVER_TASK_CONFIG_STACK_SIZE, ROVER_TASK_INSTANCES_CONFIG );
+#if ROVER_TASK_INSTANCES_PROFILER > 0
+ROVER_TASK_STORAGE( roverTaskProfiler, CONFIG_ROVER_TASK_PROFILER_STACK_SIZE, ROVER_TASK_INSTANCES_PROFILER );
+#endif
+
+// Kconfig defaults, core and priority overridden by "task.*" NVS blobs: { int8 core (-1 - any), uint8 priority,
+// uint16 stack size (ignored, stacks are reserved at build time) }; POST /config writes them
+static t_rover_task_config roverTasks[ROVER_TASK_COUNT] = {
+	[ROVER_TASK_CAMERA] = { .name = "rover_camera_task",
+		.nvsKey = "task.camera",
+		.stackSize = CONFIG_ROVER_TASK_CAMERA_STACK_SIZE,
+		.priority = CONFIG_ROVER_TASK_CAMERA_PRIORITY,
+		.coreId = ROVER_TASK_CORE( CONFIG_ROVER_TASK_CAMERA_CORE ),
+		ROVER_TASK_SLOTS( roverTaskCamera, ROVER_TASK_INSTANCES_CAMERA ) },
+	[ROVER_TASK_COMM_CONTROL] = { .name = "rover_comm_control_task",
+		.nvsKey = "task.control",
+		.stackSize = CONFIG_ROVER_TASK_COMM_CONTROL_STACK_SIZE,
+		.priority = CONFIG_ROVER_TASK_COMM_CONTROL_PRIORITY,
+		.coreId = ROVER_TASK_CORE( CONFIG_ROVER_TASK_COMM_CONTROL_CORE ),
+		ROVER_TASK_SLOTS( roverTaskControl, ROVER_TASK_INSTANCES_COMM_CONTROL ) },
+	[ROVER_TASK_COMM_STREAM] = { .name = "rover_comm_stream_task",
+		.nvsKey = "task.stream",
+		.stackSize = CONFIG_ROVER_TASK_COMM_STREAM_STACK_SIZE,
+		.priority = CONFIG_ROVER_TASK_COMM_STREAM_PRIORITY,
+		.coreId = ROVER_TASK_CORE( CONFIG_ROVER_TASK_COMM_STREAM_CORE ),
+		ROVER_TASK_SLOTS( roverTaskStream, ROVER_TASK_INSTANCES_COMM_STREAM ) },
+	[ROVER_TASK_DISCOVERY] = { .name = "rover_discovery_task",
+		.nvsKey = "task.discovery",
+		.stackSize = CONFIG_ROVER_TASK_DISCOVERY_STACK_SIZE,
+		.priority = CONFIG_ROVER_TASK_DISCOVERY_PRIORITY,
+		.coreId = ROVER_TASK_CORE( CONFIG_ROVER_TASK_DISCOVERY_CORE ),
+		ROVER_TASK_SLOTS( roverTaskDiscovery, ROVER_TASK_INSTANCES_DISCOVERY ) },
+	[ROVER_TASK_BENCH] = { .name = "rover_bench_task",
+		.nvsKey = "task.bench",
+		.stackSize = CONFIG_ROVER_TASK_BENCH_STACK_SIZE,
+		.priority = CONFIG_ROVER_TASK_BENCH_PRIORITY,
+		.coreId = ROVER_TASK_CORE( CONFIG_ROVER_TASK_BENCH_CORE ),
+#if ROVER_TASK_INSTANCES_BENCH > 0
+		ROVER_TASK_SLOTS( roverTaskBench, ROVER_TASK_INSTANCES_BENCH )
+#endif
+	},
+	[ROVER_TASK_RECORDER] = { .name = "rover_recorder_task",
+		.nvsKey = "task.recorder",
+		.stackSize = CONFIG_ROVER_TASK_RECORDER_STACK_SIZE,
+		.priority = CONFIG_ROVER_TASK_RECORDER_PRIORITY,
+		.coreId = ROVER_TASK_CORE( CONFIG_ROVER_TASK_RECORDER_CORE ),
+#if ROVER_TASK_INSTANCES_RECORDER > 0
+		ROVER_TASK_SLOTS( roverTaskRecorder, ROVER_TASK_INSTANCES_RECORDER )
+#endif
+	},
+	[ROVER_TASK_ENCODER] = { .name = "rover_encoder_task",
+		.nvsKey = "task.encoder",
+		.stackSize = CONFIG_ROVER_TASK_ENCODER_STACK_SIZE,
+		.priority = CONFIG_ROVER_TASK_ENCODER_PRIORITY,
+		.coreId = ROVER_TASK_CORE( CONFIG_ROVER_TASK_ENCODER_CORE ),
+#if ROVER_TASK_INSTANCES_ENCODER > 0
+		ROVER_TASK_SLOTS( roverTaskEncoder, ROVER_TASK_INSTANCES_ENCODER )
+#endif
+	},
+	[ROVER_TASK_PIPELINE] = { .name = "rover_pipeline_task",
+		.nvsKey = "task.pipeline",
+		.stackSize = CONFIG_ROVER_TASK_PIPELINE_STACK_SIZE,
+		.priority = CONFIG_ROVER_TASK_PIPELINE_PRIORITY,
+		.coreId = ROVER_TASK_CORE( CONFIG_ROVER_TASK_PIPELINE_CORE ),
+		ROVER_TASK_SLOTS( roverTaskPipeline, ROVER_TASK_INSTANCES_PIPELINE ) },
+	[ROVER_TASK_TRACKER] = { .name = "rover_tracker_task",
+		.nvsKey = "task.tracker",
+		.stackSize = CONFIG_ROVER_TASK_TRACKER_STACK_SIZE,
+		.priority = CONFIG_ROVER_TASK_TRACKER_PRIORITY,
+		.coreId = ROVER_TASK_CORE( CONFIG_ROVER_TASK_TRACKER_CORE ),
+#if ROVER_TASK_INSTANCES_TRACKER > 0
+		ROVER_TASK_SLOTS( roverTaskTracker, ROVER_TASK_INSTANCES_TRACKER )
+#endif
+	},
+	[ROVER_TASK_LOG] = { .name = "rover_log_task",
+		.nvsKey = "task.log",
+		.stackSize = CONFIG_ROVER_TASK_LOG_STACK_SIZE,
+		.priority = CONFIG_ROVER_TASK_LOG_PRIORITY,
+		.coreId = ROVER_TASK_CORE( CONFIG_ROVER_TASK_LOG_CORE ),
+#if ROVER_TASK_INSTANCES_LOG > 0
+		ROVER_TASK_SLOTS( roverTaskLog, ROVER_TASK_INSTANCES_LOG )
+#endif
+	},
+	[ROVER_TASK_CONFIG] = { .name = "rover_config_task",
+		.nvsKey = "task.config",
+		.stackSize = CONFIG_ROVER_TASK_CONFIG_STACK_SIZE,
+		.priority = CONFIG_ROVER_TASK_CONFIG_PRIORITY,
+		.coreId = ROVER_TASK_CORE( CONFIG_ROVER_TASK_CONFIG_CORE ),
+		ROVER_TASK_SLOTS( roverTaskConfig, ROVER_TASK_INSTANCES_CONFIG ) },
+	[ROVER_TASK_PROFILER] = { .name = "rover_profiler_task",
+		.nvsKey = "task.profiler",
+		.stackSize = CONFIG_ROVER_TASK_PROFILER_STACK_SIZE,
+		.priority = CONFIG_ROVER_TASK_PROFILER_PRIORITY,
+		.coreId = ROVER_TASK_CORE( CONFIG_ROVER_TASK_PROFILER_CORE ),
+#if ROVER_TASK_INSTANCES_PROFILER > 0
+		ROVER_TASK_SLOTS( roverTaskProfiler, ROVER_TASK_INSTANCES_PROFILER )
+#endif
+	},
+};
+
+
+#if CONFIG_ROVER_TASK_STACK_REPORT_INTERVAL > 0
+static void rover_tasks_sample_stacks( void * arg )
+{
+	rover_tasks_log_stacks();
+}
+#endif
+
+
+void rover_tasks_init( void )
+{
+	for ( size_t i = 0; i < ROVER_TASK_COUNT; ++i ) {
+		t_rover_task_config * task = &roverTasks[i];
+		t_rover_config_task override;
+
+		if ( rover_load_config_task( task->nvsKey, &override ) ) {
+			if ( ROVER_TASK_IS_CORE_VALID( override.coreId ) ) {
+				task->coreId = ROVER_TASK_CORE( override.coreId );
+			}
+			else {
+				ESP_LOGW( roverLogTAG, "%s: core override %d ignored", task->name, (int)override.coreId );
+			}
+
+			if ( ROVER_TASK_IS_PRIORITY_VALID( override.priority ) ) {
+				task->priority = override.priority;
+			}
+
+			if ( override.stackSize > 0 && override.stackSize != task->stackSize ) {
+				ESP_LOGW( roverLogTAG, "%s: stack size override ignored, see Kconfig", task->name );
+			}
+		}
+
+		ESP_LOGI( roverLogTAG,
+			"%s: core %d, priority %u, stack %" PRIu32 " x %u",
+			task->name,
+			tskNO_AFFINITY == task->coreId ? -1 : (int)task->coreId,
+			(unsigned)task->priority,
+			task->stackSize,
+			(unsigned)task->instanceMax );
+	}
+
+#if CONFIG_ROVER_TASK_STACK_REPORT_INTERVAL > 0
+	esp_timer_handle_t timer;
+	esp_timer_create_args_t timerArgs = { .callback = rover_tasks_sample_stacks, .name = "task_stacks" };
+	ESP_ERROR_CHECK( esp_timer_create( &timerArgs, &timer ) );
+	ESP_ERROR_CHECK( esp_timer_start_periodic( timer, CONFIG_ROVER_TASK_STACK_REPORT_INTERVAL * 1000000LL ) );
+#endif
+}
+
+
+const t_rover_task_config * rover_task_get_config( t_rover_task_id id )
+{
+	return &roverTasks[id];
+}
+
+
+BaseType_t rover_task_create( t_rover_task_id id, TaskFunction_t func, void * parameters, TaskHandle_t * handle )
+{
+	return rover_task_create_named( id, roverTasks[id].name, func, parameters, handle );
+}
+
+
+BaseType_t rover_task_create_named(
+	t_rover_task_id id, const char * name, TaskFunction_t func, void * parameters, TaskHandle_t * handle )
+{
+	t_rover_task_config * task = &roverTasks[id];
+	uint8_t instance = __atomic_fetch_add( &task->instanceCount, 1, __ATOMIC_SEQ_CST );
+
+	if ( instance >= task->instanceMax ) {
+		ESP_LOGE( roverLogTAG, "Failed to create task %s, all %u slots taken", name, (unsigned)task->instanceMax );
+
+		return pdFAIL;
+	}
+
+	size_t stackDepth = task->stackSize / sizeof( StackType_t );
+	task->stackFreeMin[instance] = task->stackSize;
+	task->handles[instance] = xTaskCreateStaticPinnedToCore( func,
+		name,
+		task->stackSize,
+		parameters,
+		task->priority,
+		task->stacks + instance * stackDepth,
+		&task->tcbs[instance],
+		task->coreId );
+
+	if ( handle != NULL ) {
+		*handle = task->handles[instance];
+	}
+
+	if ( NULL == task->handles[instance] ) {
+		ESP_LOGE( roverLogTAG, "Failed to create task %s", name );
+
+		return pdFAIL;
+	}
+
+	return pdPASS;
+}
+
+
+// uxTaskGetStackHighWaterMark() is in bytes on ESP-IDF; tasks that have ended report their last sample
+void rover_tasks_log_stacks( void )
+{
+	for ( size_t i = 0; i < ROVER_TASK_COUNT; ++i ) {
+		t_rover_task_config * task = &roverTasks[i];
+		uint8_t count = MIN( task->instanceCount, task->instanceMax );
+
+		for ( size_t j = 0; j < count; ++j ) {
+			TaskHandle_t handle = task->handles[j];
+
+			if ( handle != NULL && eTaskGetState( handle ) != eDeleted ) {
+				task->stackFreeMin[j] = uxTaskGetStackHighWaterMark( handle );
+			}
+
+			ESP_LOGI( roverLogTAG,
+				"%s: stack %" PRIu32 ", used max %" PRIu32 ", free min %" PRIu32,
+				NULL == handle ? task->name : pcTaskGetName( handle ),
+				task->stackSize,
+				task->stackSize - task->stackFreeMin[j],
+				task->stackFreeMin[j] );
+		}
+	}
+}
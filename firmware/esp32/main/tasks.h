@@ -0,0 +1,79 @@
+/*
+ *	Copyright (c) 2025 Denis Rozhkov <denis@rozhkoff.com>
+ *	This file is part of cam-rover.
+ *
+ *	cam-rover is free software: you can redistribute it and/or
+ *	modify it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or (at your
+ *	option) any later version.
+ *
+ *	cam-rover is distributed in the hope that it will be
+ *	useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ *	Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along with
+ *	cam-rover. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef __ROVER__TASKS__H
+#define __ROVER__TASKS__H
+
+
+#include <stdint.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+
+// what a "task.*" NVS override may set, see rover_tasks_init()
+#define ROVER_TASK_IS_CORE_VALID( a_core ) ( ( a_core ) >= -1 && ( a_core ) < portNUM_PROCESSORS )
+#define ROVER_TASK_IS_PRIORITY_VALID( a_priority ) ( ( a_priority ) > 0 && ( a_priority ) < configMAX_PRIORITIES )
+
+
+typedef enum {
+	ROVER_TASK_CAMERA = 0,
+	ROVER_TASK_COMM_CONTROL,
+	ROVER_TASK_COMM_STREAM,
+	ROVER_TASK_DISCOVERY,
+	ROVER_TASK_BENCH,
+	ROVER_TASK_RECORDER,
+	ROVER_TASK_ENCODER,
+	ROVER_TASK_PIPELINE,
+	ROVER_TASK_TRACKER,
+	ROVER_TASK_LOG,
+	ROVER_TASK_CONFIG,
+	ROVER_TASK_PROFILER,
+	ROVER_TASK_COUNT
+} t_rover_task_id;
+
+typedef struct {
+	const char * name;
+	const char * nvsKey;
+	uint32_t stackSize;
+	UBaseType_t priority;
+	BaseType_t coreId;
+	// stacks and control blocks for this many tasks are reserved at build time, slots are not reused
+	uint8_t instanceMax;
+	uint8_t instanceCount;
+	StackType_t * stacks;
+	StaticTask_t * tcbs;
+	TaskHandle_t * handles;
+	// least free stack seen (bytes) per instance, see rover_tasks_log_stacks()
+	uint32_t * stackFreeMin;
+} t_rover_task_config;
+
+
+void rover_tasks_init( void );
+const t_rover_task_config * rover_task_get_config( t_rover_task_id id );
+BaseType_t rover_task_create( t_rover_task_id id, TaskFunction_t func, void * parameters, TaskHandle_t * handle );
+// as rover_task_create(), the task is named name instead of after the id
+BaseType_t rover_task_create_named(
+	t_rover_task_id id, const char * name, TaskFunction_t func, void * parameters, TaskHandle_t * handle );
+void rover_tasks_log_stacks( void );
+
+
+#endif
@@ -0,0 +1,263 @@
+/*
+ *	Copyright (c) 2025 Denis Rozhkov <denis@rozhkoff.com>
+ *	This file is part of cam-rover.
+ *
+ *	cam-rover is free software: you can redistribute it and/or
+ *	modify it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or (at your
+ *	option) any later version.
+ *
+ *	cam-rover is distributed in the hope that it will be
+ *	useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ *	Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along with
+ *	cam-rover. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <string.h>
+#include <stdlib.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "img_converters.h"
+
+#include "types.h"
+#include "tiles.h"
+
+
+#define ROVER_TILES_SIZE CONFIG_ROVER_CAMERA_TILE_SIZE
+
+
+static const char * roverLogTAG = "rover.tiles";
+
+// drops the two low bits of every RGB565 channel so that sensor noise does not mark tiles as changed,
+// byte order independent since the pattern repeats per byte pair
+static const uint8_t roverTilesMaskBytes[4] = { 0xe7, 0x9c, 0xe7, 0x9c };
+
+
+static size_t rover_tiles_jpeg_out( void * arg, size_t index, const void * data, size_t len )
+{
+	t_rover_tiles * tiles = (t_rover_tiles *)arg;
+
+	if ( NULL == data ) {
+		return 0;
+	}
+
+	if ( tiles->packetLen + len > ROVER_TILES_PACKET_SIZE_MAX ) {
+		// keep counting so the caller can tell the tile did not fit
+		tiles->packetLen += len;
+		return len;
+	}
+
+	memcpy( tiles->packet + tiles->packetLen, data, len );
+	tiles->packetLen += len;
+
+	return len;
+}
+
+
+#ifdef CONFIG_ROVER_BENCH_TILES
+static size_t rover_tiles_jpeg_count( void * arg, size_t index, const void * data, size_t len )
+{
+	*(size_t *)arg += len;
+
+	return len;
+}
+#endif
+
+
+// word-wise compare of a tile against the reference, copies the tile into the reference and the
+// contiguous encode buffer when it changed (or when forced)
+static bool rover_tiles_update(
+	t_rover_tiles * tiles, const uint16_t * frame, uint32_t x, uint32_t y, uint32_t w, uint32_t h, bool isForced )
+{
+	uint32_t mask;
+	memcpy( &mask, roverTilesMaskBytes, sizeof mask );
+
+	size_t changedCount = 0;
+
+	if ( !isForced ) {
+		for ( uint32_t row = y; row < y + h && changedCount <= CONFIG_ROVER_CAMERA_TILE_THRESHOLD; ++row ) {
+			const uint32_t * a = (const uint32_t *)( frame + row * tiles->width + x );
+			const uint32_t * b = (const uint32_t *)( tiles->reference + row * tiles->width + x );
+
+			for ( uint32_t i = 0; i < w / 2; ++i ) {
+				changedCount += ( ( a[i] ^ b[i] ) & mask ) != 0;
+			}
+		}
+
+		if ( changedCount <= CONFIG_ROVER_CAMERA_TILE_THRESHOLD ) {
+			return false;
+		}
+	}
+
+	uint16_t * tile = (uint16_t *)tiles->tile;
+
+	for ( uint32_t row = y; row < y + h; ++row ) {
+		const uint16_t * src = frame + row * tiles->width + x;
+		memcpy( tiles->reference + row * tiles->width + x, src, w * 2 );
+		memcpy( tile + ( row - y ) * w, src, w * 2 );
+	}
+
+	return true;
+}
+
+
+static void rover_tiles_send(
+	t_rover_tiles * tiles, uint32_t x, uint32_t y, uint32_t w, uint32_t h, int64_t timestampUs )
+{
+	t_rover_comm_stream_tile header = {
+		.frameNo = tiles->frameNo,
+		.x = x,
+		.y = y,
+		.width = w,
+		.height = h,
+		.frameWidth = tiles->width,
+		.frameHeight = tiles->height,
+	};
+
+	tiles->packetLen =
+		rover_comm_emit_stream_tile( tiles->packet, ROVER_TILES_PACKET_SIZE_MAX, timestampUs, &header );
+
+	int64_t startUs = esp_timer_get_time();
+
+	bool isEncoded = fmt2jpg_cb( tiles->tile,
+		w * h * 2,
+		w,
+		h,
+		PIXFORMAT_RGB565,
+		CONFIG_ROVER_CAMERA_TILE_QUALITY,
+		rover_tiles_jpeg_out,
+		tiles );
+
+	tiles->statEncodeUs += esp_timer_get_time() - startUs;
+
+	if ( !isEncoded || tiles->packetLen > ROVER_TILES_PACKET_SIZE_MAX ) {
+		ESP_LOGW( roverLogTAG, "tile %u,%u not sent", (unsigned)x, (unsigned)y );
+		return;
+	}
+
+	ROVER_CALL( tiles->sendHandler, tiles->sendContext, tiles->packet, tiles->packetLen );
+
+	tiles->statTileCount++;
+	tiles->statByteCount += tiles->packetLen;
+}
+
+
+static void rover_tiles_log( t_rover_tiles * tiles, const t_rover_camera_frame * frame )
+{
+	ESP_LOGI( roverLogTAG,
+		"%u frames: %u tiles/frame, %u bytes/frame, encode %u us/frame",
+		(unsigned)tiles->statFrameCount,
+		(unsigned)( tiles->statTileCount / tiles->statFrameCount ),
+		(unsigned)( tiles->statByteCount / tiles->statFrameCount ),
+		(unsigned)( tiles->statEncodeUs / tiles->statFrameCount ) );
+
+#ifdef CONFIG_ROVER_BENCH_TILES
+	// the same frame as a single software JPEG for comparison
+	size_t fullLen = 0;
+	int64_t startUs = esp_timer_get_time();
+
+	fmt2jpg_cb( frame->ptr,
+		frame->len,
+		frame->width,
+		frame->height,
+		PIXFORMAT_RGB565,
+		CONFIG_ROVER_CAMERA_TILE_QUALITY,
+		rover_tiles_jpeg_count,
+		&fullLen );
+
+	ESP_LOGI( roverLogTAG,
+		"full frame: %u bytes, encode %u us",
+		(unsigned)fullLen,
+		(unsigned)( esp_timer_get_time() - startUs ) );
+#endif
+
+	tiles->statFrameCount = 0;
+	tiles->statTileCount = 0;
+	tiles->statByteCount = 0;
+	tiles->statEncodeUs = 0;
+}
+
+
+bool rover_tiles_init( t_rover_tiles * tiles, t_rover_tiles_handler_send sendHandler, void * sendContext )
+{
+	size_t tileSize = ROVER_TILES_SIZE * ROVER_TILES_SIZE * 2;
+
+	tiles->tile = heap_caps_malloc( tileSize, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT );
+
+	if ( NULL == tiles->tile ) {
+		tiles->tile = heap_caps_malloc( tileSize, MALLOC_CAP_SPIRAM );
+	}
+
+	tiles->packet = heap_caps_malloc( ROVER_TILES_PACKET_SIZE_MAX, MALLOC_CAP_SPIRAM );
+
+	if ( NULL == tiles->tile || NULL == tiles->packet ) {
+		ESP_LOGE( roverLogTAG, "failed to allocate tile buffers" );
+
+		free( tiles->tile );
+		free( tiles->packet );
+		tiles->tile = NULL;
+		tiles->packet = NULL;
+
+		return false;
+	}
+
+	tiles->sendHandler = sendHandler;
+	tiles->sendContext = sendContext;
+
+	return true;
+}
+
+
+void rover_tiles_process( t_rover_tiles * tiles, const t_rover_camera_frame * frame )
+{
+	if ( NULL == tiles->packet || frame->len < frame->width * frame->height * 2 ) {
+		return;
+	}
+
+	if ( tiles->width != frame->width || tiles->height != frame->height ) {
+		free( tiles->reference );
+		tiles->reference = heap_caps_malloc( frame->width * frame->height * 2, MALLOC_CAP_SPIRAM );
+
+		if ( NULL == tiles->reference ) {
+			ESP_LOGE( roverLogTAG, "failed to allocate reference frame" );
+			tiles->width = 0;
+			tiles->height = 0;
+
+			return;
+		}
+
+		tiles->width = frame->width;
+		tiles->height = frame->height;
+		tiles->framesSinceRefresh = CONFIG_ROVER_CAMERA_TILE_REFRESH_FRAMES;
+	}
+
+	bool isRefresh = tiles->framesSinceRefresh >= CONFIG_ROVER_CAMERA_TILE_REFRESH_FRAMES;
+	tiles->framesSinceRefresh = isRefresh ? 0 : tiles->framesSinceRefresh + 1;
+	tiles->frameNo++;
+
+	const uint16_t * pixels = (const uint16_t *)frame->ptr;
+
+	for ( uint32_t y = 0; y < tiles->height; y += ROVER_TILES_SIZE ) {
+		uint32_t h = tiles->height - y < ROVER_TILES_SIZE ? tiles->height - y : ROVER_TILES_SIZE;
+
+		for ( uint32_t x = 0; x < tiles->width; x += ROVER_TILES_SIZE ) {
+			uint32_t w = tiles->width - x < ROVER_TILES_SIZE ? tiles->width - x : ROVER_TILES_SIZE;
+
+			if ( rover_tiles_update( tiles, pixels, x, y, w, h, isRefresh ) ) {
+				rover_tiles_send( tiles, x, y, w, h, frame->timestampUs );
+			}
+		}
+	}
+
+	if ( ++tiles->statFrameCount >= CONFIG_ROVER_CAMERA_TILE_LOG_FRAMES ) {
+		rover_tiles_log( tiles, frame );
+	}
+}
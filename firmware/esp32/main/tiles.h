@@ -0,0 +1,64 @@
+/*
+ *	Copyright (c) 2025 Denis Rozhkov <denis@rozhkoff.com>
+ *	This file is part of cam-rover.
+ *
+ *	cam-rover is free software: you can redistribute it and/or
+ *	modify it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or (at your
+ *	option) any later version.
+ *
+ *	cam-rover is distributed in the hope that it will be
+ *	useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ *	Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along with
+ *	cam-rover. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef __ROVER__TILES__H
+#define __ROVER__TILES__H
+
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "camera.h"
+#include "comm.h"
+
+
+// stream packet carrying one JPEG tile, t_rover_comm_stream_tile followed by the JPEG
+#define ROVER_TILES_PACKET_SIZE_MAX ( ( 1024 * 64 ) - 128 )
+
+
+typedef void ( *t_rover_tiles_handler_send )( void * context, uint8_t * data, size_t len );
+
+typedef struct {
+	uint32_t width;
+	uint32_t height;
+	uint16_t * reference;
+	uint8_t * tile;
+	uint8_t * packet;
+	size_t packetLen;
+	uint16_t frameNo;
+	uint32_t framesSinceRefresh;
+
+	t_rover_tiles_handler_send sendHandler;
+	void * sendContext;
+
+	uint32_t statFrameCount;
+	uint32_t statTileCount;
+	uint64_t statByteCount;
+	int64_t statEncodeUs;
+} t_rover_tiles;
+
+
+bool rover_tiles_init( t_rover_tiles * tiles, t_rover_tiles_handler_send sendHandler, void * sendContext );
+void rover_tiles_process( t_rover_tiles * tiles, const t_rover_camera_frame * frame );
+
+
+#endif
@@ -0,0 +1,200 @@
+/*
+ *	Copyright (c) 2025 Denis Rozhkov <denis@rozhkoff.com>
+ *	This file is part of cam-rover.
+ *
+ *	cam-rover is free software: you can redistribute it and/or
+ *	modify it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or (at your
+ *	option) any later version.
+ *
+ *	cam-rover is distributed in the hope that it will be
+ *	useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ *	Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along with
+ *	cam-rover. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <stdlib.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "img_converters.h"
+
+#include "tracker.h"
+#include "dlog.h"
+
+
+static const char * roverLogTAG = "rover.tracker";
+
+
+static void rover_tracker_set_speed( t_rover_tracker * tracker, int32_t speedL, int32_t speedR )
+{
+	t_rover_drive * drive = tracker->drive;
+	rover_drive_change_speed( drive, speedL - drive->motor1.speed, speedR - drive->motor2.speed );
+}
+
+
+// 1/8 scale RGB565 (big endian) to grayscale, rotated so that the ground in front of the rover is at
+// the bottom of the image; returns the upright width
+static uint32_t rover_tracker_to_gray( const uint8_t * rgb,
+	uint32_t width,
+	uint32_t height,
+	uint32_t pixelStride,
+	uint32_t rowStride,
+	uint8_t * gray )
+{
+	for ( uint32_t y = 0; y < height; ++y ) {
+		for ( uint32_t x = 0; x < width; ++x ) {
+			const uint8_t * p = rgb + y * rowStride + x * pixelStride;
+			uint32_t r = p[0] & 0xf8;
+			uint32_t g = ( ( p[0] & 0x07 ) << 5 ) | ( ( p[1] & 0xe0 ) >> 3 );
+			uint32_t b = ( p[1] & 0x1f ) << 3;
+			uint8_t v = ( 77 * r + 150 * g + 29 * b ) >> 8;
+
+#if CONFIG_ROVER_TRACKER_ROTATION == 90
+			gray[( width - 1 - x ) * height + y] = v;
+#elif CONFIG_ROVER_TRACKER_ROTATION == 180
+			gray[( height - 1 - y ) * width + ( width - 1 - x )] = v;
+#elif CONFIG_ROVER_TRACKER_ROTATION == 270
+			gray[x * height + ( height - 1 - y )] = v;
+#else
+			gray[y * width + x] = v;
+#endif
+		}
+	}
+
+	return 90 == CONFIG_ROVER_TRACKER_ROTATION || 270 == CONFIG_ROVER_TRACKER_ROTATION ? height : width;
+}
+
+
+static void rover_tracker_log( t_rover_tracker * tracker )
+{
+	t_rover_tracker_stats * stats = &tracker->stats;
+
+	ROVER_DLOGI( roverLogTAG,
+		"%u frames, line found %u; detect avg %u us, max %u us; capture to drive avg %u us, max %u us",
+		(unsigned)stats->frameCount,
+		(unsigned)stats->foundCount,
+		(unsigned)( stats->detectUs / stats->frameCount ),
+		(unsigned)stats->detectMaxUs,
+		(unsigned)( stats->loopUs / stats->frameCount ),
+		(unsigned)stats->loopMaxUs );
+
+	*stats = ( t_rover_tracker_stats ){ 0 };
+}
+
+
+bool rover_tracker_init( t_rover_tracker * tracker, t_rover_drive * drive )
+{
+	tracker->drive = drive;
+	tracker->detector.isDarkLine = IS_ENABLED( CONFIG_ROVER_TRACKER_DARK_LINE );
+	tracker->detector.markerWidth = CONFIG_ROVER_TRACKER_MARKER_WIDTH;
+
+	return true;
+}
+
+
+void rover_tracker_set_enabled( t_rover_tracker * tracker, bool isEnabled )
+{
+	if ( tracker->isEnabled == isEnabled ) {
+		return;
+	}
+
+	tracker->isEnabled = isEnabled;
+	tracker->lostCount = 0;
+	tracker->lastOffset = 0;
+
+	if ( !isEnabled ) {
+		rover_tracker_set_speed( tracker, 0, 0 );
+	}
+
+	ROVER_DLOGI( roverLogTAG, "autonomous mode %s", isEnabled ? "on" : "off" );
+}
+
+
+void rover_tracker_process( t_rover_tracker * tracker, const t_rover_camera_frame * frame )
+{
+	if ( !tracker->isEnabled ) {
+		return;
+	}
+
+	int64_t startUs = esp_timer_get_time();
+	uint32_t width = frame->width / 8;
+	uint32_t height = frame->height / 8;
+	size_t rgbSize = ( width + 1 ) * ( height + 1 ) * 2;
+
+	if ( rgbSize > tracker->rgbSize ) {
+		free( tracker->rgb );
+		free( tracker->gray );
+		tracker->rgb = heap_caps_malloc( rgbSize, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT );
+		tracker->gray = heap_caps_malloc( rgbSize / 2, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT );
+		tracker->rgbSize = NULL == tracker->rgb || NULL == tracker->gray ? 0 : rgbSize;
+	}
+
+	if ( 0 == tracker->rgbSize ) {
+		return;
+	}
+
+	uint32_t grayWidth;
+
+	if ( PIXFORMAT_JPEG == frame->format ) {
+		if ( !jpg2rgb565( frame->ptr, frame->len, tracker->rgb, JPG_SCALE_8X ) ) {
+			return;
+		}
+
+		grayWidth = rover_tracker_to_gray( tracker->rgb, width, height, 2, width * 2, tracker->gray );
+	}
+	else {
+		// raw RGB565, every 8th pixel of every 8th row
+		grayWidth = rover_tracker_to_gray( frame->ptr, width, height, 8 * 2, frame->width * 8 * 2, tracker->gray );
+	}
+
+	t_rover_linedet_result result;
+	rover_linedet_detect( &tracker->detector, tracker->gray, grayWidth, width * height / grayWidth, &result );
+
+	int64_t detectUs = esp_timer_get_time() - startUs;
+
+	if ( result.isMarker ) {
+		ROVER_DLOGI( roverLogTAG, "marker reached" );
+		rover_tracker_set_enabled( tracker, false );
+	}
+	else if ( !result.isFound ) {
+		if ( ++tracker->lostCount >= CONFIG_ROVER_TRACKER_LOST_FRAMES ) {
+			ESP_LOGW( roverLogTAG, "line lost" );
+			rover_tracker_set_enabled( tracker, false );
+		}
+	}
+	else {
+		// PD on the lateral offset, the heading term anticipates curves; gains are in hundredths of the
+		// base speed per full half-width offset
+		int32_t error = result.offset + result.heading / 2;
+		int32_t turn = CONFIG_ROVER_TRACKER_BASE_SPEED *
+			( CONFIG_ROVER_TRACKER_KP * error + CONFIG_ROVER_TRACKER_KD * ( error - tracker->lastOffset ) ) / ( 100 * 1000 );
+
+		tracker->lastOffset = error;
+		tracker->lostCount = 0;
+
+		rover_tracker_set_speed(
+			tracker, CONFIG_ROVER_TRACKER_BASE_SPEED + turn, CONFIG_ROVER_TRACKER_BASE_SPEED - turn );
+	}
+
+	int64_t loopUs = esp_timer_get_time() - frame->timestampUs;
+	t_rover_tracker_stats * stats = &tracker->stats;
+
+	stats->frameCount++;
+	stats->foundCount += result.isFound ? 1 : 0;
+	stats->detectUs += detectUs;
+	stats->detectMaxUs = detectUs > stats->detectMaxUs ? detectUs : stats->detectMaxUs;
+	stats->loopUs += loopUs;
+	stats->loopMaxUs = loopUs > stats->loopMaxUs ? loopUs : stats->loopMaxUs;
+
+	if ( stats->frameCount >= CONFIG_ROVER_TRACKER_LOG_FRAMES ) {
+		rover_tracker_log( tracker );
+	}
+}
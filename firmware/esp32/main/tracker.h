@@ -0,0 +1,61 @@
+/*
+ *	Copyright (c) 2025 Denis Rozhkov <denis@rozhkoff.com>
+ *	This file is part of cam-rover.
+ *
+ *	cam-rover is free software: you can redistribute it and/or
+ *	modify it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or (at your
+ *	option) any later version.
+ *
+ *	cam-rover is distributed in the hope that it will be
+ *	useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ *	Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along with
+ *	cam-rover. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef __ROVER__TRACKER__H
+#define __ROVER__TRACKER__H
+
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "drive.h"
+#include "linedet.h"
+#include "pipeline.h"
+
+
+typedef struct {
+	uint32_t frameCount;
+	uint32_t foundCount;
+	int64_t detectUs;
+	int64_t detectMaxUs;
+	int64_t loopUs;
+	int64_t loopMaxUs;
+} t_rover_tracker_stats;
+
+typedef struct {
+	t_rover_drive * drive;
+	volatile bool isEnabled;
+	t_rover_linedet_config detector;
+	uint8_t * rgb;
+	size_t rgbSize;
+	uint8_t * gray;
+	int32_t lastOffset;
+	uint32_t lostCount;
+	t_rover_tracker_stats stats;
+} t_rover_tracker;
+
+
+bool rover_tracker_init( t_rover_tracker * tracker, t_rover_drive * drive );
+void rover_tracker_set_enabled( t_rover_tracker * tracker, bool isEnabled );
+void rover_tracker_process( t_rover_tracker * tracker, const t_rover_camera_frame * frame );
+
+
+#endif
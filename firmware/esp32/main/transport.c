@@ -0,0 +1,102 @@
+/*
+ *	Copyright (c) 2025 Denis Rozhkov <denis@rozhkoff.com>
+ *	This file is part of cam-rover.
+ *
+ *	cam-rover is free software: you can redistribute it and/or
+ *	modify it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or (at your
+ *	option) any later version.
+ *
+ *	cam-rover is distributed in the hope that it will be
+ *	useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ *	Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along with
+ *	cam-rover. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <string.h>
+
+#include "esp_log.h"
+
+#include "transport.h"
+#include "dlog.h"
+
+
+static const char * roverLogTAG = "rover.transport";
+
+
+bool rover_transport_open( t_rover_transport * transport )
+{
+	transport->sync = xSemaphoreCreateMutexStatic( &transport->syncBuffer );
+
+	if ( !transport->ops->open( transport ) ) {
+		ESP_LOGE( roverLogTAG, "Failed to open %s transport", transport->name );
+		return false;
+	}
+
+	ESP_LOGI( roverLogTAG, "%s comm port: %d", transport->name, (int)transport->portNo );
+
+	return true;
+}
+
+
+int rover_transport_poll( t_rover_transport * transport, uint32_t timeoutMs )
+{
+	return transport->ops->poll( transport, timeoutMs );
+}
+
+
+int rover_transport_recv( t_rover_transport * transport, uint8_t * buffer, size_t size )
+{
+	return transport->ops->recv( transport, buffer, size );
+}
+
+
+bool rover_transport_send(
+	t_rover_transport * transport, const uint8_t * header, size_t headerLen, const uint8_t * data, size_t dataLen )
+{
+	if ( !transport->hasClient ) {
+		return false;
+	}
+
+	if ( headerLen + dataLen > transport->messageSizeMax ) {
+		ESP_LOGE( roverLogTAG, "invalid %s message size", transport->name );
+		return false;
+	}
+
+	xSemaphoreTake( transport->sync, portMAX_DELAY );
+	bool isSent = transport->ops->send( transport, header, headerLen, data, dataLen );
+	transport->sendCount++;
+	transport->sendErrorCount += isSent ? 0 : 1;
+	xSemaphoreGive( transport->sync );
+
+	return isSent;
+}
+
+
+void rover_transport_set_client( t_rover_transport * transport, const struct sockaddr * address, socklen_t addressLen )
+{
+	if ( addressLen > sizeof transport->clientAddress ) {
+		addressLen = sizeof transport->clientAddress;
+	}
+
+	if ( transport->hasClient && addressLen == transport->clientAddressLen &&
+		0 == memcmp( &transport->clientAddress, address, addressLen ) ) {
+		return;
+	}
+
+	xSemaphoreTake( transport->sync, portMAX_DELAY );
+	memset( &transport->clientAddress, 0, sizeof transport->clientAddress );
+	memcpy( &transport->clientAddress, address, addressLen );
+	transport->clientAddressLen = addressLen;
+	transport->hasClient = true;
+	transport->clientGeneration++;
+	xSemaphoreGive( transport->sync );
+
+	ROVER_DLOGI( roverLogTAG, "%s client address updated", transport->name );
+}
@@ -0,0 +1,97 @@
+/*
+ *	Copyright (c) 2025 Denis Rozhkov <denis@rozhkoff.com>
+ *	This file is part of cam-rover.
+ *
+ *	cam-rover is free software: you can redistribute it and/or
+ *	modify it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or (at your
+ *	option) any later version.
+ *
+ *	cam-rover is distributed in the hope that it will be
+ *	useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ *	Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along with
+ *	cam-rover. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef __ROVER__TRANSPORT__H
+#define __ROVER__TRANSPORT__H
+
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/message_buffer.h"
+
+#include "lwip/sockets.h"
+
+
+// IP TOS the Wi-Fi driver maps to WMM access categories: DSCP EF (voice) and AF41 (video)
+#define ROVER_TRANSPORT_TOS_VOICE 0xb8
+#define ROVER_TRANSPORT_TOS_VIDEO 0x88
+
+typedef struct t_rover_transport t_rover_transport;
+
+typedef struct {
+	// binds or listens, a zero port number picks a free port and is updated
+	bool ( *open )( t_rover_transport * transport );
+	// waits for a message, 1 - ready, 0 - timeout, -1 - error
+	int ( *poll )( t_rover_transport * transport, uint32_t timeoutMs );
+	// reads one message and makes its sender the client, returns the message length, 0 if there was nothing to
+	// read after all and -1 on error
+	int ( *recv )( t_rover_transport * transport, uint8_t * buffer, size_t size );
+	// sends header and data to the client as one message
+	bool ( *send )(
+		t_rover_transport * transport, const uint8_t * header, size_t headerLen, const uint8_t * data, size_t dataLen );
+} t_rover_transport_ops;
+
+struct t_rover_transport {
+	const t_rover_transport_ops * ops;
+	const char * name;
+	uint16_t portNo;
+	size_t messageSizeMax;
+	// IP TOS of outgoing packets, set before opening, 0 leaves the default
+	uint8_t tos;
+	StaticSemaphore_t syncBuffer;
+	SemaphoreHandle_t sync;
+	// client identity, replies go to where the last message came from, the generation changes with the client
+	struct sockaddr_storage clientAddress;
+	socklen_t clientAddressLen;
+	bool hasClient;
+	uint32_t clientGeneration;
+	// sends attempted and failed, read by the link manager
+	uint32_t sendCount;
+	uint32_t sendErrorCount;
+	// UDP and TCP
+	int socketFd;
+	int listenFd;
+	// loopback, messages sent on one end are received on the peer
+	t_rover_transport * peer;
+	MessageBufferHandle_t messages;
+	uint8_t * rxBuffer;
+	size_t rxLen;
+	uint8_t * txBuffer;
+};
+
+
+void rover_transport_udp_init( t_rover_transport * transport, uint16_t portNo );
+void rover_transport_tcp_init( t_rover_transport * transport, uint16_t portNo );
+void rover_transport_loopback_init( t_rover_transport * a, t_rover_transport * b, size_t messageSizeMax );
+
+bool rover_transport_open( t_rover_transport * transport );
+int rover_transport_poll( t_rover_transport * transport, uint32_t timeoutMs );
+int rover_transport_recv( t_rover_transport * transport, uint8_t * buffer, size_t size );
+bool rover_transport_send(
+	t_rover_transport * transport, const uint8_t * header, size_t headerLen, const uint8_t * data, size_t dataLen );
+void rover_transport_set_client( t_rover_transport * transport, const struct sockaddr * address, socklen_t addressLen );
+
+
+#endif
@@ -0,0 +1,122 @@
+/*
+ *	Copyright (c) 2025 Denis Rozhkov <denis@rozhkoff.com>
+ *	This file is part of cam-rover.
+ *
+ *	cam-rover is free software: you can redistribute it and/or
+ *	modify it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or (at your
+ *	option) any later version.
+ *
+ *	cam-rover is distributed in the hope that it will be
+ *	useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ *	Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along with
+ *	cam-rover. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <string.h>
+
+#include "esp_heap_caps.h"
+
+#include "transport.h"
+
+
+// messages each direction can hold before sends start failing, like a full socket buffer
+#define ROVER_TRANSPORT_LOOPBACK_DEPTH 4
+
+
+static bool rover_transport_loopback_open( t_rover_transport * transport )
+{
+	if ( transport->messages != NULL ) {
+		return true;
+	}
+
+	// each message in a message buffer carries its length
+	transport->messages =
+		xMessageBufferCreate( ( transport->messageSizeMax + sizeof( size_t ) ) * ROVER_TRANSPORT_LOOPBACK_DEPTH );
+	transport->rxBuffer = heap_caps_malloc( transport->messageSizeMax, MALLOC_CAP_DEFAULT );
+	transport->txBuffer = heap_caps_malloc( transport->messageSizeMax, MALLOC_CAP_DEFAULT );
+
+	return transport->messages != NULL && transport->rxBuffer != NULL && transport->txBuffer != NULL;
+}
+
+
+// the message is taken out of the message buffer here already, recv only copies it
+static int rover_transport_loopback_poll( t_rover_transport * transport, uint32_t timeoutMs )
+{
+	if ( 0 == transport->rxLen ) {
+		transport->rxLen = xMessageBufferReceive(
+			transport->messages, transport->rxBuffer, transport->messageSizeMax, pdMS_TO_TICKS( timeoutMs ) );
+	}
+
+	return transport->rxLen > 0 ? 1 : 0;
+}
+
+
+static int rover_transport_loopback_recv( t_rover_transport * transport, uint8_t * buffer, size_t size )
+{
+	if ( 0 == rover_transport_loopback_poll( transport, 0 ) ) {
+		return 0;
+	}
+
+	size_t len = transport->rxLen;
+	transport->rxLen = 0;
+
+	if ( len > size ) {
+		return -1;
+	}
+
+	memcpy( buffer, transport->rxBuffer, len );
+
+	return len;
+}
+
+
+static bool rover_transport_loopback_send(
+	t_rover_transport * transport, const uint8_t * header, size_t headerLen, const uint8_t * data, size_t dataLen )
+{
+	if ( NULL == transport->peer->messages ) {
+		return false;
+	}
+
+	if ( headerLen > 0 ) {
+		memcpy( transport->txBuffer, header, headerLen );
+	}
+
+	memcpy( transport->txBuffer + headerLen, data, dataLen );
+
+	return xMessageBufferSend( transport->peer->messages, transport->txBuffer, headerLen + dataLen, 0 ) > 0;
+}
+
+
+static const t_rover_transport_ops roverTransportLoopbackOps = {
+	.open = rover_transport_loopback_open,
+	.poll = rover_transport_loopback_poll,
+	.recv = rover_transport_loopback_recv,
+	.send = rover_transport_loopback_send,
+};
+
+
+// two connected ends, each one is the client of the other
+void rover_transport_loopback_init( t_rover_transport * a, t_rover_transport * b, size_t messageSizeMax )
+{
+	t_rover_transport * ends[2] = { a, b };
+
+	for ( size_t i = 0; i < 2; ++i ) {
+		t_rover_transport * transport = ends[i];
+		memset( transport, 0, sizeof *transport );
+		transport->ops = &roverTransportLoopbackOps;
+		transport->name = "loopback";
+		transport->messageSizeMax = messageSizeMax;
+		transport->hasClient = true;
+		transport->clientGeneration = 1;
+		transport->socketFd = -1;
+		transport->listenFd = -1;
+		transport->peer = ends[1 - i];
+	}
+}
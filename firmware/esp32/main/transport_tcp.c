@@ -0,0 +1,271 @@
+/*
+ *	Copyright (c) 2025 Denis Rozhkov <denis@rozhkoff.com>
+ *	This file is part of cam-rover.
+ *
+ *	cam-rover is free software: you can redistribute it and/or
+ *	modify it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or (at your
+ *	option) any later version.
+ *
+ *	cam-rover is distributed in the hope that it will be
+ *	useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ *	Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along with
+ *	cam-rover. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <string.h>
+
+#include "lwip/sockets.h"
+#include "lwip/sys.h"
+#include "lwip/netdb.h"
+
+#include "esp_log.h"
+
+#include "transport.h"
+#include "dlog.h"
+
+
+// every message is prefixed with its length (u32, little endian), TCP itself has no message boundaries
+#define ROVER_TRANSPORT_TCP_PREFIX_LEN 4
+#define ROVER_TRANSPORT_TCP_MESSAGE_SIZE_MAX ( 1024 * 256 )
+// a peer stalling in the middle of a message or not reading for this long is dropped
+#define ROVER_TRANSPORT_TCP_TIMEOUT_MS 1000
+
+
+static const char * roverLogTAG = "rover.transport-tcp";
+
+
+static bool rover_transport_tcp_open( t_rover_transport * transport )
+{
+	struct sockaddr_in addr = { 0 };
+	int listenFd = socket( PF_INET, SOCK_STREAM, IPPROTO_IP );
+
+	if ( listenFd < 0 ) {
+		ESP_LOGE( roverLogTAG, "Failed to create socket. Error %d", errno );
+		return false;
+	}
+
+	int opt = 1;
+	setsockopt( listenFd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof opt );
+
+	addr.sin_family = PF_INET;
+	addr.sin_port = htons( transport->portNo );
+	addr.sin_addr.s_addr = htonl( INADDR_ANY );
+
+	if ( bind( listenFd, (struct sockaddr *)&addr, sizeof addr ) < 0 ) {
+		ESP_LOGE( roverLogTAG, "Failed to bind socket. Error %d", errno );
+		goto _l_close;
+	}
+
+	if ( listen( listenFd, 1 ) < 0 ) {
+		ESP_LOGE( roverLogTAG, "Failed to listen. Error %d", errno );
+		goto _l_close;
+	}
+
+	socklen_t addrLen = sizeof addr;
+
+	if ( getsockname( listenFd, (struct sockaddr *)&addr, &addrLen ) < 0 ) {
+		ESP_LOGE( roverLogTAG, "Failed to get socket address. Error %d", errno );
+		goto _l_close;
+	}
+
+	transport->portNo = ntohs( addr.sin_port );
+	transport->listenFd = listenFd;
+
+	return true;
+
+_l_close:
+	close( listenFd );
+	return false;
+}
+
+
+static void rover_transport_tcp_close_client( t_rover_transport * transport )
+{
+	xSemaphoreTake( transport->sync, portMAX_DELAY );
+
+	if ( transport->socketFd >= 0 ) {
+		close( transport->socketFd );
+		transport->socketFd = -1;
+		transport->hasClient = false;
+	}
+
+	xSemaphoreGive( transport->sync );
+}
+
+
+// a new connection replaces the current client
+static void rover_transport_tcp_accept( t_rover_transport * transport )
+{
+	struct sockaddr_storage raddr = { 0 };
+	socklen_t socklen = sizeof raddr;
+	int socketFd = accept( transport->listenFd, (struct sockaddr *)&raddr, &socklen );
+
+	if ( socketFd < 0 ) {
+		ESP_LOGE( roverLogTAG, "accept failed: errno %d", errno );
+		return;
+	}
+
+	// small control messages and ACKs must not wait for Nagle to coalesce them
+	int opt = 1;
+	setsockopt( socketFd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof opt );
+
+	struct timeval tv = { .tv_sec = 0, .tv_usec = ROVER_TRANSPORT_TCP_TIMEOUT_MS * 1000 };
+	setsockopt( socketFd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof tv );
+	setsockopt( socketFd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof tv );
+
+	if ( transport->tos != 0 ) {
+		int tos = transport->tos;
+		setsockopt( socketFd, IPPROTO_IP, IP_TOS, &tos, sizeof tos );
+	}
+
+	rover_transport_tcp_close_client( transport );
+
+	xSemaphoreTake( transport->sync, portMAX_DELAY );
+	transport->socketFd = socketFd;
+	xSemaphoreGive( transport->sync );
+
+	rover_transport_set_client( transport, (struct sockaddr *)&raddr, socklen );
+}
+
+
+static int rover_transport_tcp_poll( t_rover_transport * transport, uint32_t timeoutMs )
+{
+	struct timeval tv = { .tv_sec = timeoutMs / 1000, .tv_usec = ( timeoutMs % 1000 ) * 1000 };
+	int socketFd = transport->socketFd;
+	int maxFd = socketFd > transport->listenFd ? socketFd : transport->listenFd;
+	fd_set rfds;
+	FD_ZERO( &rfds );
+	FD_SET( transport->listenFd, &rfds );
+
+	if ( socketFd >= 0 ) {
+		FD_SET( socketFd, &rfds );
+	}
+
+	int s = select( maxFd + 1, &rfds, NULL, NULL, &tv );
+
+	if ( s < 0 ) {
+		ESP_LOGE( roverLogTAG, "Select failed: errno %d", errno );
+		return -1;
+	}
+
+	if ( s > 0 && FD_ISSET( transport->listenFd, &rfds ) ) {
+		rover_transport_tcp_accept( transport );
+	}
+
+	return ( s > 0 && socketFd >= 0 && FD_ISSET( socketFd, &rfds ) ) ? 1 : 0;
+}
+
+
+static bool rover_transport_tcp_read( int socketFd, uint8_t * buffer, size_t len )
+{
+	while ( len > 0 ) {
+		int r = recv( socketFd, buffer, len, 0 );
+
+		if ( r <= 0 ) {
+			return false;
+		}
+
+		buffer += r;
+		len -= r;
+	}
+
+	return true;
+}
+
+
+static int rover_transport_tcp_recv( t_rover_transport * transport, uint8_t * buffer, size_t size )
+{
+	int socketFd = transport->socketFd;
+	uint8_t prefix[ROVER_TRANSPORT_TCP_PREFIX_LEN];
+
+	if ( socketFd < 0 ) {
+		return 0;
+	}
+
+	if ( !rover_transport_tcp_read( socketFd, prefix, sizeof prefix ) ) {
+		ROVER_DLOGI( roverLogTAG, "client disconnected" );
+		rover_transport_tcp_close_client( transport );
+		return 0;
+	}
+
+	size_t len = prefix[0] | ( prefix[1] << 8 ) | ( prefix[2] << 16 ) | ( (uint32_t)prefix[3] << 24 );
+
+	if ( len > size || !rover_transport_tcp_read( socketFd, buffer, len ) ) {
+		ESP_LOGE( roverLogTAG, "invalid message, len %u", (unsigned)len );
+		rover_transport_tcp_close_client( transport );
+		return -1;
+	}
+
+	return len;
+}
+
+
+static bool rover_transport_tcp_send(
+	t_rover_transport * transport, const uint8_t * header, size_t headerLen, const uint8_t * data, size_t dataLen )
+{
+	if ( transport->socketFd < 0 ) {
+		return false;
+	}
+
+	size_t len = headerLen + dataLen;
+	uint8_t prefix[ROVER_TRANSPORT_TCP_PREFIX_LEN] = { len & 0xff, ( len >> 8 ) & 0xff, ( len >> 16 ) & 0xff, len >> 24 };
+	struct iovec iov[3] = { { .iov_base = prefix, .iov_len = sizeof prefix },
+		{ .iov_base = (void *)header, .iov_len = headerLen },
+		{ .iov_base = (void *)data, .iov_len = dataLen } };
+	struct msghdr message = { .msg_iov = iov, .msg_iovlen = 3 };
+	size_t left = sizeof prefix + len;
+
+	while ( left > 0 ) {
+		int sent = sendmsg( transport->socketFd, &message, 0 );
+
+		if ( sent <= 0 ) {
+			// the receiving task notices the shut down connection and closes it
+			shutdown( transport->socketFd, SHUT_RDWR );
+			return false;
+		}
+
+		left -= sent;
+
+		while ( sent > 0 && message.msg_iovlen > 0 ) {
+			if ( (size_t)sent < message.msg_iov[0].iov_len ) {
+				message.msg_iov[0].iov_base = (uint8_t *)message.msg_iov[0].iov_base + sent;
+				message.msg_iov[0].iov_len -= sent;
+				sent = 0;
+			}
+			else {
+				sent -= message.msg_iov[0].iov_len;
+				message.msg_iov++;
+				message.msg_iovlen--;
+			}
+		}
+	}
+
+	return true;
+}
+
+
+static const t_rover_transport_ops roverTransportTcpOps = {
+	.open = rover_transport_tcp_open,
+	.poll = rover_transport_tcp_poll,
+	.recv = rover_transport_tcp_recv,
+	.send = rover_transport_tcp_send,
+};
+
+
+void rover_transport_tcp_init( t_rover_transport * transport, uint16_t portNo )
+{
+	memset( transport, 0, sizeof *transport );
+	transport->ops = &roverTransportTcpOps;
+	transport->name = "TCP";
+	transport->portNo = portNo;
+	transport->messageSizeMax = ROVER_TRANSPORT_TCP_MESSAGE_SIZE_MAX;
+	transport->socketFd = -1;
+	transport->listenFd = -1;
+}
@@ -0,0 +1,156 @@
+/*
+ *	Copyright (c) 2025 Denis Rozhkov <denis@rozhkoff.com>
+ *	This file is part of cam-rover.
+ *
+ *	cam-rover is free software: you can redistribute it and/or
+ *	modify it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or (at your
+ *	option) any later version.
+ *
+ *	cam-rover is distributed in the hope that it will be
+ *	useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ *	Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along with
+ *	cam-rover. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <string.h>
+
+#include "lwip/sockets.h"
+#include "lwip/sys.h"
+#include "lwip/netdb.h"
+
+#include "esp_log.h"
+
+#include "transport.h"
+
+
+#define ROVER_TRANSPORT_UDP_MESSAGE_SIZE_MAX ( ( 1024 * 64 ) - 128 )
+
+
+static const char * roverLogTAG = "rover.transport-udp";
+
+
+static bool rover_transport_udp_open( t_rover_transport * transport )
+{
+	struct sockaddr_in addr = { 0 };
+	int socketFd = -1;
+	int err = 0;
+
+	socketFd = socket( PF_INET, SOCK_DGRAM, IPPROTO_IP );
+
+	if ( socketFd < 0 ) {
+		ESP_LOGE( roverLogTAG, "Failed to create socket. Error %d", errno );
+		return false;
+	}
+
+	// Bind the socket to any address
+	addr.sin_family = PF_INET;
+	addr.sin_port = htons( transport->portNo );
+	addr.sin_addr.s_addr = htonl( INADDR_ANY );
+	err = bind( socketFd, (struct sockaddr *)&addr, sizeof( struct sockaddr_in ) );
+
+	if ( err < 0 ) {
+		ESP_LOGE( roverLogTAG, "Failed to bind socket. Error %d", errno );
+		goto _l_close;
+	}
+
+	socklen_t addrLen = sizeof addr;
+	err = getsockname( socketFd, (struct sockaddr *)&addr, &addrLen );
+
+	if ( err < 0 ) {
+		ESP_LOGE( roverLogTAG, "Failed to get socket address. Error %d", errno );
+		goto _l_close;
+	}
+
+	if ( transport->tos != 0 ) {
+		int tos = transport->tos;
+		setsockopt( socketFd, IPPROTO_IP, IP_TOS, &tos, sizeof tos );
+	}
+
+	transport->portNo = ntohs( addr.sin_port );
+	transport->socketFd = socketFd;
+
+	// All set, socket is configured for sending and receiving
+	return true;
+
+_l_close:
+	close( socketFd );
+	return false;
+}
+
+
+static int rover_transport_udp_poll( t_rover_transport * transport, uint32_t timeoutMs )
+{
+	struct timeval tv = { .tv_sec = timeoutMs / 1000, .tv_usec = ( timeoutMs % 1000 ) * 1000 };
+	fd_set rfds;
+	FD_ZERO( &rfds );
+	FD_SET( transport->socketFd, &rfds );
+
+	int s = select( transport->socketFd + 1, &rfds, NULL, NULL, &tv );
+
+	if ( s < 0 ) {
+		ESP_LOGE( roverLogTAG, "Select failed: errno %d", errno );
+		return -1;
+	}
+
+	return s > 0 ? 1 : 0;
+}
+
+
+static int rover_transport_udp_recv( t_rover_transport * transport, uint8_t * buffer, size_t size )
+{
+	struct sockaddr_storage raddr = { 0 }; // Large enough for both IPv4 or IPv6
+	socklen_t socklen = sizeof raddr;
+
+	int len = recvfrom( transport->socketFd, buffer, size, 0, (struct sockaddr *)&raddr, &socklen );
+
+	if ( len < 0 ) {
+		ESP_LOGE( roverLogTAG, "recvfrom failed: errno %d", errno );
+		return -1;
+	}
+
+	rover_transport_set_client( transport, (struct sockaddr *)&raddr, socklen );
+
+	return len;
+}
+
+
+// header and data go out as one datagram without copying them together
+static bool rover_transport_udp_send(
+	t_rover_transport * transport, const uint8_t * header, size_t headerLen, const uint8_t * data, size_t dataLen )
+{
+	struct iovec iov[2] = { { .iov_base = (void *)header, .iov_len = headerLen },
+		{ .iov_base = (void *)data, .iov_len = dataLen } };
+	struct msghdr message = { .msg_name = &transport->clientAddress,
+		.msg_namelen = transport->clientAddressLen,
+		.msg_iov = iov,
+		.msg_iovlen = 2 };
+
+	return sendmsg( transport->socketFd, &message, 0 ) >= 0;
+}
+
+
+static const t_rover_transport_ops roverTransportUdpOps = {
+	.open = rover_transport_udp_open,
+	.poll = rover_transport_udp_poll,
+	.recv = rover_transport_udp_recv,
+	.send = rover_transport_udp_send,
+};
+
+
+void rover_transport_udp_init( t_rover_transport * transport, uint16_t portNo )
+{
+	memset( transport, 0, sizeof *transport );
+	transport->ops = &roverTransportUdpOps;
+	transport->name = "UDP";
+	transport->portNo = portNo;
+	transport->messageSizeMax = ROVER_TRANSPORT_UDP_MESSAGE_SIZE_MAX;
+	transport->socketFd = -1;
+	transport->listenFd = -1;
+}
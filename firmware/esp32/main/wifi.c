@@ -28,6 +28,7 @@
 #include "esp_wifi.h"
 
 #include "globals.h"
+#include "link.h"
 #include "wifi.h"
 
 
@@ -36,6 +37,7 @@
 
 
 static EventGroupHandle_t roverWifiEventGroup;
+static StaticEventGroup_t roverWifiEventGroupBuffer;
 static int roverWifiStaRetryNum = 0;
 
 static const char * roverLogTAG = "rover.wifi";
@@ -96,6 +98,7 @@ void rover_wifi_init_softap( const char * macString )
 
 	ESP_ERROR_CHECK( esp_wifi_set_mode( WIFI_MODE_AP ) );
 	ESP_ERROR_CHECK( esp_wifi_set_config( ESP_IF_WIFI_AP, &wifiConfig ) );
+	rover_link_configure_radio( WIFI_IF_AP );
 	ESP_ERROR_CHECK( esp_wifi_start() );
 
 	esp_netif_ip_info_t ip_info;
@@ -112,7 +115,7 @@ void rover_wifi_init_softap( const char * macString )
 
 bool rover_wifi_init_sta( const char * ssid, const char * password )
 {
-	roverWifiEventGroup = xEventGroupCreate();
+	roverWifiEventGroup = xEventGroupCreateStatic( &roverWifiEventGroupBuffer );
 
 	wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
 	ESP_ERROR_CHECK( esp_wifi_init( &cfg ) );
@@ -138,6 +141,7 @@ bool rover_wifi_init_sta( const char * ssid, const char * password )
 
 	ESP_ERROR_CHECK( esp_wifi_set_mode( WIFI_MODE_STA ) );
 	ESP_ERROR_CHECK( esp_wifi_set_config( WIFI_IF_STA, &wifi_config ) );
+	rover_link_configure_radio( WIFI_IF_STA );
 	ESP_ERROR_CHECK( esp_wifi_start() );
 
 	ESP_LOGI( roverLogTAG, "wifi_init_sta finished." );
@@ -0,0 +1,287 @@
+/*
+ *	Copyright (c) 2025 Denis Rozhkov <denis@rozhkoff.com>
+ *	This file is part of cam-rover.
+ *
+ *	cam-rover is free software: you can redistribute it and/or
+ *	modify it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or (at your
+ *	option) any later version.
+ *
+ *	cam-rover is distributed in the hope that it will be
+ *	useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ *	Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along with
+ *	cam-rover. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+
+// writes synthetic JPEG frames through avi.c, checks the RIFF structure and index against what was written and
+// measures the muxing throughput into memory and into a file
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "avi.h"
+
+
+#define AVI_TEST_FRAMES 64
+#define AVI_TEST_BENCH_FRAMES 2000
+#define AVI_TEST_BENCH_FRAME_LEN ( 24 * 1024 + 1 )
+
+typedef struct {
+	uint8_t * data;
+	size_t len;
+	size_t capacity;
+} t_avi_test_buffer;
+
+static int aviTestFailures = 0;
+
+#define AVI_TEST_CHECK( a_cond )                                                                                       \
+	do {                                                                                                               \
+		if ( !( a_cond ) ) {                                                                                           \
+			fprintf( stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #a_cond );                               \
+			aviTestFailures++;                                                                                         \
+		}                                                                                                              \
+	} while ( 0 )
+
+
+static bool avi_test_buffer_write( void * ctx, const void * data, size_t len )
+{
+	t_avi_test_buffer * buffer = (t_avi_test_buffer *)ctx;
+
+	if ( buffer->len + len > buffer->capacity ) {
+		size_t capacity = ( buffer->len + len ) * 2;
+		uint8_t * p = realloc( buffer->data, capacity );
+
+		if ( NULL == p ) {
+			return false;
+		}
+
+		buffer->data = p;
+		buffer->capacity = capacity;
+	}
+
+	memcpy( buffer->data + buffer->len, data, len );
+	buffer->len += len;
+
+	return true;
+}
+
+
+static bool avi_test_buffer_patch( void * ctx, size_t offset, const void * data, size_t len )
+{
+	t_avi_test_buffer * buffer = (t_avi_test_buffer *)ctx;
+
+	if ( offset + len > buffer->len ) {
+		return false;
+	}
+
+	memcpy( buffer->data + offset, data, len );
+
+	return true;
+}
+
+
+static bool avi_test_file_write( void * ctx, const void * data, size_t len )
+{
+	return fwrite( data, 1, len, (FILE *)ctx ) == len;
+}
+
+
+static bool avi_test_file_patch( void * ctx, size_t offset, const void * data, size_t len )
+{
+	FILE * file = (FILE *)ctx;
+
+	return fseek( file, offset, SEEK_SET ) == 0 && fwrite( data, 1, len, file ) == len &&
+		fseek( file, 0, SEEK_END ) == 0;
+}
+
+
+static uint32_t avi_test_get_u32( const uint8_t * p )
+{
+	return p[0] | ( p[1] << 8 ) | ( p[2] << 16 ) | ( (uint32_t)p[3] << 24 );
+}
+
+
+static bool avi_test_is_fourcc( const uint8_t * p, const char * fourcc )
+{
+	return 0 == memcmp( p, fourcc, 4 );
+}
+
+
+// SOI, a payload and EOI; odd lengths exercise the chunk padding
+static size_t avi_test_make_frame( uint8_t * frame, size_t len, unsigned seed )
+{
+	frame[0] = 0xff;
+	frame[1] = 0xd8;
+
+	for ( size_t i = 2; i < len - 2; ++i ) {
+		frame[i] = (uint8_t)( seed * 31 + i * 7 );
+	}
+
+	frame[len - 2] = 0xff;
+	frame[len - 1] = 0xd9;
+
+	return len;
+}
+
+
+static double avi_test_now_s( void )
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+static void avi_test_structure( void )
+{
+	static uint8_t index[AVI_TEST_FRAMES * ROVER_AVI_INDEX_ENTRY_SIZE];
+	static uint8_t frames[AVI_TEST_FRAMES][4096];
+	size_t frameLens[AVI_TEST_FRAMES];
+
+	t_avi_test_buffer buffer = { 0 };
+	t_rover_avi_sink sink = { .ctx = &buffer, .write = avi_test_buffer_write, .patch = avi_test_buffer_patch };
+	t_rover_avi avi;
+
+	AVI_TEST_CHECK( rover_avi_open( &avi, &sink, 640, 480, index, AVI_TEST_FRAMES ) );
+
+	for ( size_t i = 0; i < AVI_TEST_FRAMES; ++i ) {
+		frameLens[i] = avi_test_make_frame( frames[i], 1000 + i * 37, i );
+		// 25 FPS
+		AVI_TEST_CHECK( rover_avi_add_frame( &avi, frames[i], frameLens[i], 1000000 + i * 40000 ) );
+	}
+
+	AVI_TEST_CHECK( rover_avi_is_full( &avi ) );
+	AVI_TEST_CHECK( !rover_avi_add_frame( &avi, frames[0], frameLens[0], 0 ) );
+	AVI_TEST_CHECK( rover_avi_close( &avi ) );
+
+	const uint8_t * f = buffer.data;
+
+	// RIFF 'AVI ' covers the whole file
+	AVI_TEST_CHECK( avi_test_is_fourcc( f, "RIFF" ) );
+	AVI_TEST_CHECK( avi_test_get_u32( f + 4 ) == buffer.len - 8 );
+	AVI_TEST_CHECK( avi_test_is_fourcc( f + 8, "AVI " ) );
+	AVI_TEST_CHECK( avi_test_is_fourcc( f + 12, "LIST" ) && avi_test_is_fourcc( f + 20, "hdrl" ) );
+
+	// hdrl ends where LIST 'movi' starts
+	size_t moviListOffset = 20 + avi_test_get_u32( f + 16 );
+	AVI_TEST_CHECK( ROVER_AVI_HEADER_SIZE - 12 == moviListOffset );
+
+	// avih: us per frame, frame count, size
+	AVI_TEST_CHECK( avi_test_is_fourcc( f + 24, "avih" ) );
+	AVI_TEST_CHECK( avi_test_get_u32( f + 32 ) == 40000 );
+	AVI_TEST_CHECK( avi_test_get_u32( f + 32 + 16 ) == AVI_TEST_FRAMES );
+	AVI_TEST_CHECK( avi_test_get_u32( f + 32 + 32 ) == 640 && avi_test_get_u32( f + 32 + 36 ) == 480 );
+	AVI_TEST_CHECK( avi_test_is_fourcc( f + 108, "vids" ) && avi_test_is_fourcc( f + 112, "MJPG" ) );
+
+	const uint8_t * moviList = f + moviListOffset;
+	uint32_t moviListLen = avi_test_get_u32( moviList + 4 );
+	AVI_TEST_CHECK( avi_test_is_fourcc( moviList, "LIST" ) && avi_test_is_fourcc( moviList + 8, "movi" ) );
+
+	// idx1 right after the movi list, one entry per frame
+	size_t idx1Offset = moviListOffset + 8 + moviListLen;
+	AVI_TEST_CHECK( idx1Offset + 8 <= buffer.len );
+
+	if ( aviTestFailures > 0 || idx1Offset + 8 > buffer.len ) {
+		free( buffer.data );
+		return;
+	}
+
+	const uint8_t * idx1 = f + idx1Offset;
+	AVI_TEST_CHECK( avi_test_is_fourcc( idx1, "idx1" ) );
+	AVI_TEST_CHECK( avi_test_get_u32( idx1 + 4 ) == AVI_TEST_FRAMES * ROVER_AVI_INDEX_ENTRY_SIZE );
+	AVI_TEST_CHECK( idx1Offset + 8 + AVI_TEST_FRAMES * ROVER_AVI_INDEX_ENTRY_SIZE == buffer.len );
+
+	// chunks follow each other, every index entry points at its chunk (offsets relative to the 'movi' fourcc)
+	size_t chunkOffset = moviListOffset + 12;
+
+	for ( size_t i = 0; i < AVI_TEST_FRAMES; ++i ) {
+		const uint8_t * entry = idx1 + 8 + i * ROVER_AVI_INDEX_ENTRY_SIZE;
+		const uint8_t * chunk = f + chunkOffset;
+
+		AVI_TEST_CHECK( avi_test_is_fourcc( entry, "00dc" ) );
+		AVI_TEST_CHECK( moviListOffset + 8 + avi_test_get_u32( entry + 8 ) == chunkOffset );
+		AVI_TEST_CHECK( avi_test_get_u32( entry + 12 ) == frameLens[i] );
+		AVI_TEST_CHECK( avi_test_is_fourcc( chunk, "00dc" ) );
+		AVI_TEST_CHECK( avi_test_get_u32( chunk + 4 ) == frameLens[i] );
+		AVI_TEST_CHECK( 0 == memcmp( chunk + 8, frames[i], frameLens[i] ) );
+
+		chunkOffset += ROVER_AVI_CHUNK_SIZE( frameLens[i] );
+	}
+
+	AVI_TEST_CHECK( chunkOffset == idx1Offset );
+
+	printf( "avi structure: %u frames, %zu bytes, %s\n",
+		(unsigned)AVI_TEST_FRAMES,
+		buffer.len,
+		aviTestFailures > 0 ? "FAILED" : "ok" );
+
+	free( buffer.data );
+}
+
+
+static void avi_test_bench( const char * name, const t_rover_avi_sink * sink, size_t * bytesOut )
+{
+	static uint8_t index[AVI_TEST_BENCH_FRAMES * ROVER_AVI_INDEX_ENTRY_SIZE];
+	static uint8_t frame[AVI_TEST_BENCH_FRAME_LEN];
+	avi_test_make_frame( frame, sizeof frame, 1 );
+
+	t_rover_avi avi;
+	double startS = avi_test_now_s();
+
+	AVI_TEST_CHECK( rover_avi_open( &avi, sink, 640, 480, index, AVI_TEST_BENCH_FRAMES ) );
+
+	for ( size_t i = 0; i < AVI_TEST_BENCH_FRAMES; ++i ) {
+		AVI_TEST_CHECK( rover_avi_add_frame( &avi, frame, sizeof frame, i * 40000 ) );
+	}
+
+	AVI_TEST_CHECK( rover_avi_close( &avi ) );
+
+	double elapsedS = avi_test_now_s() - startS;
+	double bytes = ROVER_AVI_HEADER_SIZE + avi.moviLen + 8 + AVI_TEST_BENCH_FRAMES * ROVER_AVI_INDEX_ENTRY_SIZE;
+
+	printf( "avi throughput (%s): %u frames of %u bytes, %.1f MB/s\n",
+		name,
+		(unsigned)AVI_TEST_BENCH_FRAMES,
+		(unsigned)AVI_TEST_BENCH_FRAME_LEN,
+		elapsedS > 0 ? bytes / elapsedS / 1e6 : 0.0 );
+
+	if ( bytesOut != NULL ) {
+		*bytesOut = (size_t)bytes;
+	}
+}
+
+
+int main( void )
+{
+	avi_test_structure();
+
+	t_avi_test_buffer buffer = { 0 };
+	t_rover_avi_sink memorySink = { .ctx = &buffer, .write = avi_test_buffer_write, .patch = avi_test_buffer_patch };
+	size_t bytes = 0;
+	avi_test_bench( "memory", &memorySink, &bytes );
+	AVI_TEST_CHECK( buffer.len == bytes );
+	free( buffer.data );
+
+	// the recorder batches chunks into cluster-sized blocks, stdio buffering plays that part here; the page cache
+	// absorbs the writes, so this is the muxing cost rather than the card's
+	FILE * file = tmpfile();
+
+	if ( file != NULL ) {
+		t_rover_avi_sink fileSink = { .ctx = file, .write = avi_test_file_write, .patch = avi_test_file_patch };
+		avi_test_bench( "file", &fileSink, &bytes );
+		AVI_TEST_CHECK( ftell( file ) == (long)bytes );
+		fclose( file );
+	}
+
+	return aviTestFailures > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
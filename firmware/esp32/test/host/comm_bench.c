@@ -0,0 +1,282 @@
+/*
+ *	Copyright (c) 2025 Denis Rozhkov <denis@rozhkoff.com>
+ *	This file is part of cam-rover.
+ *
+ *	cam-rover is free software: you can redistribute it and/or
+ *	modify it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or (at your
+ *	option) any later version.
+ *
+ *	cam-rover is distributed in the hope that it will be
+ *	useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ *	Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along with
+ *	cam-rover. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+
+
+
+// runs the control protocol (comm.c, comm_protocol.c) without sockets: first parse, dispatch and ACK in one thread,
+// then a round trip between two threads over an in-memory loopback, the host counterpart of the loopback transport
+// the firmware ACK benchmark uses; the difference between the two is the handoff cost
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "comm.h"
+
+
+#define COMM_BENCH_MESSAGES 200000
+#define COMM_BENCH_ROUND_TRIPS 20000
+#define COMM_BENCH_MESSAGE_SIZE_MAX 32
+// messages one direction holds, same as the firmware loopback
+#define COMM_BENCH_LOOPBACK_DEPTH 4
+
+static int commBenchFailures = 0;
+
+#define COMM_BENCH_CHECK( a_cond )                                                                                     \
+	do {                                                                                                               \
+		if ( !( a_cond ) ) {                                                                                           \
+			fprintf( stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #a_cond );                               \
+			commBenchFailures++;                                                                                       \
+		}                                                                                                              \
+	} while ( 0 )
+
+
+// one direction of the loopback
+typedef struct {
+	pthread_mutex_t lock;
+	pthread_cond_t changed;
+	uint8_t messages[COMM_BENCH_LOOPBACK_DEPTH][COMM_BENCH_MESSAGE_SIZE_MAX];
+	size_t lens[COMM_BENCH_LOOPBACK_DEPTH];
+	size_t head;
+	size_t count;
+} t_comm_bench_queue;
+
+typedef struct {
+	t_comm_bench_queue toRover;
+	t_comm_bench_queue toClient;
+	t_rover_comm_handlers handlers;
+	size_t roundTrips;
+} t_comm_bench_loopback;
+
+
+static double comm_bench_now_s( void )
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+static t_rover_motors_speed comm_bench_move_set( int32_t speedL, int32_t speedR )
+{
+	t_rover_motors_speed speed = { .motor1 = speedL, .motor2 = speedR };
+
+	return speed;
+}
+
+
+static void comm_bench_queue_init( t_comm_bench_queue * queue )
+{
+	pthread_mutex_init( &queue->lock, NULL );
+	pthread_cond_init( &queue->changed, NULL );
+	queue->head = 0;
+	queue->count = 0;
+}
+
+
+static void comm_bench_queue_free( t_comm_bench_queue * queue )
+{
+	pthread_cond_destroy( &queue->changed );
+	pthread_mutex_destroy( &queue->lock );
+}
+
+
+// blocks while the queue is full, like a message buffer send with portMAX_DELAY
+static void comm_bench_queue_send( t_comm_bench_queue * queue, const uint8_t * message, size_t len )
+{
+	pthread_mutex_lock( &queue->lock );
+
+	while ( COMM_BENCH_LOOPBACK_DEPTH == queue->count ) {
+		pthread_cond_wait( &queue->changed, &queue->lock );
+	}
+
+	size_t slot = ( queue->head + queue->count ) % COMM_BENCH_LOOPBACK_DEPTH;
+	memcpy( queue->messages[slot], message, len );
+	queue->lens[slot] = len;
+	queue->count++;
+
+	pthread_cond_broadcast( &queue->changed );
+	pthread_mutex_unlock( &queue->lock );
+}
+
+
+static size_t comm_bench_queue_recv( t_comm_bench_queue * queue, uint8_t * buffer )
+{
+	pthread_mutex_lock( &queue->lock );
+
+	while ( 0 == queue->count ) {
+		pthread_cond_wait( &queue->changed, &queue->lock );
+	}
+
+	size_t len = queue->lens[queue->head];
+	memcpy( buffer, queue->messages[queue->head], len );
+	queue->head = ( queue->head + 1 ) % COMM_BENCH_LOOPBACK_DEPTH;
+	queue->count--;
+
+	pthread_cond_broadcast( &queue->changed );
+	pthread_mutex_unlock( &queue->lock );
+
+	return len;
+}
+
+
+// the endpoint side: every message is answered, a zero length message ends the loop
+static void * comm_bench_rover_thread( void * parameters )
+{
+	t_comm_bench_loopback * loopback = (t_comm_bench_loopback *)parameters;
+	t_rover_motors_speed motorsSpeed = { 0 };
+	uint8_t message[COMM_BENCH_MESSAGE_SIZE_MAX];
+	uint8_t ack[ROVER_COMM_ACK_LEN];
+
+	while ( true ) {
+		size_t len = comm_bench_queue_recv( &loopback->toRover, message );
+
+		if ( 0 == len ) {
+			break;
+		}
+
+		uint32_t messageId = 0;
+
+		if ( rover_comm_handle_message( &loopback->handlers, &motorsSpeed, message, len, &messageId ) ) {
+			size_t ackLen = rover_comm_build_ack( ack, messageId, &motorsSpeed, 0, 0 );
+			comm_bench_queue_send( &loopback->toClient, ack, ackLen );
+		}
+	}
+
+	return NULL;
+}
+
+
+// message id and speeds of an ACK, false if it is not one
+static bool comm_bench_parse_ack( const uint8_t * data, size_t len, uint32_t * messageId, t_rover_comm_ack * ack )
+{
+	t_rover_comm_header header;
+
+	if ( !rover_comm_parse_header( data, len, &header ) || ROVER_COMM_COMMAND_ACK != header.command ) {
+		return false;
+	}
+
+	*messageId = header.id;
+
+	return rover_comm_parse_ack( data, len, ack );
+}
+
+
+static void comm_bench_codec( const t_rover_comm_handlers * handlers )
+{
+	t_rover_motors_speed motorsSpeed = { 0 };
+	uint8_t message[COMM_BENCH_MESSAGE_SIZE_MAX];
+	uint8_t ack[ROVER_COMM_ACK_LEN];
+	size_t ackCount = 0;
+
+	double startS = comm_bench_now_s();
+
+	for ( uint32_t i = 1; i <= COMM_BENCH_MESSAGES; ++i ) {
+		t_rover_comm_move_set moveSet = { .speedL = (int32_t)( i % 200 ) - 100, .speedR = 100 - (int32_t)( i % 200 ) };
+		size_t len = rover_comm_emit_move_set( message, sizeof message, i, &moveSet );
+		uint32_t messageId = 0;
+
+		if ( rover_comm_handle_message( handlers, &motorsSpeed, message, len, &messageId ) ) {
+			ackCount += rover_comm_build_ack( ack, messageId, &motorsSpeed, 0, 0 ) > 0;
+		}
+	}
+
+	double elapsedS = comm_bench_now_s() - startS;
+
+	COMM_BENCH_CHECK( COMM_BENCH_MESSAGES == ackCount );
+
+	uint32_t ackId = 0;
+	t_rover_comm_ack parsed;
+	COMM_BENCH_CHECK( comm_bench_parse_ack( ack, ROVER_COMM_ACK_LEN, &ackId, &parsed ) );
+	COMM_BENCH_CHECK( COMM_BENCH_MESSAGES == ackId );
+	COMM_BENCH_CHECK( parsed.motor1 == motorsSpeed.motor1 && parsed.motor2 == motorsSpeed.motor2 );
+
+	printf( "comm codec (move set, parse + dispatch + ACK): %.3f us/message\n",
+		elapsedS * 1e6 / COMM_BENCH_MESSAGES );
+}
+
+
+static void comm_bench_round_trip( const t_rover_comm_handlers * handlers )
+{
+	t_comm_bench_loopback loopback = { .handlers = *handlers };
+	comm_bench_queue_init( &loopback.toRover );
+	comm_bench_queue_init( &loopback.toClient );
+
+	pthread_t rover;
+
+	if ( 0 != pthread_create( &rover, NULL, &comm_bench_rover_thread, &loopback ) ) {
+		COMM_BENCH_CHECK( !"pthread_create" );
+		goto l_exit;
+	}
+
+	uint8_t message[COMM_BENCH_MESSAGE_SIZE_MAX];
+	size_t mismatchCount = 0;
+
+	double startS = comm_bench_now_s();
+
+	for ( uint32_t i = 1; i <= COMM_BENCH_ROUND_TRIPS; ++i ) {
+		t_rover_comm_move_set moveSet = { .speedL = (int32_t)i, .speedR = -(int32_t)i };
+		size_t len = rover_comm_emit_move_set( message, sizeof message, i, &moveSet );
+		comm_bench_queue_send( &loopback.toRover, message, len );
+
+		len = comm_bench_queue_recv( &loopback.toClient, message );
+
+		uint32_t ackId = 0;
+		t_rover_comm_ack ack;
+
+		if ( !comm_bench_parse_ack( message, len, &ackId, &ack ) || ackId != i || ack.motor1 != moveSet.speedL ||
+			ack.motor2 != moveSet.speedR ) {
+
+			mismatchCount++;
+		}
+	}
+
+	double elapsedS = comm_bench_now_s() - startS;
+
+	comm_bench_queue_send( &loopback.toRover, message, 0 );
+	pthread_join( rover, NULL );
+
+	COMM_BENCH_CHECK( 0 == mismatchCount );
+
+	printf( "comm loopback round trip (move set -> ACK): %.2f us, %.0f messages/s\n",
+		elapsedS * 1e6 / COMM_BENCH_ROUND_TRIPS,
+		COMM_BENCH_ROUND_TRIPS / elapsedS );
+
+l_exit:
+	comm_bench_queue_free( &loopback.toClient );
+	comm_bench_queue_free( &loopback.toRover );
+}
+
+
+int main( void )
+{
+	t_rover_comm_handlers handlers = { .move = { .set = &comm_bench_move_set } };
+
+	comm_bench_codec( &handlers );
+	comm_bench_round_trip( &handlers );
+
+	return commBenchFailures > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,299 @@
+/*
+ *	Copyright (c) 2025 Denis Rozhkov <denis@rozhkoff.com>
+ *	This file is part of cam-rover.
+ *
+ *	cam-rover is free software: you can redistribute it and/or
+ *	modify it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or (at your
+ *	option) any later version.
+ *
+ *	cam-rover is distributed in the hope that it will be
+ *	useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ *	Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along with
+ *	cam-rover. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+
+
+// encodes synthetic frames with jpeg.c, checks the marker structure and that independently encoded bands add up to
+// the single pass output, and measures the encode cost and size per frame
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "jpeg.h"
+
+
+#define JPEG_TEST_OUT_SIZE ( 1024 * 1024 )
+#define JPEG_TEST_BANDS_MAX 4
+#define JPEG_TEST_BENCH_FRAMES 50
+
+static int jpegTestFailures = 0;
+
+#define JPEG_TEST_CHECK( a_cond )                                                                                      \
+	do {                                                                                                               \
+		if ( !( a_cond ) ) {                                                                                           \
+			fprintf( stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #a_cond );                               \
+			jpegTestFailures++;                                                                                        \
+		}                                                                                                              \
+	} while ( 0 )
+
+
+static const char * jpeg_test_format_name( t_rover_jpeg_format format )
+{
+	return ROVER_JPEG_FORMAT_RGB565 == format ? "rgb565" : "gray";
+}
+
+
+static double jpeg_test_now_s( void )
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+// gradients with a box that moves with the seed and some texture, so that every block has AC content
+static uint8_t * jpeg_test_make_frame( t_rover_jpeg_format format, uint32_t width, uint32_t height, unsigned seed )
+{
+	size_t pixelSize = ROVER_JPEG_FORMAT_RGB565 == format ? 2 : 1;
+	uint8_t * pixels = malloc( width * height * pixelSize );
+
+	if ( NULL == pixels ) {
+		return NULL;
+	}
+
+	uint32_t boxX = ( seed * 7 ) % ( width / 2 );
+	uint32_t boxY = ( seed * 5 ) % ( height / 2 );
+
+	for ( uint32_t y = 0; y < height; ++y ) {
+		for ( uint32_t x = 0; x < width; ++x ) {
+			bool isBox = x >= boxX && x < boxX + width / 4 && y >= boxY && y < boxY + height / 4;
+			uint32_t r = isBox ? 240 : x * 255 / width;
+			uint32_t g = isBox ? 32 : y * 255 / height;
+			uint32_t b = ( ( x ^ y ) & 8 ) ? 200 : 60;
+			uint8_t * p = pixels + ( y * width + x ) * pixelSize;
+
+			if ( ROVER_JPEG_FORMAT_RGB565 == format ) {
+				uint16_t v = ( ( r & 0xf8 ) << 8 ) | ( ( g & 0xfc ) << 3 ) | ( b >> 3 );
+				p[0] = v >> 8;
+				p[1] = v & 0xff;
+			}
+			else {
+				p[0] = ( 77 * r + 150 * g + 29 * b ) >> 8;
+			}
+		}
+	}
+
+	return pixels;
+}
+
+
+// header, bands encoded one by one into buffers of their own as the encoder workers do, trailer
+static bool jpeg_test_encode(
+	const t_rover_jpeg * jpeg, const uint8_t * pixels, uint32_t bandCount, t_rover_buffer * out )
+{
+	static uint8_t bandData[JPEG_TEST_OUT_SIZE];
+	bool isOk = rover_jpeg_write_header( jpeg, out );
+
+	for ( uint32_t i = 0; i < bandCount && isOk; ++i ) {
+		t_rover_buffer band = { .data = bandData, .size = sizeof bandData };
+		uint32_t firstRow;
+		uint32_t rowCount;
+
+		rover_jpeg_band( jpeg, i, bandCount, &firstRow, &rowCount );
+		isOk = rover_jpeg_encode_rows( jpeg, pixels, firstRow, rowCount, &band ) && out->len + band.len <= out->size;
+
+		if ( isOk ) {
+			memcpy( out->data + out->len, band.data, band.len );
+			out->len += band.len;
+		}
+	}
+
+	return isOk && rover_jpeg_write_trailer( out );
+}
+
+
+static uint16_t jpeg_test_get_u16( const uint8_t * p )
+{
+	return ( p[0] << 8 ) | p[1];
+}
+
+
+// walks the marker segments up to SOS, then the entropy coded data: stuffed 0xff bytes and one RSTn per MCU row
+// boundary, in order, then EOI
+static void jpeg_test_check_structure( const t_rover_jpeg * jpeg, const uint8_t * data, size_t len )
+{
+	JPEG_TEST_CHECK( len > 4 && 0xffd8 == jpeg_test_get_u16( data ) && 0xffd9 == jpeg_test_get_u16( data + len - 2 ) );
+
+	size_t offset = 2;
+	bool isSof = false;
+	bool isDri = false;
+	bool isSos = false;
+
+	while ( offset + 4 <= len && !isSos ) {
+		uint16_t marker = jpeg_test_get_u16( data + offset );
+		uint16_t segmentLen = jpeg_test_get_u16( data + offset + 2 );
+		const uint8_t * segment = data + offset + 4;
+
+		if ( 0xffc0 == marker ) {
+			uint8_t componentCount = ROVER_JPEG_FORMAT_RGB565 == jpeg->format ? 3 : 1;
+
+			JPEG_TEST_CHECK( 8 == segment[0] );
+			JPEG_TEST_CHECK( jpeg_test_get_u16( segment + 1 ) == jpeg->height );
+			JPEG_TEST_CHECK( jpeg_test_get_u16( segment + 3 ) == jpeg->width );
+			JPEG_TEST_CHECK( segment[5] == componentCount );
+			isSof = true;
+		}
+		else if ( 0xffdd == marker ) {
+			JPEG_TEST_CHECK( jpeg_test_get_u16( segment ) == jpeg->mcuColumns );
+			isDri = true;
+		}
+		else if ( 0xffda == marker ) {
+			isSos = true;
+		}
+		else {
+			JPEG_TEST_CHECK( 0xffe0 == marker || 0xffdb == marker || 0xffc4 == marker );
+		}
+
+		offset += 2 + segmentLen;
+	}
+
+	JPEG_TEST_CHECK( isSof && isDri && isSos );
+
+	uint32_t restartCount = 0;
+
+	for ( ; offset + 2 < len; ++offset ) {
+		if ( data[offset] != 0xff ) {
+			continue;
+		}
+
+		uint8_t next = data[++offset];
+
+		if ( next != 0 ) {
+			JPEG_TEST_CHECK( 0xd0 + ( restartCount & 7 ) == next );
+			restartCount++;
+		}
+	}
+
+	JPEG_TEST_CHECK( offset + 2 == len );
+	JPEG_TEST_CHECK( restartCount + 1 == jpeg->mcuRows );
+}
+
+
+static void jpeg_test_structure( t_rover_jpeg_format format, uint32_t width, uint32_t height )
+{
+	static uint8_t single[JPEG_TEST_OUT_SIZE];
+	static uint8_t banded[JPEG_TEST_OUT_SIZE];
+
+	int failures = jpegTestFailures;
+	uint8_t * pixels = jpeg_test_make_frame( format, width, height, 3 );
+	t_rover_jpeg jpeg;
+
+	JPEG_TEST_CHECK( pixels != NULL );
+
+	if ( NULL == pixels ) {
+		return;
+	}
+
+	rover_jpeg_init( &jpeg, width, height, format, 60 );
+
+	t_rover_buffer out = { .data = single, .size = sizeof single };
+	JPEG_TEST_CHECK( jpeg_test_encode( &jpeg, pixels, 1, &out ) );
+	jpeg_test_check_structure( &jpeg, out.data, out.len );
+
+	// restart intervals make the bands independent, whatever the split the bytes are the same
+	for ( uint32_t bandCount = 2; bandCount <= JPEG_TEST_BANDS_MAX; ++bandCount ) {
+		t_rover_buffer bandedOut = { .data = banded, .size = sizeof banded };
+
+		JPEG_TEST_CHECK( jpeg_test_encode( &jpeg, pixels, bandCount, &bandedOut ) );
+		JPEG_TEST_CHECK( bandedOut.len == out.len && 0 == memcmp( bandedOut.data, out.data, out.len ) );
+	}
+
+	// running out of room is reported, not written past
+	uint8_t small[1024 + 1];
+	small[1024] = 0xa5;
+	t_rover_buffer smallOut = { .data = small, .size = 1024 };
+	JPEG_TEST_CHECK( !jpeg_test_encode( &jpeg, pixels, 1, &smallOut ) );
+	JPEG_TEST_CHECK( smallOut.len <= 1024 && 0xa5 == small[1024] );
+
+	printf( "jpeg structure (%s %ux%u): %zu bytes, %s\n",
+		jpeg_test_format_name( format ),
+		(unsigned)width,
+		(unsigned)height,
+		out.len,
+		jpegTestFailures > failures ? "FAILED" : "ok" );
+
+	free( pixels );
+}
+
+
+static void jpeg_test_bench( t_rover_jpeg_format format, uint32_t width, uint32_t height, uint8_t quality )
+{
+	static uint8_t data[JPEG_TEST_OUT_SIZE];
+	uint8_t * frames[JPEG_TEST_BENCH_FRAMES];
+	size_t bytes = 0;
+	t_rover_jpeg jpeg;
+
+	for ( size_t i = 0; i < JPEG_TEST_BENCH_FRAMES; ++i ) {
+		frames[i] = jpeg_test_make_frame( format, width, height, i );
+		JPEG_TEST_CHECK( frames[i] != NULL );
+
+		if ( NULL == frames[i] ) {
+			return;
+		}
+	}
+
+	double startS = jpeg_test_now_s();
+
+	for ( size_t i = 0; i < JPEG_TEST_BENCH_FRAMES; ++i ) {
+		t_rover_buffer out = { .data = data, .size = sizeof data };
+
+		rover_jpeg_init( &jpeg, width, height, format, quality );
+		JPEG_TEST_CHECK( jpeg_test_encode( &jpeg, frames[i], 1, &out ) );
+		bytes += out.len;
+	}
+
+	double elapsedS = jpeg_test_now_s() - startS;
+
+	printf( "jpeg encode (%s %ux%u q%u): %.2f ms/frame, %zu bytes/frame\n",
+		jpeg_test_format_name( format ),
+		(unsigned)width,
+		(unsigned)height,
+		(unsigned)quality,
+		elapsedS * 1000 / JPEG_TEST_BENCH_FRAMES,
+		bytes / JPEG_TEST_BENCH_FRAMES );
+
+	for ( size_t i = 0; i < JPEG_TEST_BENCH_FRAMES; ++i ) {
+		free( frames[i] );
+	}
+}
+
+
+int main( void )
+{
+	static const uint8_t qualities[] = { 30, 60, 90 };
+
+	// a size that is not a multiple of the MCU exercises the edge replication
+	jpeg_test_structure( ROVER_JPEG_FORMAT_GRAYSCALE, 320, 240 );
+	jpeg_test_structure( ROVER_JPEG_FORMAT_RGB565, 320, 240 );
+	jpeg_test_structure( ROVER_JPEG_FORMAT_RGB565, 100, 75 );
+
+	for ( size_t i = 0; i < sizeof qualities; ++i ) {
+		jpeg_test_bench( ROVER_JPEG_FORMAT_GRAYSCALE, 320, 240, qualities[i] );
+		jpeg_test_bench( ROVER_JPEG_FORMAT_RGB565, 320, 240, qualities[i] );
+	}
+
+	jpeg_test_bench( ROVER_JPEG_FORMAT_RGB565, 640, 480, 60 );
+
+	return jpegTestFailures > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
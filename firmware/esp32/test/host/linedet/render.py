@@ -0,0 +1,114 @@
+#!/usr/bin/env python3
+#
+#	Copyright (c) 2025 Denis Rozhkov <denis@rozhkoff.com>
+#	This file is part of cam-rover.
+#
+#	cam-rover is free software: you can redistribute it and/or
+#	modify it under the terms of the GNU General Public License as published by
+#	the Free Software Foundation, either version 3 of the License, or (at your
+#	option) any later version.
+#
+#	cam-rover is distributed in the hope that it will be
+#	useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+#	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+#	Public License for more details.
+#
+#	You should have received a copy of the GNU General Public License along with
+#	cam-rover. If not, see <https://www.gnu.org/licenses/>.
+#
+
+# SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>
+# SPDX-License-Identifier: GPL-3.0-or-later
+
+# Renders the frames in this directory and prints the offset labels for expected.txt; needs Pillow.
+#
+# A perspective view of a textured floor with 19 mm tape, lit unevenly, goes through a JPEG round trip at the
+# stream quality and the 8x DC scaling the tracker decodes with, so the detector sees what it would on the rover.
+
+import io
+import os
+import random
+
+from PIL import Image
+
+
+WIDTH = 640
+HEIGHT = 480
+# focal length (px), camera height (m), horizon row (above the image, the camera looks down), tape width (m)
+FOCAL = 500.0
+CAMERA_HEIGHT = 0.12
+HORIZON = -120
+TAPE = 0.019
+QUALITY = 60
+SCALE = 8
+
+
+def row_distance( v ):
+	return FOCAL * CAMERA_HEIGHT / ( v - HORIZON )
+
+
+def line_x( line, z ):
+	x0, k, c = line
+
+	return x0 + k * z + c * z * z
+
+
+# line: ( x0, slope, curvature ) of the tape centre over the floor distance z; band: z range of a crossing tape
+def render( name, line = None, band = None, isDark = True, falloff = 0.0, seed = 1 ):
+	rnd = random.Random( seed )
+	floor, tape = ( 175, 45 ) if isDark else ( 55, 215 )
+	noise = [ [ rnd.gauss( 0, 9 ) for _ in range( WIDTH // 4 + 1 ) ] for _ in range( HEIGHT // 4 + 1 ) ]
+	image = Image.new( 'L', ( WIDTH, HEIGHT ) )
+	pixels = image.load()
+
+	for v in range( HEIGHT ):
+		z = row_distance( v + 0.5 )
+
+		for u in range( WIDTH ):
+			x = ( u + 0.5 - WIDTH / 2 ) * z / FOCAL
+			isTape = line is not None and abs( x - line_x( line, z ) ) < TAPE / 2
+			isTape = isTape or ( band is not None and band[0] <= z <= band[1] )
+			light = ( 1.0 - falloff * u / WIDTH ) * ( 1.0 - 0.25 * min( z, 1.0 ) )
+			value = ( tape if isTape else floor ) * light + noise[v // 4][u // 4]
+			pixels[u, v] = max( 0, min( 255, int( value ) ) )
+
+	jpeg = io.BytesIO()
+	image.save( jpeg, 'JPEG', quality = QUALITY )
+	small = Image.open( io.BytesIO( jpeg.getvalue() ) ).convert( 'L' ).reduce( SCALE )
+
+	with open( os.path.join( os.path.dirname( os.path.abspath( __file__ ) ), name + '.pgm' ), 'wb' ) as f:
+		f.write( b'P5\n# rendered for linedet_test, see expected.txt\n%d %d\n255\n' % small.size )
+		f.write( small.tobytes() )
+
+	if line is None:
+		return None
+
+	# tape centre in the bottom scan row, permille of half the width
+	z = row_distance( HEIGHT - SCALE / 2 )
+	u = line_x( line, z ) * FOCAL / z + WIDTH / 2
+	half = WIDTH / SCALE / 2
+
+	return round( ( u / SCALE - half ) / half * 1000 )
+
+
+FRAMES = [
+	( 'straight_center', dict( line = ( 0.0, 0.0, 0.0 ) ) ),
+	( 'straight_left', dict( line = ( -0.05, 0.0, 0.0 ), seed = 2 ) ),
+	( 'straight_right', dict( line = ( 0.04, 0.0, 0.0 ), seed = 3 ) ),
+	( 'diagonal', dict( line = ( -0.02, 0.35, 0.0 ), seed = 4 ) ),
+	( 'curve_right', dict( line = ( 0.0, 0.0, 0.6 ), seed = 5 ) ),
+	( 'shadow', dict( line = ( 0.02, 0.0, 0.0 ), falloff = 0.55, seed = 6 ) ),
+	( 'marker_near', dict( line = ( 0.0, 0.0, 0.0 ), band = ( 0.09, 0.13 ), seed = 7 ) ),
+	( 'marker_far', dict( line = ( 0.0, 0.0, 0.0 ), band = ( 0.17, 0.21 ), seed = 8 ) ),
+	( 'no_line', dict( seed = 9 ) ),
+	( 'light_line', dict( line = ( -0.03, 0.0, 0.0 ), isDark = False, seed = 10 ) ),
+]
+
+
+def main():
+	for name, args in FRAMES:
+		print( name, render( name, **args ) )
+
+
+if __name__ == '__main__':
+	main()
@@ -0,0 +1,342 @@
+/*
+ *	Copyright (c) 2025 Denis Rozhkov <denis@rozhkoff.com>
+ *	This file is part of cam-rover.
+ *
+ *	cam-rover is free software: you can redistribute it and/or
+ *	modify it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or (at your
+ *	option) any later version.
+ *
+ *	cam-rover is distributed in the hope that it will be
+ *	useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ *	Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along with
+ *	cam-rover. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+
+
+// runs linedet.c over synthetic floor images and checks what it reports: line offset and heading, crossing
+// markers near the rover, nothing on a featureless floor; then over the frame sets given on the command line, see
+// linedet/expected.txt for the format
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "linedet.h"
+
+
+#define LINEDET_TEST_WIDTH 160
+#define LINEDET_TEST_HEIGHT 120
+#define LINEDET_TEST_LINE_WIDTH 8
+#define LINEDET_TEST_FLOOR 200
+#define LINEDET_TEST_LINE 40
+// frame sets are labelled by hand, permille of half the width
+#define LINEDET_TEST_OFFSET_TOLERANCE 100
+#define LINEDET_TEST_FRAME_SIZE_MAX ( 640 * 480 )
+
+static int linedetTestFailures = 0;
+static uint8_t linedetTestImage[LINEDET_TEST_HEIGHT][LINEDET_TEST_WIDTH];
+
+#define LINEDET_TEST_CHECK( a_cond )                                                                                   \
+	do {                                                                                                               \
+		if ( !( a_cond ) ) {                                                                                           \
+			fprintf( stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #a_cond );                               \
+			linedetTestFailures++;                                                                                     \
+		}                                                                                                              \
+	} while ( 0 )
+
+
+static void linedet_test_fill( uint8_t value )
+{
+	memset( linedetTestImage, value, sizeof linedetTestImage );
+}
+
+
+// a line starting at x0 in the bottom row that drifts right by one pixel every slope rows towards the top,
+// 0 keeps it vertical
+static void linedet_test_draw_line( int32_t x0, int32_t slope, uint8_t value )
+{
+	for ( int32_t y = 0; y < LINEDET_TEST_HEIGHT; ++y ) {
+		int32_t x = x0 + ( slope > 0 ? ( LINEDET_TEST_HEIGHT - 1 - y ) / slope : 0 );
+
+		for ( int32_t i = 0; i < LINEDET_TEST_LINE_WIDTH; ++i ) {
+			if ( x + i >= 0 && x + i < LINEDET_TEST_WIDTH ) {
+				linedetTestImage[y][x + i] = value;
+			}
+		}
+	}
+}
+
+
+static void linedet_test_draw_band( int32_t y0, int32_t y1, uint8_t value )
+{
+	for ( int32_t y = y0; y < y1; ++y ) {
+		memset( linedetTestImage[y], value, LINEDET_TEST_WIDTH );
+	}
+}
+
+
+// offset the detector reports for a vertical line starting at x0, permille of half the width
+static int32_t linedet_test_offset( int32_t x0 )
+{
+	return ( 2 * x0 + LINEDET_TEST_LINE_WIDTH - 1 - ( LINEDET_TEST_WIDTH - 1 ) ) * 1000 / LINEDET_TEST_WIDTH;
+}
+
+
+static void linedet_test_detect( const char * name,
+	const t_rover_linedet_config * config,
+	const uint8_t * gray,
+	uint32_t width,
+	uint32_t height,
+	t_rover_linedet_result * result )
+{
+	rover_linedet_detect( config, gray, width, height, result );
+
+	printf( "linedet %-12s found %d, marker %d, offset %5d, heading %5d, rows %u, threshold %u\n",
+		name,
+		result->isFound,
+		result->isMarker,
+		(int)result->offset,
+		(int)result->heading,
+		(unsigned)result->rowCount,
+		(unsigned)result->threshold );
+}
+
+
+static void linedet_test_run( const char * name, bool isDarkLine, t_rover_linedet_result * result )
+{
+	t_rover_linedet_config config = { .isDarkLine = isDarkLine, .markerWidth = 600 };
+
+	linedet_test_detect( name, &config, &linedetTestImage[0][0], LINEDET_TEST_WIDTH, LINEDET_TEST_HEIGHT, result );
+}
+
+
+// next PGM header number, # comments skipped
+static bool linedet_test_pgm_number( FILE * file, uint32_t * value )
+{
+	int c = fgetc( file );
+
+	while ( isspace( c ) || '#' == c ) {
+		if ( '#' == c ) {
+			while ( c != '\n' && c != EOF ) {
+				c = fgetc( file );
+			}
+		}
+
+		c = fgetc( file );
+	}
+
+	if ( !isdigit( c ) ) {
+		return false;
+	}
+
+	*value = 0;
+
+	while ( isdigit( c ) ) {
+		*value = *value * 10 + ( c - '0' );
+		c = fgetc( file );
+	}
+
+	// exactly one whitespace character separates the header from the pixels
+	return isspace( c );
+}
+
+
+// binary PGM (P5, 8 bit), or raw 8 bit gray of the given size when width and height are not 0
+static bool linedet_test_load( const char * path, uint8_t * gray, uint32_t * width, uint32_t * height )
+{
+	FILE * file = fopen( path, "rb" );
+	bool isOk = false;
+
+	if ( NULL == file ) {
+		fprintf( stderr, "%s: cannot open\n", path );
+		return false;
+	}
+
+	if ( 0 == *width || 0 == *height ) {
+		uint32_t maxValue = 0;
+
+		if ( fgetc( file ) != 'P' || fgetc( file ) != '5' || !linedet_test_pgm_number( file, width ) ||
+			!linedet_test_pgm_number( file, height ) || !linedet_test_pgm_number( file, &maxValue ) ||
+			maxValue > 255 ) {
+
+			fprintf( stderr, "%s: not an 8 bit binary PGM\n", path );
+			goto l_exit;
+		}
+	}
+
+	if ( 0 == *width || 0 == *height || (size_t)*width * *height > LINEDET_TEST_FRAME_SIZE_MAX ) {
+		fprintf( stderr, "%s: unsupported size %ux%u\n", path, (unsigned)*width, (unsigned)*height );
+		goto l_exit;
+	}
+
+	isOk = fread( gray, 1, (size_t)*width * *height, file ) == (size_t)*width * *height;
+
+	if ( !isOk ) {
+		fprintf( stderr, "%s: truncated\n", path );
+	}
+
+l_exit:
+	fclose( file );
+
+	return isOk;
+}
+
+
+// runs every frame listed in <dir>/expected.txt and compares the result with the labels there
+static void linedet_test_frame_set( const char * dir )
+{
+	static uint8_t gray[LINEDET_TEST_FRAME_SIZE_MAX];
+	char path[512];
+	char line[256];
+	int failures = linedetTestFailures;
+	size_t frameCount = 0;
+	t_rover_linedet_config config = { .isDarkLine = true, .markerWidth = 600 };
+
+	snprintf( path, sizeof path, "%s/expected.txt", dir );
+	FILE * manifest = fopen( path, "r" );
+
+	if ( NULL == manifest ) {
+		fprintf( stderr, "%s: cannot open\n", path );
+		linedetTestFailures++;
+		return;
+	}
+
+	while ( fgets( line, sizeof line, manifest ) != NULL ) {
+		char name[128];
+		int isFound;
+		int isMarker;
+		int offset;
+		unsigned value;
+		unsigned width = 0;
+		unsigned height = 0;
+
+		if ( '#' == line[0] || '\n' == line[0] ) {
+			continue;
+		}
+
+		if ( 1 == sscanf( line, "dark %u", &value ) ) {
+			config.isDarkLine = value != 0;
+			continue;
+		}
+
+		if ( 1 == sscanf( line, "marker %u", &value ) ) {
+			config.markerWidth = value;
+			continue;
+		}
+
+		if ( sscanf( line, "%127s %d %d %d %u %u", name, &isFound, &isMarker, &offset, &width, &height ) < 4 ) {
+			fprintf( stderr, "%s: bad line: %s", path, line );
+			linedetTestFailures++;
+			continue;
+		}
+
+		t_rover_linedet_result result;
+		uint32_t frameWidth = width;
+		uint32_t frameHeight = height;
+		snprintf( path, sizeof path, "%s/%s", dir, name );
+
+		if ( !linedet_test_load( path, gray, &frameWidth, &frameHeight ) ) {
+			linedetTestFailures++;
+			continue;
+		}
+
+		linedet_test_detect( name, &config, gray, frameWidth, frameHeight, &result );
+		frameCount++;
+
+		LINEDET_TEST_CHECK( result.isFound == ( isFound != 0 ) );
+		LINEDET_TEST_CHECK( result.isMarker == ( isMarker != 0 ) );
+		LINEDET_TEST_CHECK( !result.isFound || abs( result.offset - offset ) <= LINEDET_TEST_OFFSET_TOLERANCE );
+	}
+
+	fclose( manifest );
+
+	printf( "linedet frame set %s: %zu frames, %s\n",
+		dir,
+		frameCount,
+		linedetTestFailures > failures ? "FAILED" : "ok" );
+}
+
+
+int main( int argc, char ** argv )
+{
+	t_rover_linedet_result result;
+	int32_t center = ( LINEDET_TEST_WIDTH - LINEDET_TEST_LINE_WIDTH ) / 2;
+
+	linedet_test_fill( LINEDET_TEST_FLOOR );
+	linedet_test_draw_line( center, 0, LINEDET_TEST_LINE );
+	linedet_test_run( "center", true, &result );
+	LINEDET_TEST_CHECK( result.isFound && !result.isMarker );
+	LINEDET_TEST_CHECK( 0 == result.offset && 0 == result.heading );
+	LINEDET_TEST_CHECK( ROVER_LINEDET_SCAN_ROWS == result.rowCount );
+	LINEDET_TEST_CHECK( ( LINEDET_TEST_FLOOR + LINEDET_TEST_LINE ) / 2 == result.threshold );
+
+	linedet_test_fill( LINEDET_TEST_FLOOR );
+	linedet_test_draw_line( center + 40, 0, LINEDET_TEST_LINE );
+	linedet_test_run( "right", true, &result );
+	LINEDET_TEST_CHECK( result.isFound && linedet_test_offset( center + 40 ) == result.offset && 0 == result.heading );
+
+	linedet_test_fill( LINEDET_TEST_FLOOR );
+	linedet_test_draw_line( 10, 0, LINEDET_TEST_LINE );
+	linedet_test_run( "left", true, &result );
+	LINEDET_TEST_CHECK( result.isFound && linedet_test_offset( 10 ) == result.offset && result.offset < -800 );
+
+	// turning right ahead: the top scan row sees the line further right than the bottom one
+	linedet_test_fill( LINEDET_TEST_FLOOR );
+	linedet_test_draw_line( center, 4, LINEDET_TEST_LINE );
+	linedet_test_run( "curve", true, &result );
+	LINEDET_TEST_CHECK( result.isFound && 0 == result.offset && result.heading > 0 );
+
+	// two lines, the one closest to where the previous row found it is followed
+	linedet_test_fill( LINEDET_TEST_FLOOR );
+	linedet_test_draw_line( center, 0, LINEDET_TEST_LINE );
+	linedet_test_draw_line( 4, 0, LINEDET_TEST_LINE );
+	linedet_test_run( "fork", true, &result );
+	LINEDET_TEST_CHECK( result.isFound && 0 == result.offset && 0 == result.heading );
+
+	linedet_test_fill( LINEDET_TEST_LINE );
+	linedet_test_draw_line( center - 20, 0, LINEDET_TEST_FLOOR );
+	linedet_test_run( "light line", false, &result );
+	LINEDET_TEST_CHECK( result.isFound && linedet_test_offset( center - 20 ) == result.offset );
+
+	// a crossing band over the bottom half of the scanned area is a marker, the line still shows above it
+	linedet_test_fill( LINEDET_TEST_FLOOR );
+	linedet_test_draw_line( center, 0, LINEDET_TEST_LINE );
+	linedet_test_draw_band( 90, LINEDET_TEST_HEIGHT, LINEDET_TEST_LINE );
+	linedet_test_run( "marker", true, &result );
+	LINEDET_TEST_CHECK( result.isFound && result.isMarker && 0 == result.offset );
+	LINEDET_TEST_CHECK( result.rowCount < ROVER_LINEDET_SCAN_ROWS );
+
+	// the same band far ahead is not acted on yet
+	linedet_test_fill( LINEDET_TEST_FLOOR );
+	linedet_test_draw_line( center, 0, LINEDET_TEST_LINE );
+	linedet_test_draw_band( 40, 56, LINEDET_TEST_LINE );
+	linedet_test_run( "marker far", true, &result );
+	LINEDET_TEST_CHECK( result.isFound && !result.isMarker );
+
+	linedet_test_fill( LINEDET_TEST_FLOOR );
+	linedet_test_run( "empty", true, &result );
+	LINEDET_TEST_CHECK( !result.isFound && !result.isMarker && 0 == result.rowCount );
+
+	// below ROVER_LINEDET_CONTRAST_MIN a faint line is taken for floor texture
+	linedet_test_fill( LINEDET_TEST_FLOOR );
+	linedet_test_draw_line( center, 0, LINEDET_TEST_FLOOR - ROVER_LINEDET_CONTRAST_MIN / 2 );
+	linedet_test_run( "faint", true, &result );
+	LINEDET_TEST_CHECK( !result.isFound );
+
+	for ( int i = 1; i < argc; ++i ) {
+		linedet_test_frame_set( argv[i] );
+	}
+
+	printf( "linedet: %s\n", linedetTestFailures > 0 ? "FAILED" : "ok" );
+
+	return linedetTestFailures > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
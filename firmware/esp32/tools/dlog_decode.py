@@ -0,0 +1,218 @@
+#!/usr/bin/env python3
+#
+#	Copyright (c) 2025 Denis Rozhkov <denis@rozhkoff.com>
+#	This file is part of cam-rover.
+#
+#	cam-rover is free software: you can redistribute it and/or
+#	modify it under the terms of the GNU General Public License as published by
+#	the Free Software Foundation, either version 3 of the License, or (at your
+#	option) any later version.
+#
+#	cam-rover is distributed in the hope that it will be
+#	useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+#	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+#	Public License for more details.
+#
+#	You should have received a copy of the GNU General Public License along with
+#	cam-rover. If not, see <https://www.gnu.org/licenses/>.
+#
+
+# SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>
+# SPDX-License-Identifier: GPL-3.0-or-later
+
+
+# Deferred log decoder.
+#
+# The rover's ROVER_DLOGx calls keep the address of their format string and the raw arguments in per-core rings.
+# With CONFIG_ROVER_DLOG_CONSOLE off nothing formats them on the rover, GET /log drains the rings instead and
+# this tool turns the dump into log lines, reading the format strings and tags out of the firmware ELF:
+#
+#   dlog_decode.py --elf build/cam-rover.elf --rover IP [--follow 1.0]
+#   dlog_decode.py --elf build/cam-rover.elf log.bin [...]
+#
+# The ELF has to be the one the rover runs, needs pyelftools.
+
+import argparse
+import re
+import struct
+import sys
+import time
+import urllib.request
+
+
+# see firmware/esp32/main/dlog.h
+DUMP_MAGIC = b'RDLG'
+DUMP_VERSION = 1
+DUMP_HEADER = '<4sBBI'
+ARG_U32 = 1
+ARG_U64 = 2
+ARG_F64 = 3
+ARG_STR = 4
+LEVELS = 'NEWIDV'
+
+CONVERSION = re.compile( r'%([-+ #0]*)(\d*)(?:\.(\d*))?(hh|h|ll|l|z|j|t)?([diouxXcsfFeEgGp%])' )
+
+
+class Strings:
+	def __init__( self, path ):
+		try:
+			from elftools.elf.elffile import ELFFile
+		except ImportError:
+			sys.exit( 'pyelftools is needed: pip install pyelftools' )
+
+		self.sections = []
+
+		with open( path, 'rb' ) as f:
+			for section in ELFFile( f ).iter_sections():
+				# SHF_ALLOC, the string literals end up in the flash mapped rodata
+				if section['sh_flags'] & 2 and section['sh_type'] != 'SHT_NOBITS' and section['sh_size'] > 0:
+					self.sections.append( ( section['sh_addr'], section.data() ) )
+
+		self.cache = {}
+
+	def get( self, address ):
+		if address not in self.cache:
+			self.cache[address] = self.read( address )
+
+		return self.cache[address]
+
+	def read( self, address ):
+		for start, data in self.sections:
+			if start <= address < start + len( data ):
+				end = data.find( b'\0', address - start )
+
+				return data[address - start:end if end >= 0 else len( data )].decode( errors = 'replace' )
+
+		return f'<0x{address:08x}>'
+
+
+def parse_args( data ):
+	args = []
+	offset = 0
+
+	while offset < len( data ):
+		kind = data[offset]
+		offset += 1
+
+		if kind == ARG_U32 and offset + 4 <= len( data ):
+			args.append( ( kind, struct.unpack_from( '<I', data, offset )[0] ) )
+			offset += 4
+		elif kind == ARG_U64 and offset + 8 <= len( data ):
+			args.append( ( kind, struct.unpack_from( '<Q', data, offset )[0] ) )
+			offset += 8
+		elif kind == ARG_F64 and offset + 8 <= len( data ):
+			args.append( ( kind, struct.unpack_from( '<d', data, offset )[0] ) )
+			offset += 8
+		elif kind == ARG_STR and offset < len( data ):
+			length = data[offset]
+			args.append( ( kind, data[offset + 1:offset + 1 + length].decode( errors = 'replace' ) ) )
+			offset += 1 + length
+		else:
+			break
+
+	return args
+
+
+def signed( value, bits ):
+	return value - ( 1 << bits ) if value >= 1 << ( bits - 1 ) else value
+
+
+# printf on the recorded arguments, the same conversions as rover_dlog_format()
+def format_record( fmt, args ):
+	args = iter( args )
+
+	def convert( match ):
+		flags, width, precision, _, conversion = match.groups()
+
+		if conversion == '%':
+			return '%'
+
+		arg = next( args, None )
+
+		if arg is None:
+			return '?'
+
+		kind, value = arg
+		spec = '%' + flags + width + ( '.' + precision if precision is not None else '' )
+
+		if conversion == 's' or kind == ARG_STR:
+			return ( spec + 's' ) % ( value, )
+
+		if conversion == 'p':
+			return ( spec + 's' ) % ( f'0x{value:x}', )
+
+		if conversion in 'fFeEgG':
+			value = float( signed( value, 32 ) if kind == ARG_U32 else value )
+
+			return ( spec + conversion ) % value
+
+		if kind == ARG_F64:
+			return ( spec + 'g' ) % value
+
+		if conversion in 'di':
+			value = signed( value, 32 if kind == ARG_U32 else 64 )
+
+		if conversion == 'c':
+			return chr( value & 0xff )
+
+		return ( spec + ( 'd' if conversion in 'diu' else conversion ) ) % value
+
+	return CONVERSION.sub( convert, fmt )
+
+
+def decode( dump, strings ):
+	if len( dump ) < struct.calcsize( DUMP_HEADER ):
+		return
+
+	magic, version, recordLen, dropped = struct.unpack_from( DUMP_HEADER, dump )
+
+	if magic != DUMP_MAGIC or version != DUMP_VERSION:
+		sys.exit( 'not a deferred log dump' )
+
+	if dropped:
+		print( f'# {dropped} records dropped since boot' )
+
+	record = f'<IIIBB{recordLen - 14}s'
+
+	for offset in range( struct.calcsize( DUMP_HEADER ), len( dump ) - recordLen + 1, recordLen ):
+		timestampMs, fmt, tag, level, argsLen, args = struct.unpack_from( record, dump, offset )
+		text = format_record( strings.get( fmt ), parse_args( args[:argsLen] ) )
+		tag = strings.get( tag )
+		print( f'{LEVELS[min( level, len( LEVELS ) - 1 )]} ({timestampMs}) {tag}: {text}' )
+
+
+def main():
+	parser = argparse.ArgumentParser( description = 'cam-rover deferred log decoder' )
+	parser.add_argument( '--elf', required = True, help = 'firmware ELF the rover runs' )
+	parser.add_argument( '--rover', help = 'rover IP, fetch GET /log from it' )
+	parser.add_argument( '--follow', type = float, default = 0, help = 'keep fetching every that many seconds' )
+	parser.add_argument( 'dumps', nargs = '*', help = 'saved GET /log responses' )
+	args = parser.parse_args()
+
+	if args.rover is None and not args.dumps:
+		parser.error( 'either --rover or dump files' )
+
+	strings = Strings( args.elf )
+
+	for path in args.dumps:
+		with open( path, 'rb' ) as f:
+			decode( f.read(), strings )
+
+	if args.rover is None:
+		return
+
+	try:
+		while True:
+			with urllib.request.urlopen( f'http://{args.rover}/log', timeout = 5 ) as response:
+				decode( response.read(), strings )
+
+			if args.follow <= 0:
+				break
+
+			time.sleep( args.follow )
+	except KeyboardInterrupt:
+		pass
+
+
+if __name__ == '__main__':
+	main()
@@ -0,0 +1,322 @@
+#!/usr/bin/env python3
+#
+#	Copyright (c) 2025 Denis Rozhkov <denis@rozhkoff.com>
+#	This file is part of cam-rover.
+#
+#	cam-rover is free software: you can redistribute it and/or
+#	modify it under the terms of the GNU General Public License as published by
+#	the Free Software Foundation, either version 3 of the License, or (at your
+#	option) any later version.
+#
+#	cam-rover is distributed in the hope that it will be
+#	useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+#	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+#	Public License for more details.
+#
+#	You should have received a copy of the GNU General Public License along with
+#	cam-rover. If not, see <https://www.gnu.org/licenses/>.
+#
+
+# SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>
+# SPDX-License-Identifier: GPL-3.0-or-later
+
+# Glass-to-glass latency benchmark.
+#
+# Point the camera at something the flash LED lights up (a white card a few cm in front of the lens works),
+# switch the rover to the full frame JPEG stream and run:
+#
+#   latency_bench.py [--rover IP] [--trials 50] [--csv out.csv]
+#
+# Every trial turns the flash on and waits for the first streamed frame whose mean luma rises above the
+# baseline. The ACK of the flash command carries the rover time the LED was switched on, every stream
+# packet carries the capture time of its frame, so the total is split into
+#   uplink     - command sent .. LED on (host .. rover clock, offset estimated from the ACK round trip)
+#   capture    - LED on .. capture timestamp of the first lit frame (rover clock)
+#   transport  - capture .. packet received (rover .. host clock)
+#   decode     - packet received .. frame decoded
+#   total      - command sent .. frame decoded (host clock only)
+# "decoded" stands in for "displayed", the host has no way to observe the screen.
+
+import argparse
+import csv
+import io
+import socket
+import struct
+import sys
+import threading
+import time
+
+from PIL import Image, ImageStat
+
+
+DISCOVERY_ADDR = ( '239.255.255.250', 3703 )
+
+# see protocol/protocol.json
+COMMAND_ACK = ord( 'a' )
+COMMAND_FLASH = ord( 'f' )
+COMMAND_FLASH_MODE = ord( 'm' )
+FLASH_MODE_CONSTANT = 0
+STREAM_HEADER_LEN = 9
+STREAM_FRAME = ord( 'F' )
+STREAM_CHUNK = ord( 'C' )
+CHUNK_HEADER_LEN = STREAM_HEADER_LEN + 8
+
+
+def now_us():
+	return time.perf_counter_ns() // 1000
+
+
+def discover( timeout ):
+	sock = socket.socket( socket.AF_INET, socket.SOCK_DGRAM, socket.IPPROTO_UDP )
+	sock.setsockopt( socket.IPPROTO_IP, socket.IP_MULTICAST_TTL, 2 )
+	sock.settimeout( timeout )
+	sock.sendto( b'CAM-ROVER:PROBE\0', DISCOVERY_ADDR )
+
+	try:
+		while True:
+			data, addr = sock.recvfrom( 256 )
+			# CAM-ROVER:PROBE_MATCH:<control port>:<stream port>:<session>:<capabilities>
+			parts = data.rstrip( b'\0' ).decode( errors = 'replace' ).split( ':', 5 )
+
+			if len( parts ) >= 4 and parts[1] == 'PROBE_MATCH':
+				return addr[0], int( parts[2] ), int( parts[3] )
+	except socket.timeout:
+		return None
+	finally:
+		sock.close()
+
+
+class Messages:
+	def __init__( self ):
+		self.id = 0
+
+	def build( self, command, payload = b'' ):
+		self.id += 1
+		body = struct.pack( '<IB', self.id, command ) + payload
+
+		return bytes( [ len( body ) ] ) + body, self.id
+
+
+class StreamReceiver( threading.Thread ):
+	def __init__( self, host, port, scale ):
+		super().__init__( daemon = True )
+		self.address = ( host, port )
+		self.scale = scale
+		self.sock = socket.socket( socket.AF_INET, socket.SOCK_DGRAM )
+		self.sock.settimeout( 0.2 )
+		self.messages = Messages()
+		self.frames = []
+		self.nonFrameCount = 0
+		self.cond = threading.Condition()
+		self.isRunning = True
+		# capture timestamp, frame buffer, bytes received so far
+		self.chunked = None
+
+	# returns the frame as a full frame packet once its last chunk is in
+	def add_chunk( self, data ):
+		captureUs, offset, length = struct.unpack_from( '<qII', data, 1 )
+
+		if self.chunked is None or self.chunked[0] != captureUs:
+			self.chunked = ( captureUs, bytearray( length ), [ 0 ] )
+
+		_, frame, received = self.chunked
+		chunk = data[CHUNK_HEADER_LEN:]
+		frame[offset:offset + len( chunk )] = chunk
+		received[0] += len( chunk )
+
+		if received[0] < length:
+			return None
+
+		self.chunked = None
+
+		return bytes( [ STREAM_FRAME ] ) + struct.pack( '<q', captureUs ) + bytes( frame )
+
+	def run( self ):
+		ackedAt = 0
+
+		while self.isRunning:
+			# the rover streams to whoever talked to the stream port last
+			if time.monotonic() - ackedAt > 0.1:
+				message, _ = self.messages.build( COMMAND_ACK )
+				self.sock.sendto( message, self.address )
+				ackedAt = time.monotonic()
+
+			try:
+				data = self.sock.recv( 65536 )
+			except socket.timeout:
+				ackedAt = 0
+				continue
+
+			# the last chunk is what completes the frame, so its arrival time is the frame's
+			receivedUs = now_us()
+
+			if len( data ) > CHUNK_HEADER_LEN and data[0] == STREAM_CHUNK:
+				data = self.add_chunk( data )
+
+				if data is None:
+					continue
+
+			if len( data ) <= STREAM_HEADER_LEN or data[0] != STREAM_FRAME:
+				self.nonFrameCount += 1
+				continue
+
+			captureUs, = struct.unpack_from( '<q', data, 1 )
+
+			try:
+				image = Image.open( io.BytesIO( data[STREAM_HEADER_LEN:] ) )
+				image.draft( 'L', ( image.width // self.scale, image.height // self.scale ) )
+				luma = ImageStat.Stat( image.convert( 'L' ) ).mean[0]
+			except Exception:
+				continue
+
+			decodedUs = now_us()
+
+			with self.cond:
+				self.frames.append( ( captureUs, receivedUs, decodedUs, luma ) )
+				del self.frames[:-256]
+				self.cond.notify_all()
+
+	def wait_frame( self, predicate, timeout ):
+		deadline = time.monotonic() + timeout
+
+		with self.cond:
+			while True:
+				for frame in self.frames:
+					if predicate( frame ):
+						return frame
+
+				left = deadline - time.monotonic()
+
+				if left <= 0 or not self.cond.wait( left ):
+					return None
+
+	def baseline( self, count ):
+		with self.cond:
+			lumas = [ f[3] for f in self.frames[-count:] ]
+
+		return sum( lumas ) / len( lumas ) if lumas else None
+
+
+class Control:
+	def __init__( self, host, port ):
+		self.address = ( host, port )
+		self.sock = socket.socket( socket.AF_INET, socket.SOCK_DGRAM )
+		self.messages = Messages()
+
+	# returns ( sent us, acked us, rover us ) or None
+	def request( self, command, payload, timeout = 0.5 ):
+		message, messageId = self.messages.build( command, payload )
+		self.sock.settimeout( timeout )
+		sentUs = now_us()
+		self.sock.sendto( message, self.address )
+
+		try:
+			while True:
+				data = self.sock.recv( 256 )
+
+				if len( data ) >= 22 and data[5] == COMMAND_ACK and struct.unpack_from( '<I', data, 1 )[0] == messageId:
+					return sentUs, now_us(), struct.unpack_from( '<q', data, 14 )[0]
+		except socket.timeout:
+			return None
+
+
+def percentile( values, p ):
+	values = sorted( values )
+	k = ( len( values ) - 1 ) * p / 100
+	lo = int( k )
+	hi = min( lo + 1, len( values ) - 1 )
+
+	return values[lo] + ( values[hi] - values[lo] ) * ( k - lo )
+
+
+def main():
+	parser = argparse.ArgumentParser( description = 'cam-rover glass-to-glass latency benchmark' )
+	parser.add_argument( '--rover', help = 'rover IP, discovered when omitted' )
+	parser.add_argument( '--control-port', type = int, default = 101 )
+	parser.add_argument( '--stream-port', type = int, default = 102 )
+	parser.add_argument( '--trials', type = int, default = 30 )
+	parser.add_argument( '--duty', type = int, default = 255 )
+	parser.add_argument( '--threshold', type = float, default = 20, help = 'luma rise that counts as lit' )
+	parser.add_argument( '--settle', type = float, default = 1.0, help = 'seconds between trials' )
+	parser.add_argument( '--scale', type = int, default = 8, choices = [ 1, 2, 4, 8 ] )
+	parser.add_argument( '--csv', help = 'write per-trial results to a CSV file' )
+	args = parser.parse_args()
+
+	host, controlPort, streamPort = args.rover, args.control_port, args.stream_port
+
+	if host is None:
+		found = discover( 2.0 )
+
+		if found is None:
+			sys.exit( 'rover not found' )
+
+		host, controlPort, streamPort = found
+
+	print( f'rover {host}, control port {controlPort}, stream port {streamPort}' )
+
+	stream = StreamReceiver( host, streamPort, args.scale )
+	stream.start()
+	control = Control( host, controlPort )
+
+	if control.request( COMMAND_FLASH_MODE, bytes( [ FLASH_MODE_CONSTANT ] ) ) is None:
+		sys.exit( 'no ACK from the rover' )
+
+	if stream.wait_frame( lambda f: True, 3.0 ) is None:
+		sys.exit( f'no full frames on the stream ({stream.nonFrameCount} other packets)' )
+
+	columns = [ 'uplink', 'capture', 'transport', 'decode', 'total' ]
+	results = []
+
+	for trial in range( args.trials ):
+		control.request( COMMAND_FLASH, bytes( [ 0 ] ) )
+		time.sleep( args.settle )
+		baseline = stream.baseline( 5 )
+		ack = control.request( COMMAND_FLASH, bytes( [ args.duty ] ) )
+
+		if ack is None or baseline is None:
+			print( f'trial {trial}: no ACK' )
+			continue
+
+		sentUs, ackedUs, roverOnUs = ack
+		# rover clock minus host clock, the ACK is assumed to be taken halfway through the round trip
+		offsetUs = roverOnUs - ( sentUs + ackedUs ) // 2
+		frame = stream.wait_frame(
+			lambda f: f[1] > sentUs and f[0] > roverOnUs and f[3] > baseline + args.threshold, 2.0 )
+
+		if frame is None:
+			print( f'trial {trial}: no lit frame (baseline {baseline:.1f})' )
+			continue
+
+		captureUs, receivedUs, decodedUs, luma = frame
+		row = [ roverOnUs - offsetUs - sentUs,
+			captureUs - roverOnUs,
+			receivedUs - ( captureUs - offsetUs ),
+			decodedUs - receivedUs,
+			decodedUs - sentUs ]
+		results.append( row + [ ackedUs - sentUs, baseline, luma ] )
+		print( f'trial {trial}: total {row[4] / 1000:.1f} ms (rtt {( ackedUs - sentUs ) / 1000:.1f} ms, '
+			f'luma {baseline:.0f} -> {luma:.0f})' )
+
+	control.request( COMMAND_FLASH, bytes( [ 0 ] ) )
+	stream.isRunning = False
+
+	if not results:
+		sys.exit( 'no successful trials' )
+
+	print( f'\n{len( results )}/{args.trials} trials, ms' )
+	print( f'{"":10} {"min":>8} {"p50":>8} {"p95":>8} {"p99":>8} {"max":>8}' )
+
+	for i, name in enumerate( columns ):
+		values = [ r[i] / 1000 for r in results ]
+		print( f'{name:10} {min( values ):8.1f} {percentile( values, 50 ):8.1f} {percentile( values, 95 ):8.1f} '
+			f'{percentile( values, 99 ):8.1f} {max( values ):8.1f}' )
+
+	if args.csv:
+		with open( args.csv, 'w', newline = '' ) as f:
+			writer = csv.writer( f )
+			writer.writerow( [ c + '_us' for c in columns ] + [ 'rtt_us', 'baseline_luma', 'luma' ] )
+			writer.writerows( results )
+
+
+if __name__ == '__main__':
+	main()
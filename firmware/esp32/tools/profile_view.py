@@ -0,0 +1,220 @@
+#!/usr/bin/env python3
+#
+#	Copyright (c) 2025 Denis Rozhkov <denis@rozhkoff.com>
+#	This file is part of cam-rover.
+#
+#	cam-rover is free software: you can redistribute it and/or
+#	modify it under the terms of the GNU General Public License as published by
+#	the Free Software Foundation, either version 3 of the License, or (at your
+#	option) any later version.
+#
+#	cam-rover is distributed in the hope that it will be
+#	useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+#	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+#	Public License for more details.
+#
+#	You should have received a copy of the GNU General Public License along with
+#	cam-rover. If not, see <https://www.gnu.org/licenses/>.
+#
+
+# SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>
+# SPDX-License-Identifier: GPL-3.0-or-later
+
+
+# Per-task CPU profile viewer.
+#
+# Needs a firmware built with CONFIG_ROVER_PROFILER. The rover sends a profile packet to the stream client
+# every profiler window; this tool takes the stream client's place and runs:
+#
+#   profile_view.py [--rover IP] [--top 8] [--duration 60] [--csv out.csv] [--plot out.png]
+#
+# Every window prints the load of both cores, the stream FPS seen over the same window and the heaviest
+# tasks. Loads are percent of one core, a task pinned to neither core can show up on both. --csv writes one
+# row per task per window, --plot renders core loads, FPS and the heaviest tasks over time (needs
+# matplotlib).
+
+import argparse
+import csv
+import socket
+import struct
+import sys
+import time
+
+
+DISCOVERY_ADDR = ( '239.255.255.250', 3703 )
+
+# see protocol/protocol.json
+COMMAND_ACK = ord( 'a' )
+STREAM_HEADER_LEN = 9
+STREAM_FRAME = ord( 'F' )
+STREAM_CHUNK = ord( 'C' )
+STREAM_PROFILE = ord( 'P' )
+PROFILE_HEADER_LEN = STREAM_HEADER_LEN + 9
+PROFILE_RECORD_LEN = 21
+
+
+def discover( timeout ):
+	sock = socket.socket( socket.AF_INET, socket.SOCK_DGRAM, socket.IPPROTO_UDP )
+	sock.setsockopt( socket.IPPROTO_IP, socket.IP_MULTICAST_TTL, 2 )
+	sock.settimeout( timeout )
+	sock.sendto( b'CAM-ROVER:PROBE\0', DISCOVERY_ADDR )
+
+	try:
+		while True:
+			data, addr = sock.recvfrom( 256 )
+			# CAM-ROVER:PROBE_MATCH:<control port>:<stream port>:<session>:<capabilities>
+			parts = data.rstrip( b'\0' ).decode( errors = 'replace' ).split( ':', 5 )
+
+			if len( parts ) >= 4 and parts[1] == 'PROBE_MATCH':
+				return addr[0], int( parts[3] )
+	except socket.timeout:
+		return None
+	finally:
+		sock.close()
+
+
+# returns ( timestamp us, window us, [ core loads ], [ ( name, load, core, stack free ) ] ), loads in percent
+def parse_profile( data ):
+	if len( data ) < PROFILE_HEADER_LEN or data[0] != STREAM_PROFILE:
+		return None
+
+	timestampUs, windowUs, core0, core1, count = struct.unpack_from( '<qIHHB', data, 1 )
+	tasks = []
+
+	for i in range( count ):
+		offset = PROFILE_HEADER_LEN + i * PROFILE_RECORD_LEN
+
+		if offset + PROFILE_RECORD_LEN > len( data ):
+			break
+
+		name, load, core, stackFree = struct.unpack_from( '<16sHbH', data, offset )
+		tasks.append( ( name.rstrip( b'\0' ).decode( errors = 'replace' ), load / 10, core, stackFree ) )
+
+	return timestampUs, windowUs, [ core0 / 10, core1 / 10 ], tasks
+
+
+def plot( path, rows, top ):
+	import matplotlib
+
+	matplotlib.use( 'Agg' )
+	import matplotlib.pyplot as plt
+
+	t0 = rows[0]['t']
+	times = [ ( r['t'] - t0 ) / 1e6 for r in rows ]
+	totals = {}
+
+	for r in rows:
+		for name, load, _, _ in r['tasks']:
+			totals[name] = totals.get( name, 0 ) + load
+
+	heaviest = sorted( totals, key = totals.get, reverse = True )[:top]
+	fig, ( axCores, axTasks ) = plt.subplots( 2, 1, sharex = True, figsize = ( 12, 8 ) )
+
+	for core in range( 2 ):
+		axCores.plot( times, [ r['cores'][core] for r in rows ], label = f'core {core}' )
+
+	axCores.set_ylabel( 'core load, %' )
+	axCores.set_ylim( 0, 100 )
+	axFps = axCores.twinx()
+	axFps.plot( times, [ r['fps'] for r in rows ], 'k--', label = 'FPS' )
+	axFps.set_ylabel( 'FPS' )
+	axCores.legend( loc = 'upper left' )
+	axFps.legend( loc = 'upper right' )
+
+	for name in heaviest:
+		loads = [ next( ( t[1] for t in r['tasks'] if t[0] == name ), 0 ) for r in rows ]
+		axTasks.plot( times, loads, label = name )
+
+	axTasks.set_ylabel( 'task load, % of a core' )
+	axTasks.set_xlabel( 's' )
+	axTasks.legend( loc = 'upper left', fontsize = 'small', ncol = 2 )
+	fig.tight_layout()
+	fig.savefig( path )
+
+
+def main():
+	parser = argparse.ArgumentParser( description = 'cam-rover per-task CPU profile viewer' )
+	parser.add_argument( '--rover', help = 'rover IP, discovered when omitted' )
+	parser.add_argument( '--stream-port', type = int, default = 102 )
+	parser.add_argument( '--top', type = int, default = 8, help = 'tasks shown per window' )
+	parser.add_argument( '--duration', type = float, default = 0, help = 'seconds, 0 runs until interrupted' )
+	parser.add_argument( '--csv', help = 'write per-task rows to a CSV file' )
+	parser.add_argument( '--plot', help = 'render the run to an image file' )
+	args = parser.parse_args()
+
+	host, streamPort = args.rover, args.stream_port
+
+	if host is None:
+		found = discover( 2.0 )
+
+		if found is None:
+			sys.exit( 'rover not found' )
+
+		host, streamPort = found
+
+	print( f'rover {host}, stream port {streamPort}' )
+
+	address = ( host, streamPort )
+	sock = socket.socket( socket.AF_INET, socket.SOCK_DGRAM )
+	sock.settimeout( 0.2 )
+	messageId = 0
+	ackedAt = 0
+	startedAt = time.monotonic()
+	# capture timestamps of the frames seen since the last profile
+	frames = set()
+	rows = []
+
+	try:
+		while args.duration <= 0 or time.monotonic() - startedAt < args.duration:
+			# the rover streams to whoever talked to the stream port last
+			if time.monotonic() - ackedAt > 0.1:
+				messageId += 1
+				body = struct.pack( '<IB', messageId, COMMAND_ACK )
+				sock.sendto( bytes( [ len( body ) ] ) + body, address )
+				ackedAt = time.monotonic()
+
+			try:
+				data = sock.recv( 65536 )
+			except socket.timeout:
+				ackedAt = 0
+				continue
+
+			if len( data ) >= STREAM_HEADER_LEN and data[0] in ( STREAM_FRAME, STREAM_CHUNK ):
+				frames.add( struct.unpack_from( '<q', data, 1 )[0] )
+				continue
+
+			profile = parse_profile( data )
+
+			if profile is None:
+				continue
+
+			timestampUs, windowUs, cores, tasks = profile
+			fps = len( frames ) * 1e6 / windowUs if windowUs > 0 else 0
+			frames.clear()
+			rows.append( { 't': timestampUs, 'window': windowUs, 'cores': cores, 'fps': fps, 'tasks': tasks } )
+
+			print( f'\n{timestampUs / 1e6:10.1f} s  core 0 {cores[0]:5.1f}%  core 1 {cores[1]:5.1f}%  '
+				f'{fps:5.1f} FPS' )
+
+			for name, load, core, stackFree in tasks[:args.top]:
+				print( f'  {name:16} {load:5.1f}%  core {"-" if core < 0 else core}  stack free {stackFree}' )
+	except KeyboardInterrupt:
+		pass
+
+	if args.csv:
+		with open( args.csv, 'w', newline = '' ) as f:
+			writer = csv.writer( f )
+			writer.writerow( [ 'timestamp_us', 'window_us', 'core0', 'core1', 'fps', 'task', 'load', 'core',
+				'stack_free' ] )
+
+			for r in rows:
+				for name, load, core, stackFree in r['tasks']:
+					writer.writerow( [ r['t'], r['window'], r['cores'][0], r['cores'][1], f'{r["fps"]:.1f}', name,
+						load, core, stackFree ] )
+
+	if args.plot and rows:
+		plot( args.plot, rows, args.top )
+
+
+if __name__ == '__main__':
+	main()
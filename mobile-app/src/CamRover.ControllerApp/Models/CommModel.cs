@@ -19,11 +19,14 @@
 // SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>
 // SPDX-License-Identifier: GPL-3.0-or-later
 
+using System.Buffers;
 using System.Diagnostics;
 using System.Net;
 using System.Net.Sockets;
 using System.Text;
 
+using CamRover.ControllerApp.Types;
+
 namespace CamRover.ControllerApp.Models
 {
 
@@ -36,15 +39,32 @@ namespace CamRover.ControllerApp.Models
 		Left = 'l',
 		Right = 'r',
 		Flash = 'f',
+		FlashMode = 'm',
 		Ack = 'a',
 		Set = 't',
-		Deadzone = 'z'
+		Deadzone = 'z',
+		Autonomous = 'o',
+		Ping = 'p'
 	}
 
 
 	public class CommModel
 	{
-		readonly record struct DiscoverResult( IPAddress Address, ushort ControlPortNo, ushort StreamPortNo );
+		readonly record struct DiscoverResult( IPAddress Address, ushort ControlPortNo, ushort StreamPortNo, uint SessionToken
+			, IReadOnlyDictionary<string, string>? Capabilities = null );
+
+
+		// probes start fast and back off, a rover that is already there answers the first one
+		static readonly TimeSpan ProbeBackoffMin = TimeSpan.FromMilliseconds( 20 );
+		static readonly TimeSpan ProbeBackoffMax = TimeSpan.FromMilliseconds( 500 );
+		// idle control link is pinged, without any ACK for LinkTimeout the rover is looked for again
+		static readonly TimeSpan PingInterval = TimeSpan.FromMilliseconds( 250 );
+		static readonly TimeSpan LinkTimeout = TimeSpan.FromMilliseconds( 1000 );
+		static readonly TimeSpan StreamReceiveTimeout = TimeSpan.FromMilliseconds( 500 );
+		// frames arrive in many chunks, the rover only needs to hear from the stream client now and then
+		static readonly TimeSpan StreamAckInterval = TimeSpan.FromMilliseconds( 100 );
+		const int StreamPacketSizeMax = 64 * 1024;
+		const int MessageSizeMax = 64;
 
 
 		public event Func<Task>? DiscoveryStarted;
@@ -52,6 +72,8 @@ namespace CamRover.ControllerApp.Models
 		public event Func<byte[], Task>? FrameReceived;
 		public event Func<int, int, Task>? SpeedUpdated;
 		public event Func<int, Task>? FpsUpdated;
+		// jitter, playout delay, ms; frames skipped since the last update
+		public event Func<int, int, int, Task>? PlayoutUpdated;
 
 		public uint MoveSpeedIncrement
 		{
@@ -63,12 +85,63 @@ namespace CamRover.ControllerApp.Models
 			get; set;
 		}
 
+		public uint CameraFlashMode
+		{
+			get; set;
+		}
+
+		public bool IsAutonomous
+		{
+			get; set;
+		}
+
+		// capability record of the rover found last: fw, proto, modes, transport, res, fps, load, link
+		public IReadOnlyDictionary<string, string> Capabilities
+		{
+			get; private set;
+		} = new Dictionary<string, string>();
+
+		// full frames, latest wins; the consumer decodes on its own thread
+		public FrameExchange Frames
+		{
+			get;
+		} = new FrameExchange();
+
+		// trades latency for smoothness, see FramePlayout
+		public bool IsObserverMode
+		{
+			get
+			{
+				return m_playout.IsObserverMode;
+			}
+
+			set
+			{
+				m_playout.IsObserverMode = value;
+			}
+		}
+
+		public bool IsStreamingActive
+		{
+			get
+			{
+				return m_isStreamingActive;
+			}
+		}
+
 		uint m_messageId;
+		// control messages are built and sent one at a time by Worker, so they share a buffer
+		byte[] m_message = new byte[MessageSizeMax];
 
 		EventWaitHandle m_connectCommandEvent = new EventWaitHandle( false, EventResetMode.ManualReset );
 		EventWaitHandle m_commEvent = new EventWaitHandle( false, EventResetMode.ManualReset );
 		volatile CommCommand m_commCommand;
 		volatile bool m_isStreamingActive;
+		volatile IPEndPoint? m_streamEndPoint;
+		long m_lastAckTicks;
+		FramePlayout m_playout = new FramePlayout();
+		uint m_sessionToken;
+		volatile bool m_isSessionChanged;
 
 		public int SpeedL
 		{
@@ -86,62 +159,63 @@ namespace CamRover.ControllerApp.Models
 		} = 30;
 
 
-		byte[] MessageMove( CommCommand cmd )
+		uint NextMessageId()
+		{
+			return Interlocked.Increment( ref m_messageId );
+		}
+
+
+		ReadOnlyMemory<byte> MessageMove( CommCommand cmd )
 		{
-			var id = Interlocked.Increment( ref m_messageId );
-			var idBytes = BitConverter.GetBytes( id );
-			return [6, idBytes[0], idBytes[1], idBytes[2], idBytes[3], (byte)cmd, (byte)this.MoveSpeedIncrement];
+			var message = new MoveSpeedMessage( (byte)this.MoveSpeedIncrement );
+			return m_message.AsMemory( 0, message.Emit( m_message, NextMessageId(), (ProtocolCommand)cmd ) );
 		}
 
 
-		byte[] MessageCameraFlash()
+		ReadOnlyMemory<byte> MessageCameraFlash()
 		{
-			var id = Interlocked.Increment( ref m_messageId );
-			var idBytes = BitConverter.GetBytes( id );
-			return [6, idBytes[0], idBytes[1], idBytes[2], idBytes[3], (byte)CommCommand.Flash, (byte)this.CameraFlashDuty];
+			var message = new CameraFlashMessage( (byte)this.CameraFlashDuty );
+			return m_message.AsMemory( 0, message.Emit( m_message, NextMessageId() ) );
 		}
 
 
-		byte[] MessageMoveStop()
+		ReadOnlyMemory<byte> MessageMoveAutonomous()
 		{
-			var id = Interlocked.Increment( ref m_messageId );
-			var idBytes = BitConverter.GetBytes( id );
-			return [5, idBytes[0], idBytes[1], idBytes[2], idBytes[3], (byte)CommCommand.Stop];
+			var message = new MoveAutonomousMessage( (byte)(this.IsAutonomous ? 1 : 0) );
+			return m_message.AsMemory( 0, message.Emit( m_message, NextMessageId() ) );
 		}
 
 
-		byte[] MessageMoveSet()
+		ReadOnlyMemory<byte> MessageCameraFlashMode()
 		{
-			var id = Interlocked.Increment( ref m_messageId );
-			var idBytes = BitConverter.GetBytes( id );
-			var speedLBytes = BitConverter.GetBytes( this.SpeedL );
-			var speedRBytes = BitConverter.GetBytes( this.SpeedR );
-			return [13
-				, idBytes[0], idBytes[1], idBytes[2], idBytes[3]
-				, (byte)CommCommand.Set
-				, speedLBytes[0], speedLBytes[1], speedLBytes[2], speedLBytes[3]
-				, speedRBytes[0], speedRBytes[1], speedRBytes[2], speedRBytes[3]];
+			var message = new CameraFlashModeMessage( (byte)this.CameraFlashMode );
+			return m_message.AsMemory( 0, message.Emit( m_message, NextMessageId() ) );
 		}
 
 
-		byte[] MessageMoveDeadzone()
+		ReadOnlyMemory<byte> MessageMoveStop()
 		{
-			var id = Interlocked.Increment( ref m_messageId );
-			var idBytes = BitConverter.GetBytes( id );
-			var deadzone = BitConverter.GetBytes( this.Deadzone );
-			return [9
-				, idBytes[0], idBytes[1], idBytes[2], idBytes[3]
-				, (byte)CommCommand.Deadzone
-				, deadzone[0], deadzone[1], deadzone[2], deadzone[3]
-				];
+			return m_message.AsMemory( 0, new MoveStopMessage().Emit( m_message, NextMessageId() ) );
 		}
 
 
-		byte[] MessageAck()
+		ReadOnlyMemory<byte> MessageMoveSet()
 		{
-			var id = 0;
-			var idBytes = BitConverter.GetBytes( id );
-			return [5, idBytes[0], idBytes[1], idBytes[2], idBytes[3], (byte)CommCommand.Ack];
+			var message = new MoveSetMessage( this.SpeedL, this.SpeedR );
+			return m_message.AsMemory( 0, message.Emit( m_message, NextMessageId() ) );
+		}
+
+
+		ReadOnlyMemory<byte> MessageMoveDeadzone()
+		{
+			var message = new MoveDeadzoneMessage( this.Deadzone );
+			return m_message.AsMemory( 0, message.Emit( m_message, NextMessageId() ) );
+		}
+
+
+		ReadOnlyMemory<byte> MessagePing()
+		{
+			return m_message.AsMemory( 0, new PingMessage().Emit( m_message, NextMessageId() ) );
 		}
 
 
@@ -200,33 +274,122 @@ namespace CamRover.ControllerApp.Models
 		}
 
 
-		async void StreamWorker( IPAddress address, ushort portNo )
+		async Task OnPlayoutUpdate( int jitterMs, int targetMs, int skippedCount )
+		{
+			var e = this.PlayoutUpdated;
+
+			if (e != null)
+			{
+				await e( jitterMs, targetMs, skippedCount );
+			}
+		}
+
+
+		// follows m_streamEndPoint, so it keeps running across reconnects
+		// receives into one pooled buffer and queues full frames for playout, which passes them on through
+		// Frames, nothing is allocated per packet; tiles add up to a frame and are passed on as they come
+		async void StreamWorker()
 		{
-			IPEndPoint ip = new( address, portNo );
+			var buffer = ArrayPool<byte>.Shared.Rent( StreamPacketSizeMax );
+			var ack = new byte[StreamAckMessage.Length];
+			new StreamAckMessage().Emit( ack, 0 );
+			var receiveCts = new CancellationTokenSource();
+			FrameBuffer? frame = null;
+			int skippedCount = m_playout.SkippedCount;
 
 			while (m_isStreamingActive)
 			{
 				try
 				{
-					using var udpClient = new UdpClient( 0, AddressFamily.InterNetwork );
-					//using var receiveCts = new CancellationTokenSource( TimeSpan.FromSeconds( 5 ) );
+					using var socket = new Socket( AddressFamily.InterNetwork, SocketType.Dgram, ProtocolType.Udp );
+					socket.Bind( new IPEndPoint( IPAddress.Any, 0 ) );
+
 					int frameCount = 0;
+					int tileFrameNo = -1;
+					var assembler = new FrameAssembler();
 					Stopwatch sw = Stopwatch.StartNew();
+					Stopwatch ackSw = new Stopwatch();
 
 					while (m_isStreamingActive)
 					{
-						using var receiveCts = new CancellationTokenSource( TimeSpan.FromSeconds( 5 ) );
-						//receiveCts.TryReset();
-						var receiveTask = udpClient.ReceiveAsync( receiveCts.Token );
-						udpClient.Send( MessageAck(), ip );
-						var response = await receiveTask;
-						await OnFrameReceive( response.Buffer );
+						var ip = m_streamEndPoint;
+
+						if (ip == null)
+						{
+							await Task.Delay( StreamReceiveTimeout );
+							continue;
+						}
+
+						if (!ackSw.IsRunning || ackSw.Elapsed > StreamAckInterval)
+						{
+							socket.SendTo( ack, ip );
+							ackSw.Restart();
+						}
+
+						if (!receiveCts.TryReset())
+						{
+							receiveCts.Dispose();
+							receiveCts = new CancellationTokenSource();
+						}
+
+						receiveCts.CancelAfter( StreamReceiveTimeout );
+						int length;
+
+						try
+						{
+							length = await socket.ReceiveAsync( buffer.AsMemory(), SocketFlags.None, receiveCts.Token );
+						}
+						catch (OperationCanceledException)
+						{
+							// a gap, the socket is kept and the next ACK tells the rover where to stream again
+							ackSw.Reset();
+							continue;
+						}
 
-						frameCount++;
+						if (FrameAssembler.IsChunk( buffer, length ))
+						{
+							// without a free buffer the chunks are dropped and so is their frame
+							frame ??= m_playout.Rent();
+
+							if (frame != null && assembler.Add( buffer, length, frame ))
+							{
+								m_playout.Add( frame );
+								frame = null;
+								frameCount++;
+							}
+						}
+						else if (FrameDrawable.IsTile( buffer, length ))
+						{
+							await OnFrameReceive( buffer.AsSpan( 0, length ).ToArray() );
+
+							// several tile packets make up one frame
+							var frameNo = FrameDrawable.TileFrameNo( buffer );
+
+							if (frameNo != tileFrameNo)
+							{
+								tileFrameNo = frameNo;
+								frameCount++;
+							}
+						}
+						else if (FrameDrawable.IsFrame( buffer, length ))
+						{
+							var full = m_playout.Rent();
+
+							if (full != null)
+							{
+								full.Set( buffer, length );
+								m_playout.Add( full );
+							}
+
+							frameCount++;
+						}
 
 						if (sw.Elapsed.TotalSeconds > 5)
 						{
 							await OnFpsUpdate( (int)(frameCount / sw.Elapsed.TotalSeconds) );
+							await OnPlayoutUpdate( m_playout.JitterMs, m_playout.TargetMs,
+								m_playout.SkippedCount - skippedCount );
+							skippedCount = m_playout.SkippedCount;
 							frameCount = 0;
 							sw.Restart();
 						}
@@ -236,49 +399,166 @@ namespace CamRover.ControllerApp.Models
 				{
 				}
 			}
+
+			receiveCts.Dispose();
+			ArrayPool<byte>.Shared.Return( buffer );
+		}
+
+
+		static DiscoverResult? LoadCachedEndpoint()
+		{
+			var address = Preferences.Default.Get( "rover.address", "" );
+
+			if (!IPAddress.TryParse( address, out var ip ))
+			{
+				return null;
+			}
+
+			return new DiscoverResult( ip
+				, (ushort)Preferences.Default.Get( "rover.controlPortNo", 0 )
+				, (ushort)Preferences.Default.Get( "rover.streamPortNo", 0 )
+				, 0 );
+		}
+
+
+		static void SaveCachedEndpoint( DiscoverResult result )
+		{
+			Preferences.Default.Set( "rover.address", result.Address.ToString() );
+			Preferences.Default.Set( "rover.controlPortNo", (int)result.ControlPortNo );
+			Preferences.Default.Set( "rover.streamPortNo", (int)result.StreamPortNo );
+		}
+
+
+		static uint AckSessionToken( byte[] ack )
+		{
+			return AckMessage.TryParse( ack, out var message ) ? message.SessionToken : 0;
+		}
+
+
+		// CAM-ROVER:<PROBE_MATCH|ANNOUNCE>:<control port>:<stream port>[:<session>[:<key=value;...>]]
+		static DiscoverResult? ParseRecord( string response, IPAddress address )
+		{
+			var tokens = response.TrimEnd( '\0' ).Split( ':', 6 );
+
+			if (tokens.Length < 4 || tokens[0] != "CAM-ROVER" || (tokens[1] != "PROBE_MATCH" && tokens[1] != "ANNOUNCE"))
+			{
+				return null;
+			}
+
+			var capabilities = new Dictionary<string, string>();
+
+			if (tokens.Length > 5)
+			{
+				foreach (var field in tokens[5].Split( ';', StringSplitOptions.RemoveEmptyEntries ))
+				{
+					var pair = field.Split( '=', 2 );
+					capabilities[pair[0]] = pair.Length > 1 ? pair[1] : "";
+				}
+			}
+
+			return new DiscoverResult( address
+				, ushort.Parse( tokens[2] )
+				, ushort.Parse( tokens[3] )
+				, tokens.Length > 4 ? uint.Parse( tokens[4], System.Globalization.NumberStyles.HexNumber ) : 0
+				, capabilities );
 		}
 
 
+		// the discovery port is shared with other clients, falls back to probing only when it cannot be joined
+		static UdpClient CreateDiscoveryClient( IPAddress group, ushort portNo )
+		{
+			var udpClient = new UdpClient( AddressFamily.InterNetwork );
+
+			try
+			{
+				udpClient.Client.SetSocketOption( SocketOptionLevel.Socket, SocketOptionName.ReuseAddress, true );
+				udpClient.Client.Bind( new IPEndPoint( IPAddress.Any, portNo ) );
+				udpClient.JoinMulticastGroup( group );
+			}
+			catch
+			{
+				udpClient.Dispose();
+				udpClient = new UdpClient( 0, AddressFamily.InterNetwork );
+			}
+
+			return udpClient;
+		}
+
+
+		// the last known rover is pinged directly while the multicast probe looks for any rover,
+		// rover announcements to the group are taken as well so a rover that comes up is used right away
 		async Task<DiscoverResult> Discover( string ip = "239.255.255.250", ushort portNo = 3703 )
 		{
-			var endPoint = new IPEndPoint( IPAddress.Parse( "239.255.255.250" ), portNo );
+			var endPoint = new IPEndPoint( IPAddress.Parse( ip ), portNo );
+			var probe = Encoding.ASCII.GetBytes( "CAM-ROVER:PROBE" );
+			var cached = LoadCachedEndpoint();
+			var cachedEndPoint = cached is DiscoverResult c ? new IPEndPoint( c.Address, c.ControlPortNo ) : null;
+			var backoff = ProbeBackoffMin;
+
+			using UdpClient udpClient = CreateDiscoveryClient( endPoint.Address, portNo );
 
 			while (true)
 			{
-				IPAddress address;
-				ushort controlPortNo;
-				ushort streamPortNo;
-
 				try
 				{
-					using UdpClient udpClient = new UdpClient( 0, AddressFamily.InterNetwork );
-					using var receiveCts = new CancellationTokenSource( TimeSpan.FromSeconds( 5 ) );
-					var receiveTask = udpClient.ReceiveAsync( receiveCts.Token );
+					if (cachedEndPoint != null)
+					{
+						await udpClient.SendAsync( MessagePing(), cachedEndPoint );
+					}
 
-					await udpClient.SendAsync( Encoding.ASCII.GetBytes( "CAM-ROVER:PROBE" ), endPoint );
+					await udpClient.SendAsync( probe, endPoint );
 
-					var receiveResult = await receiveTask;
-					var response = Encoding.ASCII.GetString( receiveResult.Buffer );
+					using var receiveCts = new CancellationTokenSource( backoff );
 
-					if (response.StartsWith( "CAM-ROVER:PROBE_MATCH:" ))
+					while (true)
 					{
-						address = receiveResult.RemoteEndPoint.Address;
-						var tokens = response.Split( ':' );
-						controlPortNo = ushort.Parse( tokens[2] );
-						streamPortNo = ushort.Parse( tokens[3] );
+						var receiveResult = await udpClient.ReceiveAsync( receiveCts.Token );
+						var response = Encoding.ASCII.GetString( receiveResult.Buffer );
+
+						if (ParseRecord( response, receiveResult.RemoteEndPoint.Address ) is DiscoverResult result)
+						{
+							SaveCachedEndpoint( result );
+							Capabilities = result.Capabilities ?? Capabilities;
 
-						return new DiscoverResult( address, controlPortNo, streamPortNo );
+							return result;
+						}
+
+						if (cached is DiscoverResult r && receiveResult.RemoteEndPoint.Equals( cachedEndPoint ) && Protocol.TryParseHeader( receiveResult.Buffer, out _, out var command ) && command == ProtocolCommand.Ack)
+						{
+							return r with { SessionToken = AckSessionToken( receiveResult.Buffer ) };
+						}
 					}
 				}
 				catch
 				{
 				}
 
-				await Task.Delay( TimeSpan.FromSeconds( 5 ) );
+				backoff = TimeSpan.FromTicks( Math.Min( backoff.Ticks * 2, ProbeBackoffMax.Ticks ) );
 			}
 		}
 
 
+		void UpdateSession( uint sessionToken )
+		{
+			if (sessionToken == 0 || sessionToken == m_sessionToken)
+			{
+				return;
+			}
+
+			// the rover restarted and lost what the app set up, a first connect has nothing to restore
+			m_isSessionChanged = m_sessionToken != 0;
+			m_sessionToken = sessionToken;
+		}
+
+
+		async Task SendState( UdpClient client, IPEndPoint ip )
+		{
+			await client.SendAsync( MessageMoveDeadzone(), ip );
+			await client.SendAsync( MessageCameraFlashMode(), ip );
+			await client.SendAsync( MessageCameraFlash(), ip );
+		}
+
+
 		async void Receiver( UdpClient client, CancellationToken cancellationToken )
 		{
 			while (!cancellationToken.IsCancellationRequested)
@@ -286,14 +566,12 @@ namespace CamRover.ControllerApp.Models
 				try
 				{
 					var receiveResult = await client.ReceiveAsync( cancellationToken );
+					Volatile.Write( ref m_lastAckTicks, Environment.TickCount64 );
 
-					//				 1
-					// 0 1234 5 6789 0123
-					if (receiveResult.Buffer.Length >= (receiveResult.Buffer[0] + 1))
+					if (AckMessage.TryParse( receiveResult.Buffer, out var ack ))
 					{
-						int l = (int)((uint)receiveResult.Buffer[6] | ((uint)receiveResult.Buffer[7] << 8) | ((uint)receiveResult.Buffer[8] << 16) | ((uint)receiveResult.Buffer[9] << 24));
-						int r = (int)((uint)receiveResult.Buffer[10] | ((uint)receiveResult.Buffer[11] << 8) | ((uint)receiveResult.Buffer[12] << 16) | ((uint)receiveResult.Buffer[13] << 24));
-						await OnSpeedReceive( l, r );
+						UpdateSession( ack.SessionToken );
+						await OnSpeedReceive( ack.Motor1, ack.Motor2 );
 					}
 				}
 				catch
@@ -316,20 +594,47 @@ namespace CamRover.ControllerApp.Models
 					var discoverResult = await Discover();
 					await OnDiscoveryComplete();
 
-					m_connectCommandEvent.WaitOne();
-					m_connectCommandEvent.Reset();
+					// once streaming, a lost link is resumed without waiting for the user
+					if (!m_isStreamingActive)
+					{
+						m_connectCommandEvent.WaitOne();
+						m_connectCommandEvent.Reset();
+					}
+
+					UpdateSession( discoverResult.SessionToken );
+					m_streamEndPoint = new IPEndPoint( discoverResult.Address, discoverResult.StreamPortNo );
 
-					m_isStreamingActive = true;
-					ThreadPool.QueueUserWorkItem( ( _ ) => StreamWorker( discoverResult.Address, discoverResult.StreamPortNo ) );
+					if (!m_isStreamingActive)
+					{
+						m_isStreamingActive = true;
+						ThreadPool.QueueUserWorkItem( ( _ ) => StreamWorker() );
+					}
 
 					using var controlUdpClient = new UdpClient( 0, AddressFamily.InterNetwork );
 					var ip = new IPEndPoint( discoverResult.Address, discoverResult.ControlPortNo );
 
+					Volatile.Write( ref m_lastAckTicks, Environment.TickCount64 );
 					ThreadPool.QueueUserWorkItem( ( _ ) => Receiver( controlUdpClient, receiverCts.Token ) );
 
 					while (true)
 					{
-						m_commEvent.WaitOne();
+						if (m_isSessionChanged)
+						{
+							m_isSessionChanged = false;
+							await SendState( controlUdpClient, ip );
+						}
+
+						if (Environment.TickCount64 - Volatile.Read( ref m_lastAckTicks ) > LinkTimeout.TotalMilliseconds)
+						{
+							throw new TimeoutException();
+						}
+
+						if (!m_commEvent.WaitOne( PingInterval ))
+						{
+							await controlUdpClient.SendAsync( MessagePing(), ip );
+							continue;
+						}
+
 						m_commEvent.Reset();
 
 						do
@@ -389,6 +694,18 @@ namespace CamRover.ControllerApp.Models
 										await controlUdpClient.SendAsync( MessageCameraFlash(), ip );
 									}
 									break;
+
+								case CommCommand.Autonomous:
+									{
+										await controlUdpClient.SendAsync( MessageMoveAutonomous(), ip );
+									}
+									break;
+
+								case CommCommand.FlashMode:
+									{
+										await controlUdpClient.SendAsync( MessageCameraFlashMode(), ip );
+									}
+									break;
 							}
 
 							await Task.Delay( TimeSpan.FromMilliseconds( 200 ) );
@@ -400,6 +717,9 @@ namespace CamRover.ControllerApp.Models
 						//}
 					}
 				}
+				catch (TimeoutException)
+				{
+				}
 				catch (Exception x)
 				{
 					await Task.Delay( TimeSpan.FromSeconds( 1 ) );
@@ -412,6 +732,7 @@ namespace CamRover.ControllerApp.Models
 
 		public void Init()
 		{
+			new Thread( () => m_playout.Run( this.Frames ) ) { IsBackground = true, Name = "FramePlayout" }.Start();
 			ThreadPool.QueueUserWorkItem( ( _ ) => Worker() );
 		}
 
@@ -0,0 +1,630 @@
+﻿/*
+ *	Copyright (c) 2025 Denis Rozhkov <denis@rozhkoff.com>
+ *	This file is part of cam-rover.
+ *
+ *	cam-rover is free software: you can redistribute it and/or
+ *	modify it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or (at your
+ *	option) any later version.
+ *
+ *	cam-rover is distributed in the hope that it will be
+ *	useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ *	Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along with
+ *	cam-rover. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+// generated by protocol/protogen.py from protocol/protocol.json, do not edit
+
+using System.Buffers.Binary;
+
+namespace CamRover.ControllerApp.Models
+{
+
+	enum ProtocolCommand : byte
+	{
+		Unknown = 0,
+		MoveSpeedUp = (byte)'+',
+		MoveSpeedDown = (byte)'-',
+		MoveTurnLeft = (byte)'l',
+		MoveTurnRight = (byte)'r',
+		MoveStop = (byte)'s',
+		MoveSet = (byte)'t',
+		MoveDeadzone = (byte)'z',
+		MoveAutonomous = (byte)'o',
+		CameraFlash = (byte)'f',
+		CameraFlashMode = (byte)'m',
+		Ping = (byte)'p',
+		Ack = (byte)'a'
+	}
+
+
+	enum ProtocolStreamType : byte
+	{
+		Frame = (byte)'F',
+		Tile = (byte)'T',
+		Chunk = (byte)'C',
+		Profile = (byte)'P'
+	}
+
+
+	// TryParse returns false unless data holds the whole message, Emit returns the length written or 0 if it
+	// does not fit
+	static class Protocol
+	{
+		public const int Version = 4;
+		public const int MessageHeaderLength = 6;
+		public const int StreamHeaderLength = 9;
+
+
+		public static bool TryParseHeader( ReadOnlySpan<byte> data, out uint id, out ProtocolCommand command )
+		{
+			if (data.Length < MessageHeaderLength || data[0] + 1 != data.Length)
+			{
+				id = 0;
+				command = ProtocolCommand.Unknown;
+
+				return false;
+			}
+
+			id = BinaryPrimitives.ReadUInt32LittleEndian( data.Slice( 1 ) );
+			command = (ProtocolCommand)data[5];
+
+			return true;
+		}
+
+
+		public static bool TryParseStreamHeader( ReadOnlySpan<byte> data, out ProtocolStreamType type, out long timestampUs )
+		{
+			if (data.Length < StreamHeaderLength)
+			{
+				type = 0;
+				timestampUs = 0;
+
+				return false;
+			}
+
+			type = (ProtocolStreamType)data[0];
+			timestampUs = BinaryPrimitives.ReadInt64LittleEndian( data.Slice( 1 ) );
+
+			return true;
+		}
+
+
+		// shortest message a command comes with, 0 for unknown commands
+		public static int CommandLength( ProtocolCommand command )
+		{
+			return command switch
+			{
+				ProtocolCommand.MoveSpeedUp => MoveSpeedMessage.Length,
+				ProtocolCommand.MoveSpeedDown => MoveSpeedMessage.Length,
+				ProtocolCommand.MoveTurnLeft => MoveSpeedMessage.Length,
+				ProtocolCommand.MoveTurnRight => MoveSpeedMessage.Length,
+				ProtocolCommand.MoveStop => MoveStopMessage.Length,
+				ProtocolCommand.MoveSet => MoveSetMessage.Length,
+				ProtocolCommand.MoveDeadzone => MoveDeadzoneMessage.Length,
+				ProtocolCommand.MoveAutonomous => MoveAutonomousMessage.Length,
+				ProtocolCommand.CameraFlash => CameraFlashMessage.Length,
+				ProtocolCommand.CameraFlashMode => CameraFlashModeMessage.Length,
+				ProtocolCommand.Ping => PingMessage.Length,
+				ProtocolCommand.Ack => StreamAckMessage.Length,
+				_ => 0
+			};
+		}
+
+
+		// fields added to a message later are ignored by older parsers, so only the known part has to be there
+		internal static bool TryParseMessage( ReadOnlySpan<byte> data, int length, out ProtocolCommand command )
+		{
+			return TryParseHeader( data, out _, out command ) && data.Length >= length;
+		}
+
+
+		internal static int EmitHeader( Span<byte> data, int length, uint id, ProtocolCommand command )
+		{
+			if (data.Length < length)
+			{
+				return 0;
+			}
+
+			data[0] = (byte)(length - 1);
+			BinaryPrimitives.WriteUInt32LittleEndian( data.Slice( 1 ), id );
+			data[5] = (byte)command;
+
+			return length;
+		}
+
+
+		internal static int EmitStreamHeader( Span<byte> data, int length, ProtocolStreamType type, long timestampUs )
+		{
+			if (data.Length < length)
+			{
+				return 0;
+			}
+
+			data[0] = (byte)type;
+			BinaryPrimitives.WriteInt64LittleEndian( data.Slice( 1 ), timestampUs );
+
+			return length;
+		}
+	}
+
+
+	// speed step, the command tells the direction
+	readonly record struct MoveSpeedMessage( byte Speed )
+	{
+		public const int Length = 7;
+
+
+		public static bool TryParse( ReadOnlySpan<byte> data, out MoveSpeedMessage message )
+		{
+			message = default;
+
+			if (!Protocol.TryParseMessage( data, Length, out var command ))
+			{
+				return false;
+			}
+
+			if (command != ProtocolCommand.MoveSpeedUp
+				&& command != ProtocolCommand.MoveSpeedDown
+				&& command != ProtocolCommand.MoveTurnLeft
+				&& command != ProtocolCommand.MoveTurnRight)
+			{
+				return false;
+			}
+
+			message = new MoveSpeedMessage( data[6] );
+
+			return true;
+		}
+
+
+		public int Emit( Span<byte> data, uint id, ProtocolCommand command )
+		{
+			if (Protocol.EmitHeader( data, Length, id, command ) == 0)
+			{
+				return 0;
+			}
+
+			data[6] = Speed;
+
+			return Length;
+		}
+	}
+
+
+	readonly record struct MoveStopMessage
+	{
+		public const int Length = 6;
+
+
+		public int Emit( Span<byte> data, uint id )
+		{
+			return Protocol.EmitHeader( data, Length, id, ProtocolCommand.MoveStop );
+		}
+	}
+
+
+	readonly record struct MoveSetMessage( int SpeedL, int SpeedR )
+	{
+		public const int Length = 14;
+
+
+		public static bool TryParse( ReadOnlySpan<byte> data, out MoveSetMessage message )
+		{
+			message = default;
+
+			if (!Protocol.TryParseMessage( data, Length, out var command ))
+			{
+				return false;
+			}
+
+			if (command != ProtocolCommand.MoveSet)
+			{
+				return false;
+			}
+
+			message = new MoveSetMessage( BinaryPrimitives.ReadInt32LittleEndian( data.Slice( 6 ) )
+				, BinaryPrimitives.ReadInt32LittleEndian( data.Slice( 10 ) )
+				);
+
+			return true;
+		}
+
+
+		public int Emit( Span<byte> data, uint id )
+		{
+			if (Protocol.EmitHeader( data, Length, id, ProtocolCommand.MoveSet ) == 0)
+			{
+				return 0;
+			}
+
+			BinaryPrimitives.WriteInt32LittleEndian( data.Slice( 6 ), SpeedL );
+			BinaryPrimitives.WriteInt32LittleEndian( data.Slice( 10 ), SpeedR );
+
+			return Length;
+		}
+	}
+
+
+	readonly record struct MoveDeadzoneMessage( uint Deadzone )
+	{
+		public const int Length = 10;
+
+
+		public static bool TryParse( ReadOnlySpan<byte> data, out MoveDeadzoneMessage message )
+		{
+			message = default;
+
+			if (!Protocol.TryParseMessage( data, Length, out var command ))
+			{
+				return false;
+			}
+
+			if (command != ProtocolCommand.MoveDeadzone)
+			{
+				return false;
+			}
+
+			message = new MoveDeadzoneMessage( BinaryPrimitives.ReadUInt32LittleEndian( data.Slice( 6 ) ) );
+
+			return true;
+		}
+
+
+		public int Emit( Span<byte> data, uint id )
+		{
+			if (Protocol.EmitHeader( data, Length, id, ProtocolCommand.MoveDeadzone ) == 0)
+			{
+				return 0;
+			}
+
+			BinaryPrimitives.WriteUInt32LittleEndian( data.Slice( 6 ), Deadzone );
+
+			return Length;
+		}
+	}
+
+
+	readonly record struct MoveAutonomousMessage( byte IsEnabled )
+	{
+		public const int Length = 7;
+
+
+		public static bool TryParse( ReadOnlySpan<byte> data, out MoveAutonomousMessage message )
+		{
+			message = default;
+
+			if (!Protocol.TryParseMessage( data, Length, out var command ))
+			{
+				return false;
+			}
+
+			if (command != ProtocolCommand.MoveAutonomous)
+			{
+				return false;
+			}
+
+			message = new MoveAutonomousMessage( data[6] );
+
+			return true;
+		}
+
+
+		public int Emit( Span<byte> data, uint id )
+		{
+			if (Protocol.EmitHeader( data, Length, id, ProtocolCommand.MoveAutonomous ) == 0)
+			{
+				return 0;
+			}
+
+			data[6] = IsEnabled;
+
+			return Length;
+		}
+	}
+
+
+	readonly record struct CameraFlashMessage( byte Duty )
+	{
+		public const int Length = 7;
+
+
+		public static bool TryParse( ReadOnlySpan<byte> data, out CameraFlashMessage message )
+		{
+			message = default;
+
+			if (!Protocol.TryParseMessage( data, Length, out var command ))
+			{
+				return false;
+			}
+
+			if (command != ProtocolCommand.CameraFlash)
+			{
+				return false;
+			}
+
+			message = new CameraFlashMessage( data[6] );
+
+			return true;
+		}
+
+
+		public int Emit( Span<byte> data, uint id )
+		{
+			if (Protocol.EmitHeader( data, Length, id, ProtocolCommand.CameraFlash ) == 0)
+			{
+				return 0;
+			}
+
+			data[6] = Duty;
+
+			return Length;
+		}
+	}
+
+
+	readonly record struct CameraFlashModeMessage( byte Mode )
+	{
+		public const int Length = 7;
+
+
+		public static bool TryParse( ReadOnlySpan<byte> data, out CameraFlashModeMessage message )
+		{
+			message = default;
+
+			if (!Protocol.TryParseMessage( data, Length, out var command ))
+			{
+				return false;
+			}
+
+			if (command != ProtocolCommand.CameraFlashMode)
+			{
+				return false;
+			}
+
+			message = new CameraFlashModeMessage( data[6] );
+
+			return true;
+		}
+
+
+		public int Emit( Span<byte> data, uint id )
+		{
+			if (Protocol.EmitHeader( data, Length, id, ProtocolCommand.CameraFlashMode ) == 0)
+			{
+				return 0;
+			}
+
+			data[6] = Mode;
+
+			return Length;
+		}
+	}
+
+
+	readonly record struct PingMessage
+	{
+		public const int Length = 6;
+
+
+		public int Emit( Span<byte> data, uint id )
+		{
+			return Protocol.EmitHeader( data, Length, id, ProtocolCommand.Ping );
+		}
+	}
+
+
+	// stream client keepalive, the rover streams to whoever sent it last
+	readonly record struct StreamAckMessage
+	{
+		public const int Length = 6;
+
+
+		public int Emit( Span<byte> data, uint id )
+		{
+			return Protocol.EmitHeader( data, Length, id, ProtocolCommand.Ack );
+		}
+	}
+
+
+	// motor speeds and rover time (us) right after the acknowledged command was applied
+	readonly record struct AckMessage( int Motor1, int Motor2, long AppliedUs, uint SessionToken )
+	{
+		public const int Length = 26;
+
+
+		public static bool TryParse( ReadOnlySpan<byte> data, out AckMessage message )
+		{
+			message = default;
+
+			if (!Protocol.TryParseMessage( data, Length, out var command ))
+			{
+				return false;
+			}
+
+			if (command != ProtocolCommand.Ack)
+			{
+				return false;
+			}
+
+			message = new AckMessage( BinaryPrimitives.ReadInt32LittleEndian( data.Slice( 6 ) )
+				, BinaryPrimitives.ReadInt32LittleEndian( data.Slice( 10 ) )
+				, BinaryPrimitives.ReadInt64LittleEndian( data.Slice( 14 ) )
+				, BinaryPrimitives.ReadUInt32LittleEndian( data.Slice( 22 ) )
+				);
+
+			return true;
+		}
+
+
+		public int Emit( Span<byte> data, uint id )
+		{
+			if (Protocol.EmitHeader( data, Length, id, ProtocolCommand.Ack ) == 0)
+			{
+				return 0;
+			}
+
+			BinaryPrimitives.WriteInt32LittleEndian( data.Slice( 6 ), Motor1 );
+			BinaryPrimitives.WriteInt32LittleEndian( data.Slice( 10 ), Motor2 );
+			BinaryPrimitives.WriteInt64LittleEndian( data.Slice( 14 ), AppliedUs );
+			BinaryPrimitives.WriteUInt32LittleEndian( data.Slice( 22 ), SessionToken );
+
+			return Length;
+		}
+	}
+
+
+	readonly record struct StreamFramePacket
+	{
+		public const int HeaderLength = 9;
+
+
+		public int Emit( Span<byte> data, long timestampUs )
+		{
+			return Protocol.EmitStreamHeader( data, HeaderLength, ProtocolStreamType.Frame, timestampUs );
+		}
+	}
+
+
+	// a full frame cut to datagram size, the capture timestamp identifies the frame
+	readonly record struct StreamChunkPacket( uint Offset, uint Length )
+	{
+		public const int HeaderLength = 17;
+
+
+		public static bool TryParse( ReadOnlySpan<byte> data, out StreamChunkPacket packet )
+		{
+			if (data.Length < HeaderLength || data[0] != (byte)ProtocolStreamType.Chunk)
+			{
+				packet = default;
+
+				return false;
+			}
+
+			packet = new StreamChunkPacket( BinaryPrimitives.ReadUInt32LittleEndian( data.Slice( 9 ) )
+				, BinaryPrimitives.ReadUInt32LittleEndian( data.Slice( 13 ) )
+				);
+
+			return true;
+		}
+
+
+		public int Emit( Span<byte> data, long timestampUs )
+		{
+			if (Protocol.EmitStreamHeader( data, HeaderLength, ProtocolStreamType.Chunk, timestampUs ) == 0)
+			{
+				return 0;
+			}
+
+			BinaryPrimitives.WriteUInt32LittleEndian( data.Slice( 9 ), Offset );
+			BinaryPrimitives.WriteUInt32LittleEndian( data.Slice( 13 ), Length );
+
+			return HeaderLength;
+		}
+	}
+
+
+	// a JPEG encoded rectangle of an RGB565 frame
+	readonly record struct StreamTilePacket( ushort FrameNo
+		, ushort X
+		, ushort Y
+		, ushort Width
+		, ushort Height
+		, ushort FrameWidth
+		, ushort FrameHeight
+		)
+	{
+		public const int HeaderLength = 23;
+
+
+		public static bool TryParse( ReadOnlySpan<byte> data, out StreamTilePacket packet )
+		{
+			if (data.Length < HeaderLength || data[0] != (byte)ProtocolStreamType.Tile)
+			{
+				packet = default;
+
+				return false;
+			}
+
+			packet = new StreamTilePacket( BinaryPrimitives.ReadUInt16LittleEndian( data.Slice( 9 ) )
+				, BinaryPrimitives.ReadUInt16LittleEndian( data.Slice( 11 ) )
+				, BinaryPrimitives.ReadUInt16LittleEndian( data.Slice( 13 ) )
+				, BinaryPrimitives.ReadUInt16LittleEndian( data.Slice( 15 ) )
+				, BinaryPrimitives.ReadUInt16LittleEndian( data.Slice( 17 ) )
+				, BinaryPrimitives.ReadUInt16LittleEndian( data.Slice( 19 ) )
+				, BinaryPrimitives.ReadUInt16LittleEndian( data.Slice( 21 ) )
+				);
+
+			return true;
+		}
+
+
+		public int Emit( Span<byte> data, long timestampUs )
+		{
+			if (Protocol.EmitStreamHeader( data, HeaderLength, ProtocolStreamType.Tile, timestampUs ) == 0)
+			{
+				return 0;
+			}
+
+			BinaryPrimitives.WriteUInt16LittleEndian( data.Slice( 9 ), FrameNo );
+			BinaryPrimitives.WriteUInt16LittleEndian( data.Slice( 11 ), X );
+			BinaryPrimitives.WriteUInt16LittleEndian( data.Slice( 13 ), Y );
+			BinaryPrimitives.WriteUInt16LittleEndian( data.Slice( 15 ), Width );
+			BinaryPrimitives.WriteUInt16LittleEndian( data.Slice( 17 ), Height );
+			BinaryPrimitives.WriteUInt16LittleEndian( data.Slice( 19 ), FrameWidth );
+			BinaryPrimitives.WriteUInt16LittleEndian( data.Slice( 21 ), FrameHeight );
+
+			return HeaderLength;
+		}
+	}
+
+
+	// CPU use over the window ending at the timestamp, permille of one core; followed by taskCount 21 byte records:
+	// name (16 bytes, NUL padded), load u16 (permille), core i8 (-1 not pinned), least free stack u16 (bytes)
+	readonly record struct StreamProfilePacket( uint WindowUs, ushort Core0Load, ushort Core1Load, byte TaskCount )
+	{
+		public const int HeaderLength = 18;
+
+
+		public static bool TryParse( ReadOnlySpan<byte> data, out StreamProfilePacket packet )
+		{
+			if (data.Length < HeaderLength || data[0] != (byte)ProtocolStreamType.Profile)
+			{
+				packet = default;
+
+				return false;
+			}
+
+			packet = new StreamProfilePacket( BinaryPrimitives.ReadUInt32LittleEndian( data.Slice( 9 ) )
+				, BinaryPrimitives.ReadUInt16LittleEndian( data.Slice( 13 ) )
+				, BinaryPrimitives.ReadUInt16LittleEndian( data.Slice( 15 ) )
+				, data[17]
+				);
+
+			return true;
+		}
+
+
+		public int Emit( Span<byte> data, long timestampUs )
+		{
+			if (Protocol.EmitStreamHeader( data, HeaderLength, ProtocolStreamType.Profile, timestampUs ) == 0)
+			{
+				return 0;
+			}
+
+			BinaryPrimitives.WriteUInt32LittleEndian( data.Slice( 9 ), WindowUs );
+			BinaryPrimitives.WriteUInt16LittleEndian( data.Slice( 13 ), Core0Load );
+			BinaryPrimitives.WriteUInt16LittleEndian( data.Slice( 15 ), Core1Load );
+			data[17] = TaskCount;
+
+			return HeaderLength;
+		}
+	}
+
+}
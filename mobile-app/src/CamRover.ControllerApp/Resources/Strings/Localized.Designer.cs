@@ -87,6 +87,15 @@ namespace CamRover.ControllerApp.Resources.Strings {
             }
         }
         
+        /// <summary>
+        ///   Looks up a localized string similar to Observer mode (smoother, more delay).
+        /// </summary>
+        internal static string Label_ObserverMode {
+            get {
+                return ResourceManager.GetString("Label_ObserverMode", resourceCulture);
+            }
+        }
+        
         /// <summary>
         ///   Looks up a localized string similar to Settings.
         /// </summary>
@@ -0,0 +1,103 @@
+﻿/*
+ *	Copyright (c) 2025 Denis Rozhkov <denis@rozhkoff.com>
+ *	This file is part of cam-rover.
+ *
+ *	cam-rover is free software: you can redistribute it and/or
+ *	modify it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or (at your
+ *	option) any later version.
+ *
+ *	cam-rover is distributed in the hope that it will be
+ *	useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ *	Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along with
+ *	cam-rover. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+using CamRover.ControllerApp.Models;
+
+namespace CamRover.ControllerApp.Types
+{
+
+	// joins chunk packets back into a full frame packet, see protocol.json; a frame that lost a chunk is
+	// dropped as soon as chunks of a newer frame arrive
+	public class FrameAssembler
+	{
+		const int StreamHeaderLength = Protocol.StreamHeaderLength;
+		const int ChunkHeaderLength = StreamChunkPacket.HeaderLength;
+		const int FrameLengthMax = 512 * 1024;
+		// capture timestamps further back than this mean the rover restarted
+		const long RestartGapUs = 5_000_000;
+
+
+		bool m_isAssembling;
+		long m_timestampUs;
+		int m_receivedLength;
+
+
+		public static bool IsChunk( byte[] packet, int length )
+		{
+			return length > ChunkHeaderLength && packet[0] == (byte)ProtocolStreamType.Chunk;
+		}
+
+
+		// assembles in place, returns true once the last chunk is in and frame holds a full frame packet
+		public bool Add( byte[] packet, int packetLength, FrameBuffer frame )
+		{
+			var data = packet.AsSpan( 0, packetLength );
+
+			if (!Protocol.TryParseStreamHeader( data, out _, out var timestampUs )
+				|| !StreamChunkPacket.TryParse( data, out var chunk )
+				|| chunk.Length > FrameLengthMax)
+			{
+				return false;
+			}
+
+			var offset = (int)chunk.Offset;
+			var length = (int)chunk.Length;
+			var chunkLength = packetLength - ChunkHeaderLength;
+
+			if (offset < 0 || offset + chunkLength > length)
+			{
+				return false;
+			}
+
+			if (!m_isAssembling || timestampUs != m_timestampUs)
+			{
+				bool isStale = timestampUs <= m_timestampUs && m_timestampUs - timestampUs < RestartGapUs;
+
+				if (isStale)
+				{
+					return false;
+				}
+
+				frame.Length = 0;
+				frame.EnsureCapacity( StreamHeaderLength + length );
+				frame.Data[0] = (byte)ProtocolStreamType.Frame;
+				Array.Copy( packet, 1, frame.Data, 1, StreamHeaderLength - 1 );
+				m_isAssembling = true;
+				m_timestampUs = timestampUs;
+				m_receivedLength = 0;
+			}
+
+			Array.Copy( packet, ChunkHeaderLength, frame.Data, StreamHeaderLength + offset, chunkLength );
+			m_receivedLength += chunkLength;
+
+			if (m_receivedLength < length)
+			{
+				return false;
+			}
+
+			frame.Length = StreamHeaderLength + length;
+			m_isAssembling = false;
+
+			return true;
+		}
+	}
+
+}
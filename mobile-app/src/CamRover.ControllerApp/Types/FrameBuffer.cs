@@ -0,0 +1,101 @@
+﻿/*
+ *	Copyright (c) 2025 Denis Rozhkov <denis@rozhkoff.com>
+ *	This file is part of cam-rover.
+ *
+ *	cam-rover is free software: you can redistribute it and/or
+ *	modify it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or (at your
+ *	option) any later version.
+ *
+ *	cam-rover is distributed in the hope that it will be
+ *	useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ *	Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along with
+ *	cam-rover. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+using System.Buffers;
+
+namespace CamRover.ControllerApp.Types
+{
+
+	// a stream packet on a pooled array, the stream over it is there so decoding allocates no stream either
+	public class FrameBuffer
+	{
+		byte[] m_data = Array.Empty<byte>();
+		MemoryStream m_stream = new MemoryStream( Array.Empty<byte>(), true );
+
+
+		public byte[] Data
+		{
+			get
+			{
+				return m_data;
+			}
+		}
+
+		public int Length
+		{
+			get; set;
+		}
+
+		// local time the packet was complete, see FramePlayout.NowUs
+		public long ArrivalUs
+		{
+			get; set;
+		}
+
+		// every stream packet carries the capture time right after its type
+		public long CaptureTimestampUs
+		{
+			get
+			{
+				return this.Length > 8 ? BitConverter.ToInt64( m_data, 1 ) : 0;
+			}
+		}
+
+
+		// keeps the content up to the current length
+		public void EnsureCapacity( int capacity )
+		{
+			if (capacity <= m_data.Length)
+			{
+				return;
+			}
+
+			var data = ArrayPool<byte>.Shared.Rent( capacity );
+			Array.Copy( m_data, data, this.Length );
+
+			if (m_data.Length > 0)
+			{
+				ArrayPool<byte>.Shared.Return( m_data );
+			}
+
+			m_data = data;
+			m_stream = new MemoryStream( m_data, 0, m_data.Length, true, true );
+		}
+
+
+		public void Set( byte[] packet, int length )
+		{
+			EnsureCapacity( length );
+			Array.Copy( packet, m_data, length );
+			this.Length = length;
+		}
+
+
+		public Stream GetStream( int offset )
+		{
+			m_stream.SetLength( this.Length );
+			m_stream.Position = offset;
+
+			return m_stream;
+		}
+	}
+
+}
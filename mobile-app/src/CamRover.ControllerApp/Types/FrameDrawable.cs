@@ -19,48 +19,226 @@
 // SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>
 // SPDX-License-Identifier: GPL-3.0-or-later
 
+using System.Collections.Concurrent;
+
 using Microsoft.Maui.Graphics.Platform;
 
+using CamRover.ControllerApp.Models;
+
 namespace CamRover.ControllerApp.Types
 {
 
 	public class FrameDrawable : IDrawable
 	{
+		// see protocol.json, every stream packet starts with the type and the capture timestamp
+		const int StreamHeaderLength = Protocol.StreamHeaderLength;
+		const int TilePacketHeaderLength = StreamTilePacket.HeaderLength;
+
+
+		readonly record struct Tile( int X, int Y, int Width, int Height, Microsoft.Maui.Graphics.IImage Image );
+
+
+		// swapped in whole by the decoder, Draw takes whatever is current and never waits for a decode;
+		// replaced images are disposed once no Draw can still be holding them
 		Microsoft.Maui.Graphics.IImage? m_image;
+		ConcurrentQueue<Microsoft.Maui.Graphics.IImage> m_retiredImages = new();
+		int m_drawCount;
+
+		// tiles persist between packets and together make up the frame, a tile is replaced when a newer
+		// version of it arrives
+		Dictionary<(int, int), Tile> m_tiles = new();
+		int m_tilesFrameWidth;
+		int m_tilesFrameHeight;
+
+
+		public static bool IsTile( byte[] packet )
+		{
+			return IsTile( packet, packet.Length );
+		}
+
+
+		public static bool IsTile( byte[] packet, int length )
+		{
+			return length > TilePacketHeaderLength && packet[0] == (byte)ProtocolStreamType.Tile;
+		}
+
+
+		public static bool IsFrame( byte[] packet, int length )
+		{
+			return length > StreamHeaderLength && packet[0] == (byte)ProtocolStreamType.Frame;
+		}
+
+
+		public static int TileFrameNo( byte[] packet )
+		{
+			return BitConverter.ToUInt16( packet, StreamHeaderLength );
+		}
+
+
+		public static long CaptureTimestampUs( byte[] packet )
+		{
+			return packet.Length >= StreamHeaderLength ? BitConverter.ToInt64( packet, 1 ) : 0;
+		}
 
 
 		public void Draw( ICanvas canvas, RectF dirtyRect )
 		{
-			if (m_image != null)
+			// counted before the image is read, see RetireImage
+			Interlocked.Increment( ref m_drawCount );
+
+			try
 			{
-				lock (this)
+				var image = Volatile.Read( ref m_image );
+
+				if (image != null)
+				{
+					canvas.Rotate( -90, dirtyRect.Width / 2, dirtyRect.Height / 2 );
+					var x = (dirtyRect.Width - image.Width) / 2;
+					var y = (dirtyRect.Height - image.Height) / 2;
+					canvas.DrawImage( image, x, y, image.Width, image.Height );
+
+					return;
+				}
+			}
+			catch
+			{
+			}
+			finally
+			{
+				Interlocked.Decrement( ref m_drawCount );
+			}
+
+			lock (this)
+			{
+				try
 				{
-					try
+					if (m_tiles.Count > 0)
 					{
 						canvas.Rotate( -90, dirtyRect.Width / 2, dirtyRect.Height / 2 );
-						var x = (dirtyRect.Width - m_image.Width) / 2;
-						var y = (dirtyRect.Height - m_image.Height) / 2;
-						canvas.DrawImage( m_image, x, y, m_image.Width, m_image.Height );
-					}
-					catch
-					{
+						var x = (dirtyRect.Width - m_tilesFrameWidth) / 2;
+						var y = (dirtyRect.Height - m_tilesFrameHeight) / 2;
+
+						foreach (var tile in m_tiles.Values)
+						{
+							canvas.DrawImage( tile.Image, x + tile.X, y + tile.Y, tile.Width, tile.Height );
+						}
 					}
 				}
+				catch
+				{
+				}
 			}
 		}
 
 
 		public void SetFrame( byte[] frame )
 		{
-			using (var stream = new MemoryStream( frame ))
+			if (IsTile( frame ))
+			{
+				SetTile( frame );
+				return;
+			}
+
+			int offset = frame.Length > StreamHeaderLength && frame[0] == (byte)ProtocolStreamType.Frame ? StreamHeaderLength : 0;
+
+			using (var stream = new MemoryStream( frame, offset, frame.Length - offset ))
+			{
+				SetImage( PlatformImage.FromStream( stream, ImageFormat.Jpeg ) );
+			}
+		}
+
+
+		// full frame packet on a pooled buffer, decoded on the caller's thread
+		public void SetFrame( FrameBuffer frame )
+		{
+			if (frame.Length <= StreamHeaderLength || frame.Data[0] != (byte)ProtocolStreamType.Frame)
+			{
+				return;
+			}
+
+			SetImage( PlatformImage.FromStream( frame.GetStream( StreamHeaderLength ), ImageFormat.Jpeg ) );
+		}
+
+
+		void SetImage( Microsoft.Maui.Graphics.IImage image )
+		{
+			RetireImage( Interlocked.Exchange( ref m_image, image ) );
+
+			if (m_tiles.Count > 0)
 			{
 				lock (this)
 				{
-					m_image?.Dispose();
-					m_image = PlatformImage.FromStream( stream, ImageFormat.Jpeg );
+					ClearTiles();
 				}
 			}
 		}
+
+
+		// a Draw that read the old image has raised the count before the exchange, one that starts after it
+		// reads the new image, so with no Draw running every retired image is free
+		void RetireImage( Microsoft.Maui.Graphics.IImage? image )
+		{
+			if (image != null)
+			{
+				m_retiredImages.Enqueue( image );
+			}
+
+			if (Volatile.Read( ref m_drawCount ) > 0)
+			{
+				return;
+			}
+
+			while (m_retiredImages.TryDequeue( out var retired ))
+			{
+				retired.Dispose();
+			}
+		}
+
+
+		void SetTile( byte[] packet )
+		{
+			if (!StreamTilePacket.TryParse( packet, out var tile ))
+			{
+				return;
+			}
+
+			var (_, x, y, width, height, frameWidth, frameHeight) = tile;
+
+			using (var stream = new MemoryStream( packet, TilePacketHeaderLength, packet.Length - TilePacketHeaderLength ))
+			{
+				var image = PlatformImage.FromStream( stream, ImageFormat.Jpeg );
+
+				lock (this)
+				{
+					if (frameWidth != m_tilesFrameWidth || frameHeight != m_tilesFrameHeight)
+					{
+						ClearTiles();
+						m_tilesFrameWidth = frameWidth;
+						m_tilesFrameHeight = frameHeight;
+					}
+
+					RetireImage( Interlocked.Exchange( ref m_image, null ) );
+
+					if (m_tiles.TryGetValue( (x, y), out var old ))
+					{
+						old.Image.Dispose();
+					}
+
+					m_tiles[(x, y)] = new Tile( x, y, width, height, image );
+				}
+			}
+		}
+
+
+		void ClearTiles()
+		{
+			foreach (var tile in m_tiles.Values)
+			{
+				tile.Image.Dispose();
+			}
+
+			m_tiles.Clear();
+		}
 	}
 
 }
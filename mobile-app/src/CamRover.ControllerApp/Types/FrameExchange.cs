@@ -0,0 +1,71 @@
+﻿/*
+ *	Copyright (c) 2025 Denis Rozhkov <denis@rozhkoff.com>
+ *	This file is part of cam-rover.
+ *
+ *	cam-rover is free software: you can redistribute it and/or
+ *	modify it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or (at your
+ *	option) any later version.
+ *
+ *	cam-rover is distributed in the hope that it will be
+ *	useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ *	Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along with
+ *	cam-rover. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+namespace CamRover.ControllerApp.Types
+{
+
+	// latest frame wins hand-off between the receiver and the decoder without locks: of three buffers the
+	// receiver fills one, one waits and the decoder works on the third; publishing swaps the filled buffer
+	// with the waiting one, so a frame the decoder has not taken yet is simply overwritten by a newer one
+	public class FrameExchange
+	{
+		FrameBuffer m_back = new FrameBuffer();
+		FrameBuffer m_pending = new FrameBuffer();
+		FrameBuffer m_front = new FrameBuffer();
+		AutoResetEvent m_published = new AutoResetEvent( false );
+
+
+		// the receiver side buffer, only valid until Publish
+		public FrameBuffer Back
+		{
+			get
+			{
+				return m_back;
+			}
+		}
+
+
+		public void Publish()
+		{
+			m_back = Interlocked.Exchange( ref m_pending, m_back );
+			// the buffer coming back is either consumed or a frame nobody wanted anymore
+			m_back.Length = 0;
+			m_published.Set();
+		}
+
+
+		// decoder side, the buffer stays valid until the next call
+		public FrameBuffer? Take( TimeSpan timeout )
+		{
+			m_front.Length = 0;
+
+			if (Volatile.Read( ref m_pending ).Length == 0 && !m_published.WaitOne( timeout ))
+			{
+				return null;
+			}
+
+			m_front = Interlocked.Exchange( ref m_pending, m_front );
+
+			return m_front.Length > 0 ? m_front : null;
+		}
+	}
+
+}
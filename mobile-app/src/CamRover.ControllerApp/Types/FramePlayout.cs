@@ -0,0 +1,251 @@
+﻿/*
+ *	Copyright (c) 2025 Denis Rozhkov <denis@rozhkoff.com>
+ *	This file is part of cam-rover.
+ *
+ *	cam-rover is free software: you can redistribute it and/or
+ *	modify it under the terms of the GNU General Public License as published by
+ *	the Free Software Foundation, either version 3 of the License, or (at your
+ *	option) any later version.
+ *
+ *	cam-rover is distributed in the hope that it will be
+ *	useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ *	Public License for more details.
+ *
+ *	You should have received a copy of the GNU General Public License along with
+ *	cam-rover. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+using System.Collections.Concurrent;
+using System.Diagnostics;
+
+namespace CamRover.ControllerApp.Types
+{
+
+	// jitter buffer between the receiver and the decoder; a frame is played at its capture time plus the
+	// fastest transit seen lately plus a target delay, and skipped when the frame after it is already due, so
+	// bunched arrivals are spread out or dropped instead of drawn back to back
+	public class FramePlayout
+	{
+		const int PoolSize = 8;
+		const int WindowLength = 64;
+		const int JitterPercentile = 95;
+		// observer mode delay on top of the measured jitter and its upper bound
+		const long ObserverMarginUs = 5_000;
+		const long ObserverTargetMaxUs = 300_000;
+		// transit changes beyond this mean a clock jumped (the rover restarted), the estimate starts over
+		const long ResetGapUs = 2_000_000;
+		static readonly TimeSpan IdleWait = TimeSpan.FromMilliseconds( 100 );
+
+
+		Stopwatch m_clock = Stopwatch.StartNew();
+		ConcurrentQueue<FrameBuffer> m_free = new();
+		ConcurrentQueue<FrameBuffer> m_arrived = new();
+		AutoResetEvent m_arrivedEvent = new AutoResetEvent( false );
+		int m_allocatedCount;
+
+		// playout thread only
+		List<FrameBuffer> m_queue = new List<FrameBuffer>( PoolSize );
+		long[] m_transits = new long[WindowLength];
+		long[] m_sorted = new long[WindowLength];
+		int m_transitCount;
+		int m_transitPos;
+		long m_baseTransitUs;
+		long m_lastPlayedUs;
+
+		long m_jitterUs;
+		long m_targetUs;
+		int m_skippedCount;
+
+
+		// near zero delay when false, only frames overtaken by newer ones are skipped
+		public bool IsObserverMode
+		{
+			get; set;
+		}
+
+		public int JitterMs
+		{
+			get
+			{
+				return (int)(Interlocked.Read( ref m_jitterUs ) / 1000);
+			}
+		}
+
+		public int TargetMs
+		{
+			get
+			{
+				return (int)(Interlocked.Read( ref m_targetUs ) / 1000);
+			}
+		}
+
+		public int SkippedCount
+		{
+			get
+			{
+				return Volatile.Read( ref m_skippedCount );
+			}
+		}
+
+
+		public long NowUs()
+		{
+			return m_clock.Elapsed.Ticks / (TimeSpan.TicksPerMillisecond / 1000);
+		}
+
+
+		// receiver side, null when every buffer is queued; the frame that would have gone there is skipped
+		public FrameBuffer? Rent()
+		{
+			if (m_free.TryDequeue( out var frame ))
+			{
+				return frame;
+			}
+
+			if (Interlocked.Increment( ref m_allocatedCount ) <= PoolSize)
+			{
+				return new FrameBuffer();
+			}
+
+			Interlocked.Decrement( ref m_allocatedCount );
+			Interlocked.Increment( ref m_skippedCount );
+
+			return null;
+		}
+
+
+		public void Add( FrameBuffer frame )
+		{
+			frame.ArrivalUs = NowUs();
+			m_arrived.Enqueue( frame );
+			m_arrivedEvent.Set();
+		}
+
+
+		// plays frames into output until the process ends
+		public void Run( FrameExchange output )
+		{
+			while (true)
+			{
+				while (m_arrived.TryDequeue( out var arrived ))
+				{
+					Insert( arrived );
+				}
+
+				var waitUs = -1L;
+				var nowUs = NowUs();
+
+				while (m_queue.Count > 0)
+				{
+					var frame = m_queue[0];
+
+					if (m_queue.Count > 1 && PlayAtUs( m_queue[1] ) <= nowUs)
+					{
+						Skip( frame );
+						continue;
+					}
+
+					var playAtUs = PlayAtUs( frame );
+
+					if (playAtUs > nowUs)
+					{
+						waitUs = playAtUs - nowUs;
+						break;
+					}
+
+					m_queue.RemoveAt( 0 );
+					m_lastPlayedUs = frame.CaptureTimestampUs;
+					output.Back.Set( frame.Data, frame.Length );
+					output.Publish();
+					Release( frame );
+				}
+
+				m_arrivedEvent.WaitOne( waitUs < 0 ? IdleWait : TimeSpan.FromTicks( waitUs * 10 ) );
+			}
+		}
+
+
+		long PlayAtUs( FrameBuffer frame )
+		{
+			return frame.CaptureTimestampUs + m_baseTransitUs + m_targetUs;
+		}
+
+
+		void Insert( FrameBuffer frame )
+		{
+			var timestampUs = frame.CaptureTimestampUs;
+
+			if (timestampUs <= m_lastPlayedUs && m_lastPlayedUs - timestampUs < ResetGapUs)
+			{
+				// older than what is on screen already
+				Skip( frame );
+				return;
+			}
+
+			Measure( frame.ArrivalUs - timestampUs );
+
+			var i = m_queue.Count;
+
+			while (i > 0 && m_queue[i - 1].CaptureTimestampUs > timestampUs)
+			{
+				i--;
+			}
+
+			m_queue.Insert( i, frame );
+		}
+
+
+		// the fastest transit in the window stands for the clock offset, how much later than that frames
+		// arrive is the jitter
+		void Measure( long transitUs )
+		{
+			if (m_transitCount > 0 && Math.Abs( transitUs - m_baseTransitUs ) > ResetGapUs)
+			{
+				m_transitCount = 0;
+				m_transitPos = 0;
+				m_lastPlayedUs = 0;
+			}
+
+			m_transits[m_transitPos] = transitUs;
+			m_transitPos = (m_transitPos + 1) % WindowLength;
+			m_transitCount = Math.Min( m_transitCount + 1, WindowLength );
+
+			Array.Copy( m_transits, m_sorted, m_transitCount );
+			Array.Sort( m_sorted, 0, m_transitCount );
+
+			m_baseTransitUs = m_sorted[0];
+			var jitterUs = m_sorted[(m_transitCount - 1) * JitterPercentile / 100] - m_baseTransitUs;
+			var targetUs = 0L;
+
+			if (this.IsObserverMode)
+			{
+				// grows at once, shrinks slowly so one quiet second does not bring the stutter back
+				var wantedUs = Math.Min( jitterUs + ObserverMarginUs, ObserverTargetMaxUs );
+				targetUs = wantedUs > m_targetUs ? wantedUs : m_targetUs - (m_targetUs - wantedUs) / 16;
+			}
+
+			Interlocked.Exchange( ref m_jitterUs, jitterUs );
+			Interlocked.Exchange( ref m_targetUs, targetUs );
+		}
+
+
+		void Skip( FrameBuffer frame )
+		{
+			m_queue.Remove( frame );
+			Interlocked.Increment( ref m_skippedCount );
+			Release( frame );
+		}
+
+
+		void Release( FrameBuffer frame )
+		{
+			frame.Length = 0;
+			m_free.Enqueue( frame );
+		}
+	}
+
+}
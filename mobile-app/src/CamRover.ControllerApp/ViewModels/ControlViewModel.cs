@@ -96,6 +96,16 @@ namespace CamRover.ControllerApp.ViewModels
 			get;
 		}
 
+		public RelayCommand FlashModeCommand
+		{
+			get;
+		}
+
+		public RelayCommand AutonomousCommand
+		{
+			get;
+		}
+
 		volatile bool m_isConnected;
 		public bool IsConnected
 		{
@@ -150,6 +160,32 @@ namespace CamRover.ControllerApp.ViewModels
 			}
 		}
 
+		public string FlashModeGlyph
+		{
+			get
+			{
+				switch (m_comm.CameraFlashMode)
+				{
+					case 1:
+						return Fonts.FluentUI.flash_16_regular;
+
+					case 2:
+						return Fonts.FluentUI.flash_auto_20_regular;
+
+					default:
+						return Fonts.FluentUI.flashlight_16_regular;
+				}
+			}
+		}
+
+		public bool IsAutonomous
+		{
+			get
+			{
+				return m_comm.IsAutonomous;
+			}
+		}
+
 		int m_speedL;
 		public int SpeedL
 		{
@@ -192,6 +228,35 @@ namespace CamRover.ControllerApp.ViewModels
 			}
 		}
 
+		// measured jitter and the playout delay that covers it, ms
+		string m_jitter = string.Empty;
+		public string Jitter
+		{
+			get
+			{
+				return m_jitter;
+			}
+			set
+			{
+				m_jitter = value;
+				RaisePropertyChanged();
+			}
+		}
+
+		int m_skipped;
+		public int Skipped
+		{
+			get
+			{
+				return m_skipped;
+			}
+			set
+			{
+				m_skipped = value;
+				RaisePropertyChanged();
+			}
+		}
+
 
 		public ControlViewModel( CommModel comm )
 		{
@@ -202,6 +267,9 @@ namespace CamRover.ControllerApp.ViewModels
 			m_comm.FrameReceived += comm_FrameReceived;
 			m_comm.SpeedUpdated += comm_SpeedUpdated;
 			m_comm.FpsUpdated += comm_FpsUpdated;
+			m_comm.PlayoutUpdated += comm_PlayoutUpdated;
+
+			new Thread( DecodeWorker ) { IsBackground = true, Name = "FrameDecoder" }.Start();
 
 			this.StartStreamingCommand = new RelayCommand(
 				() =>
@@ -268,7 +336,9 @@ namespace CamRover.ControllerApp.ViewModels
 			this.StopCommand = new RelayCommand(
 				() =>
 				{
+					m_comm.IsAutonomous = false;
 					m_comm.SendCommand( CommCommand.Stop );
+					RaisePropertyChanged( nameof( this.IsAutonomous ) );
 				} );
 
 			this.CenterCommand = new RelayCommand(
@@ -279,6 +349,22 @@ namespace CamRover.ControllerApp.ViewModels
 					m_comm.SpeedR = s / 2;
 					m_comm.SendCommand( CommCommand.Set );
 				} );
+
+			this.AutonomousCommand = new RelayCommand(
+				() =>
+				{
+					m_comm.IsAutonomous = !m_comm.IsAutonomous;
+					m_comm.SendCommand( CommCommand.Autonomous );
+					RaisePropertyChanged( nameof( this.IsAutonomous ) );
+				} );
+
+			this.FlashModeCommand = new RelayCommand(
+				() =>
+				{
+					m_comm.CameraFlashMode = (m_comm.CameraFlashMode + 1) % 3;
+					m_comm.SendCommand( CommCommand.FlashMode );
+					RaisePropertyChanged( nameof( this.FlashModeGlyph ) );
+				} );
 		}
 
 
@@ -288,6 +374,13 @@ namespace CamRover.ControllerApp.ViewModels
 		}
 
 
+		private async Task comm_PlayoutUpdated( int jitterMs, int targetMs, int skippedCount )
+		{
+			this.Jitter = $"{jitterMs}/{targetMs}";
+			this.Skipped = skippedCount;
+		}
+
+
 		private async Task comm_SpeedUpdated( int l, int r )
 		{
 			this.SpeedL = l;
@@ -302,13 +395,40 @@ namespace CamRover.ControllerApp.ViewModels
 		}
 
 
+		// decodes off the network thread, a frame that arrives while one is decoded replaces any still waiting
+		void DecodeWorker()
+		{
+			while (true)
+			{
+				var frame = m_comm.Frames.Take( Timeout.InfiniteTimeSpan );
+
+				if (frame == null)
+				{
+					continue;
+				}
+
+				try
+				{
+					this.FrameDrawable.SetFrame( frame );
+				}
+				catch
+				{
+					continue;
+				}
+
+				m_dispatcher( m_refreshFrame );
+			}
+		}
+
+
 		private async Task comm_Discovered()
 		{
 			await m_dispatcher(
 				() =>
 				{
+					// a resumed link keeps streaming
 					this.CanConnect = true;
-					this.IsConnected = false;
+					this.IsConnected = m_comm.IsStreamingActive;
 					this.StartStreamingCommand.NotifyCanExecuteChanged();
 				}
 			);
@@ -321,7 +441,7 @@ namespace CamRover.ControllerApp.ViewModels
 				() =>
 				{
 					this.CanConnect = false;
-					this.IsConnected = false;
+					this.IsConnected = m_comm.IsStreamingActive;
 					this.StartStreamingCommand.NotifyCanExecuteChanged();
 				} );
 		}
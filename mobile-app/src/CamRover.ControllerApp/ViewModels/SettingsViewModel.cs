@@ -55,6 +55,19 @@ namespace CamRover.ControllerApp.ViewModels
 			}
 		}
 
+		public bool IsObserverMode
+		{
+			get
+			{
+				return m_comm.IsObserverMode;
+			}
+			set
+			{
+				m_comm.IsObserverMode = value;
+				RaisePropertyChanged();
+			}
+		}
+
 
 		public SettingsViewModel( CommModel comm )
 		{
@@ -0,0 +1,991 @@
+#!/usr/bin/env python3
+#
+#	Copyright (c) 2025 Denis Rozhkov <denis@rozhkoff.com>
+#	This file is part of cam-rover.
+#
+#	cam-rover is free software: you can redistribute it and/or
+#	modify it under the terms of the GNU General Public License as published by
+#	the Free Software Foundation, either version 3 of the License, or (at your
+#	option) any later version.
+#
+#	cam-rover is distributed in the hope that it will be
+#	useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+#	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+#	Public License for more details.
+#
+#	You should have received a copy of the GNU General Public License along with
+#	cam-rover. If not, see <https://www.gnu.org/licenses/>.
+#
+
+# SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>
+# SPDX-License-Identifier: GPL-3.0-or-later
+
+# Wire protocol code generator.
+#
+# protocol.json is the only definition of the control messages and stream packet headers, this script turns it
+# into the firmware codec (main/comm_protocol.h, .c) and the app codec (Models/Protocol.cs):
+#
+#   protogen.py            regenerate, files that did not change are left alone
+#   protogen.py --check    fail if a generated file is stale or corpus.json does not round trip
+#
+# The firmware build runs it on configure. corpus.json holds encoded messages both codecs have to agree on,
+# the check decodes and re-encodes every entry with the reference codec below, which follows the same rules
+# as the generated ones: little endian, fixed layouts, trailing bytes after the known fields are ignored so a
+# newer peer can append fields. It then builds small runners around the generated C codec (if a C compiler is
+# found) and C# codec (if dotnet is) and expects the same results from them.
+
+import argparse
+import json
+import os
+import shutil
+import struct
+import subprocess
+import sys
+import tempfile
+import textwrap
+
+
+ROOT = os.path.dirname( os.path.dirname( os.path.abspath( __file__ ) ) )
+SCHEMA_PATH = os.path.join( ROOT, 'protocol', 'protocol.json' )
+CORPUS_PATH = os.path.join( ROOT, 'protocol', 'corpus.json' )
+C_HEADER_PATH = os.path.join( ROOT, 'firmware', 'esp32', 'main', 'comm_protocol.h' )
+C_SOURCE_PATH = os.path.join( ROOT, 'firmware', 'esp32', 'main', 'comm_protocol.c' )
+CS_PATH = os.path.join( ROOT, 'mobile-app', 'src', 'CamRover.ControllerApp', 'Models', 'Protocol.cs' )
+
+# 0 - payload length (message length - 1), 1-4 - message ID, 5 - command
+MESSAGE_HEADER_LEN = 6
+# 0 - packet type, 1-8 - capture timestamp
+STREAM_HEADER_LEN = 9
+
+TYPES = {
+	# struct, C, C# type, C# reader / writer suffix
+	'u8': ( 'B', 'uint8_t', 'byte', None ),
+	'u16': ( 'H', 'uint16_t', 'ushort', 'UInt16' ),
+	'u32': ( 'I', 'uint32_t', 'uint', 'UInt32' ),
+	'i32': ( 'i', 'int32_t', 'int', 'Int32' ),
+	'i64': ( 'q', 'int64_t', 'long', 'Int64' ),
+}
+
+LICENSE = '''
+	Copyright (c) 2025 Denis Rozhkov <denis@rozhkoff.com>
+	This file is part of cam-rover.
+
+	cam-rover is free software: you can redistribute it and/or
+	modify it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or (at your
+	option) any later version.
+
+	cam-rover is distributed in the hope that it will be
+	useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+	Public License for more details.
+
+	You should have received a copy of the GNU General Public License along with
+	cam-rover. If not, see <https://www.gnu.org/licenses/>.
+'''.strip( '\n' ).split( '\n' )
+
+GENERATED = 'generated by protocol/protogen.py from protocol/protocol.json, do not edit'
+
+
+def license_block( prefix ):
+	lines = [ '/*' ] + [ ( ' *' + line ).rstrip() for line in LICENSE ] + [ ' */', '' ]
+	lines += [ f'{prefix} SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>',
+		f'{prefix} SPDX-License-Identifier: GPL-3.0-or-later', '' ]
+
+	return lines
+
+
+def camel( name ):
+	return ''.join( p[:1].upper() + p[1:] for p in name.lower().split( '_' ) )
+
+
+def pascal( name ):
+	return name[:1].upper() + name[1:]
+
+
+# tabs count as 4 columns, as in the rest of the tree
+def doc_comment( doc, prefix, width = 120 ):
+	indent = prefix.count( '\t' ) * 3
+
+	return [ prefix + line for line in textwrap.wrap( doc, width - len( prefix ) - indent ) ]
+
+
+def fields_len( fields ):
+	return sum( struct.calcsize( '<' + TYPES[t][0] ) for _, t in fields )
+
+
+def layout( fields, start ):
+	offset = start
+
+	for name, t in fields:
+		yield name, t, offset
+		offset += struct.calcsize( '<' + TYPES[t][0] )
+
+
+def load_schema():
+	with open( SCHEMA_PATH ) as f:
+		schema = json.load( f )
+
+	names = set()
+
+	for message in schema['messages'] + schema['streamPackets']:
+		if message['name'] in names:
+			raise ValueError( f'duplicate message {message["name"]}' )
+
+		names.add( message['name'] )
+
+		for _, t in message['fields']:
+			if t not in TYPES:
+				raise ValueError( f'{message["name"]}: unknown type {t}' )
+
+	for message in schema['messages']:
+		for command in message['commands']:
+			if command not in schema['commands']:
+				raise ValueError( f'{message["name"]}: unknown command {command}' )
+
+		if MESSAGE_HEADER_LEN + fields_len( message['fields'] ) > 256:
+			raise ValueError( f'{message["name"]}: does not fit the length byte' )
+
+	for packet in schema['streamPackets']:
+		if packet['type'] not in schema['streamTypes']:
+			raise ValueError( f'{packet["name"]}: unknown stream type {packet["type"]}' )
+
+	return schema
+
+
+#
+# reference codec
+#
+
+def encode_message( schema, name, messageId, fields, command = None ):
+	message = next( m for m in schema['messages'] if m['name'] == name )
+	command = command or message['commands'][0]
+	body = struct.pack( '<IB', messageId, ord( schema['commands'][command] ) )
+	body += b''.join( struct.pack( '<' + TYPES[t][0], fields[n] ) for n, t in message['fields'] )
+
+	return bytes( [ len( body ) ] ) + body
+
+
+def decode_message( schema, name, data ):
+	message = next( m for m in schema['messages'] if m['name'] == name )
+
+	if len( data ) < MESSAGE_HEADER_LEN or data[0] + 1 != len( data ):
+		return None
+
+	messageId, command = struct.unpack_from( '<IB', data, 1 )
+	commands = { ord( schema['commands'][c] ): c for c in message['commands'] }
+
+	if command not in commands or len( data ) < MESSAGE_HEADER_LEN + fields_len( message['fields'] ):
+		return None
+
+	fields = { n: struct.unpack_from( '<' + TYPES[t][0], data, o )[0]
+		for n, t, o in layout( message['fields'], MESSAGE_HEADER_LEN ) }
+
+	return messageId, commands[command], fields
+
+
+def encode_packet( schema, name, timestampUs, fields ):
+	packet = next( p for p in schema['streamPackets'] if p['name'] == name )
+	data = struct.pack( '<Bq', ord( schema['streamTypes'][packet['type']] ), timestampUs )
+
+	return data + b''.join( struct.pack( '<' + TYPES[t][0], fields[n] ) for n, t in packet['fields'] )
+
+
+def decode_packet( schema, name, data ):
+	packet = next( p for p in schema['streamPackets'] if p['name'] == name )
+
+	if len( data ) < STREAM_HEADER_LEN + fields_len( packet['fields'] ) or \
+		data[0] != ord( schema['streamTypes'][packet['type']] ):
+		return None
+
+	fields = { n: struct.unpack_from( '<' + TYPES[t][0], data, o )[0]
+		for n, t, o in layout( packet['fields'], STREAM_HEADER_LEN ) }
+
+	return struct.unpack_from( '<q', data, 1 )[0], fields
+
+
+def check_corpus( schema ):
+	with open( CORPUS_PATH ) as f:
+		corpus = json.load( f )
+
+	errors = []
+
+	for i, entry in enumerate( corpus ):
+		data = bytes.fromhex( entry['bytes'] )
+		isValid = entry.get( 'valid', True )
+		where = f'corpus entry {i} ({entry.get( "message", entry.get( "packet" ) )})'
+
+		if 'message' in entry:
+			decoded = decode_message( schema, entry['message'], data )
+			expected = None if not isValid else ( entry['id'], entry['command'], entry['fields'] )
+		else:
+			decoded = decode_packet( schema, entry['packet'], data )
+			expected = None if not isValid else ( entry['timestampUs'], entry['fields'] )
+
+		if decoded != expected:
+			errors.append( f'{where}: decoded {decoded}, expected {expected}' )
+			continue
+
+		if not isValid or entry.get( 'extended' ):
+			continue
+
+		if 'message' in entry:
+			encoded = encode_message( schema, entry['message'], entry['id'], entry['fields'], entry['command'] )
+		else:
+			encoded = encode_packet( schema, entry['packet'], entry['timestampUs'], entry['fields'] )
+
+		if encoded != data:
+			errors.append( f'{where}: encoded {encoded.hex()}, expected {data.hex()}' )
+
+	return len( corpus ), errors
+
+
+#
+# corpus runners, the generated codecs built on the host and fed the same corpus
+#
+
+# one line per corpus entry: "-" if parsing fails, otherwise the decoded values and the re-encoded bytes
+def runner_input( corpus ):
+	return ''.join( f'{"M" if "message" in e else "P"} {e.get( "message", e.get( "packet" ) )} {e["bytes"]}\n'
+		for e in corpus )
+
+
+def runner_expected( schema, corpus ):
+	lines = []
+
+	for entry in corpus:
+		data = bytes.fromhex( entry['bytes'] )
+
+		if 'message' in entry:
+			decoded = decode_message( schema, entry['message'], data )
+
+			if decoded is None:
+				lines.append( '-' )
+				continue
+
+			messageId, command, fields = decoded
+			encoded = encode_message( schema, entry['message'], messageId, fields, command )
+			values = [ messageId, ord( schema['commands'][command] ) ] + list( fields.values() )
+		else:
+			decoded = decode_packet( schema, entry['packet'], data )
+
+			if decoded is None:
+				lines.append( '-' )
+				continue
+
+			timestampUs, fields = decoded
+			encoded = encode_packet( schema, entry['packet'], timestampUs, fields )
+			values = [ timestampUs ] + list( fields.values() )
+
+		lines.append( ' '.join( str( v ) for v in values ) + ' | ' + encoded.hex() )
+
+	return lines
+
+
+def generate_c_runner( schema ):
+	out = [ '#include <inttypes.h>', '#include <stdio.h>', '#include <string.h>', '', '#include "comm_protocol.h"',
+		'', '', 'static uint8_t out[512];', '', '',
+		'static int run( char kind, const char * name, const uint8_t * data, size_t len )', '{',
+		'\tt_rover_comm_header header;', '\tt_rover_comm_stream_header streamHeader;', '\tsize_t outLen;', '' ]
+
+	keyword = 'if'
+
+	for message in schema['messages']:
+		name = c_name( message )
+		fields = message['fields']
+		commands = ' || '.join( f'header.command == ROVER_COMM_COMMAND_{c}' for c in message['commands'] )
+		out += [ f'\t{keyword} (kind == \'M\' && strcmp( name, "{name}" ) == 0) {{' ]
+
+		if fields:
+			out += [ f'\t\tt_rover_comm_{name} message;', '',
+				'\t\tif (!rover_comm_parse_header( data, len, &header ) ||',
+				f'\t\t\t!rover_comm_parse_{name}( data, len, &message )) {{', '', '\t\t\treturn 0;', '\t\t}', '' ]
+		else:
+			out += [ '\t\tif (!rover_comm_parse_header( data, len, &header ) ||',
+				f'\t\t\tlen < ROVER_COMM_{name.upper()}_LEN || !({commands})) {{', '', '\t\t\treturn 0;', '\t\t}', '' ]
+
+		command = ', header.command' if len( message['commands'] ) > 1 else ''
+		source = ', &message' if fields else ''
+		out += [ '\t\tprintf( "%" PRIu32 " %d", header.id, (int)header.command );' ]
+		out += [ f'\t\tprintf( " %lld", (long long)message.{n} );' for n, _ in fields ]
+		out += [ f'\t\toutLen = rover_comm_emit_{name}( out, sizeof( out ), header.id{command}{source} );', '\t}' ]
+		keyword = 'else if'
+
+	for packet in schema['streamPackets']:
+		name = c_stream_name( packet )
+		fields = packet['fields']
+		out += [ f'\telse if (kind == \'P\' && strcmp( name, "{packet["name"]}" ) == 0) {{' ]
+
+		if fields:
+			out += [ f'\t\tt_rover_comm_{name} packet;', '',
+				'\t\tif (!rover_comm_parse_stream_header( data, len, &streamHeader ) ||',
+				f'\t\t\t!rover_comm_parse_{name}( data, len, &packet )) {{', '', '\t\t\treturn 0;', '\t\t}', '' ]
+		else:
+			out += [ '\t\tif (!rover_comm_parse_stream_header( data, len, &streamHeader ) ||',
+				f'\t\t\tstreamHeader.type != ROVER_COMM_STREAM_{packet["type"]} || '
+				f'len < ROVER_COMM_{name.upper()}_HEADER_LEN) {{', '', '\t\t\treturn 0;', '\t\t}', '' ]
+
+		source = ', &packet' if fields else ''
+		out += [ '\t\tprintf( "%" PRId64, streamHeader.timestampUs );' ]
+		out += [ f'\t\tprintf( " %lld", (long long)packet.{n} );' for n, _ in fields ]
+		out += [ f'\t\toutLen = rover_comm_emit_{name}( out, sizeof( out ), streamHeader.timestampUs{source} );',
+			'\t}' ]
+
+	out += [ '\telse {', '\t\treturn 0;', '\t}', '', '\tprintf( " |" );', '',
+		'\tfor (size_t i = 0; i < outLen; ++i) {', '\t\tprintf( i == 0 ? " %02x" : "%02x", out[i] );', '\t}', '',
+		'\treturn 1;', '}', '', '',
+		'int main( void )', '{', '\tchar line[2048];', '\tchar name[64];', '\tchar hex[1024];', '\tuint8_t data[512];',
+		'\tchar kind;', '',
+		'\twhile (fgets( line, sizeof( line ), stdin ) != NULL) {',
+		'\t\tif (sscanf( line, "%c %63s %1023s", &kind, name, hex ) != 3) {', '\t\t\tcontinue;', '\t\t}', '',
+		'\t\tsize_t len = 0;', '',
+		'\t\tfor (const char * p = hex; p[0] != 0 && p[1] != 0 && len < sizeof( data ); p += 2) {',
+		'\t\t\tunsigned int byte;', '', '\t\t\tsscanf( p, "%2x", &byte );', '\t\t\tdata[len++] = (uint8_t)byte;',
+		'\t\t}', '', '\t\tif (!run( kind, name, data, len )) {', '\t\t\tprintf( "-" );', '\t\t}', '',
+		'\t\tprintf( "\\n" );', '\t}', '', '\treturn 0;', '}' ]
+
+	return '\n'.join( out ) + '\n'
+
+
+def generate_cs_runner( schema ):
+	out = [ 'using CamRover.ControllerApp.Models;', '', 'static class Runner', '{',
+		'\tstatic string Run( string kind, string name, byte[] data )', '\t{', '\t\tvar output = new byte[512];', '' ]
+	hexOut = '{Convert.ToHexString( output, 0, length ).ToLowerInvariant()}'
+
+	for message in schema['messages']:
+		typeName = camel( message['name'] ) + 'Message'
+		fields = message['fields']
+		commands = ' || '.join( f'command == ProtocolCommand.{camel( c )}' for c in message['commands'] )
+		out += [ f'\t\tif (kind == "M" && name == "{message["name"]}")', '\t\t{' ]
+
+		if fields:
+			out += [ '\t\t\tif (!Protocol.TryParseHeader( data, out var id, out var command ) ||',
+				f'\t\t\t\t!{typeName}.TryParse( data, out var message ))' ]
+		else:
+			out += [ '\t\t\tvar message = new ' + typeName + '();', '',
+				'\t\t\tif (!Protocol.TryParseHeader( data, out var id, out var command ) ||',
+				f'\t\t\t\tdata.Length < {typeName}.Length || !({commands}))' ]
+
+		command = ', command' if len( message['commands'] ) > 1 else ''
+		values = ''.join( f' {{message.{pascal( n )}}}' for n, _ in fields )
+		out += [ '\t\t\t{', '\t\t\t\treturn "-";', '\t\t\t}', '',
+			f'\t\t\tint length = message.Emit( output, id{command} );', '',
+			f'\t\t\treturn $"{{id}} {{(byte)command}}{values} | {hexOut}";', '\t\t}', '' ]
+
+	for packet in schema['streamPackets']:
+		typeName = 'Stream' + camel( packet['name'] ) + 'Packet'
+		fields = packet['fields']
+		out += [ f'\t\tif (kind == "P" && name == "{packet["name"]}")', '\t\t{' ]
+
+		if fields:
+			out += [ '\t\t\tif (!Protocol.TryParseStreamHeader( data, out _, out var timestampUs ) ||',
+				f'\t\t\t\t!{typeName}.TryParse( data, out var packet ))' ]
+		else:
+			out += [ '\t\t\tvar packet = new ' + typeName + '();', '',
+				'\t\t\tif (!Protocol.TryParseStreamHeader( data, out var type, out var timestampUs ) ||',
+				f'\t\t\t\ttype != ProtocolStreamType.{camel( packet["type"] )} ||',
+				f'\t\t\t\tdata.Length < {typeName}.HeaderLength)' ]
+
+		values = ''.join( f' {{packet.{pascal( n )}}}' for n, _ in fields )
+		out += [ '\t\t\t{', '\t\t\t\treturn "-";', '\t\t\t}', '',
+			'\t\t\tint length = packet.Emit( output, timestampUs );', '',
+			f'\t\t\treturn $"{{timestampUs}}{values} | {hexOut}";', '\t\t}', '' ]
+
+	out += [ '\t\treturn "-";', '\t}', '', '',
+		'\tstatic void Main()', '\t{', '\t\tstring? line;', '',
+		'\t\twhile ((line = Console.ReadLine()) != null)', '\t\t{', '\t\t\tvar parts = line.Split( \' \' );', '',
+		'\t\t\tConsole.WriteLine( Run( parts[0], parts[1], Convert.FromHexString( parts[2] ) ) );', '\t\t}', '\t}',
+		'}' ]
+
+	return '\n'.join( out ) + '\n'
+
+
+CS_RUNNER_PROJECT = '''<Project Sdk="Microsoft.NET.Sdk">
+	<PropertyGroup>
+		<OutputType>Exe</OutputType>
+		<TargetFramework>net8.0</TargetFramework>
+		<ImplicitUsings>enable</ImplicitUsings>
+		<Nullable>enable</Nullable>
+		<InvariantGlobalization>true</InvariantGlobalization>
+		<EnableDefaultCompileItems>false</EnableDefaultCompileItems>
+	</PropertyGroup>
+	<ItemGroup>
+		<Compile Include="Runner.cs" />
+		<Compile Include="{protocol}" />
+	</ItemGroup>
+</Project>
+'''
+
+
+def run_runner( label, command, cwd, corpus, expected, errors ):
+	result = subprocess.run( command, cwd = cwd, input = runner_input( corpus ), capture_output = True, text = True )
+
+	if result.returncode != 0:
+		errors.append( f'{label} runner failed: {result.stderr.strip()}' )
+		return
+
+	lines = result.stdout.splitlines()
+
+	if len( lines ) != len( expected ):
+		errors.append( f'{label}: {len( lines )} results for {len( expected )} corpus entries' )
+
+	for i, ( line, want ) in enumerate( zip( lines, expected ) ):
+		if line != want:
+			errors.append( f'{label}: corpus entry {i}: got "{line}", expected "{want}"' )
+
+
+def build( label, command, cwd, errors ):
+	result = subprocess.run( command, cwd = cwd, capture_output = True, text = True )
+
+	if result.returncode != 0:
+		errors.append( f'{label} runner does not build:\n{result.stdout.strip()}\n{result.stderr.strip()}' )
+
+	return result.returncode == 0
+
+
+# runs the generated C codec if a C compiler is around and the generated C# one if dotnet is, returns the names of
+# the codecs it ran
+def check_runners( schema, errors ):
+	with open( CORPUS_PATH ) as f:
+		corpus = json.load( f )
+
+	expected = runner_expected( schema, corpus )
+	codecs = []
+
+	with tempfile.TemporaryDirectory( prefix = 'protogen-' ) as temp:
+		cc = os.environ.get( 'CC' ) or shutil.which( 'cc' ) or shutil.which( 'gcc' )
+
+		if cc:
+			with open( os.path.join( temp, 'runner.c' ), 'w' ) as f:
+				f.write( generate_c_runner( schema ) )
+
+			runner = os.path.join( temp, 'runner_c' )
+			command = [ cc, '-std=c11', '-Wall', '-Wextra', '-Werror', '-I', os.path.dirname( C_SOURCE_PATH ),
+				'-o', runner, 'runner.c', C_SOURCE_PATH ]
+
+			if build( 'C', command, temp, errors ):
+				run_runner( 'C', [ runner ], temp, corpus, expected, errors )
+
+			codecs.append( 'C' )
+
+		dotnet = shutil.which( 'dotnet' )
+
+		if dotnet:
+			project = os.path.join( temp, 'cs' )
+			os.mkdir( project )
+
+			with open( os.path.join( project, 'Runner.cs' ), 'w' ) as f:
+				f.write( generate_cs_runner( schema ) )
+
+			with open( os.path.join( project, 'Runner.csproj' ), 'w' ) as f:
+				f.write( CS_RUNNER_PROJECT.format( protocol = CS_PATH ) )
+
+			output = os.path.join( temp, 'cs-out' )
+			command = [ dotnet, 'build', '-nologo', '-v', 'q', '-o', output ]
+
+			if build( 'C#', command, project, errors ):
+				run_runner( 'C#', [ dotnet, os.path.join( output, 'Runner.dll' ) ], temp, corpus, expected, errors )
+
+			codecs.append( 'C#' )
+
+	return codecs
+
+
+# commands shared by several messages (ACK) take the shortest
+def command_lengths( schema ):
+	lengths = {}
+
+	for message in schema['messages']:
+		for command in message['commands']:
+			length = MESSAGE_HEADER_LEN + fields_len( message['fields'] )
+
+			if command not in lengths or length < lengths[command][1]:
+				lengths[command] = ( message['name'], length )
+
+	return { c: lengths[c] for c in schema['commands'] if c in lengths }
+
+
+#
+# C
+#
+
+def c_name( message ):
+	return message['name']
+
+
+def c_stream_name( packet ):
+	return 'stream_' + packet['name']
+
+
+def c_emit_field( name, t, offset, source ):
+	if t == 'u8':
+		return [ f'\tdata[{offset}] = {source}->{name};' ]
+
+	return [ f'\trover_comm_put_{t}( data + {offset}, {source}->{name} );' ]
+
+
+def c_parse_field( name, t, offset, target ):
+	if t == 'u8':
+		return [ f'\t{target}->{name} = data[{offset}];' ]
+
+	return [ f'\t{target}->{name} = rover_comm_get_{t}( data + {offset} );' ]
+
+
+def generate_c_header( schema ):
+	out = license_block( '//' )
+	out += [ f'// {GENERATED}', '', '#ifndef __ROVER__COMM_PROTOCOL__H', '#define __ROVER__COMM_PROTOCOL__H', '', '' ]
+	out += [ '#include <stdbool.h>', '#include <stddef.h>', '#include <stdint.h>', '', '' ]
+
+	out += [ f'// {v} - {schema["history"][v]}' for v in sorted( schema['history'], key = int ) ]
+	out += [ f'#define ROVER_COMM_PROTOCOL_VERSION {schema["version"]}', '' ]
+	out += [ '// 0 - payload length (message length - 1)', '// 1-4 - message ID', '// 5 - command',
+		f'#define ROVER_COMM_MESSAGE_HEADER_LEN {MESSAGE_HEADER_LEN}', '' ]
+	out += [ '// 0 - packet type', '// 1-8 - capture timestamp, us of rover time (esp_timer)',
+		f'#define ROVER_COMM_STREAM_HEADER_LEN {STREAM_HEADER_LEN}', '' ]
+
+	out += [ '// message lengths, header included' ]
+	out += [ f'#define ROVER_COMM_{m["name"].upper()}_LEN {MESSAGE_HEADER_LEN + fields_len( m["fields"] )}'
+		for m in schema['messages'] ]
+	out += [ '', '// stream packet header lengths, the payload follows' ]
+	out += [ f'#define ROVER_COMM_STREAM_{p["name"].upper()}_HEADER_LEN {STREAM_HEADER_LEN + fields_len( p["fields"] )}'
+		for p in schema['streamPackets'] ]
+	out += [ '', '' ]
+
+	out += [ 'typedef enum {', '\tROVER_COMM_COMMAND_UNKNOWN = 0,' ]
+	out += [ f"\tROVER_COMM_COMMAND_{n} = '{c}'," for n, c in schema['commands'].items() ]
+	out[-1] = out[-1].rstrip( ',' )
+	out += [ '} t_rover_comm_command;', '' ]
+
+	out += [ 'typedef enum {' ]
+	out += [ f"\tROVER_COMM_STREAM_{n} = '{c}'," for n, c in schema['streamTypes'].items() ]
+	out[-1] = out[-1].rstrip( ',' )
+	out += [ '} t_rover_comm_stream_type;', '' ]
+
+	out += [ 'typedef struct {', '\tuint32_t id;', '\tt_rover_comm_command command;', '} t_rover_comm_header;', '' ]
+	out += [ 'typedef struct {', '\tt_rover_comm_stream_type type;', '\tint64_t timestampUs;',
+		'} t_rover_comm_stream_header;', '' ]
+
+	for message, prefix in [ ( m, '' ) for m in schema['messages'] ] + \
+		[ ( p, 'stream_' ) for p in schema['streamPackets'] ]:
+		if not message['fields']:
+			continue
+
+		if 'doc' in message:
+			out += doc_comment( message['doc'], '// ' )
+
+		out += [ 'typedef struct {' ]
+		out += [ f'\t{TYPES[t][1]} {n};' for n, t in message['fields'] ]
+		out += [ f'}} t_rover_comm_{prefix}{message["name"]};', '' ]
+
+	out += [ '' ]
+	out += [ '// parse functions return false unless data holds the whole message, emit functions return the length',
+		'// written or 0 if it does not fit size' ]
+	out += [ 'bool rover_comm_parse_header( const uint8_t * data, size_t len, t_rover_comm_header * header );' ]
+	out += [ '// shortest message a command comes with, 0 for unknown commands',
+		'size_t rover_comm_command_len( t_rover_comm_command command );' ]
+
+	for message in schema['messages']:
+		name = c_name( message )
+		command = ', t_rover_comm_command command' if len( message['commands'] ) > 1 else ''
+
+		if message['fields']:
+			out += [ f'bool rover_comm_parse_{name}( const uint8_t * data, size_t len, t_rover_comm_{name} * message );' ]
+			out += [ f'size_t rover_comm_emit_{name}( uint8_t * data, size_t size, uint32_t id{command}, '
+				f'const t_rover_comm_{name} * message );' ]
+		else:
+			out += [ f'size_t rover_comm_emit_{name}( uint8_t * data, size_t size, uint32_t id{command} );' ]
+
+	out += [ 'bool rover_comm_parse_stream_header( const uint8_t * data, size_t len, '
+		't_rover_comm_stream_header * header );' ]
+
+	for packet in schema['streamPackets']:
+		name = c_stream_name( packet )
+
+		if packet['fields']:
+			out += [ f'bool rover_comm_parse_{name}( const uint8_t * data, size_t len, t_rover_comm_{name} * packet );' ]
+			out += [ f'size_t rover_comm_emit_{name}( uint8_t * data, size_t size, int64_t timestampUs, '
+				f'const t_rover_comm_{name} * packet );' ]
+		else:
+			out += [ f'size_t rover_comm_emit_{name}( uint8_t * data, size_t size, int64_t timestampUs );' ]
+
+	out += [ '', '', '#endif' ]
+
+	return wrap_c( out )
+
+
+def generate_c_source( schema ):
+	out = license_block( '//' )
+	out += [ f'// {GENERATED}', '', '#include "comm_protocol.h"', '', '' ]
+
+	used = { t for m in schema['messages'] + schema['streamPackets'] for _, t in m['fields'] }
+	used |= { 'u32', 'i64' }
+
+	for t in [ 'u16', 'u32', 'i32', 'i64' ]:
+		if t not in used:
+			continue
+
+		ct = TYPES[t][1]
+		ut = 'uint' + ct[len( 'int' ):] if ct.startswith( 'int' ) else ct
+		n = struct.calcsize( '<' + TYPES[t][0] )
+		out += [ f'static inline {ct} rover_comm_get_{t}( const uint8_t * p )', '{', f'\t{ut} v = 0;', '',
+			f'\tfor ( int i = {n - 1}; i >= 0; i-- ) {{', f'\t\tv = ( v << 8 ) | p[i];', '\t}', '',
+			f'\treturn ({ct})v;' if ct != ut else '\treturn v;', '}', '', '' ]
+		out += [ f'static inline void rover_comm_put_{t}( uint8_t * p, {ct} value )', '{',
+			f'\t{ut} v = ({ut})value;' if ct != ut else f'\t{ut} v = value;',
+			'', f'\tfor ( int i = 0; i < {n}; i++ ) {{', '\t\tp[i] = v & 0xff;', '\t\tv >>= 8;', '\t}', '}', '', '' ]
+
+	out += [ 'static void rover_comm_put_header( uint8_t * data, size_t len, uint32_t id, t_rover_comm_command command )',
+		'{', '\tdata[0] = len - 1;', '\trover_comm_put_u32( data + 1, id );', '\tdata[5] = command;', '}', '', '' ]
+
+	out += [ 'static void rover_comm_put_stream_header( uint8_t * data, t_rover_comm_stream_type type, '
+		'int64_t timestampUs )', '{', '\tdata[0] = type;', '\trover_comm_put_i64( data + 1, timestampUs );', '}', '', '' ]
+
+	out += [ '// fields added to a message later are ignored by older parsers, so only the known part has to be there',
+		'static bool rover_comm_parse_message( const uint8_t * data, size_t len, size_t minLen, '
+		't_rover_comm_header * header )', '{',
+		'\treturn rover_comm_parse_header( data, len, header ) && len >= minLen;', '}', '', '' ]
+
+	out += [ 'bool rover_comm_parse_header( const uint8_t * data, size_t len, t_rover_comm_header * header )', '{',
+		'\tif ( len < ROVER_COMM_MESSAGE_HEADER_LEN || (size_t)data[0] + 1 != len ) {', '\t\treturn false;', '\t}', '',
+		'\theader->id = rover_comm_get_u32( data + 1 );', '\theader->command = data[5];', '', '\treturn true;', '}',
+		'', '' ]
+
+	out += [ 'size_t rover_comm_command_len( t_rover_comm_command command )', '{' ]
+	isFirst = True
+
+	for command, ( name, _ ) in command_lengths( schema ).items():
+		out += [ f'\t{"" if isFirst else "else "}if ( ROVER_COMM_COMMAND_{command} == command ) {{',
+			f'\t\treturn ROVER_COMM_{name.upper()}_LEN;', '\t}' ]
+		isFirst = False
+
+	out += [ '', '\treturn 0;', '}', '', '' ]
+
+	for message in schema['messages']:
+		name = c_name( message )
+		lenName = f'ROVER_COMM_{message["name"].upper()}_LEN'
+		commands = message['commands']
+		isMulti = len( commands ) > 1
+
+		if message['fields']:
+			check = c_join( [ f'ROVER_COMM_COMMAND_{c} != header.command' for c in commands ], ' &&', '\tif ( ', ' ) {' )
+			out += [ f'bool rover_comm_parse_{name}( const uint8_t * data, size_t len, t_rover_comm_{name} * message )',
+				'{', '\tt_rover_comm_header header;', '',
+				f'\tif ( !rover_comm_parse_message( data, len, {lenName}, &header ) ) {{', '\t\treturn false;', '\t}', '',
+				*check, '\t\treturn false;', '\t}', '' ]
+
+			for n, t, o in layout( message['fields'], MESSAGE_HEADER_LEN ):
+				out += c_parse_field( n, t, o, 'message' )
+
+			out += [ '', '\treturn true;', '}', '', '' ]
+
+		command = ', t_rover_comm_command command' if isMulti else ''
+		commandValue = 'command' if isMulti else f'ROVER_COMM_COMMAND_{commands[0]}'
+
+		if message['fields']:
+			out += [ f'size_t rover_comm_emit_{name}( uint8_t * data, size_t size, uint32_t id{command}, '
+				f'const t_rover_comm_{name} * message )', '{',
+				f'\tif ( size < {lenName} ) {{', '\t\treturn 0;', '\t}', '',
+				f'\trover_comm_put_header( data, {lenName}, id, {commandValue} );' ]
+
+			for n, t, o in layout( message['fields'], MESSAGE_HEADER_LEN ):
+				out += c_emit_field( n, t, o, 'message' )
+
+			out += [ '', f'\treturn {lenName};', '}', '', '' ]
+		else:
+			out += [ f'size_t rover_comm_emit_{name}( uint8_t * data, size_t size, uint32_t id{command} )', '{',
+				f'\tif ( size < {lenName} ) {{', '\t\treturn 0;', '\t}', '',
+				f'\trover_comm_put_header( data, {lenName}, id, {commandValue} );', '', f'\treturn {lenName};', '}', '',
+				'' ]
+
+	out += [ 'bool rover_comm_parse_stream_header( const uint8_t * data, size_t len, '
+		't_rover_comm_stream_header * header )', '{', '\tif ( len < ROVER_COMM_STREAM_HEADER_LEN ) {',
+		'\t\treturn false;', '\t}', '', '\theader->type = data[0];',
+		'\theader->timestampUs = rover_comm_get_i64( data + 1 );', '', '\treturn true;', '}', '', '' ]
+
+	for packet in schema['streamPackets']:
+		name = c_stream_name( packet )
+		lenName = f'ROVER_COMM_STREAM_{packet["name"].upper()}_HEADER_LEN'
+		typeValue = f'ROVER_COMM_STREAM_{packet["type"]}'
+
+		if packet['fields']:
+			out += [ f'bool rover_comm_parse_{name}( const uint8_t * data, size_t len, t_rover_comm_{name} * packet )',
+				'{', f'\tif ( len < {lenName} || {typeValue} != data[0] ) {{', '\t\treturn false;', '\t}', '' ]
+
+			for n, t, o in layout( packet['fields'], STREAM_HEADER_LEN ):
+				out += c_parse_field( n, t, o, 'packet' )
+
+			out += [ '', '\treturn true;', '}', '', '' ]
+			out += [ f'size_t rover_comm_emit_{name}( uint8_t * data, size_t size, int64_t timestampUs, '
+				f'const t_rover_comm_{name} * packet )', '{',
+				f'\tif ( size < {lenName} ) {{', '\t\treturn 0;', '\t}', '',
+				f'\trover_comm_put_stream_header( data, {typeValue}, timestampUs );' ]
+
+			for n, t, o in layout( packet['fields'], STREAM_HEADER_LEN ):
+				out += c_emit_field( n, t, o, 'packet' )
+
+			out += [ '', f'\treturn {lenName};', '}', '', '' ]
+		else:
+			out += [ f'size_t rover_comm_emit_{name}( uint8_t * data, size_t size, int64_t timestampUs )', '{',
+				f'\tif ( size < {lenName} ) {{', '\t\treturn 0;', '\t}', '',
+				f'\trover_comm_put_stream_header( data, {typeValue}, timestampUs );', '', f'\treturn {lenName};', '}',
+				'', '' ]
+
+	while out[-1] == '':
+		out.pop()
+
+	return wrap_c( out )
+
+
+# joins terms with op, wrapping at width with one extra tab of indent
+def c_join( terms, op, head, tail, width = 120 ):
+	lines = [ head ]
+
+	for i, term in enumerate( terms ):
+		piece = term + ( op if i < len( terms ) - 1 else tail )
+
+		if lines[-1] not in ( head, '\t\t' ) and len( ( lines[-1] + ' ' + piece ).expandtabs( 4 ) ) > width:
+			lines.append( '\t\t' )
+
+		lines[-1] += piece if lines[-1] in ( head, '\t\t' ) else ' ' + piece
+
+	return lines
+
+
+# breaks long prototypes the way clang-format does in the rest of the firmware
+def wrap_c( lines, width = 120 ):
+	out = []
+
+	for line in lines:
+		if len( line.expandtabs( 4 ) ) <= width or line.startswith( ( '\t', '//' ) ):
+			out.append( line )
+			continue
+
+		indent = line[:len( line ) - len( line.lstrip( '\t' ) )]
+		head, rest = line.split( '( ', 1 )
+		args = rest.rsplit( ' )', 1 )
+		params = args[0].split( ', ' )
+		out.append( f'{head}( {params[0]},' )
+		out += [ f'{indent}\t{p},' for p in params[1:-1] ]
+		out.append( f'{indent}\t{params[-1]} ){args[1]}' )
+
+	return '\n'.join( out ) + '\n'
+
+
+#
+# C#
+#
+
+def cs_read( t, offset, span = 'data' ):
+	if t == 'u8':
+		return f'{span}[{offset}]'
+
+	return f'BinaryPrimitives.Read{TYPES[t][3]}LittleEndian( {span}.Slice( {offset} ) )'
+
+
+def cs_write( t, offset, value, span = 'data' ):
+	if t == 'u8':
+		return f'{span}[{offset}] = {value};'
+
+	return f'BinaryPrimitives.Write{TYPES[t][3]}LittleEndian( {span}.Slice( {offset} ), {value} );'
+
+
+# long argument lists go one per line with leading commas, as in the rest of the app
+def cs_wrap( line, width = 120 ):
+	if len( line.expandtabs( 4 ) ) <= width:
+		return [ line ]
+
+	indent = line[:len( line ) - len( line.lstrip( '\t' ) )]
+	head, rest = line.split( '( ', 1 )
+	args, tail = rest.rsplit( ' )', 1 )
+	params = []
+	depth = 0
+	current = ''
+
+	for ch in args:
+		depth += ch == '('
+		depth -= ch == ')'
+
+		if ch == ',' and depth == 0:
+			params.append( current.strip() )
+			current = ''
+		else:
+			current += ch
+
+	params.append( current.strip() )
+
+	return [ f'{head}( {params[0]}' ] + [ f'{indent}\t, {p}' for p in params[1:] ] + [ f'{indent}\t){tail}' ]
+
+
+def generate_cs( schema ):
+	out = [ '/*' ] + [ ( ' *' + line ).rstrip() for line in LICENSE ] + [ ' */', '' ]
+	out += [ '// SPDX-FileCopyrightText: 2025 Denis Rozhkov <denis@rozhkoff.com>',
+		'// SPDX-License-Identifier: GPL-3.0-or-later', '', f'// {GENERATED}', '' ]
+	out += [ 'using System.Buffers.Binary;', '', 'namespace CamRover.ControllerApp.Models', '{', '' ]
+
+	out += [ '\tenum ProtocolCommand : byte', '\t{', '\t\tUnknown = 0,' ]
+	out += [ f"\t\t{camel( n )} = (byte)'{c}'," for n, c in schema['commands'].items() ]
+	out[-1] = out[-1].rstrip( ',' )
+	out += [ '\t}', '', '' ]
+
+	out += [ '\tenum ProtocolStreamType : byte', '\t{' ]
+	out += [ f"\t\t{camel( n )} = (byte)'{c}'," for n, c in schema['streamTypes'].items() ]
+	out[-1] = out[-1].rstrip( ',' )
+	out += [ '\t}', '', '' ]
+
+	out += [ '\t// TryParse returns false unless data holds the whole message, Emit returns the length written or 0 if it',
+		'\t// does not fit' ]
+	out += [ '\tstatic class Protocol', '\t{', f'\t\tpublic const int Version = {schema["version"]};',
+		f'\t\tpublic const int MessageHeaderLength = {MESSAGE_HEADER_LEN};',
+		f'\t\tpublic const int StreamHeaderLength = {STREAM_HEADER_LEN};', '', '' ]
+	out += [ '\t\tpublic static bool TryParseHeader( ReadOnlySpan<byte> data, out uint id, out ProtocolCommand command )',
+		'\t\t{', '\t\t\tif (data.Length < MessageHeaderLength || data[0] + 1 != data.Length)', '\t\t\t{',
+		'\t\t\t\tid = 0;', '\t\t\t\tcommand = ProtocolCommand.Unknown;', '', '\t\t\t\treturn false;', '\t\t\t}', '',
+		f'\t\t\tid = {cs_read( "u32", 1 )};', '\t\t\tcommand = (ProtocolCommand)data[5];', '', '\t\t\treturn true;',
+		'\t\t}', '', '' ]
+	out += [ '\t\tpublic static bool TryParseStreamHeader( ReadOnlySpan<byte> data, out ProtocolStreamType type, '
+		'out long timestampUs )', '\t\t{', '\t\t\tif (data.Length < StreamHeaderLength)', '\t\t\t{', '\t\t\t\ttype = 0;',
+		'\t\t\t\ttimestampUs = 0;', '', '\t\t\t\treturn false;', '\t\t\t}', '', '\t\t\ttype = (ProtocolStreamType)data[0];',
+		f'\t\t\ttimestampUs = {cs_read( "i64", 1 )};', '', '\t\t\treturn true;', '\t\t}', '', '' ]
+	out += [ '\t\t// shortest message a command comes with, 0 for unknown commands',
+		'\t\tpublic static int CommandLength( ProtocolCommand command )', '\t\t{', '\t\t\treturn command switch', '\t\t\t{' ]
+	out += [ f'\t\t\t\tProtocolCommand.{camel( c )} => {camel( n )}Message.Length,'
+		for c, ( n, _ ) in command_lengths( schema ).items() ]
+	out += [ '\t\t\t\t_ => 0', '\t\t\t};', '\t\t}', '', '' ]
+	out += [ '\t\t// fields added to a message later are ignored by older parsers, so only the known part has to be there',
+		'\t\tinternal static bool TryParseMessage( ReadOnlySpan<byte> data, int length, out ProtocolCommand command )',
+		'\t\t{', '\t\t\treturn TryParseHeader( data, out _, out command ) && data.Length >= length;', '\t\t}', '', '' ]
+	out += [ '\t\tinternal static int EmitHeader( Span<byte> data, int length, uint id, ProtocolCommand command )',
+		'\t\t{', '\t\t\tif (data.Length < length)', '\t\t\t{', '\t\t\t\treturn 0;', '\t\t\t}', '',
+		'\t\t\tdata[0] = (byte)(length - 1);', f'\t\t\t{cs_write( "u32", 1, "id" )}', '\t\t\tdata[5] = (byte)command;', '',
+		'\t\t\treturn length;', '\t\t}', '', '' ]
+	out += [ '\t\tinternal static int EmitStreamHeader( Span<byte> data, int length, ProtocolStreamType type, '
+		'long timestampUs )', '\t\t{', '\t\t\tif (data.Length < length)', '\t\t\t{', '\t\t\t\treturn 0;', '\t\t\t}', '',
+		'\t\t\tdata[0] = (byte)type;', f'\t\t\t{cs_write( "i64", 1, "timestampUs" )}', '', '\t\t\treturn length;',
+		'\t\t}', '\t}', '', '' ]
+
+	for message in schema['messages']:
+		out += cs_record( message, camel( message['name'] ) + 'Message', MESSAGE_HEADER_LEN, True )
+
+	for packet in schema['streamPackets']:
+		out += cs_record( packet, 'Stream' + camel( packet['name'] ) + 'Packet', STREAM_HEADER_LEN, False )
+
+	while out[-1] == '':
+		out.pop()
+
+	out += [ '', '}' ]
+
+	return '\ufeff' + '\n'.join( out ) + '\n'
+
+
+def cs_record( message, typeName, start, isMessage ):
+	fields = message['fields']
+	params = ', '.join( f'{TYPES[t][2]} {pascal( n )}' for n, t in fields )
+	out = []
+
+	if 'doc' in message:
+		out += doc_comment( message['doc'], '\t// ' )
+
+	out += cs_wrap( f'\treadonly record struct {typeName}( {params} )' ) if fields else [ f'\treadonly record struct {typeName}' ]
+	out += [ '\t{', f'\t\tpublic const int {"Length" if isMessage else "HeaderLength"} = {start + fields_len( fields )};',
+		'', '' ]
+	lenName = 'Length' if isMessage else 'HeaderLength'
+
+	if isMessage:
+		commands = message['commands']
+		isMulti = len( commands ) > 1
+
+		if fields:
+			check = '\n\t\t\t\t|| '.join( f'command != ProtocolCommand.{camel( c )}' for c in commands )
+			out += [ f'\t\tpublic static bool TryParse( ReadOnlySpan<byte> data, out {typeName} message )', '\t\t{',
+				'\t\t\tmessage = default;', '',
+				'\t\t\tif (!Protocol.TryParseMessage( data, Length, out var command ))', '\t\t\t{',
+				'\t\t\t\treturn false;', '\t\t\t}', '' ]
+			out += [ f'\t\t\tif ({check.replace( "||", "&&" )})', '\t\t\t{', '\t\t\t\treturn false;', '\t\t\t}', '' ]
+			values = ', '.join( cs_read( t, o ) for _, t, o in layout( fields, start ) )
+			out += cs_wrap( f'\t\t\tmessage = new {typeName}( {values} );' ) + [ '', '\t\t\treturn true;', '\t\t}', '', '' ]
+
+		command = ', ProtocolCommand command' if isMulti else ''
+		commandValue = 'command' if isMulti else f'ProtocolCommand.{camel( commands[0] )}'
+		out += [ f'\t\tpublic int Emit( Span<byte> data, uint id{command} )', '\t\t{' ]
+
+		if fields:
+			out += [ f'\t\t\tif (Protocol.EmitHeader( data, Length, id, {commandValue} ) == 0)', '\t\t\t{',
+				'\t\t\t\treturn 0;', '\t\t\t}', '' ]
+			out += [ f'\t\t\t{cs_write( t, o, pascal( n ) )}' for n, t, o in layout( fields, start ) ]
+			out += [ '', '\t\t\treturn Length;' ]
+		else:
+			out += [ f'\t\t\treturn Protocol.EmitHeader( data, Length, id, {commandValue} );' ]
+
+		out += [ '\t\t}', '\t}', '', '' ]
+	else:
+		typeValue = f'ProtocolStreamType.{camel( message["type"] )}'
+
+		if fields:
+			out += [ f'\t\tpublic static bool TryParse( ReadOnlySpan<byte> data, out {typeName} packet )', '\t\t{',
+				f'\t\t\tif (data.Length < HeaderLength || data[0] != (byte){typeValue})', '\t\t\t{',
+				'\t\t\t\tpacket = default;', '', '\t\t\t\treturn false;', '\t\t\t}', '' ]
+			values = ', '.join( cs_read( t, o ) for _, t, o in layout( fields, start ) )
+			out += cs_wrap( f'\t\t\tpacket = new {typeName}( {values} );' ) + [ '', '\t\t\treturn true;', '\t\t}', '', '' ]
+
+		out += [ '\t\tpublic int Emit( Span<byte> data, long timestampUs )', '\t\t{' ]
+
+		if fields:
+			out += [ f'\t\t\tif (Protocol.EmitStreamHeader( data, HeaderLength, {typeValue}, timestampUs ) == 0)',
+				'\t\t\t{', '\t\t\t\treturn 0;', '\t\t\t}', '' ]
+			out += [ f'\t\t\t{cs_write( t, o, pascal( n ) )}' for n, t, o in layout( fields, start ) ]
+			out += [ '', '\t\t\treturn HeaderLength;' ]
+		else:
+			out += [ f'\t\t\treturn Protocol.EmitStreamHeader( data, HeaderLength, {typeValue}, timestampUs );' ]
+
+		out += [ '\t\t}', '\t}', '', '' ]
+
+	return out
+
+
+def main():
+	parser = argparse.ArgumentParser( description = 'cam-rover wire protocol code generator' )
+	parser.add_argument( '--check', action = 'store_true', help = 'verify instead of writing' )
+	args = parser.parse_args()
+
+	schema = load_schema()
+	outputs = {
+		C_HEADER_PATH: generate_c_header( schema ),
+		C_SOURCE_PATH: generate_c_source( schema ),
+		CS_PATH: generate_cs( schema ),
+	}
+	isFailed = False
+
+	for path, text in outputs.items():
+		current = None
+
+		if os.path.exists( path ):
+			with open( path, encoding = 'utf-8', newline = '' ) as f:
+				current = f.read()
+
+		if current == text:
+			continue
+
+		if args.check:
+			print( f'{os.path.relpath( path, ROOT )} is stale, run protocol/protogen.py', file = sys.stderr )
+			isFailed = True
+		else:
+			with open( path, 'w', encoding = 'utf-8', newline = '' ) as f:
+				f.write( text )
+
+			print( f'{os.path.relpath( path, ROOT )} written' )
+
+	if args.check:
+		count, errors = check_corpus( schema )
+		codecs = [ 'python' ] + check_runners( schema, errors )
+
+		for error in errors:
+			print( error, file = sys.stderr )
+
+		isFailed = isFailed or bool( errors )
+		print( f'{count} corpus entries, {len( errors )} failed ({", ".join( codecs )})' )
+
+	sys.exit( 1 if isFailed else 0 )
+
+
+if __name__ == '__main__':
+	main()